@@ -18,6 +18,7 @@ extern "C" {
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
 
 /**
  * @defgroup export Export Definitions
@@ -262,7 +263,9 @@ typedef enum yaml_token_type_e {
     /** A TAG token. */
     YAML_TAG_TOKEN,
     /** A SCALAR token. */
-    YAML_SCALAR_TOKEN
+    YAML_SCALAR_TOKEN,
+    /** A SCALAR-CHUNK token. */
+    YAML_SCALAR_CHUNK_TOKEN
 } yaml_token_type_t;
 
 /** The token structure. */
@@ -300,7 +303,10 @@ typedef struct yaml_token_s {
             yaml_char_t *suffix;
         } tag;
 
-        /** The scalar value (for @c YAML_SCALAR_TOKEN). */
+        /**
+         * The scalar value (for @c YAML_SCALAR_TOKEN and
+         * @c YAML_SCALAR_CHUNK_TOKEN).
+         */
         struct {
             /** The scalar value. */
             yaml_char_t *value;
@@ -379,7 +385,14 @@ typedef enum yaml_event_type_e {
     /** A MAPPING-START event. */
     YAML_MAPPING_START_EVENT,
     /** A MAPPING-END event. */
-    YAML_MAPPING_END_EVENT
+    YAML_MAPPING_END_EVENT,
+
+    /** A SCALAR-START event. */
+    YAML_SCALAR_START_EVENT,
+    /** A SCALAR-CHUNK event. */
+    YAML_SCALAR_CHUNK_EVENT,
+    /** A SCALAR-END event. */
+    YAML_SCALAR_END_EVENT
 } yaml_event_type_t;
 
 /** The event structure. */
@@ -426,7 +439,12 @@ typedef struct yaml_event_s {
             yaml_char_t *anchor;
         } alias;
 
-        /** The scalar parameters (for @c YAML_SCALAR_EVENT). */
+        /**
+         * The scalar parameters (for @c YAML_SCALAR_EVENT).
+         *
+         * A @c YAML_SCALAR_START_EVENT has no value and a
+         * @c YAML_SCALAR_CHUNK_EVENT has only the value.
+         */
         struct {
             /** The anchor. */
             yaml_char_t *anchor;
@@ -583,6 +601,63 @@ yaml_scalar_event_initialize(yaml_event_t *event,
         int plain_implicit, int quoted_implicit,
         yaml_scalar_style_t style);
 
+/**
+ * Create a SCALAR-START event.
+ *
+ * A scalar may be given in chunks: a SCALAR-START event, any number of
+ * SCALAR-CHUNK events, and a SCALAR-END event.  The value of the scalar is
+ * the concatenation of the chunk values.  The emitter writes such a scalar
+ * in the double-quoted style, whatever the @a style argument is, since the
+ * other styles depend on the whole value.
+ *
+ * Either the @a tag attribute or one of the @a plain_implicit and
+ * @a quoted_implicit flags must be set.
+ *
+ * @param[out]      event           An empty event object.
+ * @param[in]       anchor          The scalar anchor or @c NULL.
+ * @param[in]       tag             The scalar tag or @c NULL.
+ * @param[in]       plain_implicit  If the tag may be omitted for the plain
+ *                                  style.
+ * @param[in]       quoted_implicit If the tag may be omitted for any
+ *                                  non-plain style.
+ * @param[in]       style           The scalar style.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_scalar_start_event_initialize(yaml_event_t *event,
+        const yaml_char_t *anchor, const yaml_char_t *tag,
+        int plain_implicit, int quoted_implicit,
+        yaml_scalar_style_t style);
+
+/**
+ * Create a SCALAR-CHUNK event.
+ *
+ * The chunk must consist of whole UTF-8 characters.
+ *
+ * @param[out]      event       An empty event object.
+ * @param[in]       value       The part of the scalar value.
+ * @param[in]       length      The length of the part.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_scalar_chunk_event_initialize(yaml_event_t *event,
+        const yaml_char_t *value, int length);
+
+/**
+ * Create a SCALAR-END event.
+ *
+ * @param[out]      event       An empty event object.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_scalar_end_event_initialize(yaml_event_t *event);
+
 /**
  * Create a SEQUENCE-START event.
  *
@@ -673,8 +748,12 @@ yaml_event_delete(yaml_event_t *event);
 #define YAML_INT_TAG        "tag:yaml.org,2002:int"
 /** The tag @c !!float for float values. */
 #define YAML_FLOAT_TAG      "tag:yaml.org,2002:float"
+/** The tag @c !!binary for base64-encoded octets. */
+#define YAML_BINARY_TAG     "tag:yaml.org,2002:binary"
 /** The tag @c !!timestamp for date and time values. */
 #define YAML_TIMESTAMP_TAG  "tag:yaml.org,2002:timestamp"
+/** The tag @c !!merge for merge keys. */
+#define YAML_MERGE_TAG      "tag:yaml.org,2002:merge"
 
 /** The tag @c !!seq is used to denote sequences. */
 #define YAML_SEQ_TAG        "tag:yaml.org,2002:seq"
@@ -701,6 +780,55 @@ typedef enum yaml_node_type_e {
     YAML_MAPPING_NODE
 } yaml_node_type_t;
 
+/** Resolved scalar types. */
+typedef enum yaml_scalar_type_e {
+    /** The scalar has not been resolved. */
+    YAML_UNRESOLVED_SCALAR_TYPE,
+
+    /** A string scalar. */
+    YAML_STR_SCALAR_TYPE,
+    /** A null scalar. */
+    YAML_NULL_SCALAR_TYPE,
+    /** A boolean scalar. */
+    YAML_BOOL_SCALAR_TYPE,
+    /** An integer scalar. */
+    YAML_INT_SCALAR_TYPE,
+    /** A floating point scalar. */
+    YAML_FLOAT_SCALAR_TYPE,
+    /** A binary scalar; the value holds the decoded octets. */
+    YAML_BINARY_SCALAR_TYPE
+} yaml_scalar_type_t;
+
+/** The value of a resolved scalar. */
+typedef union yaml_resolved_value_u {
+    /** The boolean value (for @c YAML_BOOL_SCALAR_TYPE). */
+    int boolean;
+    /** The integer value (for @c YAML_INT_SCALAR_TYPE). */
+    int64_t integer;
+    /** The floating point value (for @c YAML_FLOAT_SCALAR_TYPE). */
+    double real;
+} yaml_resolved_value_t;
+
+/** Node flags. */
+typedef enum yaml_node_flag_e {
+    /** The node tag is not owned by the node. */
+    YAML_NODE_SHARED_TAG = 1,
+    /** The scalar value is not owned by the node. */
+    YAML_NODE_SHARED_VALUE = 2,
+    /** The node has been modified since the document was loaded. */
+    YAML_NODE_MODIFIED = 4,
+    /** The scalar tag has been resolved from the value of a plain scalar. */
+    YAML_NODE_RESOLVED_TAG = 8
+} yaml_node_flag_t;
+
+/** Options of the functions adding nodes with caller-allocated strings. */
+typedef enum yaml_adopt_flag_e {
+    /** The strings are borrowed and must outlive the document. */
+    YAML_ADOPT_BORROWED = 1,
+    /** The strings are known to be valid UTF-8. */
+    YAML_ADOPT_TRUSTED = 2
+} yaml_adopt_flag_t;
+
 /** The forward definition of a document node structure. */
 typedef struct yaml_node_s yaml_node_t;
 
@@ -774,6 +902,17 @@ struct yaml_node_s {
     /** The end of the node. */
     yaml_mark_t end_mark;
 
+    /** The node flags (a combination of @c yaml_node_flag_t values). */
+    int flags;
+
+    /** The resolved scalar (for @c YAML_SCALAR_NODE). */
+    struct {
+        /** The resolved scalar type. */
+        yaml_scalar_type_t type;
+        /** The resolved scalar value. */
+        yaml_resolved_value_t value;
+    } resolved;
+
 };
 
 /** The document structure. */
@@ -810,6 +949,34 @@ typedef struct yaml_document_s {
     /** The end of the document. */
     yaml_mark_t end_mark;
 
+    /** The pool of strings shared between nodes. */
+    struct {
+        /** The beginning of the stack. */
+        yaml_char_t **start;
+        /** The end of the stack. */
+        yaml_char_t **end;
+        /** The top of the stack. */
+        yaml_char_t **top;
+    } strings;
+
+    /** The cached structural hashes of the nodes. */
+    struct {
+        /** The beginning of the list. */
+        uint64_t *start;
+        /** The end of the list. */
+        uint64_t *end;
+    } hashes;
+
+    /** The ids of the modified nodes. */
+    struct {
+        /** The beginning of the stack. */
+        int *start;
+        /** The end of the stack. */
+        int *end;
+        /** The top of the stack. */
+        int *top;
+    } modified;
+
 } yaml_document_t;
 
 /**
@@ -846,6 +1013,41 @@ yaml_document_initialize(yaml_document_t *document,
 YAML_DECLARE(void)
 yaml_document_delete(yaml_document_t *document);
 
+/**
+ * Copy a YAML document.
+ *
+ * The copy has the same nodes with the same ids, so nodes referred to several
+ * times stay shared.  The tags and the scalar values of the copy are kept in
+ * a single block of memory with each distinct tag stored once.
+ *
+ * @param[out]      target      An empty document object.
+ * @param[in]       source      The document to copy.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_document_copy(yaml_document_t *target, yaml_document_t *source);
+
+/**
+ * Copy a node of a YAML document and its descendants into a new document.
+ *
+ * The node becomes the root of the new document.  The other nodes are
+ * numbered in the order in which yaml_parser_load() would create them, and
+ * nodes referred to several times stay shared.  The directives of the source
+ * document are copied as well.
+ *
+ * @param[out]      target      An empty document object.
+ * @param[in]       source      The source document.
+ * @param[in]       index       The id of the node to extract.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_document_extract_subtree(yaml_document_t *target,
+        yaml_document_t *source, int index);
+
 /**
  * Get a node of a YAML document.
  *
@@ -880,6 +1082,27 @@ yaml_document_get_node(yaml_document_t *document, int index);
 YAML_DECLARE(yaml_node_t *)
 yaml_document_get_root_node(yaml_document_t *document);
 
+/**
+ * Find the value of a scalar key in a mapping node.
+ *
+ * The keys of the mapping are compared with @a key regardless of their
+ * tags.  If the mapping has no such key, the mappings referenced by its
+ * merge keys (@c <<) are searched in order, so that the explicit keys
+ * override the merged ones and the earlier merged mappings override the
+ * later ones.
+ *
+ * @param[in]       document        A document object.
+ * @param[in]       mapping         The mapping node id.
+ * @param[in]       key             The key value.
+ * @param[in]       length          The length of the key value.
+ *
+ * @returns the value node id or @c 0 if the key is not found or on error.
+ */
+
+YAML_DECLARE(int)
+yaml_document_get_mapping_value(yaml_document_t *document, int mapping,
+        const yaml_char_t *key, size_t length);
+
 /**
  * Create a SCALAR node and attach it to the document.
  *
@@ -960,6 +1183,293 @@ YAML_DECLARE(int)
 yaml_document_append_mapping_pair(yaml_document_t *document,
         int mapping, int key, int value);
 
+/**
+ * Replace the value of a SCALAR node.
+ *
+ * The node keeps its tag and style.  If the node has been resolved by the
+ * loader, the new value is resolved again; a node with the
+ * @c YAML_NODE_RESOLVED_TAG flag gets the tag of its new type, while an
+ * explicit tag is kept.  The new value of a decoded binary node is taken as
+ * octets.  The node is marked as modified.
+ *
+ * @param[in,out]   document    A document object.
+ * @param[in]       index       The scalar node id.
+ * @param[in]       value       The new scalar value.
+ * @param[in]       length      The length of the scalar value.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_document_set_scalar(yaml_document_t *document, int index,
+        const yaml_char_t *value, int length);
+
+/**
+ * Reserve space for nodes of a document.
+ *
+ * After the call, @a count nodes may be added without reallocating the list
+ * of nodes.  Node pointers obtained earlier may become invalid.
+ *
+ * @param[in,out]   document    A document object.
+ * @param[in]       count       The number of nodes to be added.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_document_reserve_nodes(yaml_document_t *document, int count);
+
+/**
+ * Reserve space for items of a sequence node.
+ *
+ * @param[in,out]   document    A document object.
+ * @param[in]       sequence    The sequence node id.
+ * @param[in]       count       The number of items to be appended.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_document_reserve_items(yaml_document_t *document, int sequence,
+        int count);
+
+/**
+ * Reserve space for pairs of a mapping node.
+ *
+ * @param[in,out]   document    A document object.
+ * @param[in]       mapping     The mapping node id.
+ * @param[in]       count       The number of pairs to be appended.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_document_reserve_pairs(yaml_document_t *document, int mapping,
+        int count);
+
+/**
+ * Create a SCALAR node from caller-allocated strings and attach it to the
+ * document.
+ *
+ * Unlike yaml_document_add_scalar(), the strings are not copied.  By default,
+ * the document takes ownership of them and frees them with free().  With
+ * @c YAML_ADOPT_BORROWED, the strings stay owned by the caller (for
+ * instance, by an arena) and must outlive the document.  With
+ * @c YAML_ADOPT_TRUSTED, the strings are not checked to be valid UTF-8.
+ *
+ * A @c NULL tag stands for the default scalar tag.  The value must be
+ * terminated by a NUL character.  On error, the strings remain owned by the
+ * caller.
+ *
+ * @param[in,out]   document        A document object.
+ * @param[in]       tag             The scalar tag.
+ * @param[in]       value           The scalar value.
+ * @param[in]       length          The length of the scalar value.
+ * @param[in]       style           The scalar style.
+ * @param[in]       flags           A combination of @c yaml_adopt_flag_t
+ *                                  values.
+ *
+ * @returns the node id or @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_document_adopt_scalar(yaml_document_t *document,
+        yaml_char_t *tag, yaml_char_t *value, int length,
+        yaml_scalar_style_t style, int flags);
+
+/**
+ * Create a SEQUENCE node with a caller-allocated tag and attach it to the
+ * document.
+ *
+ * The tag is handled as by yaml_document_adopt_scalar().
+ *
+ * @param[in,out]   document    A document object.
+ * @param[in]       tag         The sequence tag.
+ * @param[in]       style       The sequence style.
+ * @param[in]       flags       A combination of @c yaml_adopt_flag_t values.
+ *
+ * @returns the node id or @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_document_adopt_sequence(yaml_document_t *document,
+        yaml_char_t *tag, yaml_sequence_style_t style, int flags);
+
+/**
+ * Create a MAPPING node with a caller-allocated tag and attach it to the
+ * document.
+ *
+ * The tag is handled as by yaml_document_adopt_scalar().
+ *
+ * @param[in,out]   document    A document object.
+ * @param[in]       tag         The mapping tag.
+ * @param[in]       style       The mapping style.
+ * @param[in]       flags       A combination of @c yaml_adopt_flag_t values.
+ *
+ * @returns the node id or @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_document_adopt_mapping(yaml_document_t *document,
+        yaml_char_t *tag, yaml_mapping_style_t style, int flags);
+
+/**
+ * Get the integer value of a SCALAR node.
+ *
+ * If the node has been resolved by the loader, the cached value is returned.
+ * Otherwise a plain scalar with the default tag is parsed according to the
+ * core schema, a scalar with a core schema tag is checked against its tag,
+ * and any other scalar is not an integer.
+ *
+ * @param[in]       node        A node object.
+ * @param[out]      value       The integer value.
+ *
+ * @returns @c 1 if the node is an integer, @c 0 otherwise.
+ */
+
+YAML_DECLARE(int)
+yaml_node_get_int64(yaml_node_t *node, int64_t *value);
+
+/**
+ * Get the floating point value of a SCALAR node.
+ *
+ * Integer scalars are converted to the nearest floating point value.
+ *
+ * @param[in]       node        A node object.
+ * @param[out]      value       The floating point value.
+ *
+ * @returns @c 1 if the node is a number, @c 0 otherwise.
+ */
+
+YAML_DECLARE(int)
+yaml_node_get_double(yaml_node_t *node, double *value);
+
+/**
+ * Get the boolean value of a SCALAR node.
+ *
+ * @param[in]       node        A node object.
+ * @param[out]      value       The boolean value (@c 0 or @c 1).
+ *
+ * @returns @c 1 if the node is a boolean, @c 0 otherwise.
+ */
+
+YAML_DECLARE(int)
+yaml_node_get_bool(yaml_node_t *node, int *value);
+
+/**
+ * Check if a SCALAR node is null.
+ *
+ * @param[in]       node        A node object.
+ *
+ * @returns @c 1 if the node is null, @c 0 otherwise.
+ */
+
+YAML_DECLARE(int)
+yaml_node_is_null(yaml_node_t *node);
+
+/**
+ * Get the structural hash of a node.
+ *
+ * The hash depends only on the tags and the content of the node and its
+ * descendants; node styles, marks, and the order of mapping pairs are
+ * ignored.  Equal nodes have equal hashes, in the same or in different
+ * documents.
+ *
+ * The hashes of all nodes are computed at once and cached in the document,
+ * even though it is passed as constant.  The cache is discarded by the
+ * functions modifying the document.  The documents of a document cache come
+ * with their hashes computed, so they may be hashed and compared from
+ * several threads.
+ *
+ * @param[in]       document    A document object.
+ * @param[in]       index       The node id.
+ *
+ * @returns the hash value or @c 0 on error.
+ */
+
+YAML_DECLARE(uint64_t)
+yaml_document_hash_node(const yaml_document_t *document, int index);
+
+/**
+ * Check if two nodes are structurally equal.
+ *
+ * Nodes are equal if they have the same kind and tag, and either the same
+ * scalar value, or equal items, or equal pairs in any order.  Subtrees with
+ * different hashes are rejected without being traversed.
+ *
+ * @param[in]       document_a  The document of the first node.
+ * @param[in]       index_a     The id of the first node.
+ * @param[in]       document_b  The document of the second node.
+ * @param[in]       index_b     The id of the second node.
+ *
+ * @returns @c 1 if the nodes are equal, @c 0 otherwise or on error.
+ */
+
+YAML_DECLARE(int)
+yaml_node_equal(const yaml_document_t *document_a, int index_a,
+        const yaml_document_t *document_b, int index_b);
+
+/**
+ * Check if two documents have structurally equal root nodes.
+ *
+ * @param[in]       document_a  The first document.
+ * @param[in]       document_b  The second document.
+ *
+ * @returns @c 1 if the documents are equal, @c 0 otherwise or on error.
+ */
+
+YAML_DECLARE(int)
+yaml_document_equal(const yaml_document_t *document_a,
+        const yaml_document_t *document_b);
+
+/**
+ * Compute the differences between two documents.
+ *
+ * The result is a patch document in the JSON Patch format: a sequence of
+ * operations like
+ *
+ * @code
+ * - op: replace
+ *   path: /servers/0/port
+ *   value: 8080
+ * @endcode
+ *
+ * The operations are @c add, @c remove, and @c replace; paths are JSON
+ * Pointers.  Mappings with scalar keys are compared key by key, sequences are
+ * aligned by their longest common subsequence, and unchanged subtrees are
+ * skipped by their hashes.  Where a change cannot be addressed by a path, the
+ * enclosing node is replaced.
+ *
+ * The patch may be dumped and loaded like any other document.
+ *
+ * @param[in,out]   old_document    The original document.
+ * @param[in,out]   new_document    The modified document.
+ * @param[out]      patch           An empty patch document object.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_document_diff(yaml_document_t *old_document,
+        yaml_document_t *new_document, yaml_document_t *patch);
+
+/**
+ * Apply a patch to a document.
+ *
+ * The operations are applied in order.  If an operation is malformed or its
+ * path does not exist, the function fails and the document is left with the
+ * preceding operations applied.  Removed and replaced nodes stay in the
+ * document, but are no longer reachable from the root.
+ *
+ * @param[in,out]   document        A document object.
+ * @param[in]       patch           A patch produced by yaml_document_diff().
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_document_apply_patch(yaml_document_t *document, yaml_document_t *patch);
+
 /** @} */
 
 /**
@@ -1061,9 +1571,47 @@ typedef enum yaml_parser_state_e {
     /** Expect an empty value of a flow mapping. */
     YAML_PARSE_FLOW_MAPPING_EMPTY_VALUE_STATE,
     /** Expect nothing. */
-    YAML_PARSE_END_STATE
+    YAML_PARSE_END_STATE,
+    /** Expect a chunk of a scalar or its end. */
+    YAML_PARSE_SCALAR_CHUNK_STATE
 } yaml_parser_state_t;
 
+/**
+ * Deduplication modes of the loader.
+ */
+
+typedef enum yaml_dedup_mode_e {
+    /** Load every node and string separately. */
+    YAML_DEDUP_NONE,
+    /** Share identical tags and scalar values between nodes. */
+    YAML_DEDUP_STRINGS,
+    /** Also share identical scalars and collections as a single node. */
+    YAML_DEDUP_NODES
+} yaml_dedup_mode_t;
+
+/**
+ * Merge key modes of the loader.
+ */
+
+typedef enum yaml_merge_mode_e {
+    /** Load merge keys as ordinary keys. */
+    YAML_MERGE_NONE,
+    /** Check merge keys and keep them as links to the merged mappings. */
+    YAML_MERGE_LINK,
+    /** Replace merge keys with the pairs of the merged mappings. */
+    YAML_MERGE_MATERIALIZE
+} yaml_merge_mode_t;
+
+/** The JSON mode of the scanner. */
+typedef enum yaml_json_mode_e {
+    /** Scan the input with the general YAML rules only. */
+    YAML_JSON_DISABLED,
+    /** Enable the JSON fast path if the input starts with @c { or @c [. */
+    YAML_JSON_DETECT,
+    /** Enable the JSON fast path. */
+    YAML_JSON_ENABLED
+} yaml_json_mode_t;
+
 /**
  * This structure holds aliases data.
  */
@@ -1078,8 +1626,75 @@ typedef struct yaml_alias_data_s {
 } yaml_alias_data_t;
 
 /**
- * The parser structure.
- *
+ * This structure holds an anchored node recorded for the alias expansion.
+ */
+
+typedef struct yaml_expansion_anchor_s {
+    /** The anchor. */
+    yaml_char_t *anchor;
+    /** The offset of the first event record of the node. */
+    size_t start;
+    /** The offset past the last event record, or @c 0 if the node is open. */
+    size_t end;
+    /** The collection level of the node. */
+    int level;
+} yaml_expansion_anchor_t;
+
+/**
+ * This structure holds a range of event records being replayed.
+ */
+
+typedef struct yaml_expansion_frame_s {
+    /** The offset of the next event record. */
+    size_t pointer;
+    /** The offset past the last event record. */
+    size_t end;
+} yaml_expansion_frame_t;
+
+/**
+ * This structure holds an error recovered by the parser.
+ */
+
+typedef struct yaml_parser_error_s {
+    /** Error type. */
+    yaml_error_type_t type;
+    /** Error description. */
+    const char *problem;
+    /** The problem position. */
+    yaml_mark_t problem_mark;
+    /** The error context. */
+    const char *context;
+    /** The context position. */
+    yaml_mark_t context_mark;
+} yaml_parser_error_t;
+
+/**
+ * This structure holds a node left open by the parser, for the error
+ * recovery.
+ */
+
+typedef struct yaml_recovery_node_s {
+    /** The type of the start event. */
+    yaml_event_type_t type;
+    /** Is it a flow collection or a chunked scalar? */
+    int flow;
+    /** Is it an indentless sequence? */
+    int indentless;
+    /** The indentation column of a block collection. */
+    int column;
+    /** The mark of the block collection start. */
+    yaml_mark_t mark;
+    /** The size of the states stack at the start. */
+    size_t states;
+    /** The size of the marks stack at the start. */
+    size_t marks;
+    /** The number of the produced children. */
+    size_t children;
+} yaml_recovery_node_t;
+
+/**
+ * The parser structure.
+ *
  * All members are internal.  Manage the structure using the @c yaml_parser_
  * family of functions.
  */
@@ -1238,6 +1853,40 @@ typedef struct yaml_parser_s {
         yaml_simple_key_t *top;
     } simple_keys;
 
+    /** The lowest flow level that may have a potential simple key. */
+    int simple_key_level;
+
+    /** The JSON mode. */
+    yaml_json_mode_t json;
+
+    /** Is the JSON fast path active (@c -1 if not detected yet)? */
+    int json_active;
+
+    /** The size of the scalar chunks, or @c 0. */
+    size_t scalar_chunk_size;
+
+    /** The block scalar being scanned in chunks. */
+    struct {
+        /** Is the scalar not finished yet? */
+        int active;
+        /** Is it a literal scalar? */
+        int literal;
+        /** The chomping method. */
+        int chomping;
+        /** The indentation level. */
+        int indent;
+        /** Does the current line start with a blank? */
+        int leading_blank;
+        /** The number of line breaks left to produce. */
+        size_t breaks;
+        /** Are only the kept trailing line breaks left? */
+        int tail;
+        /** The beginning of the scalar. */
+        yaml_mark_t start_mark;
+        /** The end of the scalar, once it is known. */
+        yaml_mark_t end_mark;
+    } scalar_chunk;
+
     /**
      * @}
      */
@@ -1280,6 +1929,79 @@ typedef struct yaml_parser_s {
         yaml_tag_directive_t *top;
     } tag_directives;
 
+    /**
+     * @}
+     */
+
+    /**
+     * @name Expander stuff
+     * @{
+     */
+
+    /** Expand aliases into the events of the anchored nodes? */
+    int expand_aliases;
+
+    /** The maximum number of replayed events per document, or @c 0. */
+    size_t expansion_max_events;
+
+    /** The maximum number of replayed scalar and tag bytes, or @c 0. */
+    size_t expansion_max_bytes;
+
+    /** The number of events replayed in the current document. */
+    size_t expansion_events;
+
+    /** The number of bytes replayed in the current document. */
+    size_t expansion_bytes;
+
+    /** The event records of the anchored nodes. */
+    struct {
+        /** The beginning of the arena. */
+        yaml_char_t *start;
+        /** The end of the arena. */
+        yaml_char_t *end;
+        /** The end of the records. */
+        yaml_char_t *pointer;
+    } expansion_arena;
+
+    /** The anchored nodes of the current document. */
+    struct {
+        /** The beginning of the list. */
+        yaml_expansion_anchor_t *start;
+        /** The end of the list. */
+        yaml_expansion_anchor_t *end;
+        /** The top of the list. */
+        yaml_expansion_anchor_t *top;
+    } expansion_anchors;
+
+    /** The stack of the open anchored collections. */
+    struct {
+        /** The beginning of the stack. */
+        int *start;
+        /** The end of the stack. */
+        int *end;
+        /** The top of the stack. */
+        int *top;
+    } expansion_open;
+
+    /** The stack of the ranges being replayed. */
+    struct {
+        /** The beginning of the stack. */
+        yaml_expansion_frame_t *start;
+        /** The end of the stack. */
+        yaml_expansion_frame_t *end;
+        /** The top of the stack. */
+        yaml_expansion_frame_t *top;
+    } expansion_frames;
+
+    /** The current collection level. */
+    int expansion_level;
+
+    /** The alias being expanded. */
+    yaml_mark_t expansion_start_mark;
+
+    /** The end of the alias being expanded. */
+    yaml_mark_t expansion_end_mark;
+
     /**
      * @}
      */
@@ -1302,6 +2024,68 @@ typedef struct yaml_parser_s {
     /** The currently parsed document. */
     yaml_document_t *document;
 
+    /** Resolve the types of scalars using the core schema? */
+    int resolve_scalars;
+
+    /** Decode the base64 text of binary scalars? */
+    int decode_binary;
+
+    /** The deduplication mode. */
+    yaml_dedup_mode_t dedup;
+
+    /** The merge key mode. */
+    yaml_merge_mode_t merge;
+
+    /** Do the marks of the nodes cover their content only? */
+    int source_spans;
+
+    /**
+     * @}
+     */
+
+    /**
+     * @name Error recovery
+     * @{
+     */
+
+    /** Recover from the scanner and parser errors? */
+    int recover_errors;
+
+    /** The recovered errors. */
+    struct {
+        /** The beginning of the list. */
+        yaml_parser_error_t *start;
+        /** The end of the list. */
+        yaml_parser_error_t *end;
+        /** The top of the list. */
+        yaml_parser_error_t *top;
+    } errors;
+
+    /** The stack of the open nodes of the current document. */
+    struct {
+        /** The beginning of the stack. */
+        yaml_recovery_node_t *start;
+        /** The end of the stack. */
+        yaml_recovery_node_t *end;
+        /** The top of the stack. */
+        yaml_recovery_node_t *top;
+    } recovery_nodes;
+
+    /** The size of the states stack in the current document, or @c 0. */
+    size_t recovery_states;
+
+    /** Has the root node of the current document been produced? */
+    int recovery_root;
+
+    /** Are the nodes above the kept ones being closed? */
+    int recovery_closing;
+
+    /** The number of the open nodes kept after the last error. */
+    size_t recovery_keep;
+
+    /** The position of the last resynchronization. */
+    yaml_mark_t recovery_mark;
+
     /**
      * @}
      */
@@ -1383,6 +2167,209 @@ yaml_parser_set_input(yaml_parser_t *parser,
 YAML_DECLARE(void)
 yaml_parser_set_encoding(yaml_parser_t *parser, yaml_encoding_t encoding);
 
+/**
+ * Enable or disable resolving of scalar types by the loader.
+ *
+ * When enabled, yaml_parser_load() resolves plain scalars without an explicit
+ * tag and scalars tagged with @c !!null, @c !!bool, @c !!int, or @c !!float
+ * according to the YAML 1.2 core schema.  The resolved tag is assigned to the
+ * node and the typed value is cached in the node.  Integers outside of the
+ * 64-bit range are resolved as floats.  When disabled, only the scalars that
+ * are strings by their tag or quoting are marked with
+ * @c YAML_STR_SCALAR_TYPE.
+ *
+ * Default: disabled
+ *
+ * @param[in,out]   parser      A parser object.
+ * @param[in]       resolve     If scalars should be resolved.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_resolve_scalars(yaml_parser_t *parser, int resolve);
+
+/**
+ * Enable or disable decoding of binary scalars by the loader.
+ *
+ * When enabled, yaml_parser_load() decodes the base64 text of scalars tagged
+ * with @c !!binary, ignoring spaces and line breaks.  The octets replace the
+ * value of the node and the node type is set to @c YAML_BINARY_SCALAR_TYPE.
+ * Invalid base64 text is a composer error.  The dumper and the document
+ * iterator encode such nodes back to base64 text in the literal style.
+ *
+ * Default: disabled
+ *
+ * @param[in,out]   parser      A parser object.
+ * @param[in]       decode      If binary scalars should be decoded.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_decode_binary(yaml_parser_t *parser, int decode);
+
+/**
+ * Set the deduplication mode of the loader.
+ *
+ * With @c YAML_DEDUP_STRINGS, identical tags and scalar values are stored
+ * once in the document string pool and the nodes are marked with
+ * @c YAML_NODE_SHARED_TAG and @c YAML_NODE_SHARED_VALUE.
+ *
+ * With @c YAML_DEDUP_NODES, scalars with the same tag, style, and value, and
+ * collections with the same tag, style, and items are additionally loaded
+ * as a single node referenced from every place they occur.  The marks of
+ * such a node point to its first occurrence.  The dumper emits repeated
+ * nodes as aliases.
+ *
+ * Shared nodes must not be modified.
+ *
+ * Default: @c YAML_DEDUP_NONE
+ *
+ * @param[in,out]   parser      A parser object.
+ * @param[in]       mode        The deduplication mode.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_dedup(yaml_parser_t *parser, yaml_dedup_mode_t mode);
+
+/**
+ * Set the merge key mode of the loader.
+ *
+ * A merge key is a plain scalar @c << or a scalar @c << tagged with
+ * @c !!merge.  Its value must be a mapping or a sequence of mappings that
+ * are complete at the point of the merge.
+ *
+ * With @c YAML_MERGE_LINK, merge keys are checked and kept in place;
+ * yaml_document_get_mapping_value() follows them.
+ *
+ * With @c YAML_MERGE_MATERIALIZE, each merge key is replaced with the pairs
+ * of the merged mappings whose keys are not present yet: the explicit keys
+ * of the mapping win, then the merged mappings are taken in order.  The
+ * merged pairs reference the same key and value nodes as the originals.
+ * Scalar keys are compared by tag and value, other keys by identity.
+ *
+ * Default: @c YAML_MERGE_NONE
+ *
+ * @param[in,out]   parser      A parser object.
+ * @param[in]       mode        The merge key mode.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_merge(yaml_parser_t *parser, yaml_merge_mode_t mode);
+
+/**
+ * Enable or disable exact source spans of the loaded nodes.
+ *
+ * By default, a block collection loaded by yaml_parser_load() ends where the
+ * next token starts, past the trailing comments and line breaks.  When
+ * enabled, it ends with its last entry instead, so the marks of every node
+ * delimit the node text exactly, apart from the line breaks following a
+ * block scalar.  This is required by yaml_emitter_dump_edited().
+ *
+ * Default: disabled
+ *
+ * @param[in,out]   parser      A parser object.
+ * @param[in]       spans       If the nodes should have exact spans.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_source_spans(yaml_parser_t *parser, int spans);
+
+/**
+ * Set the JSON mode of the scanner.
+ *
+ * With @c YAML_JSON_ENABLED, the tokens inside flow collections are fetched
+ * by a fast path for JSON: quoted strings, numbers, and the literal names
+ * are scanned directly, without the general plain scalar rules.  The
+ * produced tokens, events, and marks are the same as without the fast path.
+ * The scanner falls back to the general rules for the rest of the stream
+ * when it meets a construct that is not JSON.
+ *
+ * With @c YAML_JSON_DETECT, the fast path is enabled only if the first
+ * token of the stream starts with @c { or @c [.
+ *
+ * Default: @c YAML_JSON_DISABLED
+ *
+ * @param[in,out]   parser      A parser object.
+ * @param[in]       mode        The JSON mode.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_json(yaml_parser_t *parser, yaml_json_mode_t mode);
+
+/**
+ * Set the size of the scalar chunks.
+ *
+ * When set, a block scalar whose value grows past @a size octets is produced
+ * in parts as soon as they are scanned: yaml_parser_scan() returns
+ * @c YAML_SCALAR_CHUNK_TOKEN tokens followed by a @c YAML_SCALAR_TOKEN with
+ * the rest of the value, and yaml_parser_parse() returns a
+ * @c YAML_SCALAR_START_EVENT, @c YAML_SCALAR_CHUNK_EVENT events, and a
+ * @c YAML_SCALAR_END_EVENT instead of a @c YAML_SCALAR_EVENT.  The memory
+ * used for the scalar is then bounded by @a size and the length of the
+ * longest run of the input buffer, whatever the size of the scalar is.
+ *
+ * A chunk ends on a character boundary.  Flow and plain scalars are always
+ * produced whole, since they may turn out to be simple keys.
+ * yaml_parser_load() joins the chunks back into a single scalar node.
+ *
+ * Default: @c 0 (no chunks)
+ *
+ * @param[in,out]   parser      A parser object.
+ * @param[in]       size        The size of the chunks, or @c 0.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_scalar_chunk_size(yaml_parser_t *parser, size_t size);
+
+/**
+ * Enable or disable the expansion of aliases by the event parser.
+ *
+ * When enabled, yaml_parser_parse() records the events of every anchored
+ * node and replays them in place of each @c YAML_ALIAS_EVENT, so that the
+ * consumer never sees an alias.  The replayed events have no anchors and
+ * carry the marks of the alias.  Nested aliases are recorded as references,
+ * so the recording is linear in the size of the input.
+ *
+ * An alias to an undefined anchor or to a node that is not complete yet is
+ * a composer error, and so is an expansion that exceeds @a max_events
+ * replayed events or @a max_bytes replayed scalar and tag bytes within a
+ * document.  A limit of @c 0 is no limit.
+ *
+ * Default: disabled
+ *
+ * @param[in,out]   parser      A parser object.
+ * @param[in]       expand      If aliases should be expanded.
+ * @param[in]       max_events  The maximum number of replayed events.
+ * @param[in]       max_bytes   The maximum number of replayed bytes.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_expand_aliases(yaml_parser_t *parser, int expand,
+        size_t max_events, size_t max_bytes);
+
+/**
+ * Enable or disable the recovery from syntax errors.
+ *
+ * When enabled, a scanner or parser error does not stop yaml_parser_parse().
+ * The error is appended to the list from @c parser->errors.start to
+ * @c parser->errors.top, the input is skipped to the next line that is not
+ * indented deeper than the innermost block collection, or to the next
+ * document indicator, and parsing continues there.  The events of the nodes
+ * cut off by the error are completed with empty scalars and end events, so
+ * that the event stream stays well-formed and one pass reports every error of
+ * the stream.  yaml_parser_load() builds its documents from the same events.
+ *
+ * If the input has not advanced since the last recovered error, the line
+ * where parsing resumed is skipped as well.  Reader, memory, and composer
+ * errors are not recovered and are reported as usual.
+ *
+ * Default: disabled
+ *
+ * @param[in,out]   parser      A parser object.
+ * @param[in]       recover     If syntax errors should be recovered.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_recover_errors(yaml_parser_t *parser, int recover);
+
 /**
  * Scan the input stream and produce the next token.
  *
@@ -1456,6 +2443,49 @@ yaml_parser_parse(yaml_parser_t *parser, yaml_event_t *event);
 YAML_DECLARE(int)
 yaml_parser_load(yaml_parser_t *parser, yaml_document_t *document);
 
+/** An edit of the input of a document. */
+typedef struct yaml_edit_s {
+    /** The beginning of the replaced range in the old input. */
+    size_t start;
+    /** The end of the replaced range in the old input. */
+    size_t end;
+    /** The length of the replacement in the new input. */
+    size_t length;
+} yaml_edit_t;
+
+/**
+ * Reload a document after its input has been edited.
+ *
+ * The @a document must have been loaded from the input before the edit, and
+ * the @a input must contain a single document.  The range from
+ * @a edit->start to @a edit->end of the old input is replaced with the text
+ * starting at @a edit->start in the new input.  The offsets and the length
+ * are counted in characters, like the index of a mark; for ASCII input they
+ * are byte offsets.
+ *
+ * If the root of the document is a block mapping with all keys in the first
+ * column and the edit is confined to the lines of some of its pairs, only
+ * these lines are parsed again and the resulting pairs replace the old ones.
+ * Otherwise, the whole input is loaded again.  In both cases, the marks of
+ * the nodes refer to the new input and no node is marked as modified.
+ *
+ * The @a parser is used for the options of the loader and for reporting
+ * errors; it must not have an input set.  On error, the document is left
+ * unchanged.
+ *
+ * @param[in,out]   parser      A parser object.
+ * @param[in,out]   document    The document loaded from the old input.
+ * @param[in]       input       The new input.
+ * @param[in]       size        The size of the new input in bytes.
+ * @param[in]       edit        The edit turning the old input into the new.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_parser_reload(yaml_parser_t *parser, yaml_document_t *document,
+        const unsigned char *input, size_t size, const yaml_edit_t *edit);
+
 /**
  * Set the maximum depth of nesting.
  *
@@ -1535,7 +2565,9 @@ typedef enum yaml_emitter_state_e {
     /** Expect a value of a block mapping. */
     YAML_EMIT_BLOCK_MAPPING_VALUE_STATE,
     /** Expect nothing. */
-    YAML_EMIT_END_STATE
+    YAML_EMIT_END_STATE,
+    /** Expect SCALAR-CHUNK or SCALAR-END. */
+    YAML_EMIT_SCALAR_CHUNK_STATE
 } yaml_emitter_state_t;
 
 
@@ -1672,6 +2704,9 @@ typedef struct yaml_emitter_s {
         yaml_event_t *tail;
     } events;
 
+    /** Are all the queued events unchanged parser events? */
+    int parsed;
+
     /** The stack of indentation levels. */
     struct {
         /** The beginning of the stack. */
@@ -1760,6 +2795,14 @@ typedef struct yaml_emitter_s {
         yaml_scalar_style_t style;
     } scalar_data;
 
+    /** The scalar being written in chunks. */
+    struct {
+        /** Is nothing written yet? */
+        int empty;
+        /** Is the last written character a space? */
+        int spaces;
+    } scalar_chunk;
+
     /**
      * @}
      */
@@ -1936,58 +2979,859 @@ YAML_DECLARE(int)
 yaml_emitter_emit(yaml_emitter_t *emitter, yaml_event_t *event);
 
 /**
- * Start a YAML stream.
+ * Emit a borrowed event.
  *
- * This function should be used before yaml_emitter_dump() is called.
+ * Unlike yaml_emitter_emit(), the function does not take the event over:
+ * the application still owns it and may delete it or reuse its strings
+ * afterwards.  An event that can be written right away is not copied; only
+ * the events that the emitter has to hold back, such as the start of a
+ * collection, are copied.
+ *
+ * If @a parsed is set, the event must come unchanged from yaml_parser_parse()
+ * and the collections around it must keep their parsed styles.  A scalar is
+ * then written in its original style without being analyzed again, except
+ * for multi-line values and values with control or, unless Unicode is
+ * allowed, non-ASCII characters.
  *
  * @param[in,out]   emitter     An emitter object.
+ * @param[in]       event       A borrowed event object.
+ * @param[in]       parsed      If the event comes unchanged from the parser.
  *
  * @returns @c 1 if the function succeeded, @c 0 on error.
  */
 
 YAML_DECLARE(int)
-yaml_emitter_open(yaml_emitter_t *emitter);
+yaml_emitter_emit_borrowed(yaml_emitter_t *emitter,
+        const yaml_event_t *event, int parsed);
 
 /**
- * Finish a YAML stream.
+ * Emit an integer scalar.
  *
- * This function should be used after yaml_emitter_dump() is called.
+ * The value is written as a plain scalar without a tag.  Unlike
+ * yaml_emitter_emit(), the function does not allocate an event and does not
+ * analyze the scalar.
  *
  * @param[in,out]   emitter     An emitter object.
+ * @param[in]       value       The integer value.
  *
  * @returns @c 1 if the function succeeded, @c 0 on error.
  */
 
 YAML_DECLARE(int)
-yaml_emitter_close(yaml_emitter_t *emitter);
+yaml_emitter_emit_int64(yaml_emitter_t *emitter, int64_t value);
 
 /**
- * Emit a YAML document.
+ * Emit a floating point scalar.
  *
- * The document object may be generated using the yaml_parser_load() function
- * or the yaml_document_initialize() function.  The emitter takes the
- * responsibility for the document object and destroys its content after
- * it is emitted. The document object is destroyed even if the function fails.
+ * The value is written using the shortest representation that is read back
+ * as the same value, e.g. @c 0.1, @c 1.0e+100, @c .inf, or @c .nan.
  *
  * @param[in,out]   emitter     An emitter object.
- * @param[in,out]   document    A document object.
+ * @param[in]       value       The floating point value.
  *
  * @returns @c 1 if the function succeeded, @c 0 on error.
  */
 
 YAML_DECLARE(int)
-yaml_emitter_dump(yaml_emitter_t *emitter, yaml_document_t *document);
+yaml_emitter_emit_double(yaml_emitter_t *emitter, double value);
 
 /**
- * Flush the accumulated characters to the output.
+ * Emit a boolean scalar (@c true or @c false).
  *
  * @param[in,out]   emitter     An emitter object.
+ * @param[in]       value       The boolean value.
  *
  * @returns @c 1 if the function succeeded, @c 0 on error.
  */
 
 YAML_DECLARE(int)
-yaml_emitter_flush(yaml_emitter_t *emitter);
+yaml_emitter_emit_bool(yaml_emitter_t *emitter, int value);
+
+/**
+ * Emit a null scalar (@c null).
+ *
+ * @param[in,out]   emitter     An emitter object.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_emitter_emit_null(yaml_emitter_t *emitter);
+
+/**
+ * Start a YAML stream.
+ *
+ * This function should be used before yaml_emitter_dump() is called.
+ *
+ * @param[in,out]   emitter     An emitter object.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_emitter_open(yaml_emitter_t *emitter);
+
+/**
+ * Finish a YAML stream.
+ *
+ * This function should be used after yaml_emitter_dump() is called.
+ *
+ * @param[in,out]   emitter     An emitter object.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_emitter_close(yaml_emitter_t *emitter);
+
+/**
+ * Emit a YAML document.
+ *
+ * The document object may be generated using the yaml_parser_load() function
+ * or the yaml_document_initialize() function.  The emitter takes the
+ * responsibility for the document object and destroys its content after
+ * it is emitted. The document object is destroyed even if the function fails.
+ *
+ * @param[in,out]   emitter     An emitter object.
+ * @param[in,out]   document    A document object.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_emitter_dump(yaml_emitter_t *emitter, yaml_document_t *document);
+
+/**
+ * Emit an edited YAML document by copying its unchanged text.
+ *
+ * The @a document must have been loaded from the UTF-8 @a input with exact
+ * source spans (see yaml_parser_set_source_spans()) and without merging or
+ * deduplication.  The input is written as is, except for the nodes marked as
+ * modified: a modified scalar or flow collection is emitted in place in the
+ * flow context, and a modified block collection is emitted entry by entry,
+ * with the entries kept from the input copied together with the comments
+ * between them.  Unchanged text is written without being parsed or
+ * analyzed, so the work beyond copying depends only on the size of the
+ * changes.  If the root node has been replaced, the whole document is
+ * emitted instead.
+ *
+ * The emitter must not be opened; it is closed after the call.  Unlike
+ * yaml_emitter_dump(), the function leaves the document intact.
+ *
+ * @param[in,out]   emitter     An emitter object.
+ * @param[in,out]   document    The edited document.
+ * @param[in]       input       The input the document was loaded from.
+ * @param[in]       size        The size of the input in bytes.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_emitter_dump_edited(yaml_emitter_t *emitter, yaml_document_t *document,
+        const unsigned char *input, size_t size);
+
+/**
+ * Flush the accumulated characters to the output.
+ *
+ * @param[in,out]   emitter     An emitter object.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_emitter_flush(yaml_emitter_t *emitter);
+
+/** @} */
+
+/**
+ * @defgroup iterator Document Iterator
+ * @{
+ */
+
+/** A frame of the document iterator. */
+typedef struct yaml_document_iter_frame_s {
+    /** The collection node id. */
+    int node;
+    /** The number of visited children. */
+    int position;
+} yaml_document_iter_frame_t;
+
+/**
+ * The document iterator structure.
+ *
+ * All members are internal.  Manage the structure using the
+ * @c yaml_document_iter_ family of functions.
+ */
+
+typedef struct yaml_document_iter_s {
+
+    /** The iterated document. */
+    yaml_document_t *document;
+
+    /** The current state. */
+    int state;
+
+    /** The anchors of the nodes. */
+    yaml_anchors_t *anchors;
+
+    /** The open collections. */
+    struct {
+        /** The beginning of the stack. */
+        yaml_document_iter_frame_t *start;
+        /** The end of the stack. */
+        yaml_document_iter_frame_t *end;
+        /** The top of the stack. */
+        yaml_document_iter_frame_t *top;
+    } frames;
+
+    /** The anchor of the last produced event. */
+    yaml_char_t anchor[16];
+
+    /** The base64 text of the last produced binary scalar. */
+    yaml_char_t *text;
+
+} yaml_document_iter_t;
+
+/**
+ * Initialize a document iterator.
+ *
+ * The iterator produces the events that yaml_emitter_dump() would emit for
+ * the document, except that the document is left intact.  Nodes referenced
+ * more than once are anchored on their first occurrence and produced as
+ * aliases afterwards.  The document must not be modified while the iterator
+ * is in use.
+ *
+ * @param[out]      iter        An empty iterator object.
+ * @param[in]       document    A document object.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_document_iter_initialize(yaml_document_iter_t *iter,
+        yaml_document_t *document);
+
+/**
+ * Destroy a document iterator.
+ *
+ * @param[in,out]   iter        An iterator object.
+ */
+
+YAML_DECLARE(void)
+yaml_document_iter_delete(yaml_document_iter_t *iter);
+
+/**
+ * Produce the next event of a document.
+ *
+ * The events are produced in the order DOCUMENT-START, the nodes in the
+ * depth-first order, DOCUMENT-END.  After that, or if the document is empty,
+ * the function produces an event of the type @c YAML_NO_EVENT.
+ *
+ * The event is borrowed: its tags, values and directives point into the
+ * document, and its anchor points into the iterator and stays valid until
+ * the next call.  So does the base64 text produced for a decoded binary
+ * scalar.  The event must not be passed to yaml_event_delete() or
+ * to yaml_emitter_emit(); use yaml_emitter_emit_borrowed() to emit it.
+ *
+ * @param[in,out]   iter        An iterator object.
+ * @param[out]      event       An empty event object.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_document_iter_next(yaml_document_iter_t *iter, yaml_event_t *event);
+
+/** @} */
+
+/**
+ * @defgroup eventlog Event Logs
+ * @{
+ */
+
+/** Event log flags. */
+typedef enum yaml_event_log_flag_e {
+    /** Record the marks of the events. */
+    YAML_EVENT_LOG_MARKS = 1
+} yaml_event_log_flag_t;
+
+/**
+ * This structure holds a string interned by an event log.
+ */
+
+typedef struct yaml_event_log_string_s {
+    /** The string. */
+    const yaml_char_t *string;
+    /** The length of the string. */
+    size_t length;
+    /** The hash of the string. */
+    size_t hash;
+    /** The string number, starting from @c 1. */
+    size_t id;
+} yaml_event_log_string_t;
+
+/**
+ * The event log writer structure.
+ *
+ * All members are internal.  Manage the structure using the
+ * @c yaml_event_log_writer_ family of functions.
+ */
+
+typedef struct yaml_event_log_writer_s {
+
+    /** Error type. */
+    yaml_error_type_t error;
+    /** Error description. */
+    const char *problem;
+
+    /** Write handler. */
+    yaml_write_handler_t *write_handler;
+
+    /** A pointer for passing to the write handler. */
+    void *write_handler_data;
+
+    /** String output data. */
+    struct {
+        /** The buffer pointer. */
+        unsigned char *buffer;
+        /** The buffer size. */
+        size_t size;
+        /** The number of written bytes. */
+        size_t *size_written;
+    } output;
+
+    /** The log flags. */
+    int flags;
+
+    /** Is the header written? */
+    int started;
+
+    /** The output buffer. */
+    struct {
+        /** The beginning of the buffer. */
+        yaml_char_t *start;
+        /** The end of the buffer. */
+        yaml_char_t *end;
+        /** The current position of the buffer. */
+        yaml_char_t *pointer;
+    } buffer;
+
+    /** The interned tags, anchors and directives. */
+    struct {
+        /** The hash table. */
+        yaml_event_log_string_t *entries;
+        /** The number of slots. */
+        size_t capacity;
+        /** The number of strings. */
+        size_t count;
+    } strings;
+
+} yaml_event_log_writer_t;
+
+/**
+ * Initialize an event log writer.
+ *
+ * The writer records events in a compact binary format that
+ * yaml_event_log_read() replays without scanning.  Lengths and numbers are
+ * stored as varints, and tags, anchors, and directives are stored once and
+ * referenced afterwards.
+ *
+ * @param[out]      writer      An empty writer object.
+ * @param[in]       flags       A combination of @c yaml_event_log_flag_t.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_event_log_writer_initialize(yaml_event_log_writer_t *writer, int flags);
+
+/**
+ * Destroy an event log writer.
+ *
+ * @param[in,out]   writer      A writer object.
+ */
+
+YAML_DECLARE(void)
+yaml_event_log_writer_delete(yaml_event_log_writer_t *writer);
+
+/**
+ * Set a string output.
+ *
+ * If the buffer is smaller than required, the writer produces the
+ * YAML_WRITER_ERROR error.
+ *
+ * @param[in,out]   writer          A writer object.
+ * @param[in]       output          An output buffer.
+ * @param[in]       size            The buffer size.
+ * @param[in]       size_written    The pointer to save the number of written
+ *                                  bytes.
+ */
+
+YAML_DECLARE(void)
+yaml_event_log_writer_set_output_string(yaml_event_log_writer_t *writer,
+        unsigned char *output, size_t size, size_t *size_written);
+
+/**
+ * Set a generic output handler.
+ *
+ * @param[in,out]   writer      A writer object.
+ * @param[in]       handler     A write handler.
+ * @param[in]       data        Any application data for passing to the write
+ *                              handler.
+ */
+
+YAML_DECLARE(void)
+yaml_event_log_writer_set_output(yaml_event_log_writer_t *writer,
+        yaml_write_handler_t *handler, void *data);
+
+/**
+ * Record an event.
+ *
+ * The event is not consumed; the application is still responsible for
+ * freeing it.  The output is flushed after the STREAM-END event.
+ *
+ * @param[in,out]   writer      A writer object.
+ * @param[in]       event       An event object.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_event_log_write(yaml_event_log_writer_t *writer,
+        const yaml_event_t *event);
+
+/**
+ * Flush the recorded events to the output.
+ *
+ * @param[in,out]   writer      A writer object.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_event_log_writer_flush(yaml_event_log_writer_t *writer);
+
+/**
+ * The event log reader structure.
+ *
+ * All members are internal.  Manage the structure using the
+ * @c yaml_event_log_reader_ family of functions.
+ */
+
+typedef struct yaml_event_log_reader_s {
+
+    /** Error type. */
+    yaml_error_type_t error;
+    /** Error description. */
+    const char *problem;
+    /** The byte about which the problem occurred. */
+    size_t problem_offset;
+
+    /** The beginning of the log. */
+    const unsigned char *start;
+    /** The end of the log. */
+    const unsigned char *end;
+    /** The next record. */
+    const unsigned char *pointer;
+
+    /** The log flags. */
+    int flags;
+
+    /** Has the STREAM-END event been produced? */
+    int stream_end_produced;
+
+    /** The interned strings read so far. */
+    struct {
+        /** The beginning of the list. */
+        yaml_event_log_string_t *start;
+        /** The end of the list. */
+        yaml_event_log_string_t *end;
+        /** The top of the list. */
+        yaml_event_log_string_t *top;
+    } strings;
+
+} yaml_event_log_reader_t;
+
+/**
+ * Initialize an event log reader.
+ *
+ * Note that the @a input pointer must be valid while the @a reader object
+ * exists.
+ *
+ * @param[out]      reader      An empty reader object.
+ * @param[in]       input       An event log.
+ * @param[in]       size        The length of the log in bytes.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 if the log header is
+ * invalid or on memory error.
+ */
+
+YAML_DECLARE(int)
+yaml_event_log_reader_initialize(yaml_event_log_reader_t *reader,
+        const unsigned char *input, size_t size);
+
+/**
+ * Destroy an event log reader.
+ *
+ * @param[in,out]   reader      A reader object.
+ */
+
+YAML_DECLARE(void)
+yaml_event_log_reader_delete(yaml_event_log_reader_t *reader);
+
+/**
+ * Replay the next recorded event.
+ *
+ * The function behaves like yaml_parser_parse(): the produced event belongs
+ * to the application, which may pass it to yaml_emitter_emit() or free it
+ * with yaml_event_delete().  The marks are zero unless the log was written
+ * with @c YAML_EVENT_LOG_MARKS.  After the STREAM-END event, the function
+ * produces an event of the type @c YAML_NO_EVENT.  A log that ends before
+ * the STREAM-END event is reported as an error, and so are strings that are
+ * not valid UTF-8 and styles, encodings or flags out of range.
+ *
+ * @param[in,out]   reader      A reader object.
+ * @param[out]      event       An empty event object.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_event_log_read(yaml_event_log_reader_t *reader, yaml_event_t *event);
+
+/** @} */
+
+/**
+ * @defgroup binding Struct Bindings
+ * @{
+ */
+
+/** Field types of a binding schema. */
+typedef enum yaml_field_type_e {
+    /** A string (@c char*), or @c NULL for a null value. */
+    YAML_FIELD_STRING,
+    /** An integer (@c int). */
+    YAML_FIELD_INT,
+    /** A 64-bit integer (@c int64_t). */
+    YAML_FIELD_INT64,
+    /** A floating point number (@c double). */
+    YAML_FIELD_DOUBLE,
+    /** A boolean (@c int). */
+    YAML_FIELD_BOOL,
+    /** A nested structure described by a schema. */
+    YAML_FIELD_STRUCT,
+    /** An array: a pointer to the items and a @c size_t count. */
+    YAML_FIELD_ARRAY
+} yaml_field_type_t;
+
+/** Field flags. */
+typedef enum yaml_field_flag_e {
+    /** The key must be present unless the field has a default value. */
+    YAML_FIELD_REQUIRED = 1
+} yaml_field_flag_t;
+
+/** The forward definition of a binding schema structure. */
+typedef struct yaml_schema_s yaml_schema_t;
+
+/**
+ * This structure describes a field of a structure bound to a mapping.
+ */
+
+typedef struct yaml_field_s {
+    /** The mapping key. */
+    const char *name;
+    /** The field type. */
+    yaml_field_type_t type;
+    /** The offset of the field in the structure. */
+    size_t offset;
+    /** The item type (for @c YAML_FIELD_ARRAY); arrays cannot be nested. */
+    yaml_field_type_t item;
+    /** The offset of the @c size_t item count (for @c YAML_FIELD_ARRAY). */
+    size_t count_offset;
+    /** The schema of the structure or of the array items. */
+    const yaml_schema_t *schema;
+    /** A combination of @c yaml_field_flag_t. */
+    int flags;
+    /** The plain scalar used when the key is missing, or @c NULL. */
+    const char *default_value;
+} yaml_field_t;
+
+/**
+ * This structure describes a structure bound to a mapping.
+ */
+
+struct yaml_schema_s {
+    /** The size of the structure. */
+    size_t size;
+    /** The fields, terminated by a field with a @c NULL name. */
+    const yaml_field_t *fields;
+};
+
+/** A compiled field of a binding. */
+typedef struct yaml_binding_key_s {
+    /** The hash of the key. */
+    size_t hash;
+    /** The length of the key. */
+    size_t length;
+    /** The compiled schema of the structure or the items, or @c -1. */
+    int schema;
+    /** The emitter analysis of the key. */
+    int analysis;
+} yaml_binding_key_t;
+
+/** A compiled schema of a binding. */
+typedef struct yaml_binding_schema_s {
+    /** The schema. */
+    const yaml_schema_t *schema;
+    /** The compiled fields. */
+    yaml_binding_key_t *keys;
+    /** The number of fields. */
+    size_t count;
+    /** The hash table of the field numbers plus one. */
+    int *slots;
+    /** The number of slots. */
+    size_t capacity;
+} yaml_binding_schema_t;
+
+/**
+ * The binding structure.
+ *
+ * All members are internal.  Manage the structure using the
+ * @c yaml_binding_ family of functions.
+ */
+
+typedef struct yaml_binding_s {
+
+    /** Error type. */
+    yaml_error_type_t error;
+
+    /** The compiled schemas; the first one is the root. */
+    struct {
+        /** The beginning of the stack. */
+        yaml_binding_schema_t *start;
+        /** The end of the stack. */
+        yaml_binding_schema_t *end;
+        /** The top of the stack. */
+        yaml_binding_schema_t *top;
+    } schemas;
+
+} yaml_binding_t;
+
+/**
+ * Initialize a binding.
+ *
+ * The schema and the schemas reachable from it are compiled into hash
+ * tables of their keys.  The schemas are not copied and must outlive the
+ * binding.
+ *
+ * @param[out]      binding     An empty binding object.
+ * @param[in]       schema      The schema of the root structure.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_binding_initialize(yaml_binding_t *binding, const yaml_schema_t *schema);
+
+/**
+ * Destroy a binding.
+ *
+ * @param[in,out]   binding     A binding object.
+ */
+
+YAML_DECLARE(void)
+yaml_binding_delete(yaml_binding_t *binding);
+
+/**
+ * Decode the next document of a stream into a structure.
+ *
+ * The events produced by yaml_parser_parse() are stored in the structure as
+ * they arrive, without building a document.  The root node must be a
+ * mapping.  Scalars are converted according to the YAML 1.2 core schema:
+ * quoted scalars and scalars tagged @c !!str are strings and are rejected
+ * by number and boolean fields.  A null value leaves a string @c NULL, an
+ * array empty, and a structure with its default values; a missing
+ * structure gets its default values as well.  Keys missing from the schema
+ * are skipped.
+ * Aliases are an error unless alias expansion is enabled with
+ * yaml_parser_set_expand_aliases().
+ *
+ * The structure is cleared first.  Its strings and arrays are allocated by
+ * the decoder and freed with yaml_binding_free().  On error, they are freed
+ * and the structure is cleared again.  If the stream has no more documents,
+ * the structure is left cleared and @c parser->stream_end_produced is set.
+ *
+ * @param[in]       binding     A binding object.
+ * @param[in,out]   parser      A parser object.
+ * @param[out]      object      The root structure.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_binding_decode(yaml_binding_t *binding, yaml_parser_t *parser,
+        void *object);
+
+/**
+ * Free the strings and arrays of a decoded structure and clear it.
+ *
+ * @param[in]       binding     A binding object.
+ * @param[in,out]   object      The root structure.
+ */
+
+YAML_DECLARE(void)
+yaml_binding_free(yaml_binding_t *binding, void *object);
+
+/**
+ * Encode a structure as a document.
+ *
+ * The structure is written straight to the emitter, without building a
+ * document or copying the values into events.  The keys are analyzed when
+ * the binding is initialized and the numbers are formatted on the stack.
+ * Null strings are written as @c null, and strings that would be read back
+ * as another type are quoted.  The emitter is opened if needed.
+ *
+ * @param[in]       binding     A binding object.
+ * @param[in,out]   emitter     An emitter object.
+ * @param[in]       object      The root structure.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_binding_encode(yaml_binding_t *binding, yaml_emitter_t *emitter,
+        const void *object);
+
+/** @} */
+
+/**
+ * @defgroup cache Document Cache
+ * @{
+ */
+
+/** Document cache options. */
+typedef enum yaml_cache_flag_e {
+    /**
+     * Read and hash the file on every lookup, so that a change that keeps the
+     * size and the modification time of the file is noticed, and a file
+     * rewritten with the same content keeps its document.
+     */
+    YAML_CACHE_HASH_CONTENT = 1
+} yaml_cache_flag_t;
+
+/** The forward definition of a cache entry. */
+typedef struct yaml_cache_entry_s yaml_cache_entry_t;
+
+/**
+ * The document cache structure.
+ *
+ * The cache keeps the documents loaded from files, keyed by the device, the
+ * inode (the volume and the file index on Windows), the modification time,
+ * and the size of the file.  The modification time is compared to the
+ * nanosecond where the system records it; on file systems with a coarser
+ * clock, use @c YAML_CACHE_HASH_CONTENT to catch quick rewrites of the same
+ * size.  The documents are shared between the callers and reference counted;
+ * the least recently used ones are dropped when their total size exceeds the
+ * budget.  A cache may be used by several threads at once.
+ *
+ * All members are internal.  Manage the structure using the
+ * @c yaml_document_cache_ family of functions.
+ */
+
+typedef struct yaml_document_cache_s {
+
+    /** The cache options (a combination of @c yaml_cache_flag_t values). */
+    int flags;
+
+    /** The size of the cached documents that triggers eviction. */
+    size_t budget;
+
+    /** The total size of the cached documents. */
+    size_t size;
+
+    /** The most recently used entry. */
+    yaml_cache_entry_t *head;
+
+    /** The least recently used entry. */
+    yaml_cache_entry_t *tail;
+
+    /** The number of lookups served from the cache. */
+    size_t hits;
+
+    /** The number of lookups that loaded the file. */
+    size_t misses;
+
+    /** The lock protecting the entries. */
+    void *lock;
+
+} yaml_document_cache_t;
+
+/**
+ * Initialize a document cache.
+ *
+ * The size of a document is estimated from its nodes and strings.
+ *
+ * @param[out]      cache       An empty cache object.
+ * @param[in]       budget      The total size of the documents to keep.
+ * @param[in]       flags       A combination of @c yaml_cache_flag_t values.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_document_cache_initialize(yaml_document_cache_t *cache, size_t budget,
+        int flags);
+
+/**
+ * Destroy a document cache.
+ *
+ * All documents obtained from the cache must be released first.
+ *
+ * @param[in,out]   cache       A cache object.
+ */
+
+YAML_DECLARE(void)
+yaml_document_cache_delete(yaml_document_cache_t *cache);
+
+/**
+ * Get the document of a file, loading it if the cached one is missing or
+ * stale.
+ *
+ * A lookup costs a stat() of the file (and a read and a hash with
+ * @c YAML_CACHE_HASH_CONTENT).  On a miss, the whole file is read and loaded
+ * with @a parser, which should be freshly initialized and configured with
+ * the loader options but have no input.  The options are not part of the
+ * key: use a separate cache for each set of options.  The parser is not used
+ * on a hit; it still has to be deleted by the caller.
+ *
+ * The document is shared and must not be modified.  Its node hashes are
+ * computed when it is loaded, so it may be hashed and compared.  Release it
+ * with yaml_document_cache_release(); it stays valid until then even if it
+ * is evicted or replaced by a newer version of the file.
+ *
+ * @param[in,out]   cache       A cache object.
+ * @param[in,out]   parser      A parser object.
+ * @param[in]       path        The path of the file.
+ * @param[out]      document    The cached document.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.  Errors reading
+ * the file are reported as @c YAML_READER_ERROR in @a parser.
+ */
+
+YAML_DECLARE(int)
+yaml_document_cache_load(yaml_document_cache_t *cache, yaml_parser_t *parser,
+        const char *path, const yaml_document_t **document);
+
+/**
+ * Release a document obtained from a document cache.
+ *
+ * @param[in,out]   cache       A cache object.
+ * @param[in]       document    The cached document.
+ */
+
+YAML_DECLARE(void)
+yaml_document_cache_release(yaml_document_cache_t *cache,
+        const yaml_document_t *document);
 
 /** @} */
 
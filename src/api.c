@@ -237,6 +237,13 @@ yaml_parser_delete(yaml_parser_t *parser)
         yaml_free(tag_directive.prefix);
     }
     STACK_DEL(parser, parser->tag_directives);
+    yaml_parser_reset_expansion(parser);
+    STRING_DEL(parser, parser->expansion_arena);
+    STACK_DEL(parser, parser->expansion_anchors);
+    STACK_DEL(parser, parser->expansion_open);
+    STACK_DEL(parser, parser->expansion_frames);
+    STACK_DEL(parser, parser->errors);
+    STACK_DEL(parser, parser->recovery_nodes);
 
     memset(parser, 0, sizeof(yaml_parser_t));
 }
@@ -347,6 +354,117 @@ yaml_parser_set_encoding(yaml_parser_t *parser, yaml_encoding_t encoding)
     parser->encoding = encoding;
 }
 
+/*
+ * Set if the loader should resolve scalar types.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_resolve_scalars(yaml_parser_t *parser, int resolve)
+{
+    assert(parser); /* Non-NULL parser object expected. */
+
+    parser->resolve_scalars = (resolve != 0);
+}
+
+/*
+ * Set if the loader should decode binary scalars.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_decode_binary(yaml_parser_t *parser, int decode)
+{
+    assert(parser); /* Non-NULL parser object expected. */
+
+    parser->decode_binary = (decode != 0);
+}
+
+/*
+ * Set the deduplication mode of the loader.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_dedup(yaml_parser_t *parser, yaml_dedup_mode_t mode)
+{
+    assert(parser); /* Non-NULL parser object expected. */
+
+    parser->dedup = mode;
+}
+
+/*
+ * Set the merge key mode of the loader.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_merge(yaml_parser_t *parser, yaml_merge_mode_t mode)
+{
+    assert(parser); /* Non-NULL parser object expected. */
+
+    parser->merge = mode;
+}
+
+/*
+ * Set exact source spans for the loaded nodes.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_source_spans(yaml_parser_t *parser, int spans)
+{
+    assert(parser); /* Non-NULL parser object expected. */
+
+    parser->source_spans = (spans != 0);
+}
+
+/*
+ * Set the JSON mode of the scanner.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_json(yaml_parser_t *parser, yaml_json_mode_t mode)
+{
+    assert(parser); /* Non-NULL parser object expected. */
+
+    parser->json = mode;
+}
+
+/*
+ * Set the size of the scalar chunks.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_scalar_chunk_size(yaml_parser_t *parser, size_t size)
+{
+    assert(parser); /* Non-NULL parser object expected. */
+
+    parser->scalar_chunk_size = size;
+}
+
+/*
+ * Set the alias expansion of the event parser.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_expand_aliases(yaml_parser_t *parser, int expand,
+        size_t max_events, size_t max_bytes)
+{
+    assert(parser); /* Non-NULL parser object expected. */
+
+    parser->expand_aliases = expand;
+    parser->expansion_max_events = max_events;
+    parser->expansion_max_bytes = max_bytes;
+}
+
+/*
+ * Set the recovery from syntax errors.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_recover_errors(yaml_parser_t *parser, int recover)
+{
+    assert(parser); /* Non-NULL parser object expected. */
+
+    parser->recover_errors = (recover != 0);
+}
+
 /*
  * Create a new emitter object.
  */
@@ -606,6 +724,7 @@ yaml_token_delete(yaml_token_t *token)
             break;
 
         case YAML_SCALAR_TOKEN:
+        case YAML_SCALAR_CHUNK_TOKEN:
             yaml_free(token->data.scalar.value);
             break;
 
@@ -622,7 +741,7 @@ yaml_token_delete(yaml_token_t *token)
  * Check 'reader.c' for more details on UTF-8 encoding.
  */
 
-static int
+YAML_DECLARE(int)
 yaml_check_utf8(const yaml_char_t *start, size_t length)
 {
     const yaml_char_t *end = start+length;
@@ -867,6 +986,91 @@ error:
     return 0;
 }
 
+/*
+ * Create SCALAR-START.
+ */
+
+YAML_DECLARE(int)
+yaml_scalar_start_event_initialize(yaml_event_t *event,
+        const yaml_char_t *anchor, const yaml_char_t *tag,
+        int plain_implicit, int quoted_implicit,
+        yaml_scalar_style_t style)
+{
+    yaml_mark_t mark = { 0, 0, 0 };
+    yaml_char_t *anchor_copy = NULL;
+    yaml_char_t *tag_copy = NULL;
+
+    assert(event);      /* Non-NULL event object is expected. */
+
+    if (anchor) {
+        if (!yaml_check_utf8(anchor, strlen((char *)anchor))) goto error;
+        anchor_copy = yaml_strdup(anchor);
+        if (!anchor_copy) goto error;
+    }
+
+    if (tag) {
+        if (!yaml_check_utf8(tag, strlen((char *)tag))) goto error;
+        tag_copy = yaml_strdup(tag);
+        if (!tag_copy) goto error;
+    }
+
+    SCALAR_START_EVENT_INIT(*event, anchor_copy, tag_copy,
+            plain_implicit, quoted_implicit, style, mark, mark);
+
+    return 1;
+
+error:
+    yaml_free(anchor_copy);
+    yaml_free(tag_copy);
+
+    return 0;
+}
+
+/*
+ * Create SCALAR-CHUNK.
+ */
+
+YAML_DECLARE(int)
+yaml_scalar_chunk_event_initialize(yaml_event_t *event,
+        const yaml_char_t *value, int length)
+{
+    yaml_mark_t mark = { 0, 0, 0 };
+    yaml_char_t *value_copy = NULL;
+
+    assert(event);      /* Non-NULL event object is expected. */
+    assert(value);      /* Non-NULL value is expected. */
+
+    if (length < 0) {
+        length = strlen((char *)value);
+    }
+
+    if (!yaml_check_utf8(value, length)) return 0;
+    value_copy = YAML_MALLOC(length+1);
+    if (!value_copy) return 0;
+    memcpy(value_copy, value, length);
+    value_copy[length] = '\0';
+
+    SCALAR_CHUNK_EVENT_INIT(*event, value_copy, length, mark, mark);
+
+    return 1;
+}
+
+/*
+ * Create SCALAR-END.
+ */
+
+YAML_DECLARE(int)
+yaml_scalar_end_event_initialize(yaml_event_t *event)
+{
+    yaml_mark_t mark = { 0, 0, 0 };
+
+    assert(event);      /* Non-NULL event object is expected. */
+
+    SCALAR_END_EVENT_INIT(*event, mark, mark);
+
+    return 1;
+}
+
 /*
  * Create SEQUENCE-START.
  */
@@ -1006,6 +1210,8 @@ yaml_event_delete(yaml_event_t *event)
             break;
 
         case YAML_SCALAR_EVENT:
+        case YAML_SCALAR_START_EVENT:
+        case YAML_SCALAR_CHUNK_EVENT:
             yaml_free(event->data.scalar.anchor);
             yaml_free(event->data.scalar.tag);
             yaml_free(event->data.scalar.value);
@@ -1128,10 +1334,12 @@ yaml_document_delete(yaml_document_t *document)
 
     while (!STACK_EMPTY(&context, document->nodes)) {
         yaml_node_t node = POP(&context, document->nodes);
-        yaml_free(node.tag);
+        if (!(node.flags & YAML_NODE_SHARED_TAG))
+            yaml_free(node.tag);
         switch (node.type) {
             case YAML_SCALAR_NODE:
-                yaml_free(node.data.scalar.value);
+                if (!(node.flags & YAML_NODE_SHARED_VALUE))
+                    yaml_free(node.data.scalar.value);
                 break;
             case YAML_SEQUENCE_NODE:
                 STACK_DEL(&context, node.data.sequence.items);
@@ -1145,6 +1353,14 @@ yaml_document_delete(yaml_document_t *document)
     }
     STACK_DEL(&context, document->nodes);
 
+    while (!STACK_EMPTY(&context, document->strings)) {
+        yaml_free(POP(&context, document->strings));
+    }
+    STACK_DEL(&context, document->strings);
+
+    yaml_document_drop_hashes(document);
+    yaml_free(document->modified.start);
+
     yaml_free(document->version_directive);
     for (tag_directive = document->tag_directives.start;
             tag_directive != document->tag_directives.end;
@@ -1157,111 +1373,546 @@ yaml_document_delete(yaml_document_t *document)
     memset(document, 0, sizeof(yaml_document_t));
 }
 
-/**
- * Get a document node.
+/*
+ * An entry of the table of distinct tags of the copied nodes.
  */
 
-YAML_DECLARE(yaml_node_t *)
-yaml_document_get_node(yaml_document_t *document, int index)
-{
-    assert(document);   /* Non-NULL document object is expected. */
-
-    if (index > 0 && document->nodes.start + index <= document->nodes.top) {
-        return document->nodes.start + index - 1;
-    }
-    return NULL;
-}
+struct copy_tag {
+    const yaml_char_t *tag;
+    yaml_char_t *copy;
+};
 
-/**
- * Get the root object.
+/*
+ * Find the entry of a tag or the empty entry where it belongs.
  */
 
-YAML_DECLARE(yaml_node_t *)
-yaml_document_get_root_node(yaml_document_t *document)
+static struct copy_tag *
+yaml_document_copy_tag(struct copy_tag *tags, size_t mask,
+        const yaml_char_t *tag)
 {
-    assert(document);   /* Non-NULL document object is expected. */
+    size_t hash = 2166136261u;
+    const yaml_char_t *pointer;
+    struct copy_tag *entry;
 
-    if (document->nodes.top != document->nodes.start) {
-        return document->nodes.start;
+    for (pointer = tag; *pointer; pointer ++) {
+        hash = (hash ^ *pointer) * 16777619u;
     }
-    return NULL;
+
+    for (entry = tags + (hash & mask); entry->tag;
+            entry = tags + ((entry - tags + 1) & mask)) {
+        if (entry->tag == tag || strcmp((char *)entry->tag, (char *)tag) == 0)
+            return entry;
+    }
+
+    return entry;
 }
 
 /*
- * Add a scalar node to a document.
+ * Copy the nodes of the source document listed in @a order into an empty
+ * target document; @a map gives the new id of every listed node.  Without
+ * an order, all nodes are copied in place.
+ *
+ * The tags and the scalar values are stored in a single block of the string
+ * pool of the target, each distinct tag once.
  */
 
-YAML_DECLARE(int)
-yaml_document_add_scalar(yaml_document_t *document,
-        const yaml_char_t *tag, const yaml_char_t *value, int length,
-        yaml_scalar_style_t style)
+static int
+yaml_document_copy_nodes(yaml_document_t *target, yaml_document_t *source,
+        int *order, int *map, int count)
 {
     struct {
         yaml_error_type_t error;
     } context;
-    yaml_mark_t mark = { 0, 0, 0 };
-    yaml_char_t *tag_copy = NULL;
-    yaml_char_t *value_copy = NULL;
-    yaml_node_t node;
-
-    assert(document);   /* Non-NULL document object is expected. */
-    assert(value);      /* Non-NULL value is expected. */
+    struct copy_tag *tags = NULL;
+    struct copy_tag *entry;
+    yaml_char_t *block = NULL;
+    yaml_char_t *pointer;
+    yaml_node_t *node;
+    yaml_node_t *copy;
+    size_t capacity = 1;
+    size_t size = 0;
+    size_t length;
+    int valid_hashes;
+    int index;
+    int k, j;
+
+#define REMAP(id)   (map ? map[(id)-1] : (id))
+
+    yaml_free(target->nodes.start);
+    target->nodes.start = target->nodes.top = target->nodes.end = NULL;
+
+    target->nodes.start = yaml_malloc((count ? count : 1)*sizeof(yaml_node_t));
+    if (!target->nodes.start) goto error;
+    target->nodes.top = target->nodes.start;
+    target->nodes.end = target->nodes.start + (count ? count : 1);
+
+    while (capacity < 2*(size_t)count) {
+        capacity *= 2;
+    }
+    tags = yaml_malloc(capacity*sizeof(*tags));
+    if (!tags) goto error;
+    memset(tags, 0, capacity*sizeof(*tags));
+
+    /* Measure the strings. */
+
+    for (k = 0; k < count; k ++) {
+        node = source->nodes.start + (order ? order[k] : k+1) - 1;
+        entry = yaml_document_copy_tag(tags, capacity-1, node->tag);
+        if (!entry->tag) {
+            entry->tag = node->tag;
+            size += strlen((char *)node->tag) + 1;
+        }
+        if (node->type == YAML_SCALAR_NODE) {
+            size += node->data.scalar.length + 1;
+        }
+    }
 
-    if (!tag) {
-        tag = (yaml_char_t *)YAML_DEFAULT_SCALAR_TAG;
+    if (!STACK_INIT(&context, target->strings, yaml_char_t **)) goto error;
+    block = YAML_MALLOC(size ? size : 1);
+    if (!block) goto error;
+    if (!PUSH(&context, target->strings, block)) {
+        yaml_free(block);
+        goto error;
     }
 
-    if (!yaml_check_utf8(tag, strlen((char *)tag))) goto error;
-    tag_copy = yaml_strdup(tag);
-    if (!tag_copy) goto error;
+    /* Copy the nodes. */
 
-    if (length < 0) {
-        length = strlen((char *)value);
+    pointer = block;
+    for (k = 0; k < count; k ++)
+    {
+        node = source->nodes.start + (order ? order[k] : k+1) - 1;
+        copy = target->nodes.top;
+        *copy = *node;
+        copy->flags = YAML_NODE_SHARED_TAG
+            | (node->flags & YAML_NODE_RESOLVED_TAG);
+
+        entry = yaml_document_copy_tag(tags, capacity-1, node->tag);
+        if (!entry->copy) {
+            length = strlen((char *)node->tag) + 1;
+            memcpy(pointer, node->tag, length);
+            entry->copy = pointer;
+            pointer += length;
+        }
+        copy->tag = entry->copy;
+
+        if (node->type == YAML_SCALAR_NODE) {
+            length = node->data.scalar.length;
+            memcpy(pointer, node->data.scalar.value, length);
+            pointer[length] = '\0';
+            copy->data.scalar.value = pointer;
+            copy->flags |= YAML_NODE_SHARED_VALUE;
+            pointer += length + 1;
+        }
+
+        if (node->type == YAML_SEQUENCE_NODE) {
+            length = node->data.sequence.items.top
+                - node->data.sequence.items.start;
+            copy->data.sequence.items.start =
+                yaml_malloc((length ? length : 1)*sizeof(yaml_node_item_t));
+            if (!copy->data.sequence.items.start) goto error;
+            copy->data.sequence.items.top =
+                copy->data.sequence.items.start + length;
+            copy->data.sequence.items.end =
+                copy->data.sequence.items.start + (length ? length : 1);
+            for (j = 0; j < (int)length; j ++) {
+                copy->data.sequence.items.start[j] =
+                    REMAP(node->data.sequence.items.start[j]);
+            }
+        }
+
+        if (node->type == YAML_MAPPING_NODE) {
+            length = node->data.mapping.pairs.top
+                - node->data.mapping.pairs.start;
+            copy->data.mapping.pairs.start =
+                yaml_malloc((length ? length : 1)*sizeof(yaml_node_pair_t));
+            if (!copy->data.mapping.pairs.start) goto error;
+            copy->data.mapping.pairs.top =
+                copy->data.mapping.pairs.start + length;
+            copy->data.mapping.pairs.end =
+                copy->data.mapping.pairs.start + (length ? length : 1);
+            for (j = 0; j < (int)length; j ++) {
+                copy->data.mapping.pairs.start[j].key =
+                    REMAP(node->data.mapping.pairs.start[j].key);
+                copy->data.mapping.pairs.start[j].value =
+                    REMAP(node->data.mapping.pairs.start[j].value);
+            }
+        }
+
+        target->nodes.top ++;
     }
 
-    if (!yaml_check_utf8(value, length)) goto error;
-    value_copy = YAML_MALLOC(length+1);
-    if (!value_copy) goto error;
-    memcpy(value_copy, value, length);
-    value_copy[length] = '\0';
+    /* The hashes do not depend on the node ids. */
+
+    valid_hashes = (source->hashes.end - source->hashes.start
+            == source->nodes.top - source->nodes.start);
+    if (valid_hashes && count) {
+        target->hashes.start = yaml_malloc(count*sizeof(uint64_t));
+        if (target->hashes.start) {
+            target->hashes.end = target->hashes.start + count;
+            for (k = 0; k < count; k ++) {
+                index = order ? order[k] : k+1;
+                target->hashes.start[k] = source->hashes.start[index-1];
+            }
+        }
+    }
 
-    SCALAR_NODE_INIT(node, tag_copy, value_copy, length, style, mark, mark);
-    if (!PUSH(&context, document->nodes, node)) goto error;
+#undef REMAP
 
-    return document->nodes.top - document->nodes.start;
+    yaml_free(tags);
+
+    return 1;
 
 error:
-    yaml_free(tag_copy);
-    yaml_free(value_copy);
+    yaml_free(tags);
 
     return 0;
 }
 
 /*
- * Add a sequence node to a document.
+ * Initialize a document with the directives and the marks of another one.
  */
 
-YAML_DECLARE(int)
-yaml_document_add_sequence(yaml_document_t *document,
-        const yaml_char_t *tag, yaml_sequence_style_t style)
+static int
+yaml_document_copy_header(yaml_document_t *target, yaml_document_t *source)
 {
-    struct {
-        yaml_error_type_t error;
-    } context;
-    yaml_mark_t mark = { 0, 0, 0 };
-    yaml_char_t *tag_copy = NULL;
-    struct {
-        yaml_node_item_t *start;
-        yaml_node_item_t *end;
-        yaml_node_item_t *top;
-    } items = { NULL, NULL, NULL };
-    yaml_node_t node;
+    if (!yaml_document_initialize(target, source->version_directive,
+                source->tag_directives.start, source->tag_directives.end,
+                source->start_implicit, source->end_implicit))
+        return 0;
 
-    assert(document);   /* Non-NULL document object is expected. */
+    target->start_mark = source->start_mark;
+    target->end_mark = source->end_mark;
 
-    if (!tag) {
-        tag = (yaml_char_t *)YAML_DEFAULT_SEQUENCE_TAG;
-    }
+    return 1;
+}
+
+/*
+ * Copy a document.
+ */
+
+YAML_DECLARE(int)
+yaml_document_copy(yaml_document_t *target, yaml_document_t *source)
+{
+    assert(target);     /* Non-NULL target document object is expected. */
+    assert(source);     /* Non-NULL source document object is expected. */
+
+    if (!yaml_document_copy_header(target, source))
+        return 0;
+
+    if (!yaml_document_copy_nodes(target, source, NULL, NULL,
+                source->nodes.top - source->nodes.start)) {
+        yaml_document_delete(target);
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Copy a subtree of a document into a new document.
+ */
+
+YAML_DECLARE(int)
+yaml_document_extract_subtree(yaml_document_t *target,
+        yaml_document_t *source, int index)
+{
+    struct {
+        yaml_error_type_t error;
+    } context;
+    struct {
+        int *start;
+        int *end;
+        int *top;
+    } stack = { NULL, NULL, NULL };
+    int node_count;
+    int *map = NULL;
+    int *order = NULL;
+    int count = 0;
+    yaml_node_t *node;
+    int k;
+
+    assert(target);     /* Non-NULL target document object is expected. */
+    assert(source);     /* Non-NULL source document object is expected. */
+    assert(index > 0 && source->nodes.start + index <= source->nodes.top);
+                        /* Valid node id is required. */
+
+    if (!yaml_document_copy_header(target, source))
+        return 0;
+
+    node_count = source->nodes.top - source->nodes.start;
+    map = yaml_malloc(node_count*sizeof(int));
+    order = yaml_malloc(node_count*sizeof(int));
+    if (!map || !order) goto error;
+    memset(map, 0, node_count*sizeof(int));
+
+    /* Number the reachable nodes in the order they would be loaded. */
+
+    if (!STACK_INIT(&context, stack, int*)) goto error;
+    if (!PUSH(&context, stack, index)) goto error;
+
+    while (!STACK_EMPTY(&context, stack))
+    {
+        index = POP(&context, stack);
+        if (map[index-1])
+            continue;
+
+        order[count++] = index;
+        map[index-1] = count;
+
+        node = source->nodes.start + index - 1;
+        if (node->type == YAML_SEQUENCE_NODE) {
+            for (k = node->data.sequence.items.top
+                    - node->data.sequence.items.start - 1; k >= 0; k --) {
+                if (!PUSH(&context, stack,
+                            node->data.sequence.items.start[k]))
+                    goto error;
+            }
+        }
+        if (node->type == YAML_MAPPING_NODE) {
+            for (k = node->data.mapping.pairs.top
+                    - node->data.mapping.pairs.start - 1; k >= 0; k --) {
+                if (!PUSH(&context, stack,
+                            node->data.mapping.pairs.start[k].value)
+                        || !PUSH(&context, stack,
+                            node->data.mapping.pairs.start[k].key))
+                    goto error;
+            }
+        }
+    }
+
+    if (!yaml_document_copy_nodes(target, source, order, map, count))
+        goto error;
+
+    STACK_DEL(&context, stack);
+    yaml_free(map);
+    yaml_free(order);
+
+    return 1;
+
+error:
+    STACK_DEL(&context, stack);
+    yaml_free(map);
+    yaml_free(order);
+    yaml_document_delete(target);
+
+    return 0;
+}
+
+/**
+ * Get a document node.
+ */
+
+YAML_DECLARE(yaml_node_t *)
+yaml_document_get_node(yaml_document_t *document, int index)
+{
+    assert(document);   /* Non-NULL document object is expected. */
+
+    if (index > 0 && document->nodes.start + index <= document->nodes.top) {
+        return document->nodes.start + index - 1;
+    }
+    return NULL;
+}
+
+/**
+ * Get the root object.
+ */
+
+YAML_DECLARE(yaml_node_t *)
+yaml_document_get_root_node(yaml_document_t *document)
+{
+    assert(document);   /* Non-NULL document object is expected. */
+
+    if (document->nodes.top != document->nodes.start) {
+        return document->nodes.start;
+    }
+    return NULL;
+}
+
+/*
+ * Check if a node is a merge key.
+ */
+
+YAML_DECLARE(int)
+yaml_document_is_merge_key(yaml_node_t *node)
+{
+    if (node->type != YAML_SCALAR_NODE || node->data.scalar.length != 2
+            || memcmp(node->data.scalar.value, "<<", 2) != 0)
+        return 0;
+
+    if (strcmp((char *)node->tag, YAML_MERGE_TAG) == 0)
+        return 1;
+
+    return (node->data.scalar.style == YAML_PLAIN_SCALAR_STYLE
+            && strcmp((char *)node->tag, YAML_STR_TAG) == 0);
+}
+
+/*
+ * Find the value of a scalar key in a mapping, following merge keys.
+ */
+
+YAML_DECLARE(int)
+yaml_document_get_mapping_value(yaml_document_t *document, int mapping,
+        const yaml_char_t *key, size_t length)
+{
+    struct {
+        yaml_error_type_t error;
+    } context;
+    struct {
+        int *start;
+        int *end;
+        int *top;
+    } pending = { NULL, NULL, NULL }, visited = { NULL, NULL, NULL };
+    int value = 0;
+
+    assert(document);   /* Non-NULL document is required. */
+    assert(key);        /* Non-NULL key is required. */
+
+    if (mapping <= 0 || document->nodes.start + mapping > document->nodes.top)
+        return 0;
+
+    if (!STACK_INIT(&context, pending, int*)) goto done;
+    if (!STACK_INIT(&context, visited, int*)) goto done;
+    if (!PUSH(&context, pending, mapping)) goto done;
+
+    /*
+     * Search the mappings depth-first: the explicit keys of a mapping, then
+     * the mappings it merges in order.  A mapping merged through several
+     * paths is searched once.
+     */
+
+    while (!value && !STACK_EMPTY(&context, pending))
+    {
+        int index = POP(&context, pending);
+        yaml_node_t *node = document->nodes.start + index - 1;
+        yaml_node_pair_t *pair;
+        int *seen;
+
+        if (node->type != YAML_MAPPING_NODE)
+            continue;
+
+        for (seen = visited.start; seen != visited.top; seen ++) {
+            if (*seen == index) break;
+        }
+        if (seen != visited.top)
+            continue;
+        if (!PUSH(&context, visited, index)) goto done;
+
+        for (pair = node->data.mapping.pairs.start;
+                pair < node->data.mapping.pairs.top; pair ++) {
+            yaml_node_t *key_node = document->nodes.start + pair->key - 1;
+            if (key_node->type == YAML_SCALAR_NODE
+                    && key_node->data.scalar.length == length
+                    && memcmp(key_node->data.scalar.value, key, length) == 0
+                    && !yaml_document_is_merge_key(key_node)) {
+                value = pair->value;
+                break;
+            }
+        }
+
+        if (value)
+            break;
+
+        for (pair = node->data.mapping.pairs.top;
+                pair > node->data.mapping.pairs.start; pair --) {
+            yaml_node_t *source = document->nodes.start + pair[-1].value - 1;
+            yaml_node_item_t *item;
+            if (!yaml_document_is_merge_key(
+                        document->nodes.start + pair[-1].key - 1))
+                continue;
+            if (source->type != YAML_SEQUENCE_NODE) {
+                if (!PUSH(&context, pending, pair[-1].value)) goto done;
+                continue;
+            }
+            for (item = source->data.sequence.items.top;
+                    item > source->data.sequence.items.start; item --) {
+                if (!PUSH(&context, pending, item[-1])) goto done;
+            }
+        }
+    }
+
+done:
+
+    STACK_DEL(&context, pending);
+    STACK_DEL(&context, visited);
+
+    return value;
+}
+
+/*
+ * Add a scalar node to a document.
+ */
+
+YAML_DECLARE(int)
+yaml_document_add_scalar(yaml_document_t *document,
+        const yaml_char_t *tag, const yaml_char_t *value, int length,
+        yaml_scalar_style_t style)
+{
+    struct {
+        yaml_error_type_t error;
+    } context;
+    yaml_mark_t mark = { 0, 0, 0 };
+    yaml_char_t *tag_copy = NULL;
+    yaml_char_t *value_copy = NULL;
+    yaml_node_t node;
+
+    assert(document);   /* Non-NULL document object is expected. */
+    assert(value);      /* Non-NULL value is expected. */
+
+    if (!tag) {
+        tag = (yaml_char_t *)YAML_DEFAULT_SCALAR_TAG;
+    }
+
+    if (!yaml_check_utf8(tag, strlen((char *)tag))) goto error;
+    tag_copy = yaml_strdup(tag);
+    if (!tag_copy) goto error;
+
+    if (length < 0) {
+        length = strlen((char *)value);
+    }
+
+    if (!yaml_check_utf8(value, length)) goto error;
+    value_copy = YAML_MALLOC(length+1);
+    if (!value_copy) goto error;
+    memcpy(value_copy, value, length);
+    value_copy[length] = '\0';
+
+    SCALAR_NODE_INIT(node, tag_copy, value_copy, length, style, mark, mark);
+    if (!PUSH(&context, document->nodes, node)) goto error;
+
+    return document->nodes.top - document->nodes.start;
+
+error:
+    yaml_free(tag_copy);
+    yaml_free(value_copy);
+
+    return 0;
+}
+
+/*
+ * Add a sequence node to a document.
+ */
+
+YAML_DECLARE(int)
+yaml_document_add_sequence(yaml_document_t *document,
+        const yaml_char_t *tag, yaml_sequence_style_t style)
+{
+    struct {
+        yaml_error_type_t error;
+    } context;
+    yaml_mark_t mark = { 0, 0, 0 };
+    yaml_char_t *tag_copy = NULL;
+    struct {
+        yaml_node_item_t *start;
+        yaml_node_item_t *end;
+        yaml_node_item_t *top;
+    } items = { NULL, NULL, NULL };
+    yaml_node_t node;
+
+    assert(document);   /* Non-NULL document object is expected. */
+
+    if (!tag) {
+        tag = (yaml_char_t *)YAML_DEFAULT_SEQUENCE_TAG;
+    }
 
     if (!yaml_check_utf8(tag, strlen((char *)tag))) goto error;
     tag_copy = yaml_strdup(tag);
@@ -1352,7 +2003,9 @@ yaml_document_append_sequence_item(yaml_document_t *document,
                 document->nodes.start[sequence-1].data.sequence.items, item))
         return 0;
 
-    return 1;
+    yaml_document_drop_hashes(document);
+
+    return yaml_document_touch_node(document, sequence);
 }
 
 /*
@@ -1387,7 +2040,380 @@ yaml_document_append_mapping_pair(yaml_document_t *document,
                 document->nodes.start[mapping-1].data.mapping.pairs, pair))
         return 0;
 
+    yaml_document_drop_hashes(document);
+
+    return yaml_document_touch_node(document, mapping);
+}
+
+/*
+ * Replace the value of a scalar node.
+ */
+
+YAML_DECLARE(int)
+yaml_document_set_scalar(yaml_document_t *document, int index,
+        const yaml_char_t *value, int length)
+{
+    yaml_node_t *node;
+    yaml_char_t *value_copy;
+    yaml_char_t *tag_copy = NULL;
+    yaml_scalar_type_t type;
+    yaml_resolved_value_t resolved;
+
+    assert(document);       /* Non-NULL document is required. */
+    assert(index > 0
+            && document->nodes.start + index <= document->nodes.top);
+                            /* Valid node id is required. */
+    assert(document->nodes.start[index-1].type == YAML_SCALAR_NODE);
+                            /* A scalar node is required. */
+    assert(value);          /* Non-NULL value is expected. */
+
+    node = document->nodes.start + index - 1;
+
+    if (length < 0) {
+        length = strlen((char *)value);
+    }
+
+    /* Resolve the new value the way the loader resolved the old one. */
+
+    type = node->resolved.type;
+    if (type == YAML_BINARY_SCALAR_TYPE) {
+        resolved = node->resolved.value;
+    }
+    else if (!yaml_check_utf8(value, length)) {
+        return 0;
+    }
+    else if (type != YAML_UNRESOLVED_SCALAR_TYPE) {
+        int implicit = (node->flags & YAML_NODE_RESOLVED_TAG) != 0;
+        if (implicit) {
+            type = YAML_UNRESOLVED_SCALAR_TYPE;
+        }
+        if (!yaml_resolve_scalar(value, length, &type, &resolved))
+            return 0;
+        if (implicit && type != node->resolved.type) {
+            tag_copy = yaml_strdup((yaml_char_t *)yaml_resolved_tag(type));
+            if (!tag_copy) return 0;
+        }
+    }
+
+    value_copy = YAML_MALLOC(length+1);
+    if (!value_copy) {
+        yaml_free(tag_copy);
+        return 0;
+    }
+    memcpy(value_copy, value, length);
+    value_copy[length] = '\0';
+
+    if (!yaml_document_touch_node(document, index)) {
+        yaml_free(tag_copy);
+        yaml_free(value_copy);
+        return 0;
+    }
+
+    if (tag_copy) {
+        if (!(node->flags & YAML_NODE_SHARED_TAG))
+            yaml_free(node->tag);
+        node->tag = tag_copy;
+        node->flags &= ~YAML_NODE_SHARED_TAG;
+    }
+
+    if (!(node->flags & YAML_NODE_SHARED_VALUE))
+        yaml_free(node->data.scalar.value);
+    node->data.scalar.value = value_copy;
+    node->data.scalar.length = length;
+    node->resolved.type = type;
+    if (type != YAML_UNRESOLVED_SCALAR_TYPE) {
+        node->resolved.value = resolved;
+    }
+    node->flags &= ~YAML_NODE_SHARED_VALUE;
+
+    yaml_document_drop_hashes(document);
+
+    return 1;
+}
+
+/*
+ * Mark a node as modified.
+ */
+
+YAML_DECLARE(int)
+yaml_document_touch_node(yaml_document_t *document, int index)
+{
+    struct {
+        yaml_error_type_t error;
+    } context;
+    yaml_node_t *node = document->nodes.start + index - 1;
+
+    if (node->flags & YAML_NODE_MODIFIED)
+        return 1;
+
+    if (!document->modified.start) {
+        if (!STACK_INIT(&context, document->modified, int*))
+            return 0;
+    }
+
+    if (!PUSH(&context, document->modified, index))
+        return 0;
+
+    node->flags |= YAML_NODE_MODIFIED;
+
+    return 1;
+}
+
+/*
+ * Forget the modifications of the nodes.
+ */
+
+YAML_DECLARE(void)
+yaml_document_clear_modified(yaml_document_t *document)
+{
+    int *index;
+
+    for (index = document->modified.start;
+            index < document->modified.top; index ++) {
+        document->nodes.start[*index-1].flags &= ~YAML_NODE_MODIFIED;
+    }
+
+    document->modified.top = document->modified.start;
+}
+
+/*
+ * Make room for a number of entries above the top of a stack.
+ */
+
+static int
+yaml_stack_reserve(void **start, void **top, void **end, size_t size)
+{
+    size_t used = (char *)*top - (char *)*start;
+    void *new_start;
+
+    if ((size_t)((char *)*end - (char *)*top) >= size)
+        return 1;
+
+    if (size >= INT_MAX - used)
+        return 0;
+
+    new_start = yaml_realloc(*start, used + size);
+
+    if (!new_start) return 0;
+
+    *top = (char *)new_start + used;
+    *end = (char *)new_start + used + size;
+    *start = new_start;
+
     return 1;
 }
 
+/*
+ * Reserve space for nodes.
+ */
+
+YAML_DECLARE(int)
+yaml_document_reserve_nodes(yaml_document_t *document, int count)
+{
+    assert(document);   /* Non-NULL document object is expected. */
+    assert(count >= 0); /* Non-negative count is expected. */
+
+    return yaml_stack_reserve((void **)&document->nodes.start,
+            (void **)&document->nodes.top, (void **)&document->nodes.end,
+            count*sizeof(yaml_node_t));
+}
+
+/*
+ * Reserve space for sequence items.
+ */
+
+YAML_DECLARE(int)
+yaml_document_reserve_items(yaml_document_t *document, int sequence,
+        int count)
+{
+    yaml_node_t *node;
+
+    assert(document);       /* Non-NULL document is required. */
+    assert(sequence > 0
+            && document->nodes.start + sequence <= document->nodes.top);
+                            /* Valid sequence id is required. */
+    assert(document->nodes.start[sequence-1].type == YAML_SEQUENCE_NODE);
+                            /* A sequence node is required. */
+    assert(count >= 0);     /* Non-negative count is expected. */
+
+    node = document->nodes.start + sequence - 1;
+
+    return yaml_stack_reserve((void **)&node->data.sequence.items.start,
+            (void **)&node->data.sequence.items.top,
+            (void **)&node->data.sequence.items.end,
+            count*sizeof(yaml_node_item_t));
+}
+
+/*
+ * Reserve space for mapping pairs.
+ */
+
+YAML_DECLARE(int)
+yaml_document_reserve_pairs(yaml_document_t *document, int mapping,
+        int count)
+{
+    yaml_node_t *node;
+
+    assert(document);       /* Non-NULL document is required. */
+    assert(mapping > 0
+            && document->nodes.start + mapping <= document->nodes.top);
+                            /* Valid mapping id is required. */
+    assert(document->nodes.start[mapping-1].type == YAML_MAPPING_NODE);
+                            /* A mapping node is required. */
+    assert(count >= 0);     /* Non-negative count is expected. */
+
+    node = document->nodes.start + mapping - 1;
+
+    return yaml_stack_reserve((void **)&node->data.mapping.pairs.start,
+            (void **)&node->data.mapping.pairs.top,
+            (void **)&node->data.mapping.pairs.end,
+            count*sizeof(yaml_node_pair_t));
+}
+
+/*
+ * Prepare the tag of an adopted node.
+ */
+
+static int
+yaml_document_adopt_tag(yaml_char_t **tag, const char *default_tag,
+        int flags, int *node_flags)
+{
+    *node_flags = 0;
+
+    if (!*tag) {
+        *tag = (yaml_char_t *)default_tag;
+        *node_flags |= YAML_NODE_SHARED_TAG;
+        return 1;
+    }
+
+    if (!(flags & YAML_ADOPT_TRUSTED)
+            && !yaml_check_utf8(*tag, strlen((char *)*tag)))
+        return 0;
+
+    if (flags & YAML_ADOPT_BORROWED) {
+        *node_flags |= YAML_NODE_SHARED_TAG;
+    }
+
+    return 1;
+}
+
+/*
+ * Add a scalar node taking over the strings.
+ */
+
+YAML_DECLARE(int)
+yaml_document_adopt_scalar(yaml_document_t *document,
+        yaml_char_t *tag, yaml_char_t *value, int length,
+        yaml_scalar_style_t style, int flags)
+{
+    struct {
+        yaml_error_type_t error;
+    } context;
+    yaml_mark_t mark = { 0, 0, 0 };
+    yaml_node_t node;
+    int node_flags;
+
+    assert(document);   /* Non-NULL document object is expected. */
+    assert(value);      /* Non-NULL value is expected. */
+
+    if (!yaml_document_adopt_tag(&tag, YAML_DEFAULT_SCALAR_TAG,
+                flags, &node_flags))
+        return 0;
+
+    if (length < 0) {
+        length = strlen((char *)value);
+    }
+
+    if (!(flags & YAML_ADOPT_TRUSTED) && !yaml_check_utf8(value, length))
+        return 0;
+
+    if (flags & YAML_ADOPT_BORROWED) {
+        node_flags |= YAML_NODE_SHARED_VALUE;
+    }
+
+    SCALAR_NODE_INIT(node, tag, value, length, style, mark, mark);
+    node.flags = node_flags;
+    if (!PUSH(&context, document->nodes, node)) return 0;
+
+    return document->nodes.top - document->nodes.start;
+}
+
+/*
+ * Add a sequence node taking over the tag.
+ */
+
+YAML_DECLARE(int)
+yaml_document_adopt_sequence(yaml_document_t *document,
+        yaml_char_t *tag, yaml_sequence_style_t style, int flags)
+{
+    struct {
+        yaml_error_type_t error;
+    } context;
+    yaml_mark_t mark = { 0, 0, 0 };
+    struct {
+        yaml_node_item_t *start;
+        yaml_node_item_t *end;
+        yaml_node_item_t *top;
+    } items = { NULL, NULL, NULL };
+    yaml_node_t node;
+    int node_flags;
+
+    assert(document);   /* Non-NULL document object is expected. */
+
+    if (!yaml_document_adopt_tag(&tag, YAML_DEFAULT_SEQUENCE_TAG,
+                flags, &node_flags))
+        return 0;
+
+    if (!STACK_INIT(&context, items, yaml_node_item_t*)) return 0;
+
+    SEQUENCE_NODE_INIT(node, tag, items.start, items.end,
+            style, mark, mark);
+    node.flags = node_flags;
+    if (!PUSH(&context, document->nodes, node)) {
+        STACK_DEL(&context, items);
+        return 0;
+    }
+
+    return document->nodes.top - document->nodes.start;
+}
+
+/*
+ * Add a mapping node taking over the tag.
+ */
+
+YAML_DECLARE(int)
+yaml_document_adopt_mapping(yaml_document_t *document,
+        yaml_char_t *tag, yaml_mapping_style_t style, int flags)
+{
+    struct {
+        yaml_error_type_t error;
+    } context;
+    yaml_mark_t mark = { 0, 0, 0 };
+    struct {
+        yaml_node_pair_t *start;
+        yaml_node_pair_t *end;
+        yaml_node_pair_t *top;
+    } pairs = { NULL, NULL, NULL };
+    yaml_node_t node;
+    int node_flags;
+
+    assert(document);   /* Non-NULL document object is expected. */
+
+    if (!yaml_document_adopt_tag(&tag, YAML_DEFAULT_MAPPING_TAG,
+                flags, &node_flags))
+        return 0;
+
+    if (!STACK_INIT(&context, pairs, yaml_node_pair_t*)) return 0;
+
+    MAPPING_NODE_INIT(node, tag, pairs.start, pairs.end,
+            style, mark, mark);
+    node.flags = node_flags;
+    if (!PUSH(&context, document->nodes, node)) {
+        STACK_DEL(&context, pairs);
+        return 0;
+    }
+
+    return document->nodes.top - document->nodes.start;
+}
+
 
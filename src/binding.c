@@ -0,0 +1,1095 @@
+
+#include "yaml_private.h"
+
+/*
+ * Struct bindings.
+ *
+ * A binding compiles a schema and the schemas reachable from it into hash
+ * tables of their keys.  The decoder stores the parser events straight into
+ * the bound structures: scalars are converted in place, the values of string
+ * scalars are taken over from the events, and the open mappings and
+ * sequences are kept on a stack of frames.  The encoder walks the structures
+ * and passes borrowed keys and values to the emitter, with the analysis of
+ * the keys done by the binding.
+ */
+
+/*
+ * A frame of an open mapping or sequence.
+ */
+
+struct binding_frame {
+    /* Is the frame a sequence? */
+    int sequence;
+    /* The compiled schema of the mapping or of the sequence items. */
+    int schema;
+    /* The field of the pending value, or of the array being filled. */
+    const yaml_field_t *field;
+    /* The structure of the mapping, or the one holding the array. */
+    char *object;
+    /* The number of allocated items of the array. */
+    size_t capacity;
+    /* The offset of the flags of the seen keys. */
+    size_t seen;
+    /* The beginning of the node. */
+    yaml_mark_t start_mark;
+};
+
+/*
+ * The decoding context.
+ */
+
+struct binding_ctx {
+    struct {
+        struct binding_frame *start;
+        struct binding_frame *end;
+        struct binding_frame *top;
+    } frames;
+    struct {
+        yaml_char_t *start;
+        yaml_char_t *end;
+        yaml_char_t *top;
+    } seen;
+    int skipping;
+    int depth;
+};
+
+/*
+ * Compiling.
+ */
+
+static size_t
+yaml_binding_hash(const yaml_char_t *string, size_t length);
+
+static int
+yaml_binding_add_schema(yaml_binding_t *binding, const yaml_schema_t *schema);
+
+static int
+yaml_binding_compile(yaml_binding_t *binding, int index);
+
+static int
+yaml_binding_find(yaml_binding_schema_t *schema,
+        const yaml_char_t *key, size_t length);
+
+static int
+yaml_binding_analyze(const yaml_char_t *value, size_t length,
+        yaml_emitter_t *emitter);
+
+/*
+ * Decoding.
+ */
+
+static int
+yaml_binding_set_error(yaml_parser_t *parser, const char *context,
+        yaml_mark_t context_mark, const char *problem, yaml_mark_t problem_mark);
+
+static size_t
+yaml_binding_item_size(yaml_binding_t *binding, yaml_field_type_t type,
+        int schema);
+
+static int
+yaml_binding_convert(yaml_parser_t *parser, yaml_field_type_t type,
+        yaml_char_t *value, size_t length, int plain, char *target,
+        const char **problem);
+
+static int
+yaml_binding_store(yaml_parser_t *parser, yaml_binding_t *binding,
+        struct binding_ctx *ctx, yaml_field_type_t type, int schema,
+        const yaml_field_t *field, char *object, char *target,
+        yaml_event_t *event);
+
+static int
+yaml_binding_push_item(yaml_parser_t *parser, yaml_binding_t *binding,
+        struct binding_frame *frame, char **target);
+
+static int
+yaml_binding_finish(yaml_parser_t *parser, yaml_binding_t *binding,
+        int schema, char *object, yaml_char_t *seen,
+        yaml_mark_t start_mark, yaml_mark_t end_mark);
+
+static void
+yaml_binding_free_struct(yaml_binding_t *binding, int schema, char *object);
+
+/*
+ * Encoding.
+ */
+
+static int
+yaml_binding_emit_string(yaml_emitter_t *emitter, const char *value);
+
+static int
+yaml_binding_emit_value(yaml_binding_t *binding, yaml_emitter_t *emitter,
+        yaml_field_type_t type, int schema, const char *target);
+
+static int
+yaml_binding_emit_struct(yaml_binding_t *binding, yaml_emitter_t *emitter,
+        int schema, const char *object);
+
+/*
+ * Hash a key (FNV-1a).
+ */
+
+static size_t
+yaml_binding_hash(const yaml_char_t *string, size_t length)
+{
+    size_t hash = (size_t)0xCBF29CE484222325ULL;
+
+    while (length --) {
+        hash ^= *(string++);
+        hash *= (size_t)0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+/*
+ * Find the compiled schema of a schema or add it to the binding.
+ */
+
+static int
+yaml_binding_add_schema(yaml_binding_t *binding, const yaml_schema_t *schema)
+{
+    yaml_binding_schema_t compiled;
+    yaml_binding_schema_t *pointer;
+
+    for (pointer = binding->schemas.start;
+            pointer != binding->schemas.top; pointer ++) {
+        if (pointer->schema == schema)
+            return (int)(pointer - binding->schemas.start);
+    }
+
+    memset(&compiled, 0, sizeof(compiled));
+    compiled.schema = schema;
+
+    if (!PUSH(binding, binding->schemas, compiled))
+        return -1;
+
+    return (int)(binding->schemas.top - binding->schemas.start) - 1;
+}
+
+/*
+ * Compile the keys of a schema into a hash table.
+ */
+
+static int
+yaml_binding_compile(yaml_binding_t *binding, int index)
+{
+    const yaml_field_t *fields = binding->schemas.start[index].schema->fields;
+    yaml_binding_key_t *keys;
+    int *slots;
+    size_t count = 0;
+    size_t capacity = 4;
+    size_t k;
+
+    while (fields[count].name)
+        count ++;
+    while (capacity < count*2)
+        capacity *= 2;
+
+    keys = (yaml_binding_key_t *)yaml_malloc((count ? count : 1)
+            * sizeof(*keys));
+    slots = (int *)yaml_malloc(capacity*sizeof(*slots));
+    if (!keys || !slots) {
+        yaml_free(keys);
+        yaml_free(slots);
+        binding->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+    memset(slots, 0, capacity*sizeof(*slots));
+
+    binding->schemas.start[index].keys = keys;
+    binding->schemas.start[index].slots = slots;
+    binding->schemas.start[index].count = count;
+    binding->schemas.start[index].capacity = capacity;
+
+    for (k = 0; k < count; k ++) {
+        const yaml_field_t *field = fields + k;
+        size_t length = strlen(field->name);
+        size_t slot;
+
+        /* Only arrays of scalars and structures are supported. */
+
+        assert(field->type != YAML_FIELD_ARRAY
+                || field->item != YAML_FIELD_ARRAY);
+        assert(field->schema
+                || (field->type != YAML_FIELD_STRUCT
+                    && (field->type != YAML_FIELD_ARRAY
+                        || field->item != YAML_FIELD_STRUCT)));
+        assert(!field->default_value || field->type < YAML_FIELD_STRUCT);
+
+        keys[k].hash = yaml_binding_hash((const yaml_char_t *)field->name,
+                length);
+        keys[k].length = length;
+        keys[k].schema = -1;
+        keys[k].analysis = yaml_binding_analyze((const yaml_char_t *)
+                field->name, length, NULL);
+
+        /* The key must be unique. */
+
+        assert(yaml_binding_find(binding->schemas.start+index,
+                    (const yaml_char_t *)field->name, length) < 0);
+
+        slot = keys[k].hash & (capacity-1);
+        while (slots[slot])
+            slot = (slot+1) & (capacity-1);
+        slots[slot] = (int)k+1;
+
+        if (field->schema) {
+            int schema = yaml_binding_add_schema(binding, field->schema);
+            if (schema < 0)
+                return 0;
+            binding->schemas.start[index].keys[k].schema = schema;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * Analyze a key or a string value for the emitter.
+ *
+ * A string that would be resolved to another type is not plain implicit.
+ */
+
+static int
+yaml_binding_analyze(const yaml_char_t *value, size_t length,
+        yaml_emitter_t *emitter)
+{
+    yaml_scalar_type_t type = YAML_UNRESOLVED_SCALAR_TYPE;
+    yaml_resolved_value_t resolved;
+    int analysis = yaml_emitter_analyze_static(emitter, value, length);
+
+    if (yaml_resolve_scalar(value, length, &type, &resolved)
+            && type == YAML_STR_SCALAR_TYPE)
+        analysis |= ANALYSIS_PLAIN_IMPLICIT;
+
+    return analysis;
+}
+
+/*
+ * Initialize a binding.
+ */
+
+YAML_DECLARE(int)
+yaml_binding_initialize(yaml_binding_t *binding, const yaml_schema_t *schema)
+{
+    int index;
+
+    assert(binding);    /* Non-NULL binding object expected. */
+    assert(schema);     /* Non-NULL schema expected. */
+
+    memset(binding, 0, sizeof(yaml_binding_t));
+
+    if (!STACK_INIT(binding, binding->schemas, yaml_binding_schema_t*))
+        goto error;
+
+    if (yaml_binding_add_schema(binding, schema) < 0)
+        goto error;
+
+    /* The stack grows while the reachable schemas are compiled. */
+
+    for (index = 0; binding->schemas.start + index != binding->schemas.top;
+            index ++) {
+        if (!yaml_binding_compile(binding, index))
+            goto error;
+    }
+
+    return 1;
+
+error:
+
+    yaml_binding_delete(binding);
+    binding->error = YAML_MEMORY_ERROR;
+
+    return 0;
+}
+
+/*
+ * Destroy a binding.
+ */
+
+YAML_DECLARE(void)
+yaml_binding_delete(yaml_binding_t *binding)
+{
+    yaml_binding_schema_t *schema;
+
+    assert(binding);    /* Non-NULL binding object expected. */
+
+    for (schema = binding->schemas.start;
+            schema != binding->schemas.top; schema ++) {
+        yaml_free(schema->keys);
+        yaml_free(schema->slots);
+    }
+    STACK_DEL(binding, binding->schemas);
+
+    memset(binding, 0, sizeof(yaml_binding_t));
+}
+
+/*
+ * Find the number of the field with the given key, or -1.
+ */
+
+static int
+yaml_binding_find(yaml_binding_schema_t *schema,
+        const yaml_char_t *key, size_t length)
+{
+    size_t hash = yaml_binding_hash(key, length);
+    size_t slot = hash & (schema->capacity-1);
+
+    while (schema->slots[slot]) {
+        int index = schema->slots[slot]-1;
+        yaml_binding_key_t *compiled = schema->keys + index;
+        if (compiled->hash == hash && compiled->length == length
+                && memcmp(schema->schema->fields[index].name, key, length) == 0)
+            return index;
+        slot = (slot+1) & (schema->capacity-1);
+    }
+
+    return -1;
+}
+
+/*
+ * Set a decoding error.
+ */
+
+static int
+yaml_binding_set_error(yaml_parser_t *parser, const char *context,
+        yaml_mark_t context_mark, const char *problem, yaml_mark_t problem_mark)
+{
+    parser->error = YAML_COMPOSER_ERROR;
+    parser->context = context;
+    parser->context_mark = context_mark;
+    parser->problem = problem;
+    parser->problem_mark = problem_mark;
+
+    return 0;
+}
+
+/*
+ * Get the size of an array item.
+ */
+
+static size_t
+yaml_binding_item_size(yaml_binding_t *binding, yaml_field_type_t type,
+        int schema)
+{
+    switch (type)
+    {
+        case YAML_FIELD_STRING:
+            return sizeof(char *);
+        case YAML_FIELD_INT:
+        case YAML_FIELD_BOOL:
+            return sizeof(int);
+        case YAML_FIELD_INT64:
+            return sizeof(int64_t);
+        case YAML_FIELD_DOUBLE:
+            return sizeof(double);
+        case YAML_FIELD_STRUCT:
+            return binding->schemas.start[schema].schema->size;
+        default:
+            assert(0);      /* Arrays cannot be nested. */
+            return 0;
+    }
+}
+
+/*
+ * Check if a scalar is resolved by the core schema: a plain scalar without
+ * a tag, or any scalar with a core tag other than !!str.
+ */
+
+static int
+yaml_binding_is_plain(yaml_event_t *event)
+{
+    const char *tag = (const char *)event->data.scalar.tag;
+
+    if (!tag)
+        return (event->data.scalar.style == YAML_PLAIN_SCALAR_STYLE);
+
+    return (strcmp(tag, YAML_NULL_TAG) == 0
+            || strcmp(tag, YAML_BOOL_TAG) == 0
+            || strcmp(tag, YAML_INT_TAG) == 0
+            || strcmp(tag, YAML_FLOAT_TAG) == 0);
+}
+
+/*
+ * Convert a scalar and store it in a field.
+ *
+ * A scalar that is not plain is a string.  The value of a string is taken
+ * over; the caller must not free it if the function succeeds.  A conversion
+ * failure sets `*problem` and returns 1.
+ */
+
+static int
+yaml_binding_convert(yaml_parser_t *parser, yaml_field_type_t type,
+        yaml_char_t *value, size_t length, int plain, char *target,
+        const char **problem)
+{
+    yaml_scalar_type_t expected;
+    yaml_resolved_value_t resolved;
+
+    switch (type)
+    {
+        case YAML_FIELD_STRING:
+            expected = YAML_NULL_SCALAR_TYPE;
+            break;
+        case YAML_FIELD_INT:
+        case YAML_FIELD_INT64:
+            expected = YAML_INT_SCALAR_TYPE;
+            break;
+        case YAML_FIELD_DOUBLE:
+            expected = YAML_FLOAT_SCALAR_TYPE;
+            break;
+        case YAML_FIELD_BOOL:
+            expected = YAML_BOOL_SCALAR_TYPE;
+            break;
+        default:
+            assert(0);      /* Collections are not converted. */
+            return 0;
+    }
+
+    if (!plain) {
+        if (type == YAML_FIELD_STRING) {
+            *(char **)target = (char *)value;
+            return 1;
+        }
+        expected = YAML_STR_SCALAR_TYPE;
+    }
+    else if (!yaml_resolve_scalar(value, length, &expected, &resolved)) {
+        parser->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+
+    switch (type)
+    {
+        case YAML_FIELD_STRING:
+            if (expected == YAML_NULL_SCALAR_TYPE) {
+                *(char **)target = NULL;
+                yaml_free(value);
+            }
+            else {
+                *(char **)target = (char *)value;
+            }
+            return 1;
+
+        case YAML_FIELD_INT:
+            if (expected != YAML_INT_SCALAR_TYPE)
+                break;
+            if (resolved.integer < INT_MIN || resolved.integer > INT_MAX) {
+                *problem = "found an integer out of range";
+                return 1;
+            }
+            *(int *)target = (int)resolved.integer;
+            return 1;
+
+        case YAML_FIELD_INT64:
+            if (expected != YAML_INT_SCALAR_TYPE)
+                break;
+            *(int64_t *)target = resolved.integer;
+            return 1;
+
+        case YAML_FIELD_DOUBLE:
+            if (expected != YAML_FLOAT_SCALAR_TYPE)
+                break;
+            *(double *)target = resolved.real;
+            return 1;
+
+        case YAML_FIELD_BOOL:
+            if (expected != YAML_BOOL_SCALAR_TYPE)
+                break;
+            *(int *)target = resolved.boolean;
+            return 1;
+
+        default:
+            break;
+    }
+
+    *problem = (type == YAML_FIELD_DOUBLE) ? "expected a number"
+        : (type == YAML_FIELD_BOOL) ? "expected a boolean"
+        : "expected an integer";
+
+    return 1;
+}
+
+/*
+ * Store a node in a field or an array item.
+ *
+ * Scalars are stored right away.  For a mapping or a sequence, a frame is
+ * pushed and the following events fill it.
+ */
+
+static int
+yaml_binding_store(yaml_parser_t *parser, yaml_binding_t *binding,
+        struct binding_ctx *ctx, yaml_field_type_t type, int schema,
+        const yaml_field_t *field, char *object, char *target,
+        yaml_event_t *event)
+{
+    struct binding_frame frame;
+    const char *problem = NULL;
+
+    switch (event->type)
+    {
+        case YAML_SCALAR_EVENT:
+        {
+            int plain = yaml_binding_is_plain(event);
+            yaml_scalar_type_t null = YAML_NULL_SCALAR_TYPE;
+            yaml_resolved_value_t resolved;
+
+            if (type < YAML_FIELD_STRUCT) {
+                if (!yaml_binding_convert(parser, type,
+                            event->data.scalar.value, event->data.scalar.length,
+                            plain, target, &problem))
+                    return 0;
+                if (!problem) {
+                    if (type == YAML_FIELD_STRING)
+                        event->data.scalar.value = NULL;
+                    return 1;
+                }
+                break;
+            }
+
+            /* A null collection keeps its default values. */
+
+            if (plain && !yaml_resolve_scalar(event->data.scalar.value,
+                        event->data.scalar.length, &null, &resolved)) {
+                parser->error = YAML_MEMORY_ERROR;
+                return 0;
+            }
+            if (!plain || null != YAML_NULL_SCALAR_TYPE) {
+                problem = (type == YAML_FIELD_STRUCT) ? "expected a mapping"
+                    : "expected a sequence";
+                break;
+            }
+            if (type == YAML_FIELD_STRUCT) {
+                return yaml_binding_finish(parser, binding, schema, target,
+                        NULL, event->start_mark, event->end_mark);
+            }
+            return 1;
+        }
+
+        case YAML_MAPPING_START_EVENT:
+            if (type != YAML_FIELD_STRUCT) {
+                problem = (type == YAML_FIELD_ARRAY) ? "expected a sequence"
+                    : "expected a scalar";
+                break;
+            }
+            memset(&frame, 0, sizeof(frame));
+            frame.schema = schema;
+            frame.object = target;
+            frame.seen = ctx->seen.top - ctx->seen.start;
+            frame.start_mark = event->start_mark;
+            while ((size_t)(ctx->seen.top - ctx->seen.start) - frame.seen
+                    < binding->schemas.start[schema].count) {
+                if (!PUSH(parser, ctx->seen, 0))
+                    return 0;
+            }
+            return PUSH(parser, ctx->frames, frame);
+
+        case YAML_SEQUENCE_START_EVENT:
+            if (type != YAML_FIELD_ARRAY) {
+                problem = (type == YAML_FIELD_STRUCT) ? "expected a mapping"
+                    : "expected a scalar";
+                break;
+            }
+            memset(&frame, 0, sizeof(frame));
+            frame.sequence = 1;
+            frame.schema = schema;
+            frame.field = field;
+            frame.object = object;
+            frame.start_mark = event->start_mark;
+            return PUSH(parser, ctx->frames, frame);
+
+        case YAML_ALIAS_EVENT:
+            problem = "found an unexpanded alias";
+            break;
+
+        case YAML_SCALAR_START_EVENT:
+            problem = "found a chunked scalar";
+            break;
+
+        default:
+            assert(0);      /* Only node events are expected. */
+            return 0;
+    }
+
+    return yaml_binding_set_error(parser, "while decoding a node",
+            event->start_mark, problem, event->start_mark);
+}
+
+/*
+ * Append a cleared item to the array of a sequence frame.
+ */
+
+static int
+yaml_binding_push_item(yaml_parser_t *parser, yaml_binding_t *binding,
+        struct binding_frame *frame, char **target)
+{
+    const yaml_field_t *field = frame->field;
+    char **items = (char **)(frame->object + field->offset);
+    size_t *count = (size_t *)(frame->object + field->count_offset);
+    size_t size = yaml_binding_item_size(binding, field->item, frame->schema);
+
+    if (*count == frame->capacity) {
+        size_t capacity = frame->capacity ? frame->capacity*2 : 4;
+        char *resized;
+
+        if (capacity > ((size_t)-1) / size) {
+            parser->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+        resized = (char *)yaml_realloc(*items, capacity*size);
+        if (!resized) {
+            parser->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+        *items = resized;
+        frame->capacity = capacity;
+    }
+
+    *target = *items + (*count)*size;
+    memset(*target, 0, size);
+    (*count) ++;
+
+    return 1;
+}
+
+/*
+ * Fill the missing fields of a structure with their default values.  A
+ * missing structure gets its own default values and required keys checked.
+ *
+ * `seen` holds a flag for every field, or is NULL if the structure is empty.
+ */
+
+static int
+yaml_binding_finish(yaml_parser_t *parser, yaml_binding_t *binding,
+        int schema, char *object, yaml_char_t *seen,
+        yaml_mark_t start_mark, yaml_mark_t end_mark)
+{
+    yaml_binding_schema_t *compiled = binding->schemas.start + schema;
+    size_t k;
+
+    for (k = 0; k < compiled->count; k ++) {
+        const yaml_field_t *field = compiled->schema->fields + k;
+        const char *problem = NULL;
+        yaml_char_t *value;
+
+        if (seen && seen[k])
+            continue;
+
+        if (!field->default_value) {
+            if (field->flags & YAML_FIELD_REQUIRED) {
+                return yaml_binding_set_error(parser,
+                        "while decoding a mapping", start_mark,
+                        "did not find a required key", end_mark);
+            }
+            if (field->type == YAML_FIELD_STRUCT
+                    && !yaml_binding_finish(parser, binding,
+                        compiled->keys[k].schema, object + field->offset,
+                        NULL, start_mark, end_mark))
+                return 0;
+            continue;
+        }
+
+        value = yaml_strdup((const yaml_char_t *)field->default_value);
+        if (!value) {
+            parser->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+        if (!yaml_binding_convert(parser, field->type, value,
+                    strlen(field->default_value), 1,
+                    object + field->offset, &problem)) {
+            yaml_free(value);
+            return 0;
+        }
+        if (field->type != YAML_FIELD_STRING)
+            yaml_free(value);
+
+        assert(!problem);   /* The default value must match the type. */
+    }
+
+    return 1;
+}
+
+/*
+ * Decode the next document of a stream into a structure.
+ */
+
+YAML_DECLARE(int)
+yaml_binding_decode(yaml_binding_t *binding, yaml_parser_t *parser,
+        void *object)
+{
+    struct binding_ctx ctx = { { NULL, NULL, NULL }, { NULL, NULL, NULL },
+        0, 0 };
+    yaml_event_t event;
+
+    assert(binding);    /* Non-NULL binding object is expected. */
+    assert(parser);     /* Non-NULL parser object is expected. */
+    assert(object);     /* Non-NULL structure is expected. */
+
+    memset(object, 0, binding->schemas.start->schema->size);
+
+    if (parser->stream_end_produced)
+        return 1;
+
+    if (!yaml_parser_parse(parser, &event))
+        return 0;
+
+    if (event.type == YAML_STREAM_START_EVENT) {
+        yaml_event_delete(&event);
+        if (!yaml_parser_parse(parser, &event))
+            return 0;
+    }
+
+    if (event.type == YAML_STREAM_END_EVENT) {
+        yaml_event_delete(&event);
+        return 1;
+    }
+
+    assert(event.type == YAML_DOCUMENT_START_EVENT);
+    yaml_event_delete(&event);
+
+    if (!STACK_INIT(parser, ctx.frames, struct binding_frame*))
+        goto error;
+    if (!STACK_INIT(parser, ctx.seen, yaml_char_t*))
+        goto error;
+
+    /* Store the root node. */
+
+    if (!yaml_parser_parse(parser, &event))
+        goto error;
+    if (event.type != YAML_MAPPING_START_EVENT) {
+        yaml_binding_set_error(parser, "while decoding a document",
+                event.start_mark, "expected a mapping", event.start_mark);
+        goto error_event;
+    }
+    if (!yaml_binding_store(parser, binding, &ctx, YAML_FIELD_STRUCT, 0,
+                NULL, NULL, (char *)object, &event))
+        goto error_event;
+    yaml_event_delete(&event);
+
+    /* Fill the open mappings and sequences. */
+
+    while (!STACK_EMPTY(parser, ctx.frames))
+    {
+        struct binding_frame *frame = ctx.frames.top-1;
+
+        if (!yaml_parser_parse(parser, &event))
+            goto error;
+
+        /* Skip the value of an unknown key. */
+
+        if (ctx.skipping) {
+            if (event.type == YAML_SEQUENCE_START_EVENT
+                    || event.type == YAML_MAPPING_START_EVENT
+                    || event.type == YAML_SCALAR_START_EVENT)
+                ctx.depth ++;
+            if (event.type == YAML_SEQUENCE_END_EVENT
+                    || event.type == YAML_MAPPING_END_EVENT
+                    || event.type == YAML_SCALAR_END_EVENT)
+                ctx.depth --;
+            ctx.skipping = (ctx.depth > 0);
+        }
+
+        /* Store an array item. */
+
+        else if (frame->sequence) {
+            char *target;
+
+            if (event.type == YAML_SEQUENCE_END_EVENT) {
+                (void)POP(parser, ctx.frames);
+            }
+            else {
+                const yaml_field_t *field = frame->field;
+                char *holder = frame->object;
+                int schema = frame->schema;
+
+                if (!yaml_binding_push_item(parser, binding, frame, &target))
+                    goto error_event;
+                if (!yaml_binding_store(parser, binding, &ctx, field->item,
+                            schema, field, holder, target, &event))
+                    goto error_event;
+            }
+        }
+
+        /* Store a field value. */
+
+        else if (frame->field) {
+            yaml_binding_schema_t *compiled = binding->schemas.start
+                + frame->schema;
+            const yaml_field_t *field = frame->field;
+            char *holder = frame->object;
+            int schema = compiled->keys[field - compiled->schema->fields]
+                .schema;
+
+            frame->field = NULL;
+            if (!yaml_binding_store(parser, binding, &ctx, field->type,
+                        schema, field, holder, holder + field->offset, &event))
+                goto error_event;
+        }
+
+        /* Close the mapping. */
+
+        else if (event.type == YAML_MAPPING_END_EVENT) {
+            if (!yaml_binding_finish(parser, binding, frame->schema,
+                        frame->object, ctx.seen.start + frame->seen,
+                        frame->start_mark, event.end_mark))
+                goto error_event;
+            ctx.seen.top = ctx.seen.start + frame->seen;
+            (void)POP(parser, ctx.frames);
+        }
+
+        /* Look up a key. */
+
+        else if (event.type == YAML_SCALAR_EVENT) {
+            int index = yaml_binding_find(binding->schemas.start
+                    + frame->schema, event.data.scalar.value,
+                    event.data.scalar.length);
+
+            if (index < 0) {
+                ctx.skipping = 1;
+                ctx.depth = 0;
+            }
+            else if (ctx.seen.start[frame->seen + index]) {
+                yaml_binding_set_error(parser, "while decoding a mapping",
+                        frame->start_mark, "found a duplicate key",
+                        event.start_mark);
+                goto error_event;
+            }
+            else {
+                ctx.seen.start[frame->seen + index] = 1;
+                frame->field = binding->schemas.start[frame->schema]
+                    .schema->fields + index;
+            }
+        }
+
+        else {
+            yaml_binding_set_error(parser, "while decoding a mapping",
+                    frame->start_mark, "expected a scalar key",
+                    event.start_mark);
+            goto error_event;
+        }
+
+        yaml_event_delete(&event);
+    }
+
+    /* Consume the end of the document. */
+
+    if (!yaml_parser_parse(parser, &event))
+        goto error;
+    assert(event.type == YAML_DOCUMENT_END_EVENT);
+    yaml_event_delete(&event);
+
+    STACK_DEL(parser, ctx.frames);
+    STACK_DEL(parser, ctx.seen);
+
+    return 1;
+
+error_event:
+    yaml_event_delete(&event);
+
+error:
+    STACK_DEL(parser, ctx.frames);
+    STACK_DEL(parser, ctx.seen);
+    yaml_binding_free(binding, object);
+
+    return 0;
+}
+
+/*
+ * Free the strings and arrays of a structure.
+ */
+
+static void
+yaml_binding_free_struct(yaml_binding_t *binding, int schema, char *object)
+{
+    yaml_binding_schema_t *compiled = binding->schemas.start + schema;
+    size_t k;
+
+    for (k = 0; k < compiled->count; k ++) {
+        const yaml_field_t *field = compiled->schema->fields + k;
+        char *target = object + field->offset;
+
+        if (field->type == YAML_FIELD_STRING) {
+            yaml_free(*(char **)target);
+        }
+        else if (field->type == YAML_FIELD_STRUCT) {
+            yaml_binding_free_struct(binding, compiled->keys[k].schema, target);
+        }
+        else if (field->type == YAML_FIELD_ARRAY) {
+            char *items = *(char **)target;
+            size_t count = *(size_t *)(object + field->count_offset);
+            size_t size = yaml_binding_item_size(binding, field->item,
+                    compiled->keys[k].schema);
+            size_t item;
+
+            for (item = 0; item < count; item ++) {
+                if (field->item == YAML_FIELD_STRING) {
+                    yaml_free(*(char **)(items + item*size));
+                }
+                else if (field->item == YAML_FIELD_STRUCT) {
+                    yaml_binding_free_struct(binding,
+                            compiled->keys[k].schema, items + item*size);
+                }
+            }
+            yaml_free(items);
+        }
+    }
+}
+
+/*
+ * Free the strings and arrays of a decoded structure and clear it.
+ */
+
+YAML_DECLARE(void)
+yaml_binding_free(yaml_binding_t *binding, void *object)
+{
+    assert(binding);    /* Non-NULL binding object is expected. */
+    assert(object);     /* Non-NULL structure is expected. */
+
+    yaml_binding_free_struct(binding, 0, (char *)object);
+
+    memset(object, 0, binding->schemas.start->schema->size);
+}
+
+/*
+ * Emit a string value, or null.
+ */
+
+static int
+yaml_binding_emit_string(yaml_emitter_t *emitter, const char *value)
+{
+    size_t length;
+
+    if (!value)
+        return yaml_emitter_emit_null(emitter);
+
+    length = strlen(value);
+
+    return yaml_emitter_emit_analyzed(emitter, YAML_STR_TAG,
+            (const yaml_char_t *)value, length,
+            yaml_binding_analyze((const yaml_char_t *)value, length, emitter));
+}
+
+/*
+ * Emit a field value or an array item.
+ */
+
+static int
+yaml_binding_emit_value(yaml_binding_t *binding, yaml_emitter_t *emitter,
+        yaml_field_type_t type, int schema, const char *target)
+{
+    switch (type)
+    {
+        case YAML_FIELD_STRING:
+            return yaml_binding_emit_string(emitter, *(char * const *)target);
+
+        case YAML_FIELD_INT:
+            return yaml_emitter_emit_int64(emitter, *(const int *)target);
+
+        case YAML_FIELD_INT64:
+            return yaml_emitter_emit_int64(emitter, *(const int64_t *)target);
+
+        case YAML_FIELD_DOUBLE:
+            return yaml_emitter_emit_double(emitter, *(const double *)target);
+
+        case YAML_FIELD_BOOL:
+            return yaml_emitter_emit_bool(emitter, *(const int *)target);
+
+        case YAML_FIELD_STRUCT:
+            return yaml_binding_emit_struct(binding, emitter, schema, target);
+
+        default:
+            assert(0);      /* Arrays are emitted by their structures. */
+            return 0;
+    }
+}
+
+/*
+ * Emit a structure as a mapping.
+ */
+
+static int
+yaml_binding_emit_struct(yaml_binding_t *binding, yaml_emitter_t *emitter,
+        int schema, const char *object)
+{
+    yaml_binding_schema_t *compiled = binding->schemas.start + schema;
+    yaml_event_t event;
+    yaml_mark_t mark = { 0, 0, 0 };
+    size_t k;
+
+    MAPPING_START_EVENT_INIT(event, NULL, NULL, 1, YAML_ANY_MAPPING_STYLE,
+            mark, mark);
+    if (!yaml_emitter_emit(emitter, &event))
+        return 0;
+
+    for (k = 0; k < compiled->count; k ++)
+    {
+        const yaml_field_t *field = compiled->schema->fields + k;
+        yaml_binding_key_t *key = compiled->keys + k;
+
+        if (!yaml_emitter_emit_analyzed(emitter, YAML_STR_TAG,
+                    (const yaml_char_t *)field->name, key->length,
+                    key->analysis))
+            return 0;
+
+        if (field->type == YAML_FIELD_ARRAY) {
+            const char *items = *(char * const *)(object + field->offset);
+            size_t count = *(const size_t *)(object + field->count_offset);
+            size_t size = yaml_binding_item_size(binding, field->item,
+                    key->schema);
+            size_t item;
+
+            SEQUENCE_START_EVENT_INIT(event, NULL, NULL, 1,
+                    YAML_ANY_SEQUENCE_STYLE, mark, mark);
+            if (!yaml_emitter_emit(emitter, &event))
+                return 0;
+            for (item = 0; item < count; item ++) {
+                if (!yaml_binding_emit_value(binding, emitter, field->item,
+                            key->schema, items + item*size))
+                    return 0;
+            }
+            SEQUENCE_END_EVENT_INIT(event, mark, mark);
+            if (!yaml_emitter_emit(emitter, &event))
+                return 0;
+        }
+        else {
+            if (!yaml_binding_emit_value(binding, emitter, field->type,
+                        key->schema, object + field->offset))
+                return 0;
+        }
+    }
+
+    MAPPING_END_EVENT_INIT(event, mark, mark);
+
+    return yaml_emitter_emit(emitter, &event);
+}
+
+/*
+ * Encode a structure as a document.
+ */
+
+YAML_DECLARE(int)
+yaml_binding_encode(yaml_binding_t *binding, yaml_emitter_t *emitter,
+        const void *object)
+{
+    yaml_event_t event;
+    yaml_mark_t mark = { 0, 0, 0 };
+
+    assert(binding);    /* Non-NULL binding object is expected. */
+    assert(emitter);    /* Non-NULL emitter object is expected. */
+    assert(object);     /* Non-NULL structure is expected. */
+
+    if (!emitter->opened) {
+        if (!yaml_emitter_open(emitter))
+            return 0;
+    }
+
+    DOCUMENT_START_EVENT_INIT(event, NULL, NULL, NULL, 1, mark, mark);
+    if (!yaml_emitter_emit(emitter, &event))
+        return 0;
+
+    if (!yaml_binding_emit_struct(binding, emitter, 0, (const char *)object))
+        return 0;
+
+    DOCUMENT_END_EVENT_INIT(event, 1, mark, mark);
+
+    return yaml_emitter_emit(emitter, &event);
+}
@@ -0,0 +1,649 @@
+#include "yaml_private.h"
+
+#include <stdio.h>
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/*
+ * Document cache.
+ *
+ * The entries are kept in a list ordered by their last use.  A lookup stats
+ * the file and looks for an entry with the same key under the lock; the file
+ * is read and loaded outside of the lock, so that lookups of other files are
+ * not blocked by a slow load.  If two threads load the same file at once,
+ * the document inserted first wins and the other one is dropped.
+ *
+ * An entry evicted or replaced while its document is in use is unlinked
+ * from the list and freed by the last release.
+ */
+
+struct yaml_cache_entry_s {
+    /* The document; the first member, so that a document is its entry. */
+    yaml_document_t document;
+    /* The key of the file. */
+    struct {
+        unsigned long device;
+        uint64_t inode;
+        int64_t mtime;
+        long mtime_nsec;
+        size_t size;
+    } key;
+    /* The hash of the content (with YAML_CACHE_HASH_CONTENT). */
+    uint64_t hash;
+    /* The estimated size of the document. */
+    size_t bytes;
+    /* The number of callers using the document. */
+    int references;
+    /* Is the entry in the list? */
+    int linked;
+    /* The neighbours in the list. */
+    yaml_cache_entry_t *previous;
+    yaml_cache_entry_t *next;
+};
+
+/*
+ * Locking.
+ */
+
+static void *
+yaml_cache_lock_create(void);
+
+static void
+yaml_cache_lock_destroy(void *lock);
+
+static void
+yaml_cache_lock(void *lock);
+
+static void
+yaml_cache_unlock(void *lock);
+
+/*
+ * Entries.
+ */
+
+static size_t
+yaml_cache_document_size(yaml_document_t *document);
+
+static yaml_cache_entry_t *
+yaml_cache_find(yaml_document_cache_t *cache, yaml_cache_entry_t *key);
+
+static void
+yaml_cache_link(yaml_document_cache_t *cache, yaml_cache_entry_t *entry);
+
+static void
+yaml_cache_unlink(yaml_document_cache_t *cache, yaml_cache_entry_t *entry);
+
+static void
+yaml_cache_drop(yaml_document_cache_t *cache, yaml_cache_entry_t *entry);
+
+static void
+yaml_cache_free(yaml_cache_entry_t *entry);
+
+/*
+ * Files.
+ */
+
+static int
+yaml_cache_stat(yaml_parser_t *parser, const char *path,
+        yaml_cache_entry_t *entry);
+
+static int
+yaml_cache_read(yaml_parser_t *parser, const char *path, size_t size,
+        yaml_char_t **content, size_t *length);
+
+#if defined(_WIN32)
+
+static void *
+yaml_cache_lock_create(void)
+{
+    CRITICAL_SECTION *lock = YAML_MALLOC_STATIC(CRITICAL_SECTION);
+
+    if (lock) {
+        InitializeCriticalSection(lock);
+    }
+
+    return lock;
+}
+
+static void
+yaml_cache_lock_destroy(void *lock)
+{
+    DeleteCriticalSection((CRITICAL_SECTION *)lock);
+    yaml_free(lock);
+}
+
+static void
+yaml_cache_lock(void *lock)
+{
+    EnterCriticalSection((CRITICAL_SECTION *)lock);
+}
+
+static void
+yaml_cache_unlock(void *lock)
+{
+    LeaveCriticalSection((CRITICAL_SECTION *)lock);
+}
+
+#else
+
+static void *
+yaml_cache_lock_create(void)
+{
+    pthread_mutex_t *lock = YAML_MALLOC_STATIC(pthread_mutex_t);
+
+    if (lock && pthread_mutex_init(lock, NULL) != 0) {
+        yaml_free(lock);
+        return NULL;
+    }
+
+    return lock;
+}
+
+static void
+yaml_cache_lock_destroy(void *lock)
+{
+    pthread_mutex_destroy((pthread_mutex_t *)lock);
+    yaml_free(lock);
+}
+
+static void
+yaml_cache_lock(void *lock)
+{
+    pthread_mutex_lock((pthread_mutex_t *)lock);
+}
+
+static void
+yaml_cache_unlock(void *lock)
+{
+    pthread_mutex_unlock((pthread_mutex_t *)lock);
+}
+
+#endif
+
+/*
+ * Create a document cache.
+ */
+
+YAML_DECLARE(int)
+yaml_document_cache_initialize(yaml_document_cache_t *cache, size_t budget,
+        int flags)
+{
+    assert(cache);      /* Non-NULL cache object is expected. */
+
+    memset(cache, 0, sizeof(yaml_document_cache_t));
+
+    cache->lock = yaml_cache_lock_create();
+    if (!cache->lock)
+        return 0;
+
+    cache->budget = budget;
+    cache->flags = flags;
+
+    return 1;
+}
+
+/*
+ * Destroy a document cache.
+ */
+
+YAML_DECLARE(void)
+yaml_document_cache_delete(yaml_document_cache_t *cache)
+{
+    assert(cache);      /* Non-NULL cache object is expected. */
+
+    while (cache->head) {
+        assert(!cache->head->references);
+                        /* The documents should be released. */
+        yaml_cache_drop(cache, cache->head);
+    }
+
+    yaml_cache_lock_destroy(cache->lock);
+
+    memset(cache, 0, sizeof(yaml_document_cache_t));
+}
+
+/*
+ * Estimate the memory used by a document.
+ */
+
+static size_t
+yaml_cache_document_size(yaml_document_t *document)
+{
+    size_t size = sizeof(yaml_cache_entry_t)
+        + (document->nodes.end - document->nodes.start) * sizeof(yaml_node_t)
+        + (document->hashes.end - document->hashes.start) * sizeof(uint64_t);
+    yaml_node_t *node;
+    yaml_char_t **string;
+
+    for (string = document->strings.start; string < document->strings.top;
+            string ++) {
+        size += strlen((char *)*string) + 1 + sizeof(yaml_char_t *);
+    }
+
+    for (node = document->nodes.start; node < document->nodes.top; node ++)
+    {
+        if (!(node->flags & YAML_NODE_SHARED_TAG)) {
+            size += strlen((char *)node->tag) + 1;
+        }
+
+        switch (node->type)
+        {
+            case YAML_SCALAR_NODE:
+                if (!(node->flags & YAML_NODE_SHARED_VALUE)) {
+                    size += node->data.scalar.length + 1;
+                }
+                break;
+
+            case YAML_SEQUENCE_NODE:
+                size += (node->data.sequence.items.end
+                        - node->data.sequence.items.start)
+                    * sizeof(yaml_node_item_t);
+                break;
+
+            case YAML_MAPPING_NODE:
+                size += (node->data.mapping.pairs.end
+                        - node->data.mapping.pairs.start)
+                    * sizeof(yaml_node_pair_t);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return size;
+}
+
+/*
+ * Find the entry of a file.  With YAML_CACHE_HASH_CONTENT, the hash has to
+ * match as well, and an entry of the same file with the same content is
+ * given the new key.
+ */
+
+static yaml_cache_entry_t *
+yaml_cache_find(yaml_document_cache_t *cache, yaml_cache_entry_t *key)
+{
+    int hashed = (cache->flags & YAML_CACHE_HASH_CONTENT);
+    yaml_cache_entry_t *entry;
+
+    for (entry = cache->head; entry; entry = entry->next)
+    {
+        if (entry->key.device != key->key.device
+                || entry->key.inode != key->key.inode
+                || entry->key.size != key->key.size)
+            continue;
+
+        if (hashed) {
+            if (entry->hash == key->hash) {
+                entry->key.mtime = key->key.mtime;
+                entry->key.mtime_nsec = key->key.mtime_nsec;
+                return entry;
+            }
+        }
+        else if (entry->key.mtime == key->key.mtime
+                && entry->key.mtime_nsec == key->key.mtime_nsec) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Insert an entry at the head of the list.
+ */
+
+static void
+yaml_cache_link(yaml_document_cache_t *cache, yaml_cache_entry_t *entry)
+{
+    entry->previous = NULL;
+    entry->next = cache->head;
+    if (cache->head) {
+        cache->head->previous = entry;
+    }
+    else {
+        cache->tail = entry;
+    }
+    cache->head = entry;
+    entry->linked = 1;
+}
+
+/*
+ * Remove an entry from the list.
+ */
+
+static void
+yaml_cache_unlink(yaml_document_cache_t *cache, yaml_cache_entry_t *entry)
+{
+    if (entry->previous) {
+        entry->previous->next = entry->next;
+    }
+    else {
+        cache->head = entry->next;
+    }
+    if (entry->next) {
+        entry->next->previous = entry->previous;
+    }
+    else {
+        cache->tail = entry->previous;
+    }
+    entry->previous = entry->next = NULL;
+    entry->linked = 0;
+}
+
+/*
+ * Remove an entry from the cache, freeing it unless it is in use.
+ */
+
+static void
+yaml_cache_drop(yaml_document_cache_t *cache, yaml_cache_entry_t *entry)
+{
+    yaml_cache_unlink(cache, entry);
+    cache->size -= entry->bytes;
+
+    if (!entry->references) {
+        yaml_cache_free(entry);
+    }
+}
+
+/*
+ * Free an entry and its document.
+ */
+
+static void
+yaml_cache_free(yaml_cache_entry_t *entry)
+{
+    yaml_document_delete(&entry->document);
+    yaml_free(entry);
+}
+
+/*
+ * Fill the key of a file.  On Windows, stat() reports no inode, so the
+ * volume serial number and the file index are used instead.
+ */
+
+#if defined(_WIN32)
+
+static int
+yaml_cache_stat(yaml_parser_t *parser, const char *path,
+        yaml_cache_entry_t *entry)
+{
+    BY_HANDLE_FILE_INFORMATION information;
+    HANDLE handle;
+    uint64_t mtime;
+    int success;
+
+    handle = CreateFileA(path, 0,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+            OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        parser->error = YAML_READER_ERROR;
+        parser->problem = "cannot stat the file";
+        return 0;
+    }
+    success = GetFileInformationByHandle(handle, &information);
+    CloseHandle(handle);
+    if (!success) {
+        parser->error = YAML_READER_ERROR;
+        parser->problem = "cannot stat the file";
+        return 0;
+    }
+
+    /* The modification time is counted in 100-nanosecond intervals. */
+
+    mtime = ((uint64_t)information.ftLastWriteTime.dwHighDateTime << 32)
+        | information.ftLastWriteTime.dwLowDateTime;
+
+    entry->key.device = (unsigned long)information.dwVolumeSerialNumber;
+    entry->key.inode = ((uint64_t)information.nFileIndexHigh << 32)
+        | information.nFileIndexLow;
+    entry->key.mtime = (int64_t)(mtime / 10000000);
+    entry->key.mtime_nsec = (long)(mtime % 10000000) * 100;
+    entry->key.size = (size_t)(((uint64_t)information.nFileSizeHigh << 32)
+            | information.nFileSizeLow);
+
+    return 1;
+}
+
+#else
+
+static int
+yaml_cache_stat(yaml_parser_t *parser, const char *path,
+        yaml_cache_entry_t *entry)
+{
+    struct stat status;
+
+    if (stat(path, &status) != 0) {
+        parser->error = YAML_READER_ERROR;
+        parser->problem = "cannot stat the file";
+        return 0;
+    }
+
+    entry->key.device = (unsigned long)status.st_dev;
+    entry->key.inode = (uint64_t)status.st_ino;
+    entry->key.mtime = (int64_t)status.st_mtime;
+#if defined(HAVE_STRUCT_STAT_ST_MTIM)
+    entry->key.mtime_nsec = (long)status.st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    entry->key.mtime_nsec = (long)status.st_mtimespec.tv_nsec;
+#endif
+    entry->key.size = (size_t)status.st_size;
+
+    return 1;
+}
+
+#endif
+
+/*
+ * Read a whole file.
+ */
+
+static int
+yaml_cache_read(yaml_parser_t *parser, const char *path, size_t size,
+        yaml_char_t **content, size_t *length)
+{
+    FILE *file = fopen(path, "rb");
+    yaml_char_t *buffer;
+    yaml_char_t *grown;
+    size_t capacity = size + 1;
+
+    if (!file) {
+        parser->error = YAML_READER_ERROR;
+        parser->problem = "cannot open the file";
+        return 0;
+    }
+
+    *length = 0;
+    buffer = YAML_MALLOC(capacity);
+
+    while (buffer)
+    {
+        size_t count = fread(buffer + *length, 1, capacity - *length, file);
+
+        *length += count;
+        if (*length < capacity)
+            break;
+
+        /* The file has grown since it was stat()ed. */
+
+        capacity *= 2;
+        grown = yaml_realloc(buffer, capacity);
+        if (!grown) {
+            yaml_free(buffer);
+        }
+        buffer = grown;
+    }
+
+    if (!buffer) {
+        fclose(file);
+        parser->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+
+    if (ferror(file)) {
+        fclose(file);
+        yaml_free(buffer);
+        parser->error = YAML_READER_ERROR;
+        parser->problem = "cannot read the file";
+        return 0;
+    }
+
+    fclose(file);
+    *content = buffer;
+
+    return 1;
+}
+
+/*
+ * Get the document of a file.
+ */
+
+YAML_DECLARE(int)
+yaml_document_cache_load(yaml_document_cache_t *cache, yaml_parser_t *parser,
+        const char *path, const yaml_document_t **document)
+{
+    yaml_cache_entry_t *entry;
+    yaml_cache_entry_t *found;
+    yaml_char_t *content = NULL;
+    size_t length = 0;
+
+    assert(cache);      /* Non-NULL cache object is expected. */
+    assert(parser);     /* Non-NULL parser object is expected. */
+    assert(path);       /* Non-NULL path is expected. */
+    assert(document);   /* Non-NULL document object is expected. */
+
+    entry = YAML_MALLOC_STATIC(yaml_cache_entry_t);
+    if (!entry) {
+        parser->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+    memset(entry, 0, sizeof(yaml_cache_entry_t));
+
+    if (!yaml_cache_stat(parser, path, entry))
+        goto error;
+
+    if (cache->flags & YAML_CACHE_HASH_CONTENT) {
+        if (!yaml_cache_read(parser, path, entry->key.size,
+                    &content, &length))
+            goto error;
+        entry->key.size = length;
+        entry->hash = yaml_hash_octets(content, length);
+    }
+
+    yaml_cache_lock(cache->lock);
+    found = yaml_cache_find(cache, entry);
+    if (found) {
+        yaml_cache_unlink(cache, found);
+        yaml_cache_link(cache, found);
+        found->references ++;
+        cache->hits ++;
+    }
+    else {
+        cache->misses ++;
+    }
+    yaml_cache_unlock(cache->lock);
+
+    if (found) {
+        yaml_free(content);
+        yaml_free(entry);
+        *document = &found->document;
+        return 1;
+    }
+
+    /* Load the file outside of the lock. */
+
+    if (!content) {
+        if (!yaml_cache_read(parser, path, entry->key.size,
+                    &content, &length))
+            goto error;
+        entry->key.size = length;
+    }
+
+    yaml_parser_set_input_string(parser, content, length);
+    if (!yaml_parser_load(parser, &entry->document))
+        goto error;
+    yaml_free(content);
+    content = NULL;
+
+    /* The users compare the shared document without locking it. */
+
+    if (!yaml_document_compute_hashes(&entry->document)) {
+        yaml_document_delete(&entry->document);
+        parser->error = YAML_MEMORY_ERROR;
+        goto error;
+    }
+
+    entry->bytes = yaml_cache_document_size(&entry->document);
+    entry->references = 1;
+
+    yaml_cache_lock(cache->lock);
+    found = yaml_cache_find(cache, entry);
+    if (found) {
+        found->references ++;
+    }
+    else {
+        yaml_cache_entry_t *stale;
+
+        /* Replace the older versions of the file. */
+
+        for (stale = cache->head; stale; ) {
+            yaml_cache_entry_t *next = stale->next;
+            if (stale->key.device == entry->key.device
+                    && stale->key.inode == entry->key.inode) {
+                yaml_cache_drop(cache, stale);
+            }
+            stale = next;
+        }
+
+        yaml_cache_link(cache, entry);
+        cache->size += entry->bytes;
+
+        while (cache->size > cache->budget && cache->tail != entry) {
+            yaml_cache_drop(cache, cache->tail);
+        }
+    }
+    yaml_cache_unlock(cache->lock);
+
+    if (found) {
+        yaml_cache_free(entry);
+        entry = found;
+    }
+
+    *document = &entry->document;
+
+    return 1;
+
+error:
+    yaml_free(content);
+    yaml_free(entry);
+    return 0;
+}
+
+/*
+ * Release a cached document.
+ */
+
+YAML_DECLARE(void)
+yaml_document_cache_release(yaml_document_cache_t *cache,
+        const yaml_document_t *document)
+{
+    yaml_cache_entry_t *entry = (yaml_cache_entry_t *)document;
+    int unused;
+
+    assert(cache);      /* Non-NULL cache object is expected. */
+    assert(document);   /* Non-NULL document is expected. */
+
+    yaml_cache_lock(cache->lock);
+    assert(entry->references > 0);
+    unused = (!--entry->references && !entry->linked);
+    yaml_cache_unlock(cache->lock);
+
+    if (unused) {
+        yaml_cache_free(entry);
+    }
+}
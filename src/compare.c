@@ -0,0 +1,838 @@
+
+#include "yaml_private.h"
+
+/*
+ * Structural hashing and comparison of document nodes.
+ *
+ * The hash of a node depends only on its tag, its content, and the hashes
+ * of its children; it does not depend on node ids, styles, marks, or the
+ * order of mapping pairs, so it is stable across documents and runs.
+ *
+ * Recursive structures are handled by computing the strongly connected
+ * components of the node graph (Tarjan's algorithm).  The nodes lying on or
+ * leading to a cycle are hashed by their shape only, which makes the result
+ * independent of the order in which the nodes are visited and of the way a
+ * cycle is unrolled.
+ */
+
+#define HASH_SEED       (uint64_t)0xCBF29CE484222325ULL
+#define HASH_PRIME      (uint64_t)0x100000001B3ULL
+#define HASH_GOLDEN     (uint64_t)0x9E3779B97F4A7C15ULL
+
+/*
+ * The mapping size above which pairs are matched by sorting.
+ */
+
+#define SMALL_MAPPING   8
+
+/*
+ * A node being visited by the strongly connected components search.
+ */
+
+struct hash_frame {
+    int index;
+    int position;
+    int looped;
+    int infinite;
+};
+
+/*
+ * The state of the strongly connected components search.
+ */
+
+struct hash_ctx {
+    yaml_document_t *document;
+    uint64_t *hashes;
+    int *order;
+    int *low;
+    int *stack;
+    char *infinite;
+    struct hash_frame *frames;
+    int top;
+    int depth;
+    int counter;
+};
+
+/*
+ * A pair of nodes being compared.
+ */
+
+struct equal_frame {
+    int a;
+    int b;
+    /* The current item or pair of the first node. */
+    int position;
+    /* The pair of the second node matched against it. */
+    int candidate;
+    /* Set while the values of the matched pairs are compared. */
+    int value;
+    /* Set if the pair is on the stack of cyclic pairs. */
+    int cyclic;
+    char *used;
+    struct hashed_pair *sorted;
+};
+
+/*
+ * A pair of cyclic nodes being compared.
+ */
+
+struct equal_pair {
+    int a;
+    int b;
+};
+
+/*
+ * The state of a comparison.
+ */
+
+struct equal_ctx {
+    yaml_error_type_t error;
+    const yaml_document_t *a;
+    const yaml_document_t *b;
+    struct {
+        struct equal_frame *start;
+        struct equal_frame *end;
+        struct equal_frame *top;
+    } frames;
+    struct {
+        struct equal_pair *start;
+        struct equal_pair *end;
+        struct equal_pair *top;
+    } cycles;
+};
+
+/*
+ * A mapping pair together with the hash of its key.
+ */
+
+struct hashed_pair {
+    uint64_t hash;
+    yaml_node_pair_t *pair;
+};
+
+/*
+ * Hashing primitives.
+ */
+
+static uint64_t
+yaml_hash_bytes(uint64_t hash, const yaml_char_t *data, size_t length);
+
+static uint64_t
+yaml_hash_mix(uint64_t hash);
+
+static uint64_t
+yaml_hash_shape(yaml_node_t *node);
+
+static uint64_t
+yaml_hash_content(struct hash_ctx *ctx, yaml_node_t *node);
+
+static int
+yaml_node_child(yaml_node_t *node, int position);
+
+static void
+yaml_hash_enter(struct hash_ctx *ctx, int index);
+
+static void
+yaml_hash_link(struct hash_ctx *ctx, struct hash_frame *frame, int child);
+
+static void
+yaml_hash_leave(struct hash_ctx *ctx, struct hash_frame *frame);
+
+static void
+yaml_hash_visit(struct hash_ctx *ctx, int index);
+
+/*
+ * Comparison.
+ */
+
+static int
+yaml_node_equal_internal(struct equal_ctx *ctx, int a, int b);
+
+static int
+yaml_node_equal_enter(struct equal_ctx *ctx, int a, int b);
+
+static int
+yaml_node_equal_resume(struct equal_ctx *ctx, struct equal_frame *frame,
+        int result, int *a, int *b);
+
+static int
+yaml_node_equal_match(struct equal_ctx *ctx, struct equal_frame *frame,
+        int *a, int *b);
+
+static void
+yaml_node_equal_leave(struct equal_ctx *ctx);
+
+static int
+yaml_hashed_pair_compare(const void *a, const void *b);
+
+/*
+ * Feed a byte string into a FNV-1a hash.
+ */
+
+static uint64_t
+yaml_hash_bytes(uint64_t hash, const yaml_char_t *data, size_t length)
+{
+    size_t k;
+
+    for (k = 0; k < length; k ++) {
+        hash ^= data[k];
+        hash *= HASH_PRIME;
+    }
+
+    return hash;
+}
+
+/*
+ * Scramble the bits of a hash value.
+ */
+
+static uint64_t
+yaml_hash_mix(uint64_t hash)
+{
+    hash ^= hash >> 30;
+    hash *= (uint64_t)0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 27;
+    hash *= (uint64_t)0x94D049BB133111EBULL;
+    hash ^= hash >> 31;
+
+    return hash;
+}
+
+/*
+ * Hash a byte string.
+ */
+
+YAML_DECLARE(uint64_t)
+yaml_hash_octets(const yaml_char_t *data, size_t length)
+{
+    return yaml_hash_mix(yaml_hash_bytes(HASH_SEED, data, length));
+}
+
+/*
+ * Hash the kind and the tag of a node.
+ */
+
+static uint64_t
+yaml_hash_shape(yaml_node_t *node)
+{
+    uint64_t hash = HASH_SEED ^ (uint64_t)node->type;
+
+    if (node->tag) {
+        hash = yaml_hash_bytes(hash, node->tag, strlen((char *)node->tag));
+    }
+
+    return hash;
+}
+
+/*
+ * Hash a node whose children have been hashed already.
+ */
+
+static uint64_t
+yaml_hash_content(struct hash_ctx *ctx, yaml_node_t *node)
+{
+    uint64_t hash = yaml_hash_shape(node);
+    uint64_t sum = 0;
+    yaml_node_item_t *item;
+    yaml_node_pair_t *pair;
+
+    switch (node->type)
+    {
+        case YAML_SCALAR_NODE:
+            hash = yaml_hash_bytes(yaml_hash_mix(hash),
+                    node->data.scalar.value, node->data.scalar.length);
+            break;
+
+        case YAML_SEQUENCE_NODE:
+            for (item = node->data.sequence.items.start;
+                    item < node->data.sequence.items.top; item ++) {
+                hash = yaml_hash_mix(hash ^ (ctx->hashes[*item-1] + HASH_GOLDEN));
+            }
+            break;
+
+        case YAML_MAPPING_NODE:
+            for (pair = node->data.mapping.pairs.start;
+                    pair < node->data.mapping.pairs.top; pair ++) {
+                sum += yaml_hash_mix(ctx->hashes[pair->key-1] * HASH_PRIME
+                        + ctx->hashes[pair->value-1]);
+            }
+            hash = yaml_hash_mix(hash ^ sum) + (uint64_t)
+                (node->data.mapping.pairs.top - node->data.mapping.pairs.start);
+            break;
+
+        default:
+            assert(0);      /* Should not happen. */
+    }
+
+    return hash;
+}
+
+/*
+ * Get the child of a collection node at the given position or 0 after the
+ * last one.  The children of a mapping are its keys and values in turn.
+ */
+
+static int
+yaml_node_child(yaml_node_t *node, int position)
+{
+    yaml_node_pair_t *pair;
+
+    if (node->type == YAML_SEQUENCE_NODE) {
+        if (position < node->data.sequence.items.top
+                - node->data.sequence.items.start)
+            return node->data.sequence.items.start[position];
+    }
+
+    if (node->type == YAML_MAPPING_NODE) {
+        if (position/2 < node->data.mapping.pairs.top
+                - node->data.mapping.pairs.start) {
+            pair = node->data.mapping.pairs.start + position/2;
+            return (position & 1) ? pair->value : pair->key;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Start visiting a node.
+ */
+
+static void
+yaml_hash_enter(struct hash_ctx *ctx, int index)
+{
+    struct hash_frame *frame = ctx->frames + ctx->depth++;
+
+    ctx->order[index-1] = ctx->low[index-1] = ++ ctx->counter;
+    ctx->stack[ctx->top++] = index;
+
+    frame->index = index;
+    frame->position = 0;
+    frame->looped = 0;
+    frame->infinite = 0;
+}
+
+/*
+ * Account for a child that has been visited already.
+ */
+
+static void
+yaml_hash_link(struct hash_ctx *ctx, struct hash_frame *frame, int child)
+{
+    int index = frame->index;
+
+    if (ctx->hashes[child-1] && ctx->infinite[child-1]) {
+        frame->infinite = 1;
+    }
+    else if (!ctx->hashes[child-1]) {
+        if (ctx->order[child-1] < ctx->low[index-1])
+            ctx->low[index-1] = ctx->order[child-1];
+    }
+}
+
+/*
+ * Finish visiting a node and hash the component it is the root of.
+ */
+
+static void
+yaml_hash_leave(struct hash_ctx *ctx, struct hash_frame *frame)
+{
+    int index = frame->index;
+    int member;
+
+    if (ctx->low[index-1] != ctx->order[index-1])
+        return;
+
+    if (ctx->stack[ctx->top-1] == index && !frame->looped && !frame->infinite) {
+        ctx->top --;
+        ctx->hashes[index-1] = yaml_hash_content(ctx,
+                ctx->document->nodes.start + index - 1) | 1;
+        return;
+    }
+
+    do {
+        member = ctx->stack[--ctx->top];
+        ctx->hashes[member-1] = yaml_hash_mix(yaml_hash_shape(
+                    ctx->document->nodes.start + member - 1)) | 1;
+        ctx->infinite[member-1] = 1;
+    } while (member != index);
+}
+
+/*
+ * Visit a node and hash every strongly connected component found below it.
+ *
+ * The search keeps its own stack of frames so that the nesting depth of the
+ * document is not limited by the C stack.
+ */
+
+static void
+yaml_hash_visit(struct hash_ctx *ctx, int index)
+{
+    struct hash_frame *frame;
+    struct hash_frame *parent;
+    int child;
+
+    yaml_hash_enter(ctx, index);
+
+    while (ctx->depth)
+    {
+        frame = ctx->frames + ctx->depth - 1;
+        child = yaml_node_child(ctx->document->nodes.start + frame->index - 1,
+                frame->position);
+
+        if (child) {
+            frame->position ++;
+            if (child == frame->index) {
+                frame->looped = 1;
+            }
+            if (!ctx->order[child-1]) {
+                yaml_hash_enter(ctx, child);
+            }
+            else {
+                yaml_hash_link(ctx, frame, child);
+            }
+            continue;
+        }
+
+        ctx->depth --;
+        yaml_hash_leave(ctx, frame);
+
+        if (ctx->depth) {
+            parent = frame - 1;
+            if (ctx->low[frame->index-1] < ctx->low[parent->index-1])
+                ctx->low[parent->index-1] = ctx->low[frame->index-1];
+            yaml_hash_link(ctx, parent, frame->index);
+        }
+    }
+}
+
+/*
+ * Compute the hashes of all nodes of a document.
+ */
+
+YAML_DECLARE(int)
+yaml_document_compute_hashes(yaml_document_t *document)
+{
+    struct hash_ctx ctx;
+    int count = document->nodes.top - document->nodes.start;
+    int index;
+
+    yaml_document_drop_hashes(document);
+
+    ctx.document = document;
+    ctx.hashes = yaml_malloc(count*sizeof(uint64_t));
+    ctx.order = yaml_malloc(count*sizeof(int));
+    ctx.low = yaml_malloc(count*sizeof(int));
+    ctx.stack = yaml_malloc(count*sizeof(int));
+    ctx.infinite = yaml_malloc(count);
+    ctx.frames = yaml_malloc(count*sizeof(struct hash_frame));
+    ctx.top = 0;
+    ctx.depth = 0;
+    ctx.counter = 0;
+
+    if (!ctx.hashes || !ctx.order || !ctx.low || !ctx.stack || !ctx.infinite
+            || !ctx.frames) {
+        yaml_free(ctx.hashes);
+        yaml_free(ctx.order);
+        yaml_free(ctx.low);
+        yaml_free(ctx.stack);
+        yaml_free(ctx.infinite);
+        yaml_free(ctx.frames);
+        return 0;
+    }
+
+    memset(ctx.hashes, 0, count*sizeof(uint64_t));
+    memset(ctx.order, 0, count*sizeof(int));
+    memset(ctx.infinite, 0, count);
+
+    for (index = 1; index <= count; index ++) {
+        if (!ctx.order[index-1]) {
+            yaml_hash_visit(&ctx, index);
+        }
+    }
+
+    yaml_free(ctx.order);
+    yaml_free(ctx.low);
+    yaml_free(ctx.stack);
+    yaml_free(ctx.infinite);
+    yaml_free(ctx.frames);
+
+    document->hashes.start = ctx.hashes;
+    document->hashes.end = ctx.hashes + count;
+
+    return 1;
+}
+
+/*
+ * Forget the cached hashes of a document.
+ */
+
+YAML_DECLARE(void)
+yaml_document_drop_hashes(yaml_document_t *document)
+{
+    yaml_free(document->hashes.start);
+    document->hashes.start = document->hashes.end = NULL;
+}
+
+/*
+ * Get the structural hash of a node.
+ */
+
+YAML_DECLARE(uint64_t)
+yaml_document_hash_node(const yaml_document_t *document, int index)
+{
+    assert(document);   /* Non-NULL document object is expected. */
+    assert(index > 0 && document->nodes.start + index <= document->nodes.top);
+                        /* Valid node id is required. */
+
+    /* The hashes of a shared document are computed before it is shared. */
+
+    if (document->hashes.end - document->hashes.start
+            != document->nodes.top - document->nodes.start) {
+        if (!yaml_document_compute_hashes((yaml_document_t *)document))
+            return 0;
+    }
+
+    return document->hashes.start[index-1];
+}
+
+/*
+ * Compare two nodes.
+ *
+ * The collections being compared are kept on an explicit stack of frames.
+ * A frame is resumed with the result of the comparison of the children it
+ * asked for until it reaches its own result.
+ */
+
+static int
+yaml_node_equal_internal(struct equal_ctx *ctx, int a, int b)
+{
+    int result = yaml_node_equal_enter(ctx, a, b);
+
+    while (ctx->frames.top != ctx->frames.start)
+    {
+        if (ctx->error) {
+            yaml_node_equal_leave(ctx);
+            continue;
+        }
+
+        result = yaml_node_equal_resume(ctx, ctx->frames.top - 1, result,
+                &a, &b);
+
+        if (result < 0) {
+            result = yaml_node_equal_enter(ctx, a, b);
+        }
+        else {
+            yaml_node_equal_leave(ctx);
+        }
+    }
+
+    return ctx->error ? 0 : result;
+}
+
+/*
+ * Start comparing two nodes.
+ *
+ * Returns the result if it is known at once, or pushes a frame for the
+ * children and returns -1.
+ */
+
+static int
+yaml_node_equal_enter(struct equal_ctx *ctx, int a, int b)
+{
+    yaml_node_t *node_a = ctx->a->nodes.start + a - 1;
+    yaml_node_t *node_b = ctx->b->nodes.start + b - 1;
+    struct equal_frame frame;
+    struct equal_pair pair;
+    struct equal_pair *top;
+    uint64_t hash;
+    int count;
+    int k;
+
+    if (ctx->a == ctx->b && a == b)
+        return 1;
+
+    hash = yaml_document_hash_node(ctx->a, a);
+
+    if (hash != yaml_document_hash_node(ctx->b, b))
+        return 0;
+
+    if (node_a->type != node_b->type)
+        return 0;
+
+    if (node_a->tag != node_b->tag && (!node_a->tag || !node_b->tag
+                || strcmp((char *)node_a->tag, (char *)node_b->tag) != 0))
+        return 0;
+
+    if (node_a->type == YAML_SCALAR_NODE) {
+        return (node_a->data.scalar.length == node_b->data.scalar.length
+                && (node_a->data.scalar.value == node_b->data.scalar.value
+                    || memcmp(node_a->data.scalar.value,
+                        node_b->data.scalar.value,
+                        node_a->data.scalar.length) == 0));
+    }
+
+    memset(&frame, 0, sizeof(frame));
+    frame.a = a;
+    frame.b = b;
+
+    /*
+     * A node lying on or leading to a cycle is hashed by its shape only.
+     * Only such nodes may be compared again while their comparison is in
+     * progress, in which case they are assumed to be equal.
+     */
+
+    if (hash == (yaml_hash_mix(yaml_hash_shape(node_a)) | 1)) {
+        for (top = ctx->cycles.start; top < ctx->cycles.top; top ++) {
+            if (top->a == a && top->b == b)
+                return 1;
+        }
+        pair.a = a;
+        pair.b = b;
+        if (!PUSH(ctx, ctx->cycles, pair))
+            return 0;
+        frame.cyclic = 1;
+    }
+
+    if (node_a->type == YAML_SEQUENCE_NODE) {
+        count = node_a->data.sequence.items.top
+            - node_a->data.sequence.items.start;
+        if (count != node_b->data.sequence.items.top
+                - node_b->data.sequence.items.start)
+            goto unequal;
+    }
+    else {
+        count = node_a->data.mapping.pairs.top - node_a->data.mapping.pairs.start;
+        if (count != node_b->data.mapping.pairs.top
+                - node_b->data.mapping.pairs.start)
+            goto unequal;
+        if (count) {
+            frame.used = yaml_malloc(count);
+            if (!frame.used) goto error;
+            memset(frame.used, 0, count);
+        }
+        if (count > SMALL_MAPPING) {
+            frame.sorted = yaml_malloc(count*sizeof(*frame.sorted));
+            if (!frame.sorted) goto error;
+            for (k = 0; k < count; k ++) {
+                frame.sorted[k].pair = node_b->data.mapping.pairs.start + k;
+                frame.sorted[k].hash = yaml_document_hash_node(ctx->b,
+                        frame.sorted[k].pair->key);
+            }
+            qsort(frame.sorted, count, sizeof(*frame.sorted),
+                    yaml_hashed_pair_compare);
+        }
+    }
+
+    if (!PUSH(ctx, ctx->frames, frame)) goto error;
+
+    return -1;
+
+error:
+    ctx->error = YAML_MEMORY_ERROR;
+unequal:
+    yaml_free(frame.used);
+    yaml_free(frame.sorted);
+    if (frame.cyclic) {
+        (void)POP(ctx, ctx->cycles);
+    }
+    return 0;
+}
+
+/*
+ * Continue comparing the children of two collections.
+ *
+ * The argument `result` is the result of the last comparison the frame
+ * asked for, or -1 if the frame has just been pushed.  Returns the result of
+ * the frame, or sets `*a` and `*b` to the children to compare next and
+ * returns -1.
+ */
+
+static int
+yaml_node_equal_resume(struct equal_ctx *ctx, struct equal_frame *frame,
+        int result, int *a, int *b)
+{
+    yaml_node_t *node_a = ctx->a->nodes.start + frame->a - 1;
+    yaml_node_t *node_b = ctx->b->nodes.start + frame->b - 1;
+    yaml_node_pair_t *pair;
+
+    if (node_a->type == YAML_SEQUENCE_NODE)
+    {
+        if (!result)
+            return 0;
+        if (node_a->data.sequence.items.start + frame->position
+                == node_a->data.sequence.items.top)
+            return 1;
+        *a = node_a->data.sequence.items.start[frame->position];
+        *b = node_b->data.sequence.items.start[frame->position];
+        frame->position ++;
+        return -1;
+    }
+
+    if (result < 0) {
+        frame->candidate = -1;
+    }
+    else if (result && !frame->value) {
+        pair = frame->sorted ? frame->sorted[frame->candidate].pair
+            : node_b->data.mapping.pairs.start + frame->candidate;
+        frame->value = 1;
+        *a = node_a->data.mapping.pairs.start[frame->position].value;
+        *b = pair->value;
+        return -1;
+    }
+    else if (result) {
+        frame->used[frame->candidate] = 1;
+        frame->position ++;
+        frame->candidate = -1;
+    }
+
+    frame->value = 0;
+
+    if (node_a->data.mapping.pairs.start + frame->position
+            == node_a->data.mapping.pairs.top)
+        return 1;
+
+    return yaml_node_equal_match(ctx, frame, a, b);
+}
+
+/*
+ * Find the next unused pair of the second mapping that may match the current
+ * pair of the first one, and ask for the comparison of their keys.
+ */
+
+static int
+yaml_node_equal_match(struct equal_ctx *ctx, struct equal_frame *frame,
+        int *a, int *b)
+{
+    yaml_node_t *node_a = ctx->a->nodes.start + frame->a - 1;
+    yaml_node_t *node_b = ctx->b->nodes.start + frame->b - 1;
+    yaml_node_pair_t *pair = node_a->data.mapping.pairs.start + frame->position;
+    int count = node_b->data.mapping.pairs.top - node_b->data.mapping.pairs.start;
+    int low, high, middle;
+    uint64_t hash = 0;
+    int k = frame->candidate;
+
+    if (frame->sorted) {
+        hash = yaml_document_hash_node(ctx->a, pair->key);
+        if (k < 0) {
+            low = 0;
+            high = count;
+            while (low < high) {
+                middle = low + (high - low) / 2;
+                if (frame->sorted[middle].hash < hash)
+                    low = middle + 1;
+                else
+                    high = middle;
+            }
+            k = low - 1;
+        }
+    }
+
+    for (k ++; k < count; k ++) {
+        if (frame->sorted && frame->sorted[k].hash != hash)
+            break;
+        if (!frame->used[k])
+            break;
+    }
+
+    if (k == count || (frame->sorted && frame->sorted[k].hash != hash))
+        return 0;
+
+    frame->candidate = k;
+    *a = pair->key;
+    *b = frame->sorted ? frame->sorted[k].pair->key
+        : node_b->data.mapping.pairs.start[k].key;
+
+    return -1;
+}
+
+/*
+ * Drop the top frame of a comparison.
+ */
+
+static void
+yaml_node_equal_leave(struct equal_ctx *ctx)
+{
+    struct equal_frame frame = POP(ctx, ctx->frames);
+
+    yaml_free(frame.used);
+    yaml_free(frame.sorted);
+    if (frame.cyclic) {
+        (void)POP(ctx, ctx->cycles);
+    }
+}
+
+/*
+ * Order mapping pairs by the hashes of their keys.
+ */
+
+static int
+yaml_hashed_pair_compare(const void *a, const void *b)
+{
+    uint64_t hash_a = ((const struct hashed_pair *)a)->hash;
+    uint64_t hash_b = ((const struct hashed_pair *)b)->hash;
+
+    return (hash_a > hash_b) - (hash_a < hash_b);
+}
+
+/*
+ * Check if two nodes are structurally equal.
+ */
+
+YAML_DECLARE(int)
+yaml_node_equal(const yaml_document_t *document_a, int index_a,
+        const yaml_document_t *document_b, int index_b)
+{
+    struct equal_ctx ctx;
+    int result;
+
+    assert(document_a && document_b);
+                        /* Non-NULL document objects are expected. */
+    assert(index_a > 0
+            && document_a->nodes.start + index_a <= document_a->nodes.top);
+                        /* Valid node id is required. */
+    assert(index_b > 0
+            && document_b->nodes.start + index_b <= document_b->nodes.top);
+                        /* Valid node id is required. */
+
+    ctx.error = YAML_NO_ERROR;
+    ctx.a = document_a;
+    ctx.b = document_b;
+
+    if (!STACK_INIT(&ctx, ctx.frames, struct equal_frame *))
+        return 0;
+    if (!STACK_INIT(&ctx, ctx.cycles, struct equal_pair *)) {
+        STACK_DEL(&ctx, ctx.frames);
+        return 0;
+    }
+
+    result = yaml_node_equal_internal(&ctx, index_a, index_b);
+
+    STACK_DEL(&ctx, ctx.cycles);
+    STACK_DEL(&ctx, ctx.frames);
+
+    return (ctx.error == YAML_NO_ERROR) ? result : 0;
+}
+
+/*
+ * Check if two documents are structurally equal.
+ */
+
+YAML_DECLARE(int)
+yaml_document_equal(const yaml_document_t *document_a,
+        const yaml_document_t *document_b)
+{
+    int empty_a, empty_b;
+
+    assert(document_a && document_b);
+                        /* Non-NULL document objects are expected. */
+
+    empty_a = (document_a->nodes.start == document_a->nodes.top);
+    empty_b = (document_b->nodes.start == document_b->nodes.top);
+
+    if (empty_a || empty_b)
+        return (empty_a && empty_b);
+
+    return yaml_node_equal(document_a, 1, document_b, 1);
+}
+
@@ -0,0 +1,1455 @@
+
+#include "yaml_private.h"
+
+/*
+ * Document differences.
+ *
+ * An edit script is a document in the JSON Patch format (RFC 6902): a
+ * sequence of mappings with the keys "op", "path", and "value".  The only
+ * operations are "add", "remove", and "replace".  Paths are JSON Pointers
+ * (RFC 6901): mapping values are addressed by the values of their scalar
+ * keys, sequence items by their positions.  Since a patch is a plain
+ * document, it may be dumped, sent, and loaded like any other document.
+ */
+
+/*
+ * The maximum size of the table used to align sequences.  Longer sequences
+ * are compared item by item.
+ */
+
+#define MAX_LCS_CELLS   (1 << 20)
+
+/*
+ * The state of a subtree import.
+ */
+
+struct import_ctx {
+    yaml_document_t *target;
+    yaml_document_t *source;
+    int *map;
+    int *marks;
+    int generation;
+};
+
+/*
+ * The state of a diff.
+ */
+
+struct diff_ctx {
+    yaml_error_type_t error;
+    yaml_document_t *old_document;
+    yaml_document_t *new_document;
+    yaml_document_t *patch;
+    int root;
+    yaml_string_t path;
+    struct import_ctx import;
+
+    /* The number of references to each old node. */
+    int *refs;
+
+    /*
+     * For the old nodes with several references: the new node they were
+     * first diffed with, the number of visits, and the state below.
+     */
+    int *partners;
+    int *visits;
+    unsigned char *states;
+};
+
+/*
+ * The operations of the first visit changed the node, which the patch does
+ * on all its paths.
+ */
+
+#define DIFF_EDITED     1
+
+/*
+ * The node is replaced on every path where it differs.
+ */
+
+#define DIFF_REPLACED   2
+
+/*
+ * An item of either of the sequences being aligned.
+ */
+
+struct diff_item {
+    uint64_t hash;
+    yaml_document_t *document;
+    int index;
+    int *klass;
+};
+
+/*
+ * Import.
+ */
+
+static int
+yaml_import_initialize(struct import_ctx *ctx,
+        yaml_document_t *target, yaml_document_t *source);
+
+static void
+yaml_import_delete(struct import_ctx *ctx);
+
+static int
+yaml_import_node(struct import_ctx *ctx, int index);
+
+static int
+yaml_import_binary(struct import_ctx *ctx, yaml_node_t *node);
+
+/*
+ * Diff.
+ */
+
+static int
+yaml_diff_path_push(struct diff_ctx *ctx, const yaml_char_t *segment,
+        size_t length);
+
+static int
+yaml_diff_path_push_index(struct diff_ctx *ctx, int index);
+
+static int
+yaml_diff_emit(struct diff_ctx *ctx, const char *op, int value);
+
+static int
+yaml_diff_node(struct diff_ctx *ctx, int old_index, int new_index);
+
+static int
+yaml_diff_value(struct diff_ctx *ctx, int old_index, int new_index);
+
+static int
+yaml_diff_whole(struct diff_ctx *ctx, int old_index, int new_index);
+
+static int
+yaml_diff_shared(struct diff_ctx *ctx, int old_index, int new_index);
+
+static int
+yaml_diff_count(struct diff_ctx *ctx);
+
+static int
+yaml_diff_pass(struct diff_ctx *ctx, int *again);
+
+static int
+yaml_diff_keyable(yaml_document_t *document, yaml_node_t *node);
+
+static yaml_node_pair_t *
+yaml_diff_find_key(yaml_document_t *document, yaml_node_t *mapping,
+        yaml_node_t *key);
+
+static int
+yaml_diff_mapping(struct diff_ctx *ctx, int old_index, int new_index);
+
+static int
+yaml_diff_classify(struct diff_ctx *ctx, int *old_classes, int *new_classes,
+        yaml_node_item_t *old_items, int old_count,
+        yaml_node_item_t *new_items, int new_count);
+
+static int
+yaml_diff_item_compare(const void *a, const void *b);
+
+static int
+yaml_diff_run(struct diff_ctx *ctx, size_t length, int *position,
+        yaml_node_item_t *old_items, int old_count,
+        yaml_node_item_t *new_items, int new_count);
+
+static int
+yaml_diff_sequence(struct diff_ctx *ctx, int old_index, int new_index);
+
+/*
+ * Patch.
+ */
+
+static yaml_char_t *
+yaml_patch_get(yaml_document_t *patch, yaml_node_t *operation,
+        const char *key, int *index);
+
+static int
+yaml_patch_segment_equal(const yaml_char_t *segment, size_t segment_length,
+        const yaml_char_t *value, size_t length);
+
+static int
+yaml_patch_segment_index(const yaml_char_t *segment, size_t length,
+        int count);
+
+static int
+yaml_patch_locate(yaml_document_t *document, const yaml_char_t *path,
+        size_t length, int *parent, const yaml_char_t **segment,
+        size_t *segment_length);
+
+static void
+yaml_patch_clear(yaml_document_t *document);
+
+static int
+yaml_patch_set_root(yaml_document_t *document, int index);
+
+static int
+yaml_patch_operation(yaml_document_t *document, yaml_document_t *patch,
+        yaml_node_t *operation, struct import_ctx *import);
+
+/*
+ * Prepare to import nodes of one document into another.
+ */
+
+static int
+yaml_import_initialize(struct import_ctx *ctx,
+        yaml_document_t *target, yaml_document_t *source)
+{
+    size_t count = source->nodes.top - source->nodes.start;
+
+    ctx->target = target;
+    ctx->source = source;
+    ctx->generation = 0;
+    ctx->map = yaml_malloc(count*sizeof(int));
+    ctx->marks = yaml_malloc(count*sizeof(int));
+
+    if (!ctx->map || !ctx->marks) {
+        yaml_import_delete(ctx);
+        return 0;
+    }
+
+    memset(ctx->marks, 0, count*sizeof(int));
+
+    return 1;
+}
+
+/*
+ * Release the import tables.
+ */
+
+static void
+yaml_import_delete(struct import_ctx *ctx)
+{
+    yaml_free(ctx->map);
+    yaml_free(ctx->marks);
+    ctx->map = ctx->marks = NULL;
+}
+
+/*
+ * Copy a decoded binary scalar, whose octets are not UTF-8.
+ */
+
+static int
+yaml_import_binary(struct import_ctx *ctx, yaml_node_t *node)
+{
+    yaml_char_t *tag = yaml_strdup(node->tag);
+    yaml_char_t *value = YAML_MALLOC(node->data.scalar.length+1);
+    int copy = 0;
+
+    if (tag && value) {
+        memcpy(value, node->data.scalar.value, node->data.scalar.length+1);
+        copy = yaml_document_adopt_scalar(ctx->target, tag, value,
+                (int)node->data.scalar.length, node->data.scalar.style,
+                YAML_ADOPT_TRUSTED);
+    }
+
+    if (!copy) {
+        yaml_free(tag);
+        yaml_free(value);
+        return 0;
+    }
+
+    ctx->target->nodes.start[copy-1].resolved.type
+        = YAML_BINARY_SCALAR_TYPE;
+
+    return copy;
+}
+
+/*
+ * Copy a subtree of the source document into the target document.  Nodes
+ * referenced several times within the subtree are copied once.  Start a new
+ * generation before importing an unrelated subtree.
+ */
+
+static int
+yaml_import_node(struct import_ctx *ctx, int index)
+{
+    yaml_node_t *node = ctx->source->nodes.start + index - 1;
+    yaml_node_item_t *item;
+    yaml_node_pair_t *pair;
+    int copy = 0;
+    int key, value;
+
+    if (ctx->marks[index-1] == ctx->generation)
+        return ctx->map[index-1];
+
+    switch (node->type)
+    {
+        case YAML_SCALAR_NODE:
+            if (node->resolved.type == YAML_BINARY_SCALAR_TYPE) {
+                copy = yaml_import_binary(ctx, node);
+                break;
+            }
+            copy = yaml_document_add_scalar(ctx->target, node->tag,
+                    node->data.scalar.value, node->data.scalar.length,
+                    node->data.scalar.style);
+            break;
+
+        case YAML_SEQUENCE_NODE:
+            copy = yaml_document_add_sequence(ctx->target, node->tag,
+                    node->data.sequence.style);
+            break;
+
+        case YAML_MAPPING_NODE:
+            copy = yaml_document_add_mapping(ctx->target, node->tag,
+                    node->data.mapping.style);
+            break;
+
+        default:
+            assert(0);      /* Should not happen. */
+    }
+
+    if (!copy) return 0;
+
+    ctx->marks[index-1] = ctx->generation;
+    ctx->map[index-1] = copy;
+
+    if (node->type == YAML_SEQUENCE_NODE) {
+        for (item = node->data.sequence.items.start;
+                item < node->data.sequence.items.top; item ++) {
+            value = yaml_import_node(ctx, *item);
+            if (!value) return 0;
+            if (!yaml_document_append_sequence_item(ctx->target, copy, value))
+                return 0;
+        }
+    }
+
+    if (node->type == YAML_MAPPING_NODE) {
+        for (pair = node->data.mapping.pairs.start;
+                pair < node->data.mapping.pairs.top; pair ++) {
+            key = yaml_import_node(ctx, pair->key);
+            if (!key) return 0;
+            value = yaml_import_node(ctx, pair->value);
+            if (!value) return 0;
+            if (!yaml_document_append_mapping_pair(ctx->target,
+                        copy, key, value))
+                return 0;
+        }
+    }
+
+    return copy;
+}
+
+/*
+ * Append an escaped reference token to the current path.
+ */
+
+static int
+yaml_diff_path_push(struct diff_ctx *ctx, const yaml_char_t *segment,
+        size_t length)
+{
+    size_t k;
+
+    if (!STRING_EXTEND(ctx, ctx->path))
+        return 0;
+    *(ctx->path.pointer++) = '/';
+
+    for (k = 0; k < length; k ++) {
+        if (!STRING_EXTEND(ctx, ctx->path))
+            return 0;
+        if (segment[k] == '~') {
+            *(ctx->path.pointer++) = '~';
+            *(ctx->path.pointer++) = '0';
+        }
+        else if (segment[k] == '/') {
+            *(ctx->path.pointer++) = '~';
+            *(ctx->path.pointer++) = '1';
+        }
+        else {
+            *(ctx->path.pointer++) = segment[k];
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * Append a sequence position to the current path.
+ */
+
+static int
+yaml_diff_path_push_index(struct diff_ctx *ctx, int index)
+{
+    char buffer[16];
+
+    sprintf(buffer, "%d", index);
+
+    return yaml_diff_path_push(ctx,
+            (yaml_char_t *)buffer, strlen(buffer));
+}
+
+/*
+ * Append an operation on the current path to the patch.  The value is a node
+ * of the new document or @c 0.
+ */
+
+static int
+yaml_diff_emit(struct diff_ctx *ctx, const char *op, int value)
+{
+    yaml_document_t *patch = ctx->patch;
+    int operation, key, node;
+
+    operation = yaml_document_add_mapping(patch, NULL,
+            YAML_BLOCK_MAPPING_STYLE);
+    if (!operation) return 0;
+    if (!yaml_document_append_sequence_item(patch, ctx->root, operation))
+        return 0;
+
+    key = yaml_document_add_scalar(patch, NULL,
+            (yaml_char_t *)"op", -1, YAML_ANY_SCALAR_STYLE);
+    node = yaml_document_add_scalar(patch, NULL,
+            (yaml_char_t *)op, -1, YAML_ANY_SCALAR_STYLE);
+    if (!key || !node) return 0;
+    if (!yaml_document_append_mapping_pair(patch, operation, key, node))
+        return 0;
+
+    key = yaml_document_add_scalar(patch, NULL,
+            (yaml_char_t *)"path", -1, YAML_ANY_SCALAR_STYLE);
+    node = yaml_document_add_scalar(patch, NULL, ctx->path.start,
+            ctx->path.pointer - ctx->path.start, YAML_ANY_SCALAR_STYLE);
+    if (!key || !node) return 0;
+    if (!yaml_document_append_mapping_pair(patch, operation, key, node))
+        return 0;
+
+    if (value) {
+        ctx->import.generation ++;
+        key = yaml_document_add_scalar(patch, NULL,
+                (yaml_char_t *)"value", -1, YAML_ANY_SCALAR_STYLE);
+        node = key ? yaml_import_node(&ctx->import, value) : 0;
+        if (!key || !node) return 0;
+        if (!yaml_document_append_mapping_pair(patch, operation, key, node))
+            return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Produce the operations turning an old node into a new one.
+ *
+ * The patch changes a node in place, so the changes of a node with several
+ * references are seen on all its paths.  Such a node is diffed on the first
+ * visit only; every later visit, including the one closing a cycle, compares
+ * the new node with the one of the first visit.
+ */
+
+static int
+yaml_diff_node(struct diff_ctx *ctx, int old_index, int new_index)
+{
+    if (ctx->refs[old_index-1] > 1)
+        return yaml_diff_shared(ctx, old_index, new_index);
+
+    return yaml_diff_value(ctx, old_index, new_index);
+}
+
+/*
+ * Produce the operations turning the content of an old node into the content
+ * of a new one.
+ */
+
+static int
+yaml_diff_value(struct diff_ctx *ctx, int old_index, int new_index)
+{
+    yaml_node_t *old_node = ctx->old_document->nodes.start + old_index - 1;
+
+    if (yaml_node_equal(ctx->old_document, old_index,
+                ctx->new_document, new_index))
+        return 1;
+
+    if (yaml_diff_whole(ctx, old_index, new_index))
+        return yaml_diff_emit(ctx, "replace", new_index);
+
+    if (old_node->type == YAML_SEQUENCE_NODE)
+        return yaml_diff_sequence(ctx, old_index, new_index);
+
+    return yaml_diff_mapping(ctx, old_index, new_index);
+}
+
+/*
+ * Check if an old node is replaced as a whole rather than changed.  A mapping
+ * is replaced if its keys cannot address its pairs, if a key changes its tag,
+ * or if a new key cannot be created from a path.
+ */
+
+static int
+yaml_diff_whole(struct diff_ctx *ctx, int old_index, int new_index)
+{
+    yaml_node_t *old_node = ctx->old_document->nodes.start + old_index - 1;
+    yaml_node_t *new_node = ctx->new_document->nodes.start + new_index - 1;
+    yaml_node_pair_t *pair;
+    yaml_node_pair_t *match;
+    yaml_node_t *key;
+    yaml_node_t *match_key;
+
+    if (old_node->type != new_node->type
+            || strcmp((char *)old_node->tag, (char *)new_node->tag) != 0
+            || old_node->type == YAML_SCALAR_NODE)
+        return 1;
+
+    if (old_node->type == YAML_SEQUENCE_NODE)
+        return 0;
+
+    if (!yaml_diff_keyable(ctx->old_document, old_node)
+            || !yaml_diff_keyable(ctx->new_document, new_node))
+        return 1;
+
+    for (pair = new_node->data.mapping.pairs.start;
+            pair < new_node->data.mapping.pairs.top; pair ++) {
+        key = ctx->new_document->nodes.start + pair->key - 1;
+        match = yaml_diff_find_key(ctx->old_document, old_node, key);
+        match_key = match ? ctx->old_document->nodes.start + match->key - 1
+            : NULL;
+        if (strcmp((char *)key->tag, (char *)(match_key ? match_key->tag
+                        : (yaml_char_t *)YAML_DEFAULT_SCALAR_TAG)) != 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Visit an old node with several references.
+ */
+
+static int
+yaml_diff_shared(struct diff_ctx *ctx, int old_index, int new_index)
+{
+    yaml_node_t *root = ctx->patch->nodes.start + ctx->root - 1;
+    int *partner = ctx->partners + old_index - 1;
+    unsigned char *state = ctx->states + old_index - 1;
+    size_t count;
+
+    ctx->visits[old_index-1] ++;
+
+    if (*state & DIFF_REPLACED) {
+        if (yaml_node_equal(ctx->old_document, old_index,
+                    ctx->new_document, new_index))
+            return 1;
+        return yaml_diff_emit(ctx, "replace", new_index);
+    }
+
+    if (*partner) {
+        if (*partner == new_index || yaml_node_equal(ctx->new_document,
+                    *partner, ctx->new_document, new_index))
+            return 1;
+        return yaml_diff_emit(ctx, "replace", new_index);
+    }
+
+    /* Replacing the node on one path keeps it on the others. */
+
+    if (!yaml_node_equal(ctx->old_document, old_index,
+                ctx->new_document, new_index)
+            && yaml_diff_whole(ctx, old_index, new_index))
+        return yaml_diff_emit(ctx, "replace", new_index);
+
+    *partner = new_index;
+    count = root->data.sequence.items.top - root->data.sequence.items.start;
+
+    if (!yaml_diff_value(ctx, old_index, new_index))
+        return 0;
+
+    /* The patch nodes may have moved. */
+
+    root = ctx->patch->nodes.start + ctx->root - 1;
+    if (count != (size_t)(root->data.sequence.items.top
+                - root->data.sequence.items.start)) {
+        *state |= DIFF_EDITED;
+    }
+
+    return 1;
+}
+
+/*
+ * Count the references to the old nodes.  The root is referenced by the
+ * document.
+ */
+
+static int
+yaml_diff_count(struct diff_ctx *ctx)
+{
+    yaml_document_t *document = ctx->old_document;
+    size_t count = document->nodes.top - document->nodes.start;
+    yaml_node_t *node;
+    yaml_node_item_t *item;
+    yaml_node_pair_t *pair;
+
+    ctx->refs = yaml_malloc(count*sizeof(int));
+    ctx->partners = yaml_malloc(count*sizeof(int));
+    ctx->visits = yaml_malloc(count*sizeof(int));
+    ctx->states = yaml_malloc(count);
+    if (!ctx->refs || !ctx->partners || !ctx->visits || !ctx->states) {
+        ctx->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+
+    memset(ctx->refs, 0, count*sizeof(int));
+    memset(ctx->states, 0, count);
+    if (count) {
+        ctx->refs[0] = 1;
+    }
+
+    for (node = document->nodes.start; node < document->nodes.top; node ++) {
+        if (node->type == YAML_SEQUENCE_NODE) {
+            for (item = node->data.sequence.items.start;
+                    item < node->data.sequence.items.top; item ++) {
+                ctx->refs[*item-1] ++;
+            }
+        }
+        if (node->type == YAML_MAPPING_NODE) {
+            for (pair = node->data.mapping.pairs.start;
+                    pair < node->data.mapping.pairs.top; pair ++) {
+                ctx->refs[pair->key-1] ++;
+                ctx->refs[pair->value-1] ++;
+            }
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * Produce the operations of the whole documents.
+ *
+ * A shared node changed on its first visit is changed on the paths that were
+ * not visited as well, which are the paths where it is kept as it was.  Such
+ * a node is replaced on the next pass instead.
+ */
+
+static int
+yaml_diff_pass(struct diff_ctx *ctx, int *again)
+{
+    size_t count = ctx->old_document->nodes.top
+        - ctx->old_document->nodes.start;
+    int old_empty = (count == 0);
+    int new_empty = (ctx->new_document->nodes.start
+            == ctx->new_document->nodes.top);
+    size_t k;
+
+    *again = 0;
+
+    memset(ctx->partners, 0, count*sizeof(int));
+    memset(ctx->visits, 0, count*sizeof(int));
+    for (k = 0; k < count; k ++) {
+        ctx->states[k] &= ~DIFF_EDITED;
+    }
+
+    if (!yaml_document_initialize(ctx->patch, NULL, NULL, NULL, 1, 1))
+        return 0;
+
+    ctx->root = yaml_document_add_sequence(ctx->patch, NULL,
+            YAML_BLOCK_SEQUENCE_STYLE);
+    if (!ctx->root) return 0;
+
+    if (!old_empty && !new_empty) {
+        if (!yaml_diff_node(ctx, 1, 1))
+            return 0;
+    }
+    else if (!new_empty) {
+        if (!yaml_diff_emit(ctx, "add", 1))
+            return 0;
+    }
+    else if (!old_empty) {
+        if (!yaml_diff_emit(ctx, "remove", 0))
+            return 0;
+    }
+
+    if (ctx->error != YAML_NO_ERROR)
+        return 0;
+
+    for (k = 0; k < count; k ++) {
+        if ((ctx->states[k] & DIFF_EDITED)
+                && ctx->visits[k] < ctx->refs[k]) {
+            ctx->states[k] |= DIFF_REPLACED;
+            *again = 1;
+        }
+    }
+
+    if (*again) {
+        yaml_document_delete(ctx->patch);
+    }
+
+    return 1;
+}
+
+/*
+ * Check if the pairs of a mapping may be addressed by their keys, that is,
+ * if all keys are scalars with distinct values.
+ */
+
+static int
+yaml_diff_keyable(yaml_document_t *document, yaml_node_t *node)
+{
+    yaml_node_pair_t *pair;
+    yaml_node_t *key;
+
+    for (pair = node->data.mapping.pairs.start;
+            pair < node->data.mapping.pairs.top; pair ++) {
+        key = document->nodes.start + pair->key - 1;
+        if (key->type != YAML_SCALAR_NODE)
+            return 0;
+        if (yaml_diff_find_key(document, node, key) != pair)
+            return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Find the first pair of a mapping whose key has the same value as the given
+ * scalar.
+ */
+
+static yaml_node_pair_t *
+yaml_diff_find_key(yaml_document_t *document, yaml_node_t *mapping,
+        yaml_node_t *key)
+{
+    yaml_node_pair_t *pair;
+    yaml_node_t *node;
+
+    for (pair = mapping->data.mapping.pairs.start;
+            pair < mapping->data.mapping.pairs.top; pair ++) {
+        node = document->nodes.start + pair->key - 1;
+        if (node->type == YAML_SCALAR_NODE
+                && node->data.scalar.length == key->data.scalar.length
+                && memcmp(node->data.scalar.value, key->data.scalar.value,
+                    key->data.scalar.length) == 0)
+            return pair;
+    }
+
+    return NULL;
+}
+
+/*
+ * Produce the operations turning an old mapping into a new one.
+ */
+
+static int
+yaml_diff_mapping(struct diff_ctx *ctx, int old_index, int new_index)
+{
+    yaml_node_t *old_node = ctx->old_document->nodes.start + old_index - 1;
+    yaml_node_t *new_node = ctx->new_document->nodes.start + new_index - 1;
+    yaml_node_pair_t *pair;
+    yaml_node_pair_t *match;
+    yaml_node_t *key;
+    size_t length = ctx->path.pointer - ctx->path.start;
+
+    for (pair = old_node->data.mapping.pairs.start;
+            pair < old_node->data.mapping.pairs.top; pair ++) {
+        key = ctx->old_document->nodes.start + pair->key - 1;
+        if (!yaml_diff_find_key(ctx->new_document, new_node, key)) {
+            if (!yaml_diff_path_push(ctx, key->data.scalar.value,
+                        key->data.scalar.length))
+                return 0;
+            if (!yaml_diff_emit(ctx, "remove", 0))
+                return 0;
+            ctx->path.pointer = ctx->path.start + length;
+        }
+    }
+
+    for (pair = new_node->data.mapping.pairs.start;
+            pair < new_node->data.mapping.pairs.top; pair ++) {
+        key = ctx->new_document->nodes.start + pair->key - 1;
+        match = yaml_diff_find_key(ctx->old_document, old_node, key);
+        if (!yaml_diff_path_push(ctx, key->data.scalar.value,
+                    key->data.scalar.length))
+            return 0;
+        if (match) {
+            if (!yaml_diff_node(ctx, match->value, pair->value))
+                return 0;
+        }
+        else {
+            if (!yaml_diff_emit(ctx, "add", pair->value))
+                return 0;
+        }
+        ctx->path.pointer = ctx->path.start + length;
+    }
+
+    return 1;
+}
+
+/*
+ * Number the items of two sequences so that equal items get equal numbers.
+ */
+
+static int
+yaml_diff_classify(struct diff_ctx *ctx, int *old_classes, int *new_classes,
+        yaml_node_item_t *old_items, int old_count,
+        yaml_node_item_t *new_items, int new_count)
+{
+    struct diff_item *items;
+    int count = old_count + new_count;
+    int classes = 0;
+    int first, k, j;
+
+    items = yaml_malloc(count*sizeof(*items));
+    if (!items) {
+        ctx->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+
+    for (k = 0; k < count; k ++) {
+        if (k < old_count) {
+            items[k].document = ctx->old_document;
+            items[k].index = old_items[k];
+            items[k].klass = old_classes + k;
+        }
+        else {
+            items[k].document = ctx->new_document;
+            items[k].index = new_items[k-old_count];
+            items[k].klass = new_classes + k - old_count;
+        }
+        items[k].hash = yaml_document_hash_node(items[k].document,
+                items[k].index);
+        *items[k].klass = 0;
+    }
+
+    qsort(items, count, sizeof(*items), yaml_diff_item_compare);
+
+    for (first = 0; first < count; first = k) {
+        for (k = first; k < count && items[k].hash == items[first].hash; k ++) {
+            for (j = first; j < k; j ++) {
+                if (yaml_node_equal(items[j].document, items[j].index,
+                            items[k].document, items[k].index)) {
+                    *items[k].klass = *items[j].klass;
+                    break;
+                }
+            }
+            if (!*items[k].klass) {
+                *items[k].klass = ++ classes;
+            }
+        }
+    }
+
+    yaml_free(items);
+
+    return 1;
+}
+
+/*
+ * Order sequence items by their hashes.
+ */
+
+static int
+yaml_diff_item_compare(const void *a, const void *b)
+{
+    uint64_t hash_a = ((const struct diff_item *)a)->hash;
+    uint64_t hash_b = ((const struct diff_item *)b)->hash;
+
+    return (hash_a > hash_b) - (hash_a < hash_b);
+}
+
+/*
+ * Produce the operations replacing a run of old items with a run of new
+ * items.  The items are paired and compared first; the remaining old items
+ * are removed and the remaining new items are added.
+ */
+
+static int
+yaml_diff_run(struct diff_ctx *ctx, size_t length, int *position,
+        yaml_node_item_t *old_items, int old_count,
+        yaml_node_item_t *new_items, int new_count)
+{
+    int k;
+
+    for (k = 0; k < old_count || k < new_count; k ++)
+    {
+        if (!yaml_diff_path_push_index(ctx, *position))
+            return 0;
+
+        if (k < old_count && k < new_count) {
+            if (!yaml_diff_node(ctx, old_items[k], new_items[k]))
+                return 0;
+            (*position) ++;
+        }
+        else if (k < old_count) {
+            if (!yaml_diff_emit(ctx, "remove", 0))
+                return 0;
+        }
+        else {
+            if (!yaml_diff_emit(ctx, "add", new_items[k]))
+                return 0;
+            (*position) ++;
+        }
+
+        ctx->path.pointer = ctx->path.start + length;
+    }
+
+    return 1;
+}
+
+/*
+ * Produce the operations turning an old sequence into a new one.  The common
+ * prefix and suffix are skipped and the rest is aligned by the longest common
+ * subsequence, unless it is too long, in which case the items are compared
+ * pairwise.
+ */
+
+static int
+yaml_diff_sequence(struct diff_ctx *ctx, int old_index, int new_index)
+{
+    yaml_node_t *old_node = ctx->old_document->nodes.start + old_index - 1;
+    yaml_node_t *new_node = ctx->new_document->nodes.start + new_index - 1;
+    yaml_node_item_t *old_items = old_node->data.sequence.items.start;
+    yaml_node_item_t *new_items = new_node->data.sequence.items.start;
+    int old_count = old_node->data.sequence.items.top - old_items;
+    int new_count = new_node->data.sequence.items.top - new_items;
+    size_t length = ctx->path.pointer - ctx->path.start;
+    int *old_classes = NULL;
+    int *new_classes = NULL;
+    int *table = NULL;
+    int prefix = 0;
+    int position;
+    int width;
+    int i, j, i0, j0;
+    int result = 0;
+
+    while (prefix < old_count && prefix < new_count
+            && yaml_node_equal(ctx->old_document, old_items[prefix],
+                ctx->new_document, new_items[prefix]))
+        prefix ++;
+
+    while (old_count > prefix && new_count > prefix
+            && yaml_node_equal(ctx->old_document, old_items[old_count-1],
+                ctx->new_document, new_items[new_count-1])) {
+        old_count --;
+        new_count --;
+    }
+
+    old_items += prefix;
+    new_items += prefix;
+    old_count -= prefix;
+    new_count -= prefix;
+    position = prefix;
+
+    if (!old_count || !new_count
+            || (size_t)(old_count+1) * (size_t)(new_count+1) > MAX_LCS_CELLS)
+        return yaml_diff_run(ctx, length, &position,
+                old_items, old_count, new_items, new_count);
+
+    width = new_count + 1;
+    old_classes = yaml_malloc(old_count*sizeof(int));
+    new_classes = yaml_malloc(new_count*sizeof(int));
+    table = yaml_malloc((old_count+1)*width*sizeof(int));
+    if (!old_classes || !new_classes || !table) {
+        ctx->error = YAML_MEMORY_ERROR;
+        goto error;
+    }
+
+    if (!yaml_diff_classify(ctx, old_classes, new_classes,
+                old_items, old_count, new_items, new_count))
+        goto error;
+
+    for (i = old_count; i >= 0; i --) {
+        for (j = new_count; j >= 0; j --) {
+            if (i == old_count || j == new_count)
+                table[i*width+j] = 0;
+            else if (old_classes[i] == new_classes[j])
+                table[i*width+j] = table[(i+1)*width+j+1] + 1;
+            else if (table[(i+1)*width+j] >= table[i*width+j+1])
+                table[i*width+j] = table[(i+1)*width+j];
+            else
+                table[i*width+j] = table[i*width+j+1];
+        }
+    }
+
+    i = i0 = 0;
+    j = j0 = 0;
+    while (i < old_count || j < new_count)
+    {
+        if (i < old_count && j < new_count
+                && old_classes[i] == new_classes[j]) {
+            if (!yaml_diff_run(ctx, length, &position,
+                        old_items+i0, i-i0, new_items+j0, j-j0))
+                goto error;
+            position ++;
+            i0 = ++ i;
+            j0 = ++ j;
+        }
+        else if (j == new_count || (i < old_count
+                    && table[(i+1)*width+j] >= table[i*width+j+1])) {
+            i ++;
+        }
+        else {
+            j ++;
+        }
+    }
+
+    if (!yaml_diff_run(ctx, length, &position,
+                old_items+i0, i-i0, new_items+j0, j-j0))
+        goto error;
+
+    result = 1;
+
+error:
+    yaml_free(old_classes);
+    yaml_free(new_classes);
+    yaml_free(table);
+
+    return result;
+}
+
+/*
+ * Compute the differences between two documents.
+ */
+
+YAML_DECLARE(int)
+yaml_document_diff(yaml_document_t *old_document,
+        yaml_document_t *new_document, yaml_document_t *patch)
+{
+    struct diff_ctx ctx;
+    int again = 1;
+
+    assert(old_document);   /* Non-NULL document object is expected. */
+    assert(new_document);   /* Non-NULL document object is expected. */
+    assert(patch);          /* Non-NULL patch object is expected. */
+
+    memset(&ctx, 0, sizeof(ctx));
+    memset(patch, 0, sizeof(*patch));
+
+    ctx.old_document = old_document;
+    ctx.new_document = new_document;
+    ctx.patch = patch;
+
+    if (!yaml_diff_count(&ctx))
+        goto error;
+
+    if (!STRING_INIT(&ctx, ctx.path, INITIAL_STRING_SIZE))
+        goto error;
+
+    while (again) {
+        if (!yaml_import_initialize(&ctx.import, patch, new_document))
+            goto error;
+        if (!yaml_diff_pass(&ctx, &again))
+            goto error;
+        yaml_import_delete(&ctx.import);
+    }
+
+    STRING_DEL(&ctx, ctx.path);
+    yaml_free(ctx.refs);
+    yaml_free(ctx.partners);
+    yaml_free(ctx.visits);
+    yaml_free(ctx.states);
+
+    return 1;
+
+error:
+
+    STRING_DEL(&ctx, ctx.path);
+    yaml_import_delete(&ctx.import);
+    yaml_free(ctx.refs);
+    yaml_free(ctx.partners);
+    yaml_free(ctx.visits);
+    yaml_free(ctx.states);
+    yaml_document_delete(patch);
+
+    return 0;
+}
+
+/*
+ * Get the value of a key of a patch operation.
+ */
+
+static yaml_char_t *
+yaml_patch_get(yaml_document_t *patch, yaml_node_t *operation,
+        const char *key, int *index)
+{
+    yaml_node_pair_t *pair;
+    yaml_node_t *node;
+
+    for (pair = operation->data.mapping.pairs.start;
+            pair < operation->data.mapping.pairs.top; pair ++) {
+        node = patch->nodes.start + pair->key - 1;
+        if (node->type == YAML_SCALAR_NODE
+                && strcmp((char *)node->data.scalar.value, key) == 0) {
+            node = patch->nodes.start + pair->value - 1;
+            if (index) {
+                *index = pair->value;
+            }
+            return (node->type == YAML_SCALAR_NODE) ?
+                node->data.scalar.value : NULL;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Check if an escaped reference token matches a scalar value.
+ */
+
+static int
+yaml_patch_segment_equal(const yaml_char_t *segment, size_t segment_length,
+        const yaml_char_t *value, size_t length)
+{
+    size_t k = 0, j = 0;
+    yaml_char_t ch;
+
+    while (k < segment_length) {
+        ch = segment[k++];
+        if (ch == '~') {
+            if (k == segment_length)
+                return 0;
+            ch = (segment[k++] == '1') ? '/' : '~';
+        }
+        if (j == length || value[j++] != ch)
+            return 0;
+    }
+
+    return (j == length);
+}
+
+/*
+ * Parse a reference token as a sequence position.  The token "-" refers to
+ * the position after the last item.
+ */
+
+static int
+yaml_patch_segment_index(const yaml_char_t *segment, size_t length,
+        int count)
+{
+    size_t k;
+    int index = 0;
+
+    if (length == 1 && segment[0] == '-')
+        return count;
+
+    if (!length || (length > 1 && segment[0] == '0'))
+        return -1;
+
+    for (k = 0; k < length; k ++) {
+        if (segment[k] < '0' || segment[k] > '9' || index > count)
+            return -1;
+        index = index*10 + (segment[k] - '0');
+    }
+
+    return (index <= count) ? index : -1;
+}
+
+/*
+ * Find the parent node of a path and its last reference token.
+ */
+
+static int
+yaml_patch_locate(yaml_document_t *document, const yaml_char_t *path,
+        size_t length, int *parent, const yaml_char_t **segment,
+        size_t *segment_length)
+{
+    const yaml_char_t *end = path + length;
+    const yaml_char_t *pointer = path;
+    const yaml_char_t *next;
+    yaml_node_t *node;
+    yaml_node_t *key_node;
+    yaml_node_pair_t *pair;
+    int index = 1;
+    int count;
+    int position;
+
+    *parent = 0;
+
+    if (pointer == end)
+        return 1;
+
+    if (*pointer != '/' || document->nodes.start == document->nodes.top)
+        return 0;
+
+    while (1)
+    {
+        pointer ++;
+        for (next = pointer; next < end && *next != '/'; next ++);
+
+        if (next == end) {
+            *parent = index;
+            *segment = pointer;
+            *segment_length = next - pointer;
+            return 1;
+        }
+
+        node = document->nodes.start + index - 1;
+
+        if (node->type == YAML_SEQUENCE_NODE) {
+            count = node->data.sequence.items.top
+                - node->data.sequence.items.start;
+            position = yaml_patch_segment_index(pointer, next-pointer, count);
+            if (position < 0 || position == count)
+                return 0;
+            index = node->data.sequence.items.start[position];
+        }
+        else if (node->type == YAML_MAPPING_NODE) {
+            for (pair = node->data.mapping.pairs.start;
+                    pair < node->data.mapping.pairs.top; pair ++) {
+                key_node = document->nodes.start + pair->key - 1;
+                if (key_node->type == YAML_SCALAR_NODE
+                        && yaml_patch_segment_equal(pointer, next-pointer,
+                            key_node->data.scalar.value,
+                            key_node->data.scalar.length))
+                    break;
+            }
+            if (pair == node->data.mapping.pairs.top)
+                return 0;
+            index = pair->value;
+        }
+        else {
+            return 0;
+        }
+
+        pointer = next;
+    }
+}
+
+/*
+ * Remove all nodes of a document.
+ */
+
+static void
+yaml_patch_clear(yaml_document_t *document)
+{
+    yaml_node_t *node;
+
+    while (document->nodes.top != document->nodes.start) {
+        node = -- document->nodes.top;
+        if (!(node->flags & YAML_NODE_SHARED_TAG))
+            yaml_free(node->tag);
+        switch (node->type) {
+            case YAML_SCALAR_NODE:
+                if (!(node->flags & YAML_NODE_SHARED_VALUE))
+                    yaml_free(node->data.scalar.value);
+                break;
+            case YAML_SEQUENCE_NODE:
+                yaml_free(node->data.sequence.items.start);
+                break;
+            case YAML_MAPPING_NODE:
+                yaml_free(node->data.mapping.pairs.start);
+                break;
+            default:
+                assert(0);  /* Should not happen. */
+        }
+    }
+
+    document->modified.top = document->modified.start;
+}
+
+/*
+ * Make a node the root of a document by exchanging it with the first node.
+ */
+
+static int
+yaml_patch_set_root(yaml_document_t *document, int index)
+{
+    yaml_node_t *node;
+    yaml_node_t swap;
+    yaml_node_item_t *item;
+    yaml_node_pair_t *pair;
+    int *modified;
+
+#define SWAP_ID(id)     ((id) == 1 ? index : (id) == index ? 1 : (id))
+
+    if (index == 1)
+        return 1;
+
+    swap = document->nodes.start[0];
+    document->nodes.start[0] = document->nodes.start[index-1];
+    document->nodes.start[index-1] = swap;
+
+    for (node = document->nodes.start; node < document->nodes.top; node ++) {
+        if (node->type == YAML_SEQUENCE_NODE) {
+            for (item = node->data.sequence.items.start;
+                    item < node->data.sequence.items.top; item ++) {
+                *item = SWAP_ID(*item);
+            }
+        }
+        if (node->type == YAML_MAPPING_NODE) {
+            for (pair = node->data.mapping.pairs.start;
+                    pair < node->data.mapping.pairs.top; pair ++) {
+                pair->key = SWAP_ID(pair->key);
+                pair->value = SWAP_ID(pair->value);
+            }
+        }
+    }
+
+    for (modified = document->modified.start;
+            modified < document->modified.top; modified ++) {
+        *modified = SWAP_ID(*modified);
+    }
+
+#undef SWAP_ID
+
+    return 1;
+}
+
+/*
+ * Apply a single patch operation.
+ */
+
+static int
+yaml_patch_operation(yaml_document_t *document, yaml_document_t *patch,
+        yaml_node_t *operation, struct import_ctx *import)
+{
+    yaml_char_t *op;
+    yaml_char_t *path;
+    yaml_char_t *name = NULL;
+    const yaml_char_t *segment = NULL;
+    size_t segment_length = 0;
+    int value_index = 0;
+    int value = 0;
+    int parent;
+    int key;
+    int count;
+    int position;
+    int add, remove;
+    yaml_node_t *node;
+    yaml_node_pair_t *pair = NULL;
+    yaml_node_item_t *items;
+    size_t k, j;
+
+    if (operation->type != YAML_MAPPING_NODE)
+        return 0;
+
+    op = yaml_patch_get(patch, operation, "op", NULL);
+    path = yaml_patch_get(patch, operation, "path", NULL);
+    (void)yaml_patch_get(patch, operation, "value", &value_index);
+
+    if (!op || !path)
+        return 0;
+
+    add = (strcmp((char *)op, "add") == 0);
+    remove = (strcmp((char *)op, "remove") == 0);
+    if (!add && !remove && strcmp((char *)op, "replace") != 0)
+        return 0;
+    if (!remove && !value_index)
+        return 0;
+
+    if (!yaml_patch_locate(document, path, strlen((char *)path),
+                &parent, &segment, &segment_length))
+        return 0;
+
+    if (!remove) {
+        import->generation ++;
+        value = yaml_import_node(import, value_index);
+        if (!value) return 0;
+    }
+
+    if (!parent) {
+        if (remove) {
+            yaml_patch_clear(document);
+            return 1;
+        }
+        return yaml_patch_set_root(document, value);
+    }
+
+    node = document->nodes.start + parent - 1;
+
+    if (node->type == YAML_MAPPING_NODE)
+    {
+        for (pair = node->data.mapping.pairs.start;
+                pair < node->data.mapping.pairs.top; pair ++) {
+            yaml_node_t *key_node = document->nodes.start + pair->key - 1;
+            if (key_node->type == YAML_SCALAR_NODE
+                    && yaml_patch_segment_equal(segment, segment_length,
+                        key_node->data.scalar.value,
+                        key_node->data.scalar.length))
+                break;
+        }
+
+        if (pair < node->data.mapping.pairs.top) {
+            if (!yaml_document_touch_node(document, parent))
+                return 0;
+            if (remove) {
+                memmove(pair, pair+1, (node->data.mapping.pairs.top-pair-1)
+                        *sizeof(*pair));
+                node->data.mapping.pairs.top --;
+            }
+            else {
+                pair->value = value;
+            }
+            return 1;
+        }
+
+        if (!add)
+            return 0;
+
+        name = yaml_malloc(segment_length+1);
+        if (!name) return 0;
+        for (k = 0, j = 0; k < segment_length; k ++) {
+            if (segment[k] == '~' && k+1 < segment_length) {
+                name[j++] = (segment[++k] == '1') ? '/' : '~';
+            }
+            else {
+                name[j++] = segment[k];
+            }
+        }
+        key = yaml_document_add_scalar(document, NULL, name, j,
+                YAML_ANY_SCALAR_STYLE);
+        yaml_free(name);
+        if (!key) return 0;
+
+        return yaml_document_append_mapping_pair(document, parent, key, value);
+    }
+
+    if (node->type == YAML_SEQUENCE_NODE)
+    {
+        count = node->data.sequence.items.top - node->data.sequence.items.start;
+        position = yaml_patch_segment_index(segment, segment_length, count);
+        if (position < 0 || (!add && position == count))
+            return 0;
+        if (!yaml_document_touch_node(document, parent))
+            return 0;
+
+        if (add) {
+            if (!yaml_document_append_sequence_item(document, parent, value))
+                return 0;
+            items = document->nodes.start[parent-1].data.sequence.items.start;
+            memmove(items+position+1, items+position,
+                    (count-position)*sizeof(*items));
+            items[position] = value;
+        }
+        else if (remove) {
+            items = node->data.sequence.items.start;
+            memmove(items+position, items+position+1,
+                    (count-position-1)*sizeof(*items));
+            node->data.sequence.items.top --;
+        }
+        else {
+            node->data.sequence.items.start[position] = value;
+        }
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Apply a patch to a document.
+ */
+
+YAML_DECLARE(int)
+yaml_document_apply_patch(yaml_document_t *document, yaml_document_t *patch)
+{
+    struct import_ctx import;
+    yaml_node_t *root;
+    yaml_node_item_t *item;
+    int result = 1;
+
+    assert(document);   /* Non-NULL document object is expected. */
+    assert(patch);      /* Non-NULL patch object is expected. */
+
+    root = yaml_document_get_root_node(patch);
+    if (!root)
+        return 1;
+    if (root->type != YAML_SEQUENCE_NODE)
+        return 0;
+
+    if (!yaml_import_initialize(&import, document, patch))
+        return 0;
+
+    for (item = root->data.sequence.items.start;
+            result && item < root->data.sequence.items.top; item ++) {
+        result = yaml_patch_operation(document, patch,
+                patch->nodes.start + *item - 1, &import);
+    }
+
+    yaml_import_delete(&import);
+    yaml_document_drop_hashes(document);
+
+    return result;
+}
+
@@ -54,6 +54,129 @@ static int
 yaml_emitter_dump_mapping(yaml_emitter_t *emitter, yaml_node_t *node,
         yaml_char_t *anchor);
 
+static int
+yaml_emitter_plain_implicit(yaml_node_t *node);
+
+static yaml_char_t *
+yaml_emitter_scalar_text(yaml_node_t *node, int width, size_t *length,
+        yaml_scalar_style_t *style);
+
+/*
+ * Document iterator functions.
+ */
+
+YAML_DECLARE(int)
+yaml_document_iter_initialize(yaml_document_iter_t *iter,
+        yaml_document_t *document);
+
+YAML_DECLARE(void)
+yaml_document_iter_delete(yaml_document_iter_t *iter);
+
+YAML_DECLARE(int)
+yaml_document_iter_next(yaml_document_iter_t *iter, yaml_event_t *event);
+
+/*
+ * Edited dump functions.
+ */
+
+YAML_DECLARE(int)
+yaml_emitter_dump_edited(yaml_emitter_t *emitter, yaml_document_t *document,
+        const unsigned char *input, size_t size);
+
+struct edit_span;
+struct edit_entry;
+struct edit_range;
+struct edit_fragment;
+struct edit_ctx;
+
+static int
+yaml_edit_has_span(yaml_node_t *node);
+
+static int
+yaml_edit_is_block(yaml_node_t *node);
+
+static size_t
+yaml_edit_offset(struct edit_ctx *ctx, size_t index);
+
+static size_t
+yaml_edit_trim(struct edit_ctx *ctx, size_t start, size_t end);
+
+static size_t
+yaml_edit_comment(struct edit_ctx *ctx, size_t end);
+
+static int
+yaml_edit_clean(struct edit_ctx *ctx, size_t start, size_t end);
+
+static size_t
+yaml_edit_properties(struct edit_ctx *ctx, yaml_node_t *node,
+        size_t start, size_t end, size_t *anchor, size_t *anchor_length);
+
+static int
+yaml_edit_write(struct edit_ctx *ctx, const unsigned char *text,
+        size_t length);
+
+static int
+yaml_edit_write_indented(struct edit_ctx *ctx, const unsigned char *text,
+        size_t length, size_t column);
+
+static int
+yaml_edit_spaces(struct edit_ctx *ctx, size_t count);
+
+static int
+yaml_edit_separator(struct edit_ctx *ctx, size_t column);
+
+static int
+yaml_edit_gap(struct edit_ctx *ctx, size_t start, size_t end);
+
+static int
+yaml_edit_copy(struct edit_ctx *ctx, size_t start, size_t end);
+
+static int
+yaml_edit_is_marker(struct edit_ctx *ctx, size_t pointer);
+
+static int
+yaml_edit_value(struct edit_ctx *ctx, struct edit_span *span);
+
+static int
+yaml_edit_node(struct edit_ctx *ctx, struct edit_span *span, size_t *end);
+
+static int
+yaml_edit_entry(struct edit_ctx *ctx, yaml_node_t *node, size_t k,
+        struct edit_entry *entry);
+
+static size_t
+yaml_edit_entries(struct edit_ctx *ctx, yaml_node_t *node,
+        size_t start, size_t end, struct edit_entry *entry);
+
+static int
+yaml_edit_collection(struct edit_ctx *ctx, yaml_node_t *node,
+        size_t start, size_t end);
+
+static int
+yaml_edit_render(struct edit_ctx *ctx, yaml_node_type_t type,
+        int first, int second, size_t column);
+
+static int
+yaml_edit_emit_node(struct edit_ctx *ctx, yaml_emitter_t *fragment,
+        int index, int flow);
+
+static void
+yaml_edit_reach(struct edit_ctx *ctx, unsigned char *marks, int index,
+        unsigned char mark, size_t fragment);
+
+static int
+yaml_edit_dropped(struct edit_range *ranges, int count, size_t index);
+
+static int
+yaml_edit_anchored(struct edit_ctx *ctx, yaml_node_t *node);
+
+static int
+yaml_edit_forward(struct edit_ctx *ctx, struct edit_range *ranges, int count,
+        unsigned char *marks, int index, size_t fragment, int root);
+
+static int
+yaml_edit_plan(struct edit_ctx *ctx, int *whole);
+
 /*
  * Issue a STREAM-START event.
  */
@@ -178,8 +301,11 @@ yaml_emitter_delete_document_and_anchors(yaml_emitter_t *emitter)
             < emitter->document->nodes.top; index ++) {
         yaml_node_t node = emitter->document->nodes.start[index];
         if (!emitter->anchors[index].serialized) {
-            yaml_free(node.tag);
-            if (node.type == YAML_SCALAR_NODE) {
+            if (!(node.flags & YAML_NODE_SHARED_TAG)) {
+                yaml_free(node.tag);
+            }
+            if (node.type == YAML_SCALAR_NODE
+                    && !(node.flags & YAML_NODE_SHARED_VALUE)) {
                 yaml_free(node.data.scalar.value);
             }
         }
@@ -192,6 +318,15 @@ yaml_emitter_delete_document_and_anchors(yaml_emitter_t *emitter)
     }
 
     STACK_DEL(emitter, emitter->document->nodes);
+
+    while (!STACK_EMPTY(emitter, emitter->document->strings)) {
+        yaml_free(POP(emitter, emitter->document->strings));
+    }
+    STACK_DEL(emitter, emitter->document->strings);
+
+    yaml_document_drop_hashes(emitter->document);
+    STACK_DEL(emitter, emitter->document->modified);
+
     yaml_free(emitter->anchors);
 
     emitter->anchors = NULL;
@@ -319,16 +454,48 @@ yaml_emitter_dump_scalar(yaml_emitter_t *emitter, yaml_node_t *node,
     yaml_event_t event;
     yaml_mark_t mark  = { 0, 0, 0 };
 
-    int plain_implicit = (strcmp((char *)node->tag,
-                YAML_DEFAULT_SCALAR_TAG) == 0);
+    int plain_implicit = yaml_emitter_plain_implicit(node);
     int quoted_implicit = (strcmp((char *)node->tag,
                 YAML_DEFAULT_SCALAR_TAG) == 0);
 
-    SCALAR_EVENT_INIT(event, anchor, node->tag, node->data.scalar.value,
-            node->data.scalar.length, plain_implicit, quoted_implicit,
-            node->data.scalar.style, mark, mark);
+    yaml_char_t *tag = node->tag;
+    yaml_char_t *value = node->data.scalar.value;
+    size_t length = node->data.scalar.length;
+    yaml_scalar_style_t style = node->data.scalar.style;
+
+    if (node->flags & YAML_NODE_SHARED_TAG) {
+        tag = yaml_strdup(node->tag);
+        if (!tag) goto error;
+    }
+
+    /* The event takes the base64 text over instead of the octets. */
+
+    if (node->resolved.type == YAML_BINARY_SCALAR_TYPE) {
+        value = yaml_emitter_scalar_text(node, emitter->best_width,
+                &length, &style);
+        if (!value) goto error;
+        if (!(node->flags & YAML_NODE_SHARED_VALUE)) {
+            yaml_free(node->data.scalar.value);
+        }
+        node->data.scalar.value = NULL;
+    }
+    else if (node->flags & YAML_NODE_SHARED_VALUE) {
+        value = YAML_MALLOC(node->data.scalar.length+1);
+        if (!value) goto error;
+        memcpy(value, node->data.scalar.value, node->data.scalar.length);
+        value[node->data.scalar.length] = '\0';
+    }
+
+    SCALAR_EVENT_INIT(event, anchor, tag, value, length,
+            plain_implicit, quoted_implicit, style, mark, mark);
 
     return yaml_emitter_emit(emitter, &event);
+
+error:
+    if (tag != node->tag) yaml_free(tag);
+    yaml_free(anchor);
+    emitter->error = YAML_MEMORY_ERROR;
+    return 0;
 }
 
 /*
@@ -346,7 +513,18 @@ yaml_emitter_dump_sequence(yaml_emitter_t *emitter, yaml_node_t *node,
 
     yaml_node_item_t *item;
 
-    SEQUENCE_START_EVENT_INIT(event, anchor, node->tag, implicit,
+    yaml_char_t *tag = node->tag;
+
+    if (node->flags & YAML_NODE_SHARED_TAG) {
+        tag = yaml_strdup(node->tag);
+        if (!tag) {
+            yaml_free(anchor);
+            emitter->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+    }
+
+    SEQUENCE_START_EVENT_INIT(event, anchor, tag, implicit,
             node->data.sequence.style, mark, mark);
     if (!yaml_emitter_emit(emitter, &event)) return 0;
 
@@ -376,7 +554,18 @@ yaml_emitter_dump_mapping(yaml_emitter_t *emitter, yaml_node_t *node,
 
     yaml_node_pair_t *pair;
 
-    MAPPING_START_EVENT_INIT(event, anchor, node->tag, implicit,
+    yaml_char_t *tag = node->tag;
+
+    if (node->flags & YAML_NODE_SHARED_TAG) {
+        tag = yaml_strdup(node->tag);
+        if (!tag) {
+            yaml_free(anchor);
+            emitter->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+    }
+
+    MAPPING_START_EVENT_INIT(event, anchor, tag, implicit,
             node->data.mapping.style, mark, mark);
     if (!yaml_emitter_emit(emitter, &event)) return 0;
 
@@ -392,3 +581,2040 @@ yaml_emitter_dump_mapping(yaml_emitter_t *emitter, yaml_node_t *node,
     return 1;
 }
 
+/*
+ * Check if the tag of a scalar may be omitted in the plain style.
+ */
+
+static int
+yaml_emitter_plain_implicit(yaml_node_t *node)
+{
+    if (strcmp((char *)node->tag, YAML_DEFAULT_SCALAR_TAG) == 0) {
+        yaml_scalar_type_t type = YAML_UNRESOLVED_SCALAR_TYPE;
+        yaml_resolved_value_t resolved;
+
+        /* A string that reads as another type must be quoted or tagged. */
+
+        if (node->resolved.type != YAML_STR_SCALAR_TYPE)
+            return 1;
+
+        return (yaml_resolve_scalar(node->data.scalar.value,
+                    node->data.scalar.length, &type, &resolved)
+                && type == YAML_STR_SCALAR_TYPE);
+    }
+
+    /* A plain scalar resolved by the core schema does not need a tag. */
+
+    return (node->resolved.type > YAML_STR_SCALAR_TYPE
+            && node->resolved.type != YAML_BINARY_SCALAR_TYPE
+            && (node->data.scalar.style == YAML_ANY_SCALAR_STYLE
+                || node->data.scalar.style == YAML_PLAIN_SCALAR_STYLE)
+            && strcmp((char *)node->tag,
+                yaml_resolved_tag(node->resolved.type)) == 0);
+}
+
+/*
+ * Encode the octets of a decoded binary scalar as base64 text in the literal
+ * style, wrapped at the preferred width or at 76 digits.
+ */
+
+static yaml_char_t *
+yaml_emitter_scalar_text(yaml_node_t *node, int width, size_t *length,
+        yaml_scalar_style_t *style)
+{
+    *style = YAML_LITERAL_SCALAR_STYLE;
+
+    return yaml_encode_binary(node->data.scalar.value,
+            node->data.scalar.length, (width > 0) ? width : 76, length);
+}
+
+/*
+ * Document iterator states.
+ */
+
+#define ITER_DOCUMENT_START     0
+#define ITER_ROOT               1
+#define ITER_NODES              2
+#define ITER_DONE               3
+
+/*
+ * Initialize a document iterator and assign the anchors.
+ */
+
+YAML_DECLARE(int)
+yaml_document_iter_initialize(yaml_document_iter_t *iter,
+        yaml_document_t *document)
+{
+    struct {
+        yaml_error_type_t error;
+    } context;
+    struct {
+        int *start;
+        int *end;
+        int *top;
+    } pending = { NULL, NULL, NULL };
+    size_t count;
+    int last_anchor_id = 0;
+
+    assert(iter);       /* Non-NULL iterator object is expected. */
+    assert(document);   /* Non-NULL document object is expected. */
+
+    memset(iter, 0, sizeof(yaml_document_iter_t));
+
+    iter->document = document;
+    count = document->nodes.top - document->nodes.start;
+
+    if (!count) {
+        iter->state = ITER_DONE;
+        return 1;
+    }
+
+    iter->anchors = yaml_malloc(count*sizeof(*(iter->anchors)));
+    iter->frames.start = yaml_malloc(count*sizeof(*(iter->frames.start)));
+    if (!iter->anchors || !iter->frames.start) goto error;
+    memset(iter->anchors, 0, count*sizeof(*(iter->anchors)));
+    iter->frames.top = iter->frames.start;
+    iter->frames.end = iter->frames.start + count;
+
+    /*
+     * Count the references the same way yaml_emitter_anchor_node() does,
+     * with the children pushed in reverse order so that the anchor ids are
+     * assigned in the same order.
+     */
+
+    if (!STACK_INIT(&context, pending, int*)) goto error;
+    if (!PUSH(&context, pending, 1)) goto error;
+
+    while (!STACK_EMPTY(&context, pending)) {
+        int index = POP(&context, pending);
+        yaml_node_t *node = document->nodes.start + index - 1;
+        yaml_anchors_t *anchor = iter->anchors + index - 1;
+        yaml_node_item_t *item;
+        yaml_node_pair_t *pair;
+
+        anchor->references ++;
+
+        if (anchor->references == 2) {
+            anchor->anchor = (++ last_anchor_id);
+        }
+
+        if (anchor->references != 1)
+            continue;
+
+        switch (node->type) {
+            case YAML_SEQUENCE_NODE:
+                for (item = node->data.sequence.items.top;
+                        item > node->data.sequence.items.start; item --) {
+                    if (!PUSH(&context, pending, item[-1])) goto error;
+                }
+                break;
+            case YAML_MAPPING_NODE:
+                for (pair = node->data.mapping.pairs.top;
+                        pair > node->data.mapping.pairs.start; pair --) {
+                    if (!PUSH(&context, pending, pair[-1].value)) goto error;
+                    if (!PUSH(&context, pending, pair[-1].key)) goto error;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    STACK_DEL(&context, pending);
+
+    return 1;
+
+error:
+
+    STACK_DEL(&context, pending);
+    yaml_document_iter_delete(iter);
+
+    return 0;
+}
+
+/*
+ * Destroy a document iterator.
+ */
+
+YAML_DECLARE(void)
+yaml_document_iter_delete(yaml_document_iter_t *iter)
+{
+    assert(iter);       /* Non-NULL iterator object is expected. */
+
+    yaml_free(iter->anchors);
+    yaml_free(iter->frames.start);
+    yaml_free(iter->text);
+
+    memset(iter, 0, sizeof(yaml_document_iter_t));
+    iter->state = ITER_DONE;
+}
+
+/*
+ * Produce the event of a node: an alias if it is already visited or the
+ * scalar or the collection start otherwise.
+ */
+
+static int
+yaml_document_iter_node(yaml_document_iter_t *iter, int index,
+        yaml_event_t *event)
+{
+    yaml_node_t *node = iter->document->nodes.start + index - 1;
+    yaml_anchors_t *anchor = iter->anchors + index - 1;
+    yaml_char_t *name = NULL;
+    yaml_char_t *value;
+    size_t length;
+    yaml_scalar_style_t style;
+
+    if (anchor->anchor) {
+        sprintf((char *)iter->anchor, ANCHOR_TEMPLATE, anchor->anchor);
+        name = iter->anchor;
+    }
+
+    if (anchor->serialized) {
+        ALIAS_EVENT_INIT(*event, name, node->start_mark, node->end_mark);
+        return 1;
+    }
+
+    anchor->serialized = 1;
+
+    switch (node->type) {
+        case YAML_SCALAR_NODE:
+            value = node->data.scalar.value;
+            length = node->data.scalar.length;
+            style = node->data.scalar.style;
+            if (node->resolved.type == YAML_BINARY_SCALAR_TYPE) {
+                iter->text = value = yaml_emitter_scalar_text(node, 0,
+                        &length, &style);
+                if (!value)
+                    return 0;
+            }
+            SCALAR_EVENT_INIT(*event, name, node->tag, value, length,
+                    yaml_emitter_plain_implicit(node),
+                    strcmp((char *)node->tag, YAML_DEFAULT_SCALAR_TAG) == 0,
+                    style, node->start_mark, node->end_mark);
+            break;
+        case YAML_SEQUENCE_NODE:
+            SEQUENCE_START_EVENT_INIT(*event, name, node->tag,
+                    strcmp((char *)node->tag, YAML_DEFAULT_SEQUENCE_TAG) == 0,
+                    node->data.sequence.style,
+                    node->start_mark, node->start_mark);
+            break;
+        case YAML_MAPPING_NODE:
+            MAPPING_START_EVENT_INIT(*event, name, node->tag,
+                    strcmp((char *)node->tag, YAML_DEFAULT_MAPPING_TAG) == 0,
+                    node->data.mapping.style,
+                    node->start_mark, node->start_mark);
+            break;
+        default:
+            assert(0);      /* Could not happen. */
+            return 0;
+    }
+
+    if (node->type != YAML_SCALAR_NODE) {
+        iter->frames.top->node = index;
+        iter->frames.top->position = 0;
+        iter->frames.top ++;
+    }
+
+    return 1;
+}
+
+/*
+ * Produce the next event of a document.
+ */
+
+YAML_DECLARE(int)
+yaml_document_iter_next(yaml_document_iter_t *iter, yaml_event_t *event)
+{
+    yaml_document_t *document;
+    yaml_document_iter_frame_t *frame;
+    yaml_node_t *node;
+
+    assert(iter);       /* Non-NULL iterator object is expected. */
+    assert(event);      /* Non-NULL event object is expected. */
+
+    document = iter->document;
+
+    yaml_free(iter->text);
+    iter->text = NULL;
+
+    switch (iter->state)
+    {
+        case ITER_DOCUMENT_START:
+            DOCUMENT_START_EVENT_INIT(*event, document->version_directive,
+                    document->tag_directives.start,
+                    document->tag_directives.end,
+                    document->start_implicit,
+                    document->start_mark, document->start_mark);
+            iter->state = ITER_ROOT;
+            return 1;
+
+        case ITER_ROOT:
+            iter->state = ITER_NODES;
+            return yaml_document_iter_node(iter, 1, event);
+
+        case ITER_NODES:
+            if (iter->frames.top == iter->frames.start) {
+                DOCUMENT_END_EVENT_INIT(*event, document->end_implicit,
+                        document->end_mark, document->end_mark);
+                iter->state = ITER_DONE;
+                return 1;
+            }
+            frame = iter->frames.top - 1;
+            node = document->nodes.start + frame->node - 1;
+            if (node->type == YAML_SEQUENCE_NODE) {
+                if (node->data.sequence.items.start + frame->position
+                        < node->data.sequence.items.top) {
+                    return yaml_document_iter_node(iter,
+                            node->data.sequence.items.start[frame->position++],
+                            event);
+                }
+                SEQUENCE_END_EVENT_INIT(*event,
+                        node->end_mark, node->end_mark);
+            }
+            else {
+                if (node->data.mapping.pairs.start + frame->position/2
+                        < node->data.mapping.pairs.top) {
+                    yaml_node_pair_t *pair = node->data.mapping.pairs.start
+                        + frame->position/2;
+                    return yaml_document_iter_node(iter,
+                            (frame->position++ % 2) ? pair->value : pair->key,
+                            event);
+                }
+                MAPPING_END_EVENT_INIT(*event,
+                        node->end_mark, node->end_mark);
+            }
+            iter->frames.top --;
+            return 1;
+
+        default:
+            memset(event, 0, sizeof(yaml_event_t));
+            return 1;
+    }
+}
+
+/*
+ * A modified node with a source span.
+ */
+
+struct edit_span {
+    /* The character index of the node start. */
+    size_t index;
+    /* The character index of the node end. */
+    size_t end_index;
+    /* The byte offset of the node start. */
+    size_t start;
+    /* The node id. */
+    int node;
+    /* Is the node emitted or being emitted? */
+    int done;
+    /*
+     * Does the node need a ':' indicator?  An empty value of a block mapping
+     * is put on a line of its own at the column of its key indicator.
+     */
+    int colon;
+    size_t column;
+};
+
+/*
+ * The walk over the entries of a modified block collection.
+ */
+
+struct edit_entry {
+    /* The byte offset and the character index past the last kept entry. */
+    size_t previous;
+    size_t index;
+    /* The byte offset of the collection end. */
+    size_t limit;
+    /* The input text of the current entry. */
+    size_t start;
+    size_t end;
+    size_t end_index;
+    /* The nodes of the entry. */
+    int first;
+    int second;
+    int last;
+};
+
+/*
+ * A range of the input text in characters.
+ */
+
+struct edit_range {
+    size_t start;
+    size_t end;
+};
+
+/*
+ * A node emitted in place of the input text.
+ */
+
+struct edit_fragment {
+    /* The character index where the node is placed. */
+    size_t index;
+    /* The node id. */
+    int node;
+};
+
+/*
+ * The state of an edited dump.
+ */
+
+struct edit_ctx {
+    yaml_emitter_t *emitter;
+    yaml_document_t *document;
+    const unsigned char *input;
+    size_t size;
+
+    /* The byte offset of the first character (past a BOM). */
+    size_t base;
+
+    /* The last converted character index and its byte offset. */
+    size_t index;
+    size_t pointer;
+
+    /* The modified nodes ordered by their start. */
+    struct edit_span *spans;
+    int count;
+
+    /* The line break of the output. */
+    const char *line_break;
+
+    /* The last written octet. */
+    unsigned char last;
+
+    /* The input offset where the last copied range ends. */
+    size_t copied;
+
+    /* The character index where the fragment being emitted is placed. */
+    size_t fragment;
+
+    /* The states of the nodes emitted in fragments. */
+    unsigned char *states;
+
+    /* The output of the fragment emitter. */
+    unsigned char *output;
+    size_t length;
+    size_t capacity;
+};
+
+#define EDIT_NONE       0
+#define EDIT_OPEN       1
+#define EDIT_DONE       2
+
+#define EDIT_IS_BREAK(octet)    ((octet) == '\r' || (octet) == '\n')
+#define EDIT_IS_BLANK(octet)    ((octet) == ' ' || (octet) == '\t')
+
+/*
+ * Check if a node has been loaded and has a source span.
+ */
+
+static int
+yaml_edit_has_span(yaml_node_t *node)
+{
+    return (node->end_mark.index > 0);
+}
+
+/*
+ * Convert a character index into a byte offset of the input.
+ *
+ * The conversion starts from the previous one, so it is cheap when the
+ * indices are requested in the input order.
+ */
+
+static size_t
+yaml_edit_offset(struct edit_ctx *ctx, size_t index)
+{
+    while (ctx->index < index && ctx->pointer < ctx->size) {
+        ctx->pointer ++;
+        while (ctx->pointer < ctx->size
+                && (ctx->input[ctx->pointer] & 0xC0) == 0x80) {
+            ctx->pointer ++;
+        }
+        ctx->index ++;
+    }
+
+    while (ctx->index > index) {
+        ctx->pointer --;
+        while ((ctx->input[ctx->pointer] & 0xC0) == 0x80) {
+            ctx->pointer --;
+        }
+        ctx->index --;
+    }
+
+    return ctx->pointer;
+}
+
+/*
+ * Check if a node is a block collection.
+ */
+
+static int
+yaml_edit_is_block(yaml_node_t *node)
+{
+    return ((node->type == YAML_SEQUENCE_NODE
+                && node->data.sequence.style == YAML_BLOCK_SEQUENCE_STYLE)
+            || (node->type == YAML_MAPPING_NODE
+                && node->data.mapping.style == YAML_BLOCK_MAPPING_STYLE));
+}
+
+/*
+ * Drop the trailing empty lines and the final line break of a span.
+ */
+
+static size_t
+yaml_edit_trim(struct edit_ctx *ctx, size_t start, size_t end)
+{
+    size_t pointer = end;
+
+    while (pointer > start) {
+        unsigned char octet = ctx->input[pointer-1];
+        if (EDIT_IS_BLANK(octet)) {
+            pointer --;
+        }
+        else if (EDIT_IS_BREAK(octet)) {
+            end = -- pointer;
+        }
+        else {
+            break;
+        }
+    }
+
+    return end;
+}
+
+/*
+ * Include the comment that ends the line of a span.
+ */
+
+static size_t
+yaml_edit_comment(struct edit_ctx *ctx, size_t end)
+{
+    size_t pointer = end;
+
+    if (end == ctx->base || EDIT_IS_BREAK(ctx->input[end-1]))
+        return end;
+
+    while (pointer < ctx->size && EDIT_IS_BLANK(ctx->input[pointer])) {
+        pointer ++;
+    }
+
+    if (pointer == ctx->size || ctx->input[pointer] != '#')
+        return end;
+
+    while (pointer < ctx->size && !EDIT_IS_BREAK(ctx->input[pointer])) {
+        pointer ++;
+    }
+
+    return pointer;
+}
+
+/*
+ * Check if a range of the input has only spaces, line breaks, and comments.
+ */
+
+static int
+yaml_edit_clean(struct edit_ctx *ctx, size_t start, size_t end)
+{
+    const unsigned char *input = ctx->input;
+    size_t pointer;
+
+    for (pointer = start; pointer < end; pointer ++) {
+        if (input[pointer] == '#') {
+            while (pointer < end && !EDIT_IS_BREAK(input[pointer])) {
+                pointer ++;
+            }
+            if (pointer == end)
+                break;
+        }
+        if (!EDIT_IS_BLANK(input[pointer]) && !EDIT_IS_BREAK(input[pointer]))
+            return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Skip the anchor and the tag of a node and return the start of its content.
+ *
+ * The properties of a block collection end their line; otherwise they
+ * belong to the first key.
+ */
+
+static size_t
+yaml_edit_properties(struct edit_ctx *ctx, yaml_node_t *node,
+        size_t start, size_t end, size_t *anchor, size_t *anchor_length)
+{
+    const unsigned char *input = ctx->input;
+    size_t pointer = start;
+    int block = yaml_edit_is_block(node);
+    int broken = 0;
+
+    *anchor_length = 0;
+
+    while (pointer < end && (input[pointer] == '&' || input[pointer] == '!'))
+    {
+        size_t name = ++ pointer;
+
+        if (input[name-1] == '!' && pointer < end && input[pointer] == '<') {
+            while (pointer < end && input[pointer] != '>') {
+                pointer ++;
+            }
+        }
+
+        while (pointer < end && !EDIT_IS_BLANK(input[pointer])
+                && !EDIT_IS_BREAK(input[pointer])
+                && (input[name-1] == '!' || !strchr(",[]{}", input[pointer]))) {
+            pointer ++;
+        }
+
+        if (input[name-1] == '&') {
+            *anchor = name;
+            *anchor_length = pointer - name;
+        }
+
+        /* Skip the separating spaces, line breaks, and comments. */
+
+        while (pointer < end) {
+            if (EDIT_IS_BREAK(input[pointer])) {
+                broken = 1;
+                pointer ++;
+            }
+            else if (EDIT_IS_BLANK(input[pointer])) {
+                pointer ++;
+            }
+            else if (input[pointer] == '#') {
+                while (pointer < end && !EDIT_IS_BREAK(input[pointer])) {
+                    pointer ++;
+                }
+            }
+            else {
+                break;
+            }
+        }
+    }
+
+    if (block && !broken) {
+        *anchor_length = 0;
+        return start;
+    }
+
+    return pointer;
+}
+
+/*
+ * Write a piece of UTF-8 text.
+ *
+ * Long runs of the input are passed to the write handler directly when the
+ * output encoding is UTF-8.
+ */
+
+static int
+yaml_edit_write(struct edit_ctx *ctx, const unsigned char *text,
+        size_t length)
+{
+    yaml_emitter_t *emitter = ctx->emitter;
+
+    if (!length)
+        return 1;
+
+    ctx->last = text[length-1];
+
+    if (emitter->encoding == YAML_UTF8_ENCODING
+            && length > (size_t)(emitter->buffer.end - emitter->buffer.pointer)) {
+        if (!yaml_emitter_flush(emitter))
+            return 0;
+        if (!emitter->write_handler(emitter->write_handler_data,
+                    (unsigned char *)text, length)) {
+            emitter->error = YAML_WRITER_ERROR;
+            emitter->problem = "write error";
+            return 0;
+        }
+        return 1;
+    }
+
+    while (length) {
+        size_t chunk = emitter->buffer.end - emitter->buffer.pointer;
+
+        /* The buffer is recoded on flush, so characters are not split. */
+
+        if (chunk >= length) {
+            chunk = length;
+        }
+        else {
+            while (chunk && (text[chunk] & 0xC0) == 0x80) {
+                chunk --;
+            }
+        }
+
+        memcpy(emitter->buffer.pointer, text, chunk);
+        emitter->buffer.pointer += chunk;
+        text += chunk;
+        length -= chunk;
+
+        if (length && !yaml_emitter_flush(emitter))
+            return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Write the output of the fragment emitter indenting all lines but the
+ * first one.
+ */
+
+static int
+yaml_edit_write_indented(struct edit_ctx *ctx, const unsigned char *text,
+        size_t length, size_t column)
+{
+    size_t start = 0;
+    size_t k;
+
+    for (k = 0; k < length; k ++)
+    {
+        if (text[k] != '\n')
+            continue;
+
+        if (!yaml_edit_write(ctx, text+start, k-start)
+                || !yaml_edit_write(ctx, (const unsigned char *)ctx->line_break,
+                    strlen(ctx->line_break)))
+            return 0;
+        start = k+1;
+
+        /* Empty lines are not indented. */
+
+        if (start < length && text[start] != '\n') {
+            if (!yaml_edit_spaces(ctx, column))
+                return 0;
+        }
+    }
+
+    return yaml_edit_write(ctx, text+start, length-start);
+}
+
+/*
+ * Write a run of spaces.
+ */
+
+static int
+yaml_edit_spaces(struct edit_ctx *ctx, size_t count)
+{
+    static const unsigned char spaces[] = "                ";
+
+    while (count > 0) {
+        size_t chunk = (count < sizeof(spaces)-1) ? count : sizeof(spaces)-1;
+        if (!yaml_edit_write(ctx, spaces, chunk))
+            return 0;
+        count -= chunk;
+    }
+
+    return 1;
+}
+
+/*
+ * Start a new line at the given column unless the output is already at the
+ * start of a line.
+ */
+
+static int
+yaml_edit_separator(struct edit_ctx *ctx, size_t column)
+{
+    if (!EDIT_IS_BREAK(ctx->last)) {
+        if (!yaml_edit_write(ctx, (const unsigned char *)ctx->line_break,
+                    strlen(ctx->line_break)))
+            return 0;
+    }
+
+    return yaml_edit_spaces(ctx, column);
+}
+
+/*
+ * Copy the input text between the replaced parts.
+ *
+ * If the replacement ends a line that the replaced text did not end, the
+ * line break that follows is dropped, so that the line structure and the
+ * trailing line breaks of a block scalar are kept.
+ */
+
+static int
+yaml_edit_gap(struct edit_ctx *ctx, size_t start, size_t end)
+{
+    const unsigned char *input = ctx->input;
+    size_t pointer = start;
+
+    if (EDIT_IS_BREAK(ctx->last) && start > ctx->base
+            && !EDIT_IS_BREAK(input[start-1])) {
+        while (pointer < end && EDIT_IS_BLANK(input[pointer])) {
+            pointer ++;
+        }
+        if (pointer < end && EDIT_IS_BREAK(input[pointer])) {
+            if (input[pointer] == '\r' && pointer+1 < end
+                    && input[pointer+1] == '\n') {
+                pointer ++;
+            }
+            start = pointer+1;
+        }
+    }
+
+    return yaml_edit_write(ctx, input+start, end-start);
+}
+
+/*
+ * Copy a range of the input replacing the modified nodes within it.
+ */
+
+static int
+yaml_edit_copy(struct edit_ctx *ctx, size_t start, size_t end)
+{
+    int low = 0;
+    int high = ctx->count;
+    int k;
+
+    while (low < high) {
+        int middle = low + (high-low)/2;
+        if (ctx->spans[middle].start < start) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    /* An empty node may also start where the range ends. */
+
+    for (k = low; k < ctx->count && (ctx->spans[k].start < end
+                || (ctx->spans[k].start == end
+                    && ctx->spans[k].index == ctx->spans[k].end_index)); k ++)
+    {
+        struct edit_span *span = ctx->spans + k;
+
+        /*
+         * Skip the nodes nested in a replaced one, its ancestors, and the
+         * collections that start with a copied entry.
+         */
+
+        if (span->start < start || span->done
+                || yaml_edit_trim(ctx, span->start,
+                    yaml_edit_offset(ctx, span->end_index)) > end)
+            continue;
+
+        if (!yaml_edit_gap(ctx, start, span->start))
+            return 0;
+        if (!yaml_edit_node(ctx, span, &start))
+            return 0;
+    }
+
+    /* A replaced node may end past the range with its comment. */
+
+    ctx->copied = (start < end) ? end : start;
+
+    if (start < end)
+        return yaml_edit_gap(ctx, start, end);
+
+    return 1;
+}
+
+/*
+ * Replace a modified node.
+ */
+
+static int
+yaml_edit_node(struct edit_ctx *ctx, struct edit_span *span, size_t *end)
+{
+    yaml_node_t *node = ctx->document->nodes.start + span->node - 1;
+    size_t start = span->start;
+
+    span->done = 1;
+    *end = yaml_edit_offset(ctx, node->end_mark.index);
+
+    if (yaml_edit_is_block(node)) {
+        *end = yaml_edit_comment(ctx, *end);
+        return yaml_edit_collection(ctx, node, start, *end);
+    }
+
+    *end = yaml_edit_trim(ctx, start, *end);
+
+    if (span->colon) {
+        *end = start;
+        ctx->fragment = span->index;
+        if (!yaml_edit_spaces(ctx, span->column)
+                || !yaml_edit_write(ctx, (const unsigned char *)": ", 2)
+                || !yaml_edit_render(ctx, YAML_SCALAR_NODE, span->node, 0, 0))
+            return 0;
+        return (span->colon == 2) ? yaml_edit_separator(ctx, 0) : 1;
+    }
+
+    /* An empty node directly follows its indicator. */
+
+    if (start == *end && start > ctx->base
+            && !EDIT_IS_BLANK(ctx->input[start-1])
+            && !EDIT_IS_BREAK(ctx->input[start-1])) {
+        if (!yaml_edit_write(ctx, (const unsigned char *)" ", 1))
+            return 0;
+    }
+
+    ctx->fragment = span->index;
+
+    if (!yaml_edit_render(ctx, YAML_SCALAR_NODE, span->node, 0, 0))
+        return 0;
+
+    /*
+     * An empty node at the start of a line may be followed by a document
+     * marker or by the end of the input, which need a line of their own.
+     */
+
+    if (start == *end && (start == ctx->base
+                || EDIT_IS_BREAK(ctx->input[start-1]))
+            && (*end == ctx->size || yaml_edit_is_marker(ctx, *end))) {
+        return yaml_edit_separator(ctx, 0);
+    }
+
+    return 1;
+}
+
+/*
+ * Check if the input has a document start or end marker at the given offset.
+ */
+
+static int
+yaml_edit_is_marker(struct edit_ctx *ctx, size_t pointer)
+{
+    const unsigned char *input = ctx->input;
+
+    return (pointer+3 <= ctx->size
+            && (memcmp(input+pointer, "---", 3) == 0
+                || memcmp(input+pointer, "...", 3) == 0)
+            && (pointer+3 == ctx->size
+                || EDIT_IS_BLANK(input[pointer+3])
+                || EDIT_IS_BREAK(input[pointer+3])));
+}
+
+/*
+ * Check if an empty mapping value follows its ':' indicator.
+ *
+ * An empty value that follows its key directly gets the indicator written
+ * before it.  A block value starts the line of the next token, so it is moved
+ * to the start of the line.  Return 0 if the text between the key and the
+ * value is not understood and the whole document has to be emitted.
+ */
+
+static int
+yaml_edit_value(struct edit_ctx *ctx, struct edit_span *span)
+{
+    yaml_document_t *document = ctx->document;
+    const unsigned char *input = ctx->input;
+    yaml_node_t *node = document->nodes.start + span->node - 1;
+    yaml_node_t *mapping = NULL;
+    yaml_node_t *key = NULL;
+    yaml_node_t *parent;
+    yaml_node_pair_t *pair;
+    size_t start, pointer;
+
+    if (node->type != YAML_SCALAR_NODE || span->index != span->end_index)
+        return 1;
+
+    /* Find the closest key that precedes the value. */
+
+    for (parent = document->nodes.start; parent < document->nodes.top;
+            parent ++) {
+        if (parent->type != YAML_MAPPING_NODE)
+            continue;
+        for (pair = parent->data.mapping.pairs.start;
+                pair < parent->data.mapping.pairs.top; pair ++) {
+            yaml_node_t *candidate = document->nodes.start + pair->key - 1;
+            if (pair->value != span->node || !yaml_edit_has_span(candidate)
+                    || candidate->end_mark.index > span->index)
+                continue;
+            if (!key || candidate->end_mark.index > key->end_mark.index) {
+                mapping = parent;
+                key = candidate;
+            }
+        }
+    }
+
+    if (!key)
+        return 1;
+
+    start = yaml_edit_offset(ctx, key->end_mark.index);
+
+    for (pointer = start; pointer < span->start; pointer ++) {
+        if (input[pointer] == '#') {
+            while (pointer < span->start && !EDIT_IS_BREAK(input[pointer])) {
+                pointer ++;
+            }
+            if (pointer == span->start)
+                break;
+        }
+        if (input[pointer] == ':')
+            return 1;
+        if (!EDIT_IS_BLANK(input[pointer]) && !EDIT_IS_BREAK(input[pointer]))
+            return 0;
+    }
+
+    span->colon = 1;
+
+    if (!yaml_edit_is_block(mapping)) {
+        return (memchr(input+start, '\r', span->start-start) == NULL
+                && memchr(input+start, '\n', span->start-start) == NULL);
+    }
+
+    /* Find the '?' indicator of the key and the start of the value line. */
+
+    pointer = yaml_edit_offset(ctx, key->start_mark.index);
+    while (pointer > ctx->base && EDIT_IS_BLANK(input[pointer-1])) {
+        pointer --;
+    }
+    if (pointer == ctx->base || input[pointer-1] != '?')
+        return 0;
+    span->column = key->start_mark.column
+        - (yaml_edit_offset(ctx, key->start_mark.index) - pointer) - 1;
+
+    while (span->start > ctx->base && EDIT_IS_BLANK(input[span->start-1])) {
+        span->start --;
+    }
+    if (span->start > ctx->base && !EDIT_IS_BREAK(input[span->start-1]))
+        return 0;
+
+    span->colon = 2;
+
+    return 1;
+}
+
+/*
+ * Find the input text of an entry of a block collection.
+ *
+ * An entry is kept if its nodes follow the previous kept entry in the input
+ * and are not aliases to the nodes defined before.  The text starts with the
+ * indicator of the entry.
+ */
+
+static int
+yaml_edit_entry(struct edit_ctx *ctx, yaml_node_t *node, size_t k,
+        struct edit_entry *entry)
+{
+    const unsigned char *input = ctx->input;
+    int sequence = (node->type == YAML_SEQUENCE_NODE);
+    size_t pointer;
+
+    if (sequence) {
+        entry->first = entry->last = node->data.sequence.items.start[k];
+        entry->second = 0;
+    }
+    else {
+        entry->first = node->data.mapping.pairs.start[k].key;
+        entry->last = entry->second = node->data.mapping.pairs.start[k].value;
+    }
+
+    {
+        yaml_node_t *first = ctx->document->nodes.start + entry->first - 1;
+        yaml_node_t *last = ctx->document->nodes.start + entry->last - 1;
+
+        if (!yaml_edit_has_span(first) || !yaml_edit_has_span(last)
+                || first->start_mark.index < entry->index
+                || last->end_mark.index > node->end_mark.index
+                || (!sequence
+                    && last->start_mark.index < first->end_mark.index))
+            return 0;
+
+        entry->start = yaml_edit_offset(ctx, first->start_mark.index);
+        entry->end = yaml_edit_offset(ctx, last->end_mark.index);
+        if (entry->end > entry->limit) {
+            entry->end = entry->limit;
+        }
+        entry->end_index = last->end_mark.index;
+    }
+
+    /*
+     * Look for the indicator back over the spaces and, in a sequence, over
+     * the empty and comment lines.
+     */
+
+    pointer = entry->start;
+
+    while (1)
+    {
+        size_t line = pointer;
+        size_t k;
+
+        while (line > entry->previous && !EDIT_IS_BREAK(input[line-1])) {
+            line --;
+        }
+        if (pointer != entry->start) {
+            for (k = line; k < pointer; k ++) {
+                if (input[k] == '#' && (k == line || EDIT_IS_BLANK(input[k-1]))) {
+                    pointer = k;
+                    break;
+                }
+            }
+        }
+        while (pointer > line && EDIT_IS_BLANK(input[pointer-1])) {
+            pointer --;
+        }
+
+        if (pointer > line) {
+            if (input[pointer-1] == (sequence ? '-' : '?')
+                    && (pointer-1 == line
+                        || EDIT_IS_BLANK(input[pointer-2]))) {
+                entry->start = pointer-1;
+                return 1;
+            }
+            return !sequence;
+        }
+
+        if (!sequence || line == entry->previous)
+            return !sequence;
+
+        /* Move to the end of the previous line. */
+
+        pointer = line-1;
+        if (pointer > entry->previous && input[pointer] == '\n'
+                && input[pointer-1] == '\r') {
+            pointer --;
+        }
+    }
+}
+
+/*
+ * Start the walk over the entries of a block collection.
+ */
+
+static size_t
+yaml_edit_entries(struct edit_ctx *ctx, yaml_node_t *node,
+        size_t start, size_t end, struct edit_entry *entry)
+{
+    const unsigned char *input = ctx->input;
+    size_t anchor, anchor_length;
+    size_t body, pointer;
+
+    body = yaml_edit_properties(ctx, node, start, end,
+            &anchor, &anchor_length);
+
+    entry->previous = body;
+    entry->index = node->start_mark.index;
+    entry->limit = end;
+    for (pointer = start; pointer < body; pointer ++) {
+        if ((input[pointer] & 0xC0) != 0x80) {
+            entry->index ++;
+        }
+    }
+
+    return body;
+}
+
+/*
+ * Replace a modified block collection entry by entry.
+ *
+ * The entries kept from the input are copied together with the comments
+ * between them; the others are emitted.
+ */
+
+static int
+yaml_edit_collection(struct edit_ctx *ctx, yaml_node_t *node,
+        size_t start, size_t end)
+{
+    const unsigned char *input = ctx->input;
+    int sequence = (node->type == YAML_SEQUENCE_NODE);
+    size_t count = sequence
+        ? (size_t)(node->data.sequence.items.top
+                - node->data.sequence.items.start)
+        : (size_t)(node->data.mapping.pairs.top
+                - node->data.mapping.pairs.start);
+    struct edit_entry entry;
+    size_t body, column, pointer, indicator;
+    int previous_copied = 0;
+    size_t k;
+
+    /* Keep the properties and find the column of the entries. */
+
+    body = yaml_edit_entries(ctx, node, start, end, &entry);
+    if (!yaml_edit_write(ctx, input+start, body-start))
+        return 0;
+
+    column = 0;
+    for (pointer = body; pointer > ctx->base
+            && !EDIT_IS_BREAK(input[pointer-1]); pointer --) {
+        if ((input[pointer-1] & 0xC0) != 0x80) {
+            column ++;
+        }
+    }
+
+    if (!count) {
+        if (!yaml_edit_write(ctx,
+                    (const unsigned char *)(sequence ? "[]" : "{}"), 2))
+            return 0;
+    }
+
+    for (k = 0; k < count; k ++)
+    {
+        size_t previous = entry.previous;
+
+        if (yaml_edit_entry(ctx, node, k, &entry))
+        {
+            /* Keep the line breaks and comments between the entries. */
+
+            if ((k == 0 || previous_copied)
+                    && yaml_edit_clean(ctx, previous, entry.start)) {
+                if (!yaml_edit_gap(ctx, previous, entry.start))
+                    return 0;
+            }
+            else if (k > 0) {
+                if (!yaml_edit_separator(ctx, column))
+                    return 0;
+            }
+
+            /*
+             * The indicator is written as is, since a modified parent of the
+             * entry node in the input may start there.
+             */
+
+            indicator = yaml_edit_offset(ctx,
+                    ctx->document->nodes.start[entry.first-1]
+                    .start_mark.index);
+            if (indicator < entry.start)
+                indicator = entry.start;
+
+            if (!yaml_edit_write(ctx, ctx->input + entry.start,
+                        indicator - entry.start))
+                return 0;
+            if (!yaml_edit_copy(ctx, indicator, entry.end))
+                return 0;
+            entry.end = ctx->copied;
+
+            entry.previous = entry.end;
+            entry.index = entry.end_index;
+            previous_copied = 1;
+        }
+        else
+        {
+            /* Keep the comment that ends the line of the previous entry. */
+
+            if (previous_copied) {
+                if (!yaml_edit_gap(ctx, previous,
+                            yaml_edit_comment(ctx, previous)))
+                    return 0;
+            }
+
+            if (k > 0) {
+                if (!yaml_edit_separator(ctx, column))
+                    return 0;
+            }
+
+            ctx->fragment = entry.index;
+            if (!yaml_edit_render(ctx, node->type, entry.first, entry.second,
+                        column))
+                return 0;
+
+            previous_copied = 0;
+        }
+    }
+
+    /* Keep the comments after the last entry if it is copied. */
+
+    if (previous_copied && yaml_edit_clean(ctx, entry.previous, end))
+        return yaml_edit_gap(ctx, entry.previous, end);
+
+    if (previous_copied) {
+        if (!yaml_edit_gap(ctx, entry.previous,
+                    yaml_edit_comment(ctx, entry.previous)))
+            return 0;
+    }
+
+    /*
+     * The empty lines before the end belong to a dropped block scalar, so
+     * only the line is ended.
+     */
+
+    pointer = yaml_edit_trim(ctx, body, end);
+    if (pointer == end || EDIT_IS_BREAK(ctx->last))
+        return 1;
+
+    return yaml_edit_write(ctx, input+pointer,
+            (input[pointer] == '\r' && pointer+1 < end
+             && input[pointer+1] == '\n') ? 2 : 1);
+}
+
+/*
+ * Append the output of the fragment emitter.
+ */
+
+static int
+yaml_edit_output_handler(void *data, unsigned char *buffer, size_t size)
+{
+    struct edit_ctx *ctx = data;
+
+    if (ctx->length + size > ctx->capacity) {
+        size_t capacity = ctx->capacity ? ctx->capacity : 256;
+        unsigned char *output;
+        while (capacity < ctx->length + size) {
+            capacity *= 2;
+        }
+        output = yaml_realloc(ctx->output, capacity);
+        if (!output) return 0;
+        ctx->output = output;
+        ctx->capacity = capacity;
+    }
+
+    memcpy(ctx->output + ctx->length, buffer, size);
+    ctx->length += size;
+
+    return 1;
+}
+
+/*
+ * Emit nodes in place of the input.
+ *
+ * A @c YAML_SCALAR_NODE type means a single node in the flow context;
+ * otherwise the node (and the value node of a pair) is emitted as an entry
+ * of a block collection indented to the column.
+ */
+
+static int
+yaml_edit_render(struct edit_ctx *ctx, yaml_node_type_t type,
+        int first, int second, size_t column)
+{
+    yaml_emitter_t fragment;
+    yaml_event_t event;
+    yaml_mark_t mark = { 0, 0, 0 };
+    int flow = (type == YAML_SCALAR_NODE);
+    unsigned char *text;
+    size_t length;
+
+    if (!yaml_emitter_initialize(&fragment)) {
+        ctx->emitter->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+
+    yaml_emitter_set_output(&fragment, yaml_edit_output_handler, ctx);
+    yaml_emitter_set_encoding(&fragment, YAML_UTF8_ENCODING);
+    yaml_emitter_set_break(&fragment, YAML_LN_BREAK);
+    yaml_emitter_set_indent(&fragment, ctx->emitter->best_indent);
+    yaml_emitter_set_width(&fragment, flow ? -1 : ctx->emitter->best_width);
+    yaml_emitter_set_unicode(&fragment, ctx->emitter->unicode);
+
+    ctx->length = 0;
+
+    STREAM_START_EVENT_INIT(event, YAML_UTF8_ENCODING, mark, mark);
+    if (!yaml_emitter_emit(&fragment, &event)) goto error;
+
+    DOCUMENT_START_EVENT_INIT(event, NULL, NULL, NULL, 1, mark, mark);
+    if (!yaml_emitter_emit(&fragment, &event)) goto error;
+
+    if (type == YAML_MAPPING_NODE) {
+        MAPPING_START_EVENT_INIT(event, NULL, NULL, 1,
+                YAML_BLOCK_MAPPING_STYLE, mark, mark);
+    }
+    else {
+        SEQUENCE_START_EVENT_INIT(event, NULL, NULL, 1,
+                flow ? YAML_FLOW_SEQUENCE_STYLE : YAML_BLOCK_SEQUENCE_STYLE,
+                mark, mark);
+    }
+    if (!yaml_emitter_emit(&fragment, &event)) goto error;
+
+    if (!yaml_edit_emit_node(ctx, &fragment, first, flow)) goto error;
+    if (second && !yaml_edit_emit_node(ctx, &fragment, second, flow))
+        goto error;
+
+    if (type == YAML_MAPPING_NODE) {
+        MAPPING_END_EVENT_INIT(event, mark, mark);
+    }
+    else {
+        SEQUENCE_END_EVENT_INIT(event, mark, mark);
+    }
+    if (!yaml_emitter_emit(&fragment, &event)) goto error;
+
+    DOCUMENT_END_EVENT_INIT(event, 1, mark, mark);
+    if (!yaml_emitter_emit(&fragment, &event)) goto error;
+
+    STREAM_END_EVENT_INIT(event, mark, mark);
+    if (!yaml_emitter_emit(&fragment, &event)) goto error;
+
+    yaml_emitter_delete(&fragment);
+
+    /*
+     * Drop the final line break or the document end marker that follows an
+     * open ended scalar, and the brackets of the flow wrapper.
+     */
+
+    text = ctx->output;
+    length = ctx->length;
+
+    if (length >= 5 && memcmp(text+length-5, "\n...\n", 5) == 0) {
+        length -= 4;
+    }
+    else if (length && text[length-1] == '\n') {
+        length --;
+    }
+
+    if (flow) {
+        assert(length >= 2);    /* The wrapper is always written. */
+        text ++;
+        length -= 2;
+    }
+
+    return yaml_edit_write_indented(ctx, text, length, column);
+
+error:
+    if (fragment.error != YAML_NO_ERROR) {
+        ctx->emitter->error = fragment.error;
+        ctx->emitter->problem = fragment.problem;
+    }
+    else if (ctx->emitter->error == YAML_NO_ERROR) {
+        ctx->emitter->error = YAML_MEMORY_ERROR;
+    }
+    yaml_emitter_delete(&fragment);
+    return 0;
+}
+
+/*
+ * Emit a node into the fragment emitter.
+ *
+ * The anchors are taken from the input.  A node anchored in the input is
+ * emitted as an alias if it has been emitted already or if its input text
+ * precedes the fragment.
+ */
+
+static int
+yaml_edit_emit_node(struct edit_ctx *ctx, yaml_emitter_t *fragment,
+        int index, int flow)
+{
+    yaml_node_t *node = ctx->document->nodes.start + index - 1;
+    yaml_event_t event;
+    yaml_mark_t mark = { 0, 0, 0 };
+    yaml_char_t *anchor = NULL;
+    size_t anchor_start = 0, anchor_length = 0;
+    int k;
+
+    if (!ctx->states) {
+        size_t count = ctx->document->nodes.top - ctx->document->nodes.start;
+        ctx->states = yaml_malloc(count);
+        if (!ctx->states) {
+            ctx->emitter->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+        memset(ctx->states, EDIT_NONE, count);
+    }
+
+    if (yaml_edit_has_span(node)) {
+        size_t start = yaml_edit_offset(ctx, node->start_mark.index);
+        yaml_edit_properties(ctx, node, start,
+                yaml_edit_offset(ctx, node->end_mark.index),
+                &anchor_start, &anchor_length);
+    }
+
+    if (anchor_length) {
+        anchor = yaml_malloc(anchor_length+1);
+        if (!anchor) {
+            ctx->emitter->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+        memcpy(anchor, ctx->input+anchor_start, anchor_length);
+        anchor[anchor_length] = '\0';
+
+        if (ctx->states[index-1] != EDIT_NONE
+                || node->start_mark.index < ctx->fragment) {
+            ALIAS_EVENT_INIT(event, anchor, mark, mark);
+            k = yaml_emitter_emit_borrowed(fragment, &event, 0);
+            yaml_free(anchor);
+            return k;
+        }
+    }
+    else if (ctx->states[index-1] == EDIT_OPEN) {
+        ctx->emitter->error = YAML_EMITTER_ERROR;
+        ctx->emitter->problem = "found a recursive node without an anchor";
+        return 0;
+    }
+
+    ctx->states[index-1] = anchor ? EDIT_DONE : EDIT_OPEN;
+
+    switch (node->type)
+    {
+        case YAML_SCALAR_NODE:
+            {
+                yaml_char_t *value = node->data.scalar.value;
+                size_t length = node->data.scalar.length;
+                yaml_scalar_style_t style = node->data.scalar.style;
+                yaml_char_t *text = NULL;
+                int emitted;
+
+                if (node->resolved.type == YAML_BINARY_SCALAR_TYPE) {
+                    text = value = yaml_emitter_scalar_text(node,
+                            ctx->emitter->best_width, &length, &style);
+                    if (!value) {
+                        ctx->emitter->error = YAML_MEMORY_ERROR;
+                        goto error;
+                    }
+                }
+
+                /* Keep a flow scalar on a single line. */
+
+                if (flow && memchr(value, '\n', length)) {
+                    style = YAML_DOUBLE_QUOTED_SCALAR_STYLE;
+                }
+
+                SCALAR_EVENT_INIT(event, anchor, node->tag, value, length,
+                        yaml_emitter_plain_implicit(node),
+                        strcmp((char *)node->tag,
+                            YAML_DEFAULT_SCALAR_TAG) == 0,
+                        style, mark, mark);
+                emitted = yaml_emitter_emit_borrowed(fragment, &event, 0);
+                yaml_free(text);
+                if (!emitted)
+                    goto error;
+            }
+            break;
+
+        case YAML_SEQUENCE_NODE:
+            SEQUENCE_START_EVENT_INIT(event, anchor, node->tag,
+                    strcmp((char *)node->tag, YAML_DEFAULT_SEQUENCE_TAG) == 0,
+                    node->data.sequence.style, mark, mark);
+            if (!yaml_emitter_emit_borrowed(fragment, &event, 0))
+                goto error;
+            for (k = 0; node->data.sequence.items.start + k
+                    < node->data.sequence.items.top; k ++) {
+                if (!yaml_edit_emit_node(ctx, fragment,
+                            node->data.sequence.items.start[k], flow))
+                    goto error;
+            }
+            SEQUENCE_END_EVENT_INIT(event, mark, mark);
+            if (!yaml_emitter_emit(fragment, &event))
+                goto error;
+            break;
+
+        case YAML_MAPPING_NODE:
+            MAPPING_START_EVENT_INIT(event, anchor, node->tag,
+                    strcmp((char *)node->tag, YAML_DEFAULT_MAPPING_TAG) == 0,
+                    node->data.mapping.style, mark, mark);
+            if (!yaml_emitter_emit_borrowed(fragment, &event, 0))
+                goto error;
+            for (k = 0; node->data.mapping.pairs.start + k
+                    < node->data.mapping.pairs.top; k ++) {
+                if (!yaml_edit_emit_node(ctx, fragment,
+                            node->data.mapping.pairs.start[k].key, flow)
+                        || !yaml_edit_emit_node(ctx, fragment,
+                            node->data.mapping.pairs.start[k].value, flow))
+                    goto error;
+            }
+            MAPPING_END_EVENT_INIT(event, mark, mark);
+            if (!yaml_emitter_emit(fragment, &event))
+                goto error;
+            break;
+
+        default:
+            assert(0);      /* Could not happen. */
+    }
+
+    if (!anchor) {
+        ctx->states[index-1] = EDIT_NONE;
+    }
+    yaml_free(anchor);
+
+    return 1;
+
+error:
+    yaml_free(anchor);
+    return 0;
+}
+
+/*
+ * Mark the nodes reachable from a node.
+ *
+ * If the index of a fragment is given, an anchored node that precedes it is
+ * emitted as an alias, so it is neither marked nor followed.
+ */
+
+static void
+yaml_edit_reach(struct edit_ctx *ctx, unsigned char *marks, int index,
+        unsigned char mark, size_t fragment)
+{
+    yaml_node_t *node = ctx->document->nodes.start + index - 1;
+    int k;
+
+    if (marks[index-1] & mark)
+        return;
+
+    if (fragment && yaml_edit_has_span(node)
+            && node->start_mark.index < fragment
+            && yaml_edit_anchored(ctx, node))
+        return;
+
+    marks[index-1] |= mark;
+
+    if (node->type == YAML_SEQUENCE_NODE) {
+        for (k = 0; node->data.sequence.items.start + k
+                < node->data.sequence.items.top; k ++) {
+            yaml_edit_reach(ctx, marks, node->data.sequence.items.start[k],
+                    mark, fragment);
+        }
+    }
+    else if (node->type == YAML_MAPPING_NODE) {
+        for (k = 0; node->data.mapping.pairs.start + k
+                < node->data.mapping.pairs.top; k ++) {
+            yaml_edit_reach(ctx, marks, node->data.mapping.pairs.start[k].key,
+                    mark, fragment);
+            yaml_edit_reach(ctx, marks,
+                    node->data.mapping.pairs.start[k].value, mark, fragment);
+        }
+    }
+}
+
+/*
+ * Order the dropped ranges of the input.
+ */
+
+static int
+yaml_edit_compare_ranges(const void *a, const void *b)
+{
+    const struct edit_range *first = a;
+    const struct edit_range *second = b;
+
+    if (first->start != second->start)
+        return (first->start < second->start) ? -1 : 1;
+    return 0;
+}
+
+/*
+ * Order the fragments by their place.
+ */
+
+static int
+yaml_edit_compare_fragments(const void *a, const void *b)
+{
+    const struct edit_fragment *first = a;
+    const struct edit_fragment *second = b;
+
+    if (first->index != second->index)
+        return (first->index < second->index) ? -1 : 1;
+    return 0;
+}
+
+/*
+ * Check if a character index is in one of the ranges a character index.
+ */
+
+static int
+yaml_edit_dropped(struct edit_range *ranges, int count, size_t index)
+{
+    int low = 0;
+    int high = count;
+
+    while (low < high) {
+        int middle = low + (high-low)/2;
+        if (ranges[middle].end <= index) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    return (low < count && ranges[low].start <= index);
+}
+
+/*
+ * Check if a node is anchored in the input.
+ */
+
+static int
+yaml_edit_anchored(struct edit_ctx *ctx, yaml_node_t *node)
+{
+    size_t anchor, anchor_length;
+    size_t start;
+
+    if (!yaml_edit_has_span(node))
+        return 0;
+
+    start = yaml_edit_offset(ctx, node->start_mark.index);
+    yaml_edit_properties(ctx, node, start,
+            yaml_edit_offset(ctx, node->end_mark.index),
+            &anchor, &anchor_length);
+
+    return (anchor_length > 0);
+}
+
+/*
+ * Check that a fragment does not refer to a node defined by the kept text
+ * after it.
+ */
+
+static int
+yaml_edit_forward(struct edit_ctx *ctx, struct edit_range *ranges, int count,
+        unsigned char *marks, int index, size_t fragment, int root)
+{
+    yaml_node_t *node = ctx->document->nodes.start + index - 1;
+    int k;
+
+    if (marks[index-1] & 4)
+        return 0;
+    marks[index-1] |= 4;
+
+    if (!root && yaml_edit_has_span(node)
+            && node->start_mark.index >= fragment
+            && !yaml_edit_dropped(ranges, count, node->start_mark.index)
+            && yaml_edit_anchored(ctx, node))
+        return 1;
+
+    if (node->type == YAML_SEQUENCE_NODE) {
+        for (k = 0; node->data.sequence.items.start + k
+                < node->data.sequence.items.top; k ++) {
+            if (yaml_edit_forward(ctx, ranges, count, marks,
+                        node->data.sequence.items.start[k], fragment, 0))
+                return 1;
+        }
+    }
+    else if (node->type == YAML_MAPPING_NODE) {
+        for (k = 0; node->data.mapping.pairs.start + k
+                < node->data.mapping.pairs.top; k ++) {
+            if (yaml_edit_forward(ctx, ranges, count, marks,
+                        node->data.mapping.pairs.start[k].key, fragment, 0)
+                    || yaml_edit_forward(ctx, ranges, count, marks,
+                        node->data.mapping.pairs.start[k].value, fragment, 0))
+                return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Check that the anchors stay defined before their aliases.
+ *
+ * The text of the modified nodes and of the dropped entries is not copied.
+ * The whole document has to be emitted if an anchored node defined there is
+ * still in use and is not emitted again in place of a modified flow node,
+ * or if an emitted fragment refers to a node defined by the kept text after
+ * the fragment.
+ */
+
+static int
+yaml_edit_plan(struct edit_ctx *ctx, int *whole)
+{
+    yaml_document_t *document = ctx->document;
+    size_t nodes = document->nodes.top - document->nodes.start;
+    struct edit_range *ranges = NULL;
+    struct edit_fragment *fragments = NULL;
+    unsigned char *marks = NULL;
+    size_t capacity = 0;
+    int count = 0;
+    int fragments_count = 0;
+    int dropped = 0;
+    int k, j;
+
+    *whole = 0;
+
+    for (k = 0; k < ctx->count && !*whole; k ++) {
+        *whole = !yaml_edit_value(ctx, ctx->spans + k);
+    }
+
+    if (*whole)
+        return 1;
+
+    for (k = 0; k < ctx->count; k ++) {
+        yaml_node_t *node = document->nodes.start + ctx->spans[k].node - 1;
+        capacity += 1 + ((node->type == YAML_SEQUENCE_NODE)
+                ? node->data.sequence.items.top - node->data.sequence.items.start
+                : (node->type == YAML_MAPPING_NODE)
+                ? node->data.mapping.pairs.top - node->data.mapping.pairs.start
+                : 0);
+    }
+
+    if (!capacity)
+        return 1;
+
+    ranges = yaml_malloc(capacity * sizeof(*ranges));
+    fragments = yaml_malloc(capacity * 2 * sizeof(*fragments));
+    marks = yaml_malloc(nodes);
+    if (!ranges || !fragments || !marks)
+        goto error;
+    memset(marks, 0, nodes);
+
+    /*
+     * Collect the input text that is not copied and the emitted fragments;
+     * a fragment is the root node id and the index where it is placed.
+     */
+
+    for (k = 0; k < ctx->count; k ++)
+    {
+        yaml_node_t *node = document->nodes.start + ctx->spans[k].node - 1;
+        size_t start = ctx->spans[k].start;
+        size_t end = yaml_edit_offset(ctx, node->end_mark.index);
+
+        if (yaml_edit_is_block(node))
+        {
+            struct edit_entry entry;
+            size_t items = (node->type == YAML_SEQUENCE_NODE)
+                ? (size_t)(node->data.sequence.items.top
+                        - node->data.sequence.items.start)
+                : (size_t)(node->data.mapping.pairs.top
+                        - node->data.mapping.pairs.start);
+            size_t item;
+
+            yaml_edit_entries(ctx, node, start, yaml_edit_comment(ctx, end),
+                    &entry);
+
+            for (item = 0; item < items; item ++) {
+                if (!yaml_edit_entry(ctx, node, item, &entry)) {
+                    fragments[fragments_count].index = entry.index;
+                    fragments[fragments_count].node = entry.first;
+                    fragments_count ++;
+                    if (entry.second) {
+                        fragments[fragments_count].index = entry.index;
+                        fragments[fragments_count].node = entry.second;
+                        fragments_count ++;
+                    }
+                    continue;
+                }
+                ranges[count].start = entry.index;
+                ranges[count].end = document->nodes.start[entry.first-1]
+                    .start_mark.index;
+                count ++;
+                entry.previous = entry.end;
+                entry.index = entry.end_index;
+            }
+
+            ranges[count].start = entry.index;
+            ranges[count].end = node->end_mark.index;
+            count ++;
+        }
+        else {
+            ranges[count].start = node->start_mark.index + 1;
+            ranges[count].end = node->end_mark.index;
+            count ++;
+        }
+    }
+
+    /* Merge the ranges. */
+
+    qsort(ranges, count, sizeof(*ranges), yaml_edit_compare_ranges);
+
+    for (k = 0, j = 0; k < count; k ++) {
+        if (ranges[k].start >= ranges[k].end)
+            continue;
+        if (j > 0 && ranges[k].start <= ranges[j-1].end) {
+            if (ranges[j-1].end < ranges[k].end) {
+                ranges[j-1].end = ranges[k].end;
+            }
+        }
+        else {
+            ranges[j++] = ranges[k];
+        }
+    }
+    count = j;
+
+    /* The modified flow nodes that are copied are emitted in place. */
+
+    for (k = 0; k < ctx->count; k ++) {
+        yaml_node_t *node = document->nodes.start + ctx->spans[k].node - 1;
+        if (!yaml_edit_is_block(node)
+                && !yaml_edit_dropped(ranges, count, node->start_mark.index)) {
+            fragments[fragments_count].index = node->start_mark.index;
+            fragments[fragments_count].node = ctx->spans[k].node;
+            fragments_count ++;
+            yaml_edit_reach(ctx, marks, ctx->spans[k].node, 2,
+                    node->start_mark.index);
+        }
+    }
+
+    /* Check the fragments from the first one. */
+
+    qsort(fragments, fragments_count, sizeof(*fragments),
+            yaml_edit_compare_fragments);
+
+    for (k = 0; k < fragments_count && !*whole; k ++) {
+        yaml_node_t *node = document->nodes.start + fragments[k].node - 1;
+        *whole = yaml_edit_forward(ctx, ranges, count, marks,
+                fragments[k].node, fragments[k].index,
+                node->start_mark.index == fragments[k].index);
+    }
+
+    /* Look for the anchors in the dropped text. */
+
+    for (k = 0; k < count && !dropped && !*whole; k ++) {
+        size_t start = yaml_edit_offset(ctx, ranges[k].start);
+        size_t end = yaml_edit_offset(ctx, ranges[k].end);
+        dropped = (memchr(ctx->input+start, '&', end-start) != NULL);
+    }
+
+    if (dropped)
+    {
+        /* Find the dropped anchored nodes that are still in use. */
+
+        yaml_edit_reach(ctx, marks, 1, 1, 0);
+
+        for (k = 0; k < (int)nodes && !*whole; k ++) {
+            yaml_node_t *node = document->nodes.start + k;
+            *whole = ((marks[k] & 3) == 1 && yaml_edit_has_span(node)
+                    && yaml_edit_dropped(ranges, count,
+                        node->start_mark.index)
+                    && yaml_edit_anchored(ctx, node));
+        }
+    }
+
+    yaml_free(marks);
+    yaml_free(fragments);
+    yaml_free(ranges);
+
+    return 1;
+
+error:
+    yaml_free(marks);
+    yaml_free(fragments);
+    yaml_free(ranges);
+    ctx->emitter->error = YAML_MEMORY_ERROR;
+
+    return 0;
+}
+
+/*
+ * Order the modified nodes by their start and the enclosing ones first.
+ */
+
+static int
+yaml_edit_compare_spans(const void *a, const void *b)
+{
+    const struct edit_span *first = a;
+    const struct edit_span *second = b;
+
+    if (first->index != second->index)
+        return (first->index < second->index) ? -1 : 1;
+    if (first->end_index != second->end_index)
+        return (first->end_index > second->end_index) ? -1 : 1;
+    return 0;
+}
+
+/*
+ * Emit an edited document by copying its unchanged text.
+ */
+
+YAML_DECLARE(int)
+yaml_emitter_dump_edited(yaml_emitter_t *emitter, yaml_document_t *document,
+        const unsigned char *input, size_t size)
+{
+    struct edit_ctx ctx;
+    yaml_document_t copy;
+    int whole = 0;
+    int *id;
+    int k;
+
+    assert(emitter);            /* Non-NULL emitter object is required. */
+    assert(document);           /* Non-NULL document object is expected. */
+    assert(input || !size);     /* Non-NULL input is expected. */
+    assert(!emitter->opened);   /* The emitter should not be opened. */
+
+    /* Emit the whole document if its root has no input text. */
+
+    if (STACK_EMPTY(emitter, document->nodes)
+            || !yaml_edit_has_span(document->nodes.start))
+        goto whole;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.emitter = emitter;
+    ctx.document = document;
+    ctx.input = input;
+    ctx.size = size;
+    ctx.last = '\n';
+
+    if (size >= 3 && memcmp(input, "\xEF\xBB\xBF", 3) == 0) {
+        ctx.base = 3;
+    }
+    ctx.pointer = ctx.base;
+
+    switch (emitter->line_break) {
+        case YAML_CR_BREAK:
+            ctx.line_break = "\r";
+            break;
+        case YAML_CRLN_BREAK:
+            ctx.line_break = "\r\n";
+            break;
+        case YAML_LN_BREAK:
+            ctx.line_break = "\n";
+            break;
+        default:
+            {
+                const unsigned char *pointer = memchr(input, '\n', size);
+                ctx.line_break = (pointer && pointer > input
+                        && pointer[-1] == '\r') ? "\r\n" : "\n";
+            }
+    }
+
+    /* Collect the modified nodes that have input text. */
+
+    if (document->modified.start) {
+        ctx.spans = yaml_malloc(sizeof(*ctx.spans)
+                * (document->modified.top - document->modified.start + 1));
+        if (!ctx.spans) {
+            emitter->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+        for (id = document->modified.start; id < document->modified.top;
+                id ++) {
+            yaml_node_t *node = document->nodes.start + *id - 1;
+            if (!yaml_edit_has_span(node))
+                continue;
+            ctx.spans[ctx.count].index = node->start_mark.index;
+            ctx.spans[ctx.count].end_index = node->end_mark.index;
+            ctx.spans[ctx.count].node = *id;
+            ctx.spans[ctx.count].done = 0;
+            ctx.spans[ctx.count].colon = 0;
+            ctx.spans[ctx.count].column = 0;
+            ctx.count ++;
+        }
+        qsort(ctx.spans, ctx.count, sizeof(*ctx.spans),
+                yaml_edit_compare_spans);
+        for (k = 0; k < ctx.count; k ++) {
+            ctx.spans[k].start = yaml_edit_offset(&ctx, ctx.spans[k].index);
+        }
+    }
+
+    if (!yaml_edit_plan(&ctx, &whole))
+        goto error;
+
+    if (whole) {
+        yaml_free(ctx.spans);
+        goto whole;
+    }
+
+    if (emitter->encoding == YAML_ANY_ENCODING) {
+        emitter->encoding = YAML_UTF8_ENCODING;
+    }
+
+    /* A recoded output starts with its own BOM. */
+
+    if (emitter->encoding != YAML_UTF8_ENCODING) {
+        if (!yaml_edit_write(&ctx, (const unsigned char *)"\xEF\xBB\xBF", 3)
+                || !yaml_edit_copy(&ctx, ctx.base, size))
+            goto error;
+    }
+    else {
+        if (!yaml_edit_copy(&ctx, 0, size))
+            goto error;
+    }
+
+    if (!yaml_emitter_flush(emitter))
+        goto error;
+
+    emitter->opened = 1;
+    emitter->closed = 1;
+
+    yaml_free(ctx.spans);
+    yaml_free(ctx.states);
+    yaml_free(ctx.output);
+
+    return 1;
+
+whole:
+    if (!yaml_document_copy(&copy, document)) {
+        emitter->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+    if (!yaml_emitter_dump(emitter, &copy))
+        return 0;
+
+    return yaml_emitter_close(emitter);
+
+error:
+    yaml_free(ctx.spans);
+    yaml_free(ctx.states);
+    yaml_free(ctx.output);
+
+    return 0;
+}
@@ -1,6 +1,8 @@
 
 #include "yaml_private.h"
 
+#include <float.h>
+
 /*
  * Flush the buffer if needed.
  */
@@ -68,6 +70,22 @@
 YAML_DECLARE(int)
 yaml_emitter_emit(yaml_emitter_t *emitter, yaml_event_t *event);
 
+YAML_DECLARE(int)
+yaml_emitter_emit_borrowed(yaml_emitter_t *emitter,
+        const yaml_event_t *event, int parsed);
+
+YAML_DECLARE(int)
+yaml_emitter_emit_int64(yaml_emitter_t *emitter, int64_t value);
+
+YAML_DECLARE(int)
+yaml_emitter_emit_double(yaml_emitter_t *emitter, double value);
+
+YAML_DECLARE(int)
+yaml_emitter_emit_bool(yaml_emitter_t *emitter, int value);
+
+YAML_DECLARE(int)
+yaml_emitter_emit_null(yaml_emitter_t *emitter);
+
 /*
  * Utility functions.
  */
@@ -143,6 +161,12 @@ yaml_emitter_emit_alias(yaml_emitter_t *emitter, yaml_event_t *event);
 static int
 yaml_emitter_emit_scalar(yaml_emitter_t *emitter, yaml_event_t *event);
 
+static int
+yaml_emitter_emit_scalar_start(yaml_emitter_t *emitter, yaml_event_t *event);
+
+static int
+yaml_emitter_emit_scalar_chunk(yaml_emitter_t *emitter, yaml_event_t *event);
+
 static int
 yaml_emitter_emit_sequence_start(yaml_emitter_t *emitter, yaml_event_t *event);
 
@@ -205,9 +229,13 @@ static int
 yaml_emitter_analyze_scalar(yaml_emitter_t *emitter,
         yaml_char_t *value, size_t length);
 
+static int
+yaml_emitter_analyze_parsed_scalar(yaml_emitter_t *emitter,
+        yaml_char_t *value, size_t length, yaml_scalar_style_t style);
+
 static int
 yaml_emitter_analyze_event(yaml_emitter_t *emitter,
-        yaml_event_t *event);
+        yaml_event_t *event, int parsed);
 
 /*
  * Writers.
@@ -248,6 +276,11 @@ static int
 yaml_emitter_write_double_quoted_scalar(yaml_emitter_t *emitter,
         yaml_char_t *value, size_t length, int allow_breaks);
 
+static int
+yaml_emitter_write_double_quoted_text(yaml_emitter_t *emitter,
+        yaml_char_t *value, size_t length, int allow_breaks, int first,
+        int *spaces);
+
 static int
 yaml_emitter_write_block_scalar_hints(yaml_emitter_t *emitter,
         yaml_string_t string);
@@ -260,6 +293,32 @@ static int
 yaml_emitter_write_folded_scalar(yaml_emitter_t *emitter,
         yaml_char_t *value, size_t length);
 
+/*
+ * Number formatting.
+ */
+
+static size_t
+yaml_emitter_format_int64(int64_t value, yaml_char_t *buffer);
+
+static size_t
+yaml_emitter_format_double(double value, yaml_char_t *buffer);
+
+static int
+yaml_emitter_emit_formatted(yaml_emitter_t *emitter, const char *tag,
+        yaml_char_t *value, size_t length);
+
+/*
+ * Borrowed events.
+ */
+
+static int
+yaml_emitter_copy_event(yaml_emitter_t *emitter, const yaml_event_t *event,
+        yaml_event_t *copy);
+
+static int
+yaml_emitter_emit_queued(yaml_emitter_t *emitter, yaml_event_t *event,
+        int parsed);
+
 /*
  * Set an emitter error and return 0.
  */
@@ -280,13 +339,28 @@ yaml_emitter_set_emitter_error(yaml_emitter_t *emitter, const char *problem)
 YAML_DECLARE(int)
 yaml_emitter_emit(yaml_emitter_t *emitter, yaml_event_t *event)
 {
+    return yaml_emitter_emit_queued(emitter, event, 0);
+}
+
+/*
+ * Queue an event and emit the events that no longer need lookahead.
+ */
+
+static int
+yaml_emitter_emit_queued(yaml_emitter_t *emitter, yaml_event_t *event,
+        int parsed)
+{
+    emitter->parsed = (QUEUE_EMPTY(emitter, emitter->events)
+            || emitter->parsed) && parsed;
+
     if (!ENQUEUE(emitter, emitter->events, *event)) {
         yaml_event_delete(event);
         return 0;
     }
 
     while (!yaml_emitter_need_more_events(emitter)) {
-        if (!yaml_emitter_analyze_event(emitter, emitter->events.head))
+        if (!yaml_emitter_analyze_event(emitter, emitter->events.head,
+                    emitter->parsed))
             return 0;
         if (!yaml_emitter_state_machine(emitter, emitter->events.head))
             return 0;
@@ -296,6 +370,330 @@ yaml_emitter_emit(yaml_emitter_t *emitter, yaml_event_t *event)
     return 1;
 }
 
+/*
+ * Copy a borrowed event.
+ */
+
+static int
+yaml_emitter_copy_event(yaml_emitter_t *emitter, const yaml_event_t *event,
+        yaml_event_t *copy)
+{
+    int result = 0;
+
+    switch (event->type)
+    {
+        case YAML_STREAM_START_EVENT:
+            result = yaml_stream_start_event_initialize(copy,
+                    event->data.stream_start.encoding);
+            break;
+
+        case YAML_STREAM_END_EVENT:
+            result = yaml_stream_end_event_initialize(copy);
+            break;
+
+        case YAML_DOCUMENT_START_EVENT:
+            result = yaml_document_start_event_initialize(copy,
+                    event->data.document_start.version_directive,
+                    event->data.document_start.tag_directives.start,
+                    event->data.document_start.tag_directives.end,
+                    event->data.document_start.implicit);
+            break;
+
+        case YAML_DOCUMENT_END_EVENT:
+            result = yaml_document_end_event_initialize(copy,
+                    event->data.document_end.implicit);
+            break;
+
+        case YAML_ALIAS_EVENT:
+            result = yaml_alias_event_initialize(copy,
+                    event->data.alias.anchor);
+            break;
+
+        case YAML_SCALAR_EVENT:
+            result = yaml_scalar_event_initialize(copy,
+                    event->data.scalar.anchor, event->data.scalar.tag,
+                    event->data.scalar.value, (int)event->data.scalar.length,
+                    event->data.scalar.plain_implicit,
+                    event->data.scalar.quoted_implicit,
+                    event->data.scalar.style);
+            break;
+
+        case YAML_SCALAR_START_EVENT:
+            result = yaml_scalar_start_event_initialize(copy,
+                    event->data.scalar.anchor, event->data.scalar.tag,
+                    event->data.scalar.plain_implicit,
+                    event->data.scalar.quoted_implicit,
+                    event->data.scalar.style);
+            break;
+
+        case YAML_SCALAR_CHUNK_EVENT:
+            result = yaml_scalar_chunk_event_initialize(copy,
+                    event->data.scalar.value, (int)event->data.scalar.length);
+            break;
+
+        case YAML_SCALAR_END_EVENT:
+            result = yaml_scalar_end_event_initialize(copy);
+            break;
+
+        case YAML_SEQUENCE_START_EVENT:
+            result = yaml_sequence_start_event_initialize(copy,
+                    event->data.sequence_start.anchor,
+                    event->data.sequence_start.tag,
+                    event->data.sequence_start.implicit,
+                    event->data.sequence_start.style);
+            break;
+
+        case YAML_SEQUENCE_END_EVENT:
+            result = yaml_sequence_end_event_initialize(copy);
+            break;
+
+        case YAML_MAPPING_START_EVENT:
+            result = yaml_mapping_start_event_initialize(copy,
+                    event->data.mapping_start.anchor,
+                    event->data.mapping_start.tag,
+                    event->data.mapping_start.implicit,
+                    event->data.mapping_start.style);
+            break;
+
+        case YAML_MAPPING_END_EVENT:
+            result = yaml_mapping_end_event_initialize(copy);
+            break;
+
+        default:
+            assert(0);      /* Unknown event type. */
+    }
+
+    if (!result) {
+        emitter->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Emit a borrowed event.
+ *
+ * If no events are waiting in the queue and the event does not need the
+ * following ones, it is processed right away without being copied.
+ * Otherwise, it is copied and queued.
+ */
+
+YAML_DECLARE(int)
+yaml_emitter_emit_borrowed(yaml_emitter_t *emitter,
+        const yaml_event_t *event, int parsed)
+{
+    yaml_event_t copy;
+    int result;
+
+    assert(emitter);    /* Non-NULL emitter object is expected. */
+    assert(event);      /* Non-NULL event object is expected. */
+
+    if (!QUEUE_EMPTY(emitter, emitter->events)
+            || event->type == YAML_DOCUMENT_START_EVENT
+            || event->type == YAML_SEQUENCE_START_EVENT
+            || event->type == YAML_MAPPING_START_EVENT) {
+        if (!yaml_emitter_copy_event(emitter, event, &copy))
+            return 0;
+        return yaml_emitter_emit_queued(emitter, &copy, parsed);
+    }
+
+    if (!ENQUEUE(emitter, emitter->events, *event))
+        return 0;
+
+    result = (yaml_emitter_analyze_event(emitter, emitter->events.head, parsed)
+            && yaml_emitter_state_machine(emitter, emitter->events.head));
+
+    /* The event is borrowed, so it is dropped without deleting. */
+
+    (void)DEQUEUE(emitter, emitter->events);
+
+    return result;
+}
+
+/*
+ * Analyze a scalar once to emit it many times.
+ *
+ * The result is a combination of the ANALYSIS_ flags.  Without an emitter,
+ * non-ASCII characters are treated as special characters.
+ */
+
+YAML_DECLARE(int)
+yaml_emitter_analyze_static(yaml_emitter_t *emitter,
+        const yaml_char_t *value, size_t length)
+{
+    yaml_emitter_t scratch;
+
+    if (!emitter) {
+        memset(&scratch, 0, sizeof(scratch));
+        emitter = &scratch;
+    }
+
+    (void)yaml_emitter_analyze_scalar(emitter, (yaml_char_t *)value, length);
+
+    return (emitter->scalar_data.multiline ? ANALYSIS_MULTILINE : 0)
+        | (emitter->scalar_data.flow_plain_allowed
+                ? ANALYSIS_FLOW_PLAIN_ALLOWED : 0)
+        | (emitter->scalar_data.block_plain_allowed
+                ? ANALYSIS_BLOCK_PLAIN_ALLOWED : 0)
+        | (emitter->scalar_data.single_quoted_allowed
+                ? ANALYSIS_SINGLE_QUOTED_ALLOWED : 0)
+        | (emitter->scalar_data.block_allowed ? ANALYSIS_BLOCK_ALLOWED : 0);
+}
+
+/*
+ * Emit a scalar analyzed in advance.
+ *
+ * The analysis of the scalar is skipped and the value is processed right
+ * away without being copied.  Unless the analysis has ANALYSIS_PLAIN_IMPLICIT,
+ * the scalar is quoted.
+ */
+
+YAML_DECLARE(int)
+yaml_emitter_emit_analyzed(yaml_emitter_t *emitter, const char *tag,
+        const yaml_char_t *value, size_t length, int analysis)
+{
+    yaml_event_t event;
+    yaml_mark_t mark = { 0, 0, 0 };
+    int plain_implicit = (analysis & ANALYSIS_PLAIN_IMPLICIT) != 0;
+    int result;
+
+    assert(emitter);    /* Non-NULL emitter object is expected. */
+
+    if (emitter->canonical) {
+        if (!yaml_scalar_event_initialize(&event, NULL, (yaml_char_t *)tag,
+                    (yaml_char_t *)value, (int)length, 0, 0,
+                    YAML_PLAIN_SCALAR_STYLE)) {
+            emitter->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+        return yaml_emitter_emit(emitter, &event);
+    }
+
+    SCALAR_EVENT_INIT(event, NULL, NULL, (yaml_char_t *)value, length,
+            plain_implicit, 1, YAML_PLAIN_SCALAR_STYLE, mark, mark);
+
+    if (!ENQUEUE(emitter, emitter->events, event))
+        return 0;
+
+    /*
+     * The waiting events look ahead only at the type of the event that
+     * follows them, so they can be emitted now that a scalar follows.
+     */
+
+    while (emitter->events.head != emitter->events.tail - 1) {
+        if (!yaml_emitter_analyze_event(emitter, emitter->events.head,
+                    emitter->parsed)
+                || !yaml_emitter_state_machine(emitter, emitter->events.head)) {
+            emitter->events.tail --;
+            return 0;
+        }
+        yaml_event_delete(&DEQUEUE(emitter, emitter->events));
+    }
+
+    emitter->anchor_data.anchor = NULL;
+    emitter->anchor_data.anchor_length = 0;
+    emitter->tag_data.handle = NULL;
+    emitter->tag_data.handle_length = 0;
+    emitter->tag_data.suffix = NULL;
+    emitter->tag_data.suffix_length = 0;
+    emitter->scalar_data.value = (yaml_char_t *)value;
+    emitter->scalar_data.length = length;
+    emitter->scalar_data.multiline = (analysis & ANALYSIS_MULTILINE) != 0;
+    emitter->scalar_data.flow_plain_allowed =
+        (analysis & ANALYSIS_FLOW_PLAIN_ALLOWED) != 0;
+    emitter->scalar_data.block_plain_allowed =
+        (analysis & ANALYSIS_BLOCK_PLAIN_ALLOWED) != 0;
+    emitter->scalar_data.single_quoted_allowed =
+        (analysis & ANALYSIS_SINGLE_QUOTED_ALLOWED) != 0;
+    emitter->scalar_data.block_allowed =
+        (analysis & ANALYSIS_BLOCK_ALLOWED) != 0;
+
+    result = yaml_emitter_state_machine(emitter, emitter->events.head);
+
+    /* The event does not own the value, so it is dropped without deleting. */
+
+    (void)DEQUEUE(emitter, emitter->events);
+
+    return result;
+}
+
+/*
+ * Emit a scalar formatted by one of the typed emitters.
+ *
+ * The value is known to be a valid plain scalar.
+ */
+
+static int
+yaml_emitter_emit_formatted(yaml_emitter_t *emitter, const char *tag,
+        yaml_char_t *value, size_t length)
+{
+    return yaml_emitter_emit_analyzed(emitter, tag, value, length,
+            ANALYSIS_FLOW_PLAIN_ALLOWED | ANALYSIS_BLOCK_PLAIN_ALLOWED
+            | ANALYSIS_SINGLE_QUOTED_ALLOWED | ANALYSIS_PLAIN_IMPLICIT);
+}
+
+/*
+ * Emit an integer scalar.
+ */
+
+YAML_DECLARE(int)
+yaml_emitter_emit_int64(yaml_emitter_t *emitter, int64_t value)
+{
+    yaml_char_t buffer[24];
+    size_t length;
+
+    length = yaml_emitter_format_int64(value, buffer);
+
+    return yaml_emitter_emit_formatted(emitter, YAML_INT_TAG, buffer, length);
+}
+
+/*
+ * Emit a floating point scalar.
+ */
+
+YAML_DECLARE(int)
+yaml_emitter_emit_double(yaml_emitter_t *emitter, double value)
+{
+    yaml_char_t buffer[32];
+    size_t length;
+
+    length = yaml_emitter_format_double(value, buffer);
+
+    return yaml_emitter_emit_formatted(emitter, YAML_FLOAT_TAG, buffer, length);
+}
+
+/*
+ * Emit a boolean scalar.
+ */
+
+YAML_DECLARE(int)
+yaml_emitter_emit_bool(yaml_emitter_t *emitter, int value)
+{
+    yaml_char_t buffer[6];
+
+    if (value) {
+        memcpy(buffer, "true", 5);
+        return yaml_emitter_emit_formatted(emitter, YAML_BOOL_TAG, buffer, 4);
+    }
+
+    memcpy(buffer, "false", 6);
+    return yaml_emitter_emit_formatted(emitter, YAML_BOOL_TAG, buffer, 5);
+}
+
+/*
+ * Emit a null scalar.
+ */
+
+YAML_DECLARE(int)
+yaml_emitter_emit_null(yaml_emitter_t *emitter)
+{
+    yaml_char_t buffer[5];
+
+    memcpy(buffer, "null", 5);
+    return yaml_emitter_emit_formatted(emitter, YAML_NULL_TAG, buffer, 4);
+}
+
 /*
  * Check if we need to accumulate more events before emitting.
  *
@@ -480,6 +878,9 @@ yaml_emitter_state_machine(yaml_emitter_t *emitter, yaml_event_t *event)
             return yaml_emitter_set_emitter_error(emitter,
                     "expected nothing after STREAM-END");
 
+        case YAML_EMIT_SCALAR_CHUNK_STATE:
+            return yaml_emitter_emit_scalar_chunk(emitter, event);
+
         default:
             assert(1);      /* Invalid state. */
     }
@@ -1000,6 +1401,9 @@ yaml_emitter_emit_node(yaml_emitter_t *emitter, yaml_event_t *event,
         case YAML_SCALAR_EVENT:
             return yaml_emitter_emit_scalar(emitter, event);
 
+        case YAML_SCALAR_START_EVENT:
+            return yaml_emitter_emit_scalar_start(emitter, event);
+
         case YAML_SEQUENCE_START_EVENT:
             return yaml_emitter_emit_sequence_start(emitter, event);
 
@@ -1053,6 +1457,81 @@ yaml_emitter_emit_scalar(yaml_emitter_t *emitter, yaml_event_t *event)
     return 1;
 }
 
+/*
+ * Expect SCALAR-START.
+ *
+ * The style of a scalar given in chunks cannot be chosen by its value, so it
+ * is always written double-quoted.
+ */
+
+static int
+yaml_emitter_emit_scalar_start(yaml_emitter_t *emitter, yaml_event_t *event)
+{
+    if (!emitter->tag_data.handle && !emitter->tag_data.suffix)
+    {
+        if (!event->data.scalar.plain_implicit
+                && !event->data.scalar.quoted_implicit) {
+            return yaml_emitter_set_emitter_error(emitter,
+                    "neither tag nor implicit flags are specified");
+        }
+        if (!event->data.scalar.quoted_implicit) {
+            emitter->tag_data.handle = (yaml_char_t *)"!";
+            emitter->tag_data.handle_length = 1;
+        }
+    }
+
+    if (!yaml_emitter_process_anchor(emitter))
+        return 0;
+    if (!yaml_emitter_process_tag(emitter))
+        return 0;
+    if (!yaml_emitter_increase_indent(emitter, 1, 0))
+        return 0;
+    if (!yaml_emitter_write_indicator(emitter, "\"", 1, 0, 0))
+        return 0;
+
+    emitter->scalar_chunk.empty = 1;
+    emitter->scalar_chunk.spaces = 0;
+    emitter->state = YAML_EMIT_SCALAR_CHUNK_STATE;
+
+    return 1;
+}
+
+/*
+ * Expect SCALAR-CHUNK or SCALAR-END.
+ */
+
+static int
+yaml_emitter_emit_scalar_chunk(yaml_emitter_t *emitter, yaml_event_t *event)
+{
+    if (event->type == YAML_SCALAR_CHUNK_EVENT)
+    {
+        if (!event->data.scalar.length)
+            return 1;
+        if (!yaml_emitter_write_double_quoted_text(emitter,
+                    event->data.scalar.value, event->data.scalar.length, 1,
+                    emitter->scalar_chunk.empty, &emitter->scalar_chunk.spaces))
+            return 0;
+        emitter->scalar_chunk.empty = 0;
+
+        return 1;
+    }
+
+    if (event->type == YAML_SCALAR_END_EVENT)
+    {
+        if (!yaml_emitter_write_indicator(emitter, "\"", 0, 0, 0))
+            return 0;
+        emitter->whitespace = 0;
+        emitter->indention = 0;
+        emitter->indent = POP(emitter, emitter->indents);
+        emitter->state = POP(emitter, emitter->states);
+
+        return 1;
+    }
+
+    return yaml_emitter_set_emitter_error(emitter,
+            "expected SCALAR-CHUNK or SCALAR-END");
+}
+
 /*
  * Expect SEQUENCE-START.
  */
@@ -1693,13 +2172,60 @@ yaml_emitter_analyze_scalar(yaml_emitter_t *emitter,
     return 1;
 }
 
+/*
+ * Analyze a scalar in the style it was parsed in.
+ *
+ * A scalar produced by the parser can be written back in its original style
+ * in the same context.  A double-quoted scalar needs no analysis; plain and
+ * single-quoted scalars are only checked for line breaks and control
+ * characters, and for non-ASCII characters unless Unicode is allowed.  If
+ * the function returns 0, the scalar needs the full analysis.
+ */
+
+static int
+yaml_emitter_analyze_parsed_scalar(yaml_emitter_t *emitter,
+        yaml_char_t *value, size_t length, yaml_scalar_style_t style)
+{
+    size_t k;
+
+    if (emitter->canonical || !length)
+        return 0;
+
+    if (style != YAML_PLAIN_SCALAR_STYLE
+            && style != YAML_SINGLE_QUOTED_SCALAR_STYLE
+            && style != YAML_DOUBLE_QUOTED_SCALAR_STYLE)
+        return 0;
+
+    if (style != YAML_DOUBLE_QUOTED_SCALAR_STYLE) {
+        for (k = 0; k < length; k ++) {
+            yaml_char_t octet = value[k];
+            if (octet < 0x20 || octet == 0x7F || (octet >= 0x80
+                        && (!emitter->unicode || octet == 0xE2)))
+                return 0;
+        }
+    }
+
+    emitter->scalar_data.value = value;
+    emitter->scalar_data.length = length;
+    emitter->scalar_data.multiline = 0;
+    emitter->scalar_data.flow_plain_allowed =
+        (style == YAML_PLAIN_SCALAR_STYLE);
+    emitter->scalar_data.block_plain_allowed =
+        (style == YAML_PLAIN_SCALAR_STYLE);
+    emitter->scalar_data.single_quoted_allowed =
+        (style == YAML_SINGLE_QUOTED_SCALAR_STYLE);
+    emitter->scalar_data.block_allowed = 0;
+
+    return 1;
+}
+
 /*
  * Check if the event data is valid.
  */
 
 static int
 yaml_emitter_analyze_event(yaml_emitter_t *emitter,
-        yaml_event_t *event)
+        yaml_event_t *event, int parsed)
 {
     emitter->anchor_data.anchor = NULL;
     emitter->anchor_data.anchor_length = 0;
@@ -1730,11 +2256,29 @@ yaml_emitter_analyze_event(yaml_emitter_t *emitter,
                 if (!yaml_emitter_analyze_tag(emitter, event->data.scalar.tag))
                     return 0;
             }
+            if (parsed && yaml_emitter_analyze_parsed_scalar(emitter,
+                        event->data.scalar.value, event->data.scalar.length,
+                        event->data.scalar.style))
+                return 1;
             if (!yaml_emitter_analyze_scalar(emitter,
                         event->data.scalar.value, event->data.scalar.length))
                 return 0;
             return 1;
 
+        case YAML_SCALAR_START_EVENT:
+            if (event->data.scalar.anchor) {
+                if (!yaml_emitter_analyze_anchor(emitter,
+                            event->data.scalar.anchor, 0))
+                    return 0;
+            }
+            if (event->data.scalar.tag && (emitter->canonical ||
+                        (!event->data.scalar.plain_implicit
+                         && !event->data.scalar.quoted_implicit))) {
+                if (!yaml_emitter_analyze_tag(emitter, event->data.scalar.tag))
+                    return 0;
+            }
+            return 1;
+
         case YAML_SEQUENCE_START_EVENT:
             if (event->data.sequence_start.anchor) {
                 if (!yaml_emitter_analyze_anchor(emitter,
@@ -2051,14 +2595,41 @@ static int
 yaml_emitter_write_double_quoted_scalar(yaml_emitter_t *emitter,
         yaml_char_t *value, size_t length, int allow_breaks)
 {
-    yaml_string_t string;
     int spaces = 0;
 
-    STRING_ASSIGN(string, value, length);
-
     if (!yaml_emitter_write_indicator(emitter, "\"", 1, 0, 0))
         return 0;
 
+    if (!yaml_emitter_write_double_quoted_text(emitter, value, length,
+                allow_breaks, 1, &spaces))
+        return 0;
+
+    if (!yaml_emitter_write_indicator(emitter, "\"", 0, 0, 0))
+        return 0;
+
+    emitter->whitespace = 0;
+    emitter->indention = 0;
+
+    return 1;
+}
+
+/*
+ * Write the content of a double-quoted scalar or a part of it.
+ *
+ * A line is never broken before the first character of the scalar, which
+ * is in the part if @a first is set, or before the last character of the
+ * part.
+ */
+
+static int
+yaml_emitter_write_double_quoted_text(yaml_emitter_t *emitter,
+        yaml_char_t *value, size_t length, int allow_breaks, int first,
+        int *spaces)
+{
+    yaml_string_t string;
+
+    STRING_ASSIGN(string, value, length);
+
     while (string.pointer != string.end)
     {
         if (!IS_PRINTABLE(string) || (!emitter->unicode && !IS_ASCII(string))
@@ -2168,13 +2739,13 @@ yaml_emitter_write_double_quoted_scalar(yaml_emitter_t *emitter,
                             return 0;
                     }
             }
-            spaces = 0;
+            *spaces = 0;
         }
         else if (IS_SPACE(string))
         {
-            if (allow_breaks && !spaces
+            if (allow_breaks && !*spaces
                     && emitter->column > emitter->best_width
-                    && string.pointer != string.start
+                    && (!first || string.pointer != string.start)
                     && string.pointer != string.end - 1) {
                 if (!yaml_emitter_write_indent(emitter)) return 0;
                 if (IS_SPACE_AT(string, 1)) {
@@ -2185,21 +2756,15 @@ yaml_emitter_write_double_quoted_scalar(yaml_emitter_t *emitter,
             else {
                 if (!WRITE(emitter, string)) return 0;
             }
-            spaces = 1;
+            *spaces = 1;
         }
         else
         {
             if (!WRITE(emitter, string)) return 0;
-            spaces = 0;
+            *spaces = 0;
         }
     }
 
-    if (!yaml_emitter_write_indicator(emitter, "\"", 0, 0, 0))
-        return 0;
-
-    emitter->whitespace = 0;
-    emitter->indention = 0;
-
     return 1;
 }
 
@@ -2356,3 +2921,475 @@ yaml_emitter_write_folded_scalar(yaml_emitter_t *emitter,
 
     return 1;
 }
+
+/*
+ * Number formatting.
+ */
+
+/*
+ * Pairs of decimal digits for formatting integers two digits at a time.
+ */
+
+static const char yaml_emitter_digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/*
+ * Format an integer.  The buffer should hold at least 20 characters.
+ */
+
+static size_t
+yaml_emitter_format_int64(int64_t value, yaml_char_t *buffer)
+{
+    yaml_char_t digits[20];
+    yaml_char_t *pointer = digits + sizeof(digits);
+    uint64_t magnitude = (value < 0) ? (uint64_t)0 - (uint64_t)value
+        : (uint64_t)value;
+    size_t length = 0;
+
+    while (magnitude >= 100) {
+        const char *pair = yaml_emitter_digit_pairs + (magnitude % 100) * 2;
+        magnitude /= 100;
+        *(--pointer) = pair[1];
+        *(--pointer) = pair[0];
+    }
+
+    if (magnitude >= 10) {
+        const char *pair = yaml_emitter_digit_pairs + magnitude * 2;
+        *(--pointer) = pair[1];
+        *(--pointer) = pair[0];
+    }
+    else {
+        *(--pointer) = (yaml_char_t)('0' + magnitude);
+    }
+
+    if (value < 0)
+        buffer[length++] = '-';
+
+    memcpy(buffer + length, pointer, digits + sizeof(digits) - pointer);
+    length += digits + sizeof(digits) - pointer;
+
+    return length;
+}
+
+/*
+ * Floating point values are formatted with the Grisu2 algorithm by Florian
+ * Loitsch ("Printing Floating-Point Numbers Quickly and Accurately with
+ * Integers").  It produces the shortest digit string that reads back as the
+ * same value in almost all cases, and a slightly longer one that still reads
+ * back correctly otherwise.  As in Grisu3, the cases where a shorter string
+ * could be hidden by the error of the computation are detected, and the
+ * shorter candidates are then checked exactly.
+ */
+
+typedef struct {
+    uint64_t f;
+    int e;
+} yaml_diy_fp_t;
+
+/*
+ * Normalized powers of ten from 10^-348 to 10^340 in steps of 10^8.
+ */
+
+static const uint64_t yaml_emitter_cached_powers_f[] = {
+    UINT64_C(0xFA8FD5A0081C0288), UINT64_C(0xBAAEE17FA23EBF76), UINT64_C(0x8B16FB203055AC76),
+    UINT64_C(0xCF42894A5DCE35EA), UINT64_C(0x9A6BB0AA55653B2D), UINT64_C(0xE61ACF033D1A45DF),
+    UINT64_C(0xAB70FE17C79AC6CA), UINT64_C(0xFF77B1FCBEBCDC4F), UINT64_C(0xBE5691EF416BD60C),
+    UINT64_C(0x8DD01FAD907FFC3C), UINT64_C(0xD3515C2831559A83), UINT64_C(0x9D71AC8FADA6C9B5),
+    UINT64_C(0xEA9C227723EE8BCB), UINT64_C(0xAECC49914078536D), UINT64_C(0x823C12795DB6CE57),
+    UINT64_C(0xC21094364DFB5637), UINT64_C(0x9096EA6F3848984F), UINT64_C(0xD77485CB25823AC7),
+    UINT64_C(0xA086CFCD97BF97F4), UINT64_C(0xEF340A98172AACE5), UINT64_C(0xB23867FB2A35B28E),
+    UINT64_C(0x84C8D4DFD2C63F3B), UINT64_C(0xC5DD44271AD3CDBA), UINT64_C(0x936B9FCEBB25C996),
+    UINT64_C(0xDBAC6C247D62A584), UINT64_C(0xA3AB66580D5FDAF6), UINT64_C(0xF3E2F893DEC3F126),
+    UINT64_C(0xB5B5ADA8AAFF80B8), UINT64_C(0x87625F056C7C4A8B), UINT64_C(0xC9BCFF6034C13053),
+    UINT64_C(0x964E858C91BA2655), UINT64_C(0xDFF9772470297EBD), UINT64_C(0xA6DFBD9FB8E5B88F),
+    UINT64_C(0xF8A95FCF88747D94), UINT64_C(0xB94470938FA89BCF), UINT64_C(0x8A08F0F8BF0F156B),
+    UINT64_C(0xCDB02555653131B6), UINT64_C(0x993FE2C6D07B7FAC), UINT64_C(0xE45C10C42A2B3B06),
+    UINT64_C(0xAA242499697392D3), UINT64_C(0xFD87B5F28300CA0E), UINT64_C(0xBCE5086492111AEB),
+    UINT64_C(0x8CBCCC096F5088CC), UINT64_C(0xD1B71758E219652C), UINT64_C(0x9C40000000000000),
+    UINT64_C(0xE8D4A51000000000), UINT64_C(0xAD78EBC5AC620000), UINT64_C(0x813F3978F8940984),
+    UINT64_C(0xC097CE7BC90715B3), UINT64_C(0x8F7E32CE7BEA5C70), UINT64_C(0xD5D238A4ABE98068),
+    UINT64_C(0x9F4F2726179A2245), UINT64_C(0xED63A231D4C4FB27), UINT64_C(0xB0DE65388CC8ADA8),
+    UINT64_C(0x83C7088E1AAB65DB), UINT64_C(0xC45D1DF942711D9A), UINT64_C(0x924D692CA61BE758),
+    UINT64_C(0xDA01EE641A708DEA), UINT64_C(0xA26DA3999AEF774A), UINT64_C(0xF209787BB47D6B85),
+    UINT64_C(0xB454E4A179DD1877), UINT64_C(0x865B86925B9BC5C2), UINT64_C(0xC83553C5C8965D3D),
+    UINT64_C(0x952AB45CFA97A0B3), UINT64_C(0xDE469FBD99A05FE3), UINT64_C(0xA59BC234DB398C25),
+    UINT64_C(0xF6C69A72A3989F5C), UINT64_C(0xB7DCBF5354E9BECE), UINT64_C(0x88FCF317F22241E2),
+    UINT64_C(0xCC20CE9BD35C78A5), UINT64_C(0x98165AF37B2153DF), UINT64_C(0xE2A0B5DC971F303A),
+    UINT64_C(0xA8D9D1535CE3B396), UINT64_C(0xFB9B7CD9A4A7443C), UINT64_C(0xBB764C4CA7A44410),
+    UINT64_C(0x8BAB8EEFB6409C1A), UINT64_C(0xD01FEF10A657842C), UINT64_C(0x9B10A4E5E9913129),
+    UINT64_C(0xE7109BFBA19C0C9D), UINT64_C(0xAC2820D9623BF429), UINT64_C(0x80444B5E7AA7CF85),
+    UINT64_C(0xBF21E44003ACDD2D), UINT64_C(0x8E679C2F5E44FF8F), UINT64_C(0xD433179D9C8CB841),
+    UINT64_C(0x9E19DB92B4E31BA9), UINT64_C(0xEB96BF6EBADF77D9), UINT64_C(0xAF87023B9BF0EE6B),
+};
+
+static const short yaml_emitter_cached_powers_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007,  -980,
+     -954,  -927,  -901,  -874,  -847,  -821,  -794,  -768,  -741,  -715,
+     -688,  -661,  -635,  -608,  -582,  -555,  -529,  -502,  -475,  -449,
+     -422,  -396,  -369,  -343,  -316,  -289,  -263,  -236,  -210,  -183,
+     -157,  -130,  -103,   -77,   -50,   -24,     3,    30,    56,    83,
+      109,   136,   162,   189,   216,   242,   269,   295,   322,   348,
+      375,   402,   428,   455,   481,   508,   534,   561,   588,   614,
+      641,   667,   694,   720,   747,   774,   800,   827,   853,   880,
+      907,   933,   960,   986,  1013,  1039,  1066,
+};
+
+static const uint32_t yaml_emitter_powers_of_10[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+#define DIY_FP_HIDDEN_BIT   ((uint64_t)1 << 52)
+
+static yaml_diy_fp_t
+yaml_diy_fp_multiply(yaml_diy_fp_t x, yaml_diy_fp_t y)
+{
+    const uint64_t mask = 0xFFFFFFFF;
+    uint64_t a = x.f >> 32, b = x.f & mask;
+    uint64_t c = y.f >> 32, d = y.f & mask;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t middle = (bd >> 32) + (ad & mask) + (bc & mask) + (1U << 31);
+    yaml_diy_fp_t result;
+
+    result.f = ac + (ad >> 32) + (bc >> 32) + (middle >> 32);
+    result.e = x.e + y.e + 64;
+
+    return result;
+}
+
+static yaml_diy_fp_t
+yaml_diy_fp_normalize(yaml_diy_fp_t x)
+{
+    while (!(x.f & ((uint64_t)1 << 63))) {
+        x.f <<= 1;
+        x.e --;
+    }
+
+    return x;
+}
+
+/*
+ * Decrease the last digit while the result stays within the rounding interval
+ * and gets closer to the scaled value.
+ */
+
+static void
+yaml_emitter_grisu_round(yaml_char_t *buffer, int length, uint64_t delta,
+        uint64_t rest, uint64_t ten_kappa, uint64_t wp_w)
+{
+    while (rest < wp_w && delta - rest >= ten_kappa
+            && (rest + ten_kappa < wp_w
+                || wp_w - rest > rest + ten_kappa - wp_w)) {
+        buffer[length-1] --;
+        rest += ten_kappa;
+    }
+}
+
+/*
+ * Generate the digits of the upper boundary Mp until they are within delta of
+ * it.  W is the scaled value.
+ *
+ * The boundaries are off by up to 2 units, so a shorter result could still be
+ * in the true rounding interval if fewer digits came within delta + 2 units
+ * of Mp, or within 2 units of the next digit.  The smallest such length is
+ * stored in `shorter`, or 0 if there is none.
+ */
+
+static int
+yaml_emitter_grisu_digits(yaml_diy_fp_t w, yaml_diy_fp_t mp, uint64_t delta,
+        yaml_char_t *buffer, int *k, int *shorter)
+{
+    yaml_diy_fp_t one;
+    uint64_t wp_w = mp.f - w.f;
+    uint64_t unit = 1;
+    uint32_t p1;
+    uint64_t p2;
+    int kappa = 10;
+    int length = 0;
+
+    one.e = mp.e;
+    one.f = (uint64_t)1 << -one.e;
+    p1 = (uint32_t)(mp.f >> -one.e);
+    p2 = mp.f & (one.f - 1);
+
+    *shorter = 0;
+
+    while (kappa > 1 && p1 < yaml_emitter_powers_of_10[kappa-1])
+        kappa --;
+
+    while (kappa > 0)
+    {
+        uint32_t digit = p1 / yaml_emitter_powers_of_10[kappa-1];
+        uint64_t ten_kappa;
+        uint64_t rest;
+
+        p1 %= yaml_emitter_powers_of_10[kappa-1];
+        if (digit || length)
+            buffer[length++] = (yaml_char_t)('0' + digit);
+        kappa --;
+
+        rest = ((uint64_t)p1 << -one.e) + p2;
+        ten_kappa = (uint64_t)yaml_emitter_powers_of_10[kappa] << -one.e;
+        if (rest <= delta) {
+            *k += kappa;
+            yaml_emitter_grisu_round(buffer, length, delta, rest,
+                    ten_kappa, wp_w);
+            return length;
+        }
+
+        if (!*shorter && length
+                && (rest - delta <= 2 || ten_kappa - rest <= 2))
+            *shorter = length;
+    }
+
+    while (1)
+    {
+        uint32_t digit;
+
+        p2 *= 10;
+        delta *= 10;
+        unit *= 10;
+        digit = (uint32_t)(p2 >> -one.e);
+        if (digit || length)
+            buffer[length++] = (yaml_char_t)('0' + digit);
+        p2 &= one.f - 1;
+        kappa --;
+
+        if (p2 < delta) {
+            *k += kappa;
+            yaml_emitter_grisu_round(buffer, length, delta, p2, one.f,
+                    wp_w * (-kappa < 10 ? yaml_emitter_powers_of_10[-kappa] : 0));
+            return length;
+        }
+
+        if (!*shorter && length
+                && (p2 - delta <= 2*unit || one.f - p2 <= 2*unit))
+            *shorter = length;
+    }
+}
+
+/*
+ * Find the shortest digits of a value between `length` and `count` digits
+ * that read back as the value.  The digits in the buffer are cut, or cut and
+ * rounded up, to each length in turn.
+ */
+
+static int
+yaml_emitter_grisu_shorten(double value, yaml_char_t *buffer, int count,
+        int *k, int length)
+{
+    yaml_char_t candidate[20];
+    int size, exponent, up, pass, j;
+
+    for (; length < count; length ++)
+    {
+        up = (buffer[length] >= '5');
+
+        for (pass = 0; pass < 2; pass ++, up = !up)
+        {
+            memcpy(candidate, buffer, length);
+            size = length;
+            exponent = *k + count - length;
+
+            if (up) {
+                for (j = size-1; j >= 0 && candidate[j] == '9'; j --)
+                    candidate[j] = '0';
+                if (j >= 0) {
+                    candidate[j] ++;
+                }
+                else {
+                    candidate[0] = '1';
+                    size = 1;
+                    exponent += length;
+                }
+            }
+
+            while (size > 1 && candidate[size-1] == '0') {
+                size --;
+                exponent ++;
+            }
+
+            if (yaml_resolve_digits(candidate, size, exponent) == value) {
+                memcpy(buffer, candidate, size);
+                *k = exponent;
+                return size;
+            }
+        }
+    }
+
+    return count;
+}
+
+/*
+ * Produce the shortest digits of a positive finite value.  The value is equal
+ * to the digits multiplied by 10^k.
+ */
+
+static int
+yaml_emitter_grisu2(double value, yaml_char_t *buffer, int *k)
+{
+    union { double d; uint64_t u; } bits;
+    yaml_diy_fp_t v, w, mp, mm, c;
+    int count, shorter;
+    int biased_e;
+    double dk;
+    int index;
+
+    bits.d = value;
+    biased_e = (int)((bits.u >> 52) & 0x7FF);
+    v.f = bits.u & (DIY_FP_HIDDEN_BIT - 1);
+    if (biased_e) {
+        v.f += DIY_FP_HIDDEN_BIT;
+        v.e = biased_e - 1075;
+    }
+    else {
+        v.e = -1074;
+    }
+
+    /* Compute the boundaries m+ and m- of the rounding interval. */
+
+    mp.f = (v.f << 1) + 1;
+    mp.e = v.e - 1;
+    while (!(mp.f & (DIY_FP_HIDDEN_BIT << 1))) {
+        mp.f <<= 1;
+        mp.e --;
+    }
+    mp.f <<= 10;
+    mp.e -= 10;
+
+    if (v.f == DIY_FP_HIDDEN_BIT) {
+        mm.f = (v.f << 2) - 1;
+        mm.e = v.e - 2;
+    }
+    else {
+        mm.f = (v.f << 1) - 1;
+        mm.e = v.e - 1;
+    }
+    mm.f <<= mm.e - mp.e;
+    mm.e = mp.e;
+
+    /* Find a cached power of ten that brings the exponent in range. */
+
+    dk = (-61 - mp.e) * 0.30102999566398114 + 347;
+    index = (int)dk;
+    if (dk - index > 0.0)
+        index ++;
+    index = (index >> 3) + 1;
+    *k = -(-348 + index * 8);
+    c.f = yaml_emitter_cached_powers_f[index];
+    c.e = yaml_emitter_cached_powers_e[index];
+
+    w = yaml_diy_fp_multiply(yaml_diy_fp_normalize(v), c);
+    mp = yaml_diy_fp_multiply(mp, c);
+    mm = yaml_diy_fp_multiply(mm, c);
+    mm.f ++;
+    mp.f --;
+
+    count = yaml_emitter_grisu_digits(w, mp, mp.f - mm.f, buffer, k, &shorter);
+
+    if (shorter)
+        count = yaml_emitter_grisu_shorten(value, buffer, count, k, shorter);
+
+    return count;
+}
+
+/*
+ * Format a floating point value.  The buffer should hold at least 32
+ * characters.
+ *
+ * The result always contains a '.' so that it is resolved as a float.
+ */
+
+static size_t
+yaml_emitter_format_double(double value, yaml_char_t *buffer)
+{
+    yaml_char_t digits[20];
+    size_t length = 0;
+    int count, k, point;
+
+    if (value != value) {
+        memcpy(buffer, ".nan", 4);
+        return 4;
+    }
+
+    if (value < 0 || (value == 0 && 1 / value < 0)) {
+        buffer[length++] = '-';
+        value = -value;
+    }
+
+    if (value > DBL_MAX) {
+        memcpy(buffer + length, ".inf", 4);
+        return length + 4;
+    }
+
+    if (value == 0) {
+        memcpy(buffer + length, "0.0", 3);
+        return length + 3;
+    }
+
+    count = yaml_emitter_grisu2(value, digits, &k);
+    point = count + k;
+
+    if (k >= 0 && point <= 17)
+    {
+        /* 1234e2 -> 123400.0 */
+
+        memcpy(buffer + length, digits, count);
+        length += count;
+        memset(buffer + length, '0', k);
+        length += k;
+        buffer[length++] = '.';
+        buffer[length++] = '0';
+    }
+    else if (point > 0 && point <= 17)
+    {
+        /* 1234e-2 -> 12.34 */
+
+        memcpy(buffer + length, digits, point);
+        length += point;
+        buffer[length++] = '.';
+        memcpy(buffer + length, digits + point, count - point);
+        length += count - point;
+    }
+    else if (point > -6 && point <= 0)
+    {
+        /* 1234e-6 -> 0.001234 */
+
+        buffer[length++] = '0';
+        buffer[length++] = '.';
+        memset(buffer + length, '0', -point);
+        length += -point;
+        memcpy(buffer + length, digits, count);
+        length += count;
+    }
+    else
+    {
+        /* 1234e30 -> 1.234e+33 */
+
+        int exponent = point - 1;
+
+        buffer[length++] = digits[0];
+        buffer[length++] = '.';
+        if (count > 1) {
+            memcpy(buffer + length, digits + 1, count - 1);
+            length += count - 1;
+        }
+        else {
+            buffer[length++] = '0';
+        }
+        buffer[length++] = 'e';
+        buffer[length++] = (exponent < 0) ? '-' : '+';
+        length += yaml_emitter_format_int64(exponent < 0 ? -exponent : exponent,
+                buffer + length);
+    }
+
+    return length;
+}
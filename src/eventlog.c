@@ -0,0 +1,989 @@
+
+#include "yaml_private.h"
+
+/*
+ * Binary event logs.
+ *
+ * A log starts with the magic "YEVL", the format version, and the flags.
+ * Each record starts with the event type, followed by the marks if the log
+ * has them, and the fields of the event:
+ *
+ *      STREAM-START        encoding
+ *      DOCUMENT-START      flags [major minor] count (handle prefix)*
+ *      DOCUMENT-END        implicit
+ *      ALIAS               anchor
+ *      SCALAR              anchor tag flags length octets
+ *      SEQUENCE-START      anchor tag flags
+ *      MAPPING-START       anchor tag flags
+ *      SCALAR-START        anchor tag flags
+ *      SCALAR-CHUNK        length octets
+ *
+ * Numbers are stored in 7-bit groups, the lowest group first.  A string
+ * reference is 0 for a missing string, an odd number (id*2+1) for a string
+ * stored before, or an even number ((length+1)*2) followed by the octets of
+ * a new string, which gets the next id.
+ */
+
+#define EVENT_LOG_MAGIC             "YEVL"
+#define EVENT_LOG_VERSION           1
+#define EVENT_LOG_HEADER_SIZE       6
+
+#define EVENT_LOG_IMPLICIT          0x08
+#define EVENT_LOG_QUOTED_IMPLICIT   0x10
+#define EVENT_LOG_STYLE             0x07
+
+#define EVENT_LOG_DOCUMENT_IMPLICIT 0x01
+#define EVENT_LOG_DOCUMENT_VERSION  0x02
+
+#define EVENT_LOG_HASH_SEED         (size_t)2166136261U
+#define EVENT_LOG_HASH_PRIME        (size_t)16777619U
+
+/*
+ * Writer.
+ */
+
+static int
+yaml_event_log_string_write_handler(void *data, unsigned char *buffer,
+        size_t size);
+
+static int
+yaml_event_log_put_octets(yaml_event_log_writer_t *writer,
+        const yaml_char_t *octets, size_t length);
+
+static int
+yaml_event_log_put_number(yaml_event_log_writer_t *writer, size_t number);
+
+static int
+yaml_event_log_put_marks(yaml_event_log_writer_t *writer,
+        const yaml_event_t *event);
+
+static size_t
+yaml_event_log_hash(const yaml_char_t *string, size_t length);
+
+static int
+yaml_event_log_grow_strings(yaml_event_log_writer_t *writer);
+
+static int
+yaml_event_log_put_string(yaml_event_log_writer_t *writer,
+        const yaml_char_t *string);
+
+/*
+ * Reader.
+ */
+
+static int
+yaml_event_log_set_reader_error(yaml_event_log_reader_t *reader,
+        const char *problem);
+
+static int
+yaml_event_log_get_number(yaml_event_log_reader_t *reader, size_t *number);
+
+static int
+yaml_event_log_get_flags(yaml_event_log_reader_t *reader, int *flags,
+        int mask, int max_style);
+
+static int
+yaml_event_log_get_marks(yaml_event_log_reader_t *reader,
+        yaml_event_t *event);
+
+static int
+yaml_event_log_get_string(yaml_event_log_reader_t *reader,
+        yaml_char_t **string);
+
+static int
+yaml_event_log_get_value(yaml_event_log_reader_t *reader,
+        yaml_event_t *event);
+
+static int
+yaml_event_log_get_event(yaml_event_log_reader_t *reader,
+        yaml_event_t *event);
+
+/*
+ * Create a new writer object.
+ */
+
+YAML_DECLARE(int)
+yaml_event_log_writer_initialize(yaml_event_log_writer_t *writer, int flags)
+{
+    assert(writer);     /* Non-NULL writer object expected. */
+
+    memset(writer, 0, sizeof(yaml_event_log_writer_t));
+    writer->flags = flags & YAML_EVENT_LOG_MARKS;
+
+    if (!STRING_INIT(writer, writer->buffer, OUTPUT_BUFFER_SIZE))
+        goto error;
+
+    writer->strings.capacity = 16;
+    writer->strings.entries = (yaml_event_log_string_t *)yaml_malloc(
+            writer->strings.capacity*sizeof(*writer->strings.entries));
+    if (!writer->strings.entries) {
+        writer->error = YAML_MEMORY_ERROR;
+        goto error;
+    }
+    memset(writer->strings.entries, 0,
+            writer->strings.capacity*sizeof(*writer->strings.entries));
+
+    return 1;
+
+error:
+
+    STRING_DEL(writer, writer->buffer);
+
+    return 0;
+}
+
+/*
+ * Destroy a writer object.
+ */
+
+YAML_DECLARE(void)
+yaml_event_log_writer_delete(yaml_event_log_writer_t *writer)
+{
+    size_t k;
+
+    assert(writer);     /* Non-NULL writer object expected. */
+
+    STRING_DEL(writer, writer->buffer);
+    for (k = 0; k < writer->strings.capacity; k ++) {
+        yaml_free((void *)writer->strings.entries[k].string);
+    }
+    yaml_free(writer->strings.entries);
+
+    memset(writer, 0, sizeof(yaml_event_log_writer_t));
+}
+
+/*
+ * String write handler.
+ */
+
+static int
+yaml_event_log_string_write_handler(void *data, unsigned char *buffer,
+        size_t size)
+{
+    yaml_event_log_writer_t *writer = (yaml_event_log_writer_t *)data;
+
+    if (writer->output.size - *writer->output.size_written < size) {
+        memcpy(writer->output.buffer + *writer->output.size_written, buffer,
+                writer->output.size - *writer->output.size_written);
+        *writer->output.size_written = writer->output.size;
+        return 0;
+    }
+
+    memcpy(writer->output.buffer + *writer->output.size_written, buffer, size);
+    *writer->output.size_written += size;
+    return 1;
+}
+
+/*
+ * Set a string output.
+ */
+
+YAML_DECLARE(void)
+yaml_event_log_writer_set_output_string(yaml_event_log_writer_t *writer,
+        unsigned char *output, size_t size, size_t *size_written)
+{
+    assert(writer);     /* Non-NULL writer object expected. */
+    assert(!writer->write_handler); /* You can set the output only once. */
+    assert(output);     /* Non-NULL output string expected. */
+
+    writer->write_handler = yaml_event_log_string_write_handler;
+    writer->write_handler_data = writer;
+
+    writer->output.buffer = output;
+    writer->output.size = size;
+    writer->output.size_written = size_written;
+    *size_written = 0;
+}
+
+/*
+ * Set a generic output handler.
+ */
+
+YAML_DECLARE(void)
+yaml_event_log_writer_set_output(yaml_event_log_writer_t *writer,
+        yaml_write_handler_t *handler, void *data)
+{
+    assert(writer);     /* Non-NULL writer object expected. */
+    assert(!writer->write_handler); /* You can set the output only once. */
+    assert(handler);    /* Non-NULL handler object expected. */
+
+    writer->write_handler = handler;
+    writer->write_handler_data = data;
+}
+
+/*
+ * Append octets to the buffer.
+ */
+
+static int
+yaml_event_log_put_octets(yaml_event_log_writer_t *writer,
+        const yaml_char_t *octets, size_t length)
+{
+    while ((size_t)(writer->buffer.end - writer->buffer.pointer) < length) {
+        if (!yaml_string_extend(&writer->buffer.start,
+                    &writer->buffer.pointer, &writer->buffer.end)) {
+            writer->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+    }
+
+    if (length) {
+        memcpy(writer->buffer.pointer, octets, length);
+        writer->buffer.pointer += length;
+    }
+
+    return 1;
+}
+
+/*
+ * Append a number to the buffer.
+ */
+
+static int
+yaml_event_log_put_number(yaml_event_log_writer_t *writer, size_t number)
+{
+    yaml_char_t octets[(sizeof(size_t)*8+6)/7];
+    size_t length = 0;
+
+    do {
+        octets[length] = number & 0x7F;
+        number >>= 7;
+        if (number) octets[length] |= 0x80;
+        length ++;
+    } while (number);
+
+    return yaml_event_log_put_octets(writer, octets, length);
+}
+
+/*
+ * Append the marks of an event if the log has them.
+ */
+
+static int
+yaml_event_log_put_marks(yaml_event_log_writer_t *writer,
+        const yaml_event_t *event)
+{
+    if (!(writer->flags & YAML_EVENT_LOG_MARKS))
+        return 1;
+
+    return yaml_event_log_put_number(writer, event->start_mark.index)
+        && yaml_event_log_put_number(writer, event->start_mark.line)
+        && yaml_event_log_put_number(writer, event->start_mark.column)
+        && yaml_event_log_put_number(writer, event->end_mark.index)
+        && yaml_event_log_put_number(writer, event->end_mark.line)
+        && yaml_event_log_put_number(writer, event->end_mark.column);
+}
+
+/*
+ * Hash a string (FNV-1a).
+ */
+
+static size_t
+yaml_event_log_hash(const yaml_char_t *string, size_t length)
+{
+    size_t hash = EVENT_LOG_HASH_SEED;
+    size_t k;
+
+    for (k = 0; k < length; k ++) {
+        hash = (hash ^ string[k]) * EVENT_LOG_HASH_PRIME;
+    }
+
+    return hash;
+}
+
+/*
+ * Double the size of the string table.
+ */
+
+static int
+yaml_event_log_grow_strings(yaml_event_log_writer_t *writer)
+{
+    size_t capacity = writer->strings.capacity*2;
+    yaml_event_log_string_t *entries;
+    size_t k;
+
+    entries = (yaml_event_log_string_t *)yaml_malloc(
+            capacity*sizeof(*entries));
+    if (!entries) {
+        writer->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+    memset(entries, 0, capacity*sizeof(*entries));
+
+    for (k = 0; k < writer->strings.capacity; k ++) {
+        yaml_event_log_string_t *entry = writer->strings.entries + k;
+        size_t slot;
+        if (!entry->string) continue;
+        slot = entry->hash & (capacity-1);
+        while (entries[slot].string) {
+            slot = (slot+1) & (capacity-1);
+        }
+        entries[slot] = *entry;
+    }
+
+    yaml_free(writer->strings.entries);
+    writer->strings.entries = entries;
+    writer->strings.capacity = capacity;
+
+    return 1;
+}
+
+/*
+ * Append a reference to a string, storing the string on its first use.
+ */
+
+static int
+yaml_event_log_put_string(yaml_event_log_writer_t *writer,
+        const yaml_char_t *string)
+{
+    yaml_event_log_string_t *entry;
+    yaml_char_t *copy;
+    size_t length;
+    size_t hash;
+    size_t slot;
+
+    if (!string)
+        return yaml_event_log_put_number(writer, 0);
+
+    length = strlen((char *)string);
+    hash = yaml_event_log_hash(string, length);
+    slot = hash & (writer->strings.capacity-1);
+
+    while ((entry = writer->strings.entries + slot)->string) {
+        if (entry->hash == hash && entry->length == length
+                && memcmp(entry->string, string, length) == 0)
+            return yaml_event_log_put_number(writer, entry->id*2+1);
+        slot = (slot+1) & (writer->strings.capacity-1);
+    }
+
+    copy = YAML_MALLOC(length+1);
+    if (!copy) {
+        writer->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+    memcpy(copy, string, length+1);
+
+    entry->string = copy;
+    entry->length = length;
+    entry->hash = hash;
+    entry->id = ++ writer->strings.count;
+
+    if (writer->strings.count*2 > writer->strings.capacity
+            && !yaml_event_log_grow_strings(writer))
+        return 0;
+
+    return yaml_event_log_put_number(writer, (length+1)*2)
+        && yaml_event_log_put_octets(writer, string, length);
+}
+
+/*
+ * Record an event.
+ */
+
+YAML_DECLARE(int)
+yaml_event_log_write(yaml_event_log_writer_t *writer,
+        const yaml_event_t *event)
+{
+    yaml_char_t type = (yaml_char_t)event->type;
+    yaml_char_t flags = 0;
+    yaml_tag_directive_t *tag_directive;
+
+    assert(writer);     /* Non-NULL writer object expected. */
+    assert(event);      /* Non-NULL event object expected. */
+
+    if (!writer->started) {
+        yaml_char_t header[EVENT_LOG_HEADER_SIZE];
+        memcpy(header, EVENT_LOG_MAGIC, 4);
+        header[4] = EVENT_LOG_VERSION;
+        header[5] = (yaml_char_t)writer->flags;
+        if (!yaml_event_log_put_octets(writer, header, sizeof(header)))
+            return 0;
+        writer->started = 1;
+    }
+
+    if (!yaml_event_log_put_octets(writer, &type, 1)
+            || !yaml_event_log_put_marks(writer, event))
+        return 0;
+
+    switch (event->type)
+    {
+        case YAML_STREAM_START_EVENT:
+            if (!yaml_event_log_put_number(writer,
+                        event->data.stream_start.encoding))
+                return 0;
+            break;
+
+        case YAML_DOCUMENT_START_EVENT:
+            if (event->data.document_start.implicit)
+                flags |= EVENT_LOG_DOCUMENT_IMPLICIT;
+            if (event->data.document_start.version_directive)
+                flags |= EVENT_LOG_DOCUMENT_VERSION;
+            if (!yaml_event_log_put_octets(writer, &flags, 1))
+                return 0;
+            if (event->data.document_start.version_directive) {
+                if (!yaml_event_log_put_number(writer, event->data
+                            .document_start.version_directive->major)
+                        || !yaml_event_log_put_number(writer, event->data
+                            .document_start.version_directive->minor))
+                    return 0;
+            }
+            if (!yaml_event_log_put_number(writer,
+                        event->data.document_start.tag_directives.end
+                        - event->data.document_start.tag_directives.start))
+                return 0;
+            for (tag_directive = event->data.document_start.tag_directives.start;
+                    tag_directive != event->data.document_start.tag_directives.end;
+                    tag_directive ++) {
+                if (!yaml_event_log_put_string(writer, tag_directive->handle)
+                        || !yaml_event_log_put_string(writer,
+                            tag_directive->prefix))
+                    return 0;
+            }
+            break;
+
+        case YAML_DOCUMENT_END_EVENT:
+            if (!yaml_event_log_put_number(writer,
+                        event->data.document_end.implicit != 0))
+                return 0;
+            break;
+
+        case YAML_ALIAS_EVENT:
+            if (!yaml_event_log_put_string(writer, event->data.alias.anchor))
+                return 0;
+            break;
+
+        case YAML_SCALAR_EVENT:
+            flags = (yaml_char_t)event->data.scalar.style
+                | (event->data.scalar.plain_implicit ? EVENT_LOG_IMPLICIT : 0)
+                | (event->data.scalar.quoted_implicit
+                        ? EVENT_LOG_QUOTED_IMPLICIT : 0);
+            if (!yaml_event_log_put_string(writer, event->data.scalar.anchor)
+                    || !yaml_event_log_put_string(writer,
+                        event->data.scalar.tag)
+                    || !yaml_event_log_put_octets(writer, &flags, 1)
+                    || !yaml_event_log_put_number(writer,
+                        event->data.scalar.length)
+                    || !yaml_event_log_put_octets(writer,
+                        event->data.scalar.value, event->data.scalar.length))
+                return 0;
+            break;
+
+        case YAML_SCALAR_START_EVENT:
+            flags = (yaml_char_t)event->data.scalar.style
+                | (event->data.scalar.plain_implicit ? EVENT_LOG_IMPLICIT : 0)
+                | (event->data.scalar.quoted_implicit
+                        ? EVENT_LOG_QUOTED_IMPLICIT : 0);
+            if (!yaml_event_log_put_string(writer, event->data.scalar.anchor)
+                    || !yaml_event_log_put_string(writer,
+                        event->data.scalar.tag)
+                    || !yaml_event_log_put_octets(writer, &flags, 1))
+                return 0;
+            break;
+
+        case YAML_SCALAR_CHUNK_EVENT:
+            if (!yaml_event_log_put_number(writer, event->data.scalar.length)
+                    || !yaml_event_log_put_octets(writer,
+                        event->data.scalar.value, event->data.scalar.length))
+                return 0;
+            break;
+
+        case YAML_SEQUENCE_START_EVENT:
+            flags = (yaml_char_t)event->data.sequence_start.style
+                | (event->data.sequence_start.implicit ? EVENT_LOG_IMPLICIT : 0);
+            if (!yaml_event_log_put_string(writer,
+                        event->data.sequence_start.anchor)
+                    || !yaml_event_log_put_string(writer,
+                        event->data.sequence_start.tag)
+                    || !yaml_event_log_put_octets(writer, &flags, 1))
+                return 0;
+            break;
+
+        case YAML_MAPPING_START_EVENT:
+            flags = (yaml_char_t)event->data.mapping_start.style
+                | (event->data.mapping_start.implicit ? EVENT_LOG_IMPLICIT : 0);
+            if (!yaml_event_log_put_string(writer,
+                        event->data.mapping_start.anchor)
+                    || !yaml_event_log_put_string(writer,
+                        event->data.mapping_start.tag)
+                    || !yaml_event_log_put_octets(writer, &flags, 1))
+                return 0;
+            break;
+
+        default:
+            break;
+    }
+
+    if (event->type == YAML_STREAM_END_EVENT
+            || writer->buffer.pointer - writer->buffer.start
+                >= OUTPUT_BUFFER_SIZE)
+        return yaml_event_log_writer_flush(writer);
+
+    return 1;
+}
+
+/*
+ * Flush the buffer to the output.
+ */
+
+YAML_DECLARE(int)
+yaml_event_log_writer_flush(yaml_event_log_writer_t *writer)
+{
+    assert(writer);     /* Non-NULL writer object expected. */
+    assert(writer->write_handler);  /* Write handler must be set. */
+
+    if (writer->buffer.pointer == writer->buffer.start)
+        return 1;
+
+    if (!writer->write_handler(writer->write_handler_data,
+                writer->buffer.start,
+                writer->buffer.pointer - writer->buffer.start)) {
+        writer->error = YAML_WRITER_ERROR;
+        writer->problem = "write error";
+        return 0;
+    }
+
+    writer->buffer.pointer = writer->buffer.start;
+
+    return 1;
+}
+
+/*
+ * Set the reader error and return 0.
+ */
+
+static int
+yaml_event_log_set_reader_error(yaml_event_log_reader_t *reader,
+        const char *problem)
+{
+    reader->error = YAML_READER_ERROR;
+    reader->problem = problem;
+    reader->problem_offset = reader->pointer - reader->start;
+
+    return 0;
+}
+
+/*
+ * Create a new reader object.
+ */
+
+YAML_DECLARE(int)
+yaml_event_log_reader_initialize(yaml_event_log_reader_t *reader,
+        const unsigned char *input, size_t size)
+{
+    assert(reader);     /* Non-NULL reader object expected. */
+    assert(input || !size); /* Non-NULL input expected. */
+
+    memset(reader, 0, sizeof(yaml_event_log_reader_t));
+    reader->start = input;
+    reader->end = input + size;
+    reader->pointer = input;
+
+    if (size < EVENT_LOG_HEADER_SIZE
+            || memcmp(input, EVENT_LOG_MAGIC, 4) != 0
+            || input[4] != EVENT_LOG_VERSION
+            || (input[5] & ~YAML_EVENT_LOG_MARKS))
+        return yaml_event_log_set_reader_error(reader,
+                "invalid event log header");
+
+    reader->flags = input[5];
+    reader->pointer += EVENT_LOG_HEADER_SIZE;
+
+    if (!STACK_INIT(reader, reader->strings, yaml_event_log_string_t*))
+        return 0;
+
+    return 1;
+}
+
+/*
+ * Destroy a reader object.
+ */
+
+YAML_DECLARE(void)
+yaml_event_log_reader_delete(yaml_event_log_reader_t *reader)
+{
+    assert(reader);     /* Non-NULL reader object expected. */
+
+    STACK_DEL(reader, reader->strings);
+
+    memset(reader, 0, sizeof(yaml_event_log_reader_t));
+}
+
+/*
+ * Read a number.
+ */
+
+static int
+yaml_event_log_get_number(yaml_event_log_reader_t *reader, size_t *number)
+{
+    size_t shift = 0;
+
+    *number = 0;
+
+    do {
+        if (reader->pointer == reader->end)
+            return yaml_event_log_set_reader_error(reader,
+                    "unexpected end of the event log");
+        if (shift >= sizeof(size_t)*8
+                || (shift && (size_t)(*reader->pointer & 0x7F)
+                    >> (sizeof(size_t)*8 - shift)))
+            return yaml_event_log_set_reader_error(reader,
+                    "found a number out of range");
+        *number |= (size_t)(*reader->pointer & 0x7F) << shift;
+        shift += 7;
+    } while (*(reader->pointer++) & 0x80);
+
+    return 1;
+}
+
+/*
+ * Read the flags of an event and check that they are in range.
+ */
+
+static int
+yaml_event_log_get_flags(yaml_event_log_reader_t *reader, int *flags,
+        int mask, int max_style)
+{
+    size_t number;
+
+    if (!yaml_event_log_get_number(reader, &number))
+        return 0;
+
+    if ((number & ~(size_t)mask)
+            || (int)(number & EVENT_LOG_STYLE) > max_style)
+        return yaml_event_log_set_reader_error(reader,
+                "found invalid event flags");
+
+    *flags = (int)number;
+
+    return 1;
+}
+
+/*
+ * Read the marks of an event if the log has them.
+ */
+
+static int
+yaml_event_log_get_marks(yaml_event_log_reader_t *reader,
+        yaml_event_t *event)
+{
+    if (!(reader->flags & YAML_EVENT_LOG_MARKS))
+        return 1;
+
+    return yaml_event_log_get_number(reader, &event->start_mark.index)
+        && yaml_event_log_get_number(reader, &event->start_mark.line)
+        && yaml_event_log_get_number(reader, &event->start_mark.column)
+        && yaml_event_log_get_number(reader, &event->end_mark.index)
+        && yaml_event_log_get_number(reader, &event->end_mark.line)
+        && yaml_event_log_get_number(reader, &event->end_mark.column);
+}
+
+/*
+ * Read a copy of a referenced string.
+ */
+
+static int
+yaml_event_log_get_string(yaml_event_log_reader_t *reader,
+        yaml_char_t **string)
+{
+    yaml_event_log_string_t entry;
+    size_t number;
+
+    *string = NULL;
+
+    if (!yaml_event_log_get_number(reader, &number))
+        return 0;
+
+    if (!number)
+        return 1;
+
+    if (number & 1) {
+        number >>= 1;
+        if (!number || number > (size_t)(reader->strings.top
+                    - reader->strings.start))
+            return yaml_event_log_set_reader_error(reader,
+                    "found an undefined string reference");
+        entry = reader->strings.start[number-1];
+    }
+    else {
+        entry.string = reader->pointer;
+        entry.length = (number >> 1) - 1;
+        entry.hash = 0;
+        entry.id = reader->strings.top - reader->strings.start + 1;
+        if (entry.length > (size_t)(reader->end - reader->pointer))
+            return yaml_event_log_set_reader_error(reader,
+                    "unexpected end of the event log");
+        if (memchr(entry.string, '\0', entry.length))
+            return yaml_event_log_set_reader_error(reader,
+                    "found a NUL character in a string");
+        if (!yaml_check_utf8(entry.string, entry.length))
+            return yaml_event_log_set_reader_error(reader,
+                    "found an invalid UTF-8 string");
+        if (!PUSH(reader, reader->strings, entry))
+            return 0;
+        reader->pointer += entry.length;
+    }
+
+    *string = YAML_MALLOC(entry.length+1);
+    if (!*string) {
+        reader->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+    memcpy(*string, entry.string, entry.length);
+    (*string)[entry.length] = '\0';
+
+    return 1;
+}
+
+/*
+ * Read a copy of the value of a scalar or a scalar chunk.
+ */
+
+static int
+yaml_event_log_get_value(yaml_event_log_reader_t *reader,
+        yaml_event_t *event)
+{
+    size_t length;
+
+    if (!yaml_event_log_get_number(reader, &length))
+        return 0;
+
+    if (length > (size_t)(reader->end - reader->pointer))
+        return yaml_event_log_set_reader_error(reader,
+                "unexpected end of the event log");
+
+    if (!yaml_check_utf8(reader->pointer, length))
+        return yaml_event_log_set_reader_error(reader,
+                "found an invalid UTF-8 value");
+
+    event->data.scalar.value = YAML_MALLOC(length+1);
+    if (!event->data.scalar.value) {
+        reader->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+    memcpy(event->data.scalar.value, reader->pointer, length);
+    event->data.scalar.value[length] = '\0';
+    event->data.scalar.length = length;
+    reader->pointer += length;
+
+    return 1;
+}
+
+/*
+ * Read the fields of an event.
+ */
+
+static int
+yaml_event_log_get_event(yaml_event_log_reader_t *reader,
+        yaml_event_t *event)
+{
+    size_t number;
+    size_t count;
+    int flags;
+
+    event->type = (yaml_event_type_t)*(reader->pointer++);
+
+    if (!yaml_event_log_get_marks(reader, event))
+        return 0;
+
+    switch (event->type)
+    {
+        case YAML_STREAM_START_EVENT:
+            if (!yaml_event_log_get_number(reader, &number))
+                return 0;
+            if (number > YAML_UTF16BE_ENCODING)
+                return yaml_event_log_set_reader_error(reader,
+                        "found an unknown encoding");
+            event->data.stream_start.encoding = (yaml_encoding_t)number;
+            return 1;
+
+        case YAML_STREAM_END_EVENT:
+            reader->stream_end_produced = 1;
+            return 1;
+
+        case YAML_DOCUMENT_START_EVENT:
+            if (!yaml_event_log_get_number(reader, &number))
+                return 0;
+            if (number & ~(size_t)(EVENT_LOG_DOCUMENT_IMPLICIT
+                        | EVENT_LOG_DOCUMENT_VERSION))
+                return yaml_event_log_set_reader_error(reader,
+                        "found invalid event flags");
+            flags = (int)number;
+            event->data.document_start.implicit
+                = (flags & EVENT_LOG_DOCUMENT_IMPLICIT) != 0;
+            if (flags & EVENT_LOG_DOCUMENT_VERSION) {
+                yaml_version_directive_t *version_directive
+                    = YAML_MALLOC_STATIC(yaml_version_directive_t);
+                if (!version_directive) {
+                    reader->error = YAML_MEMORY_ERROR;
+                    return 0;
+                }
+                event->data.document_start.version_directive
+                    = version_directive;
+                if (!yaml_event_log_get_number(reader, &number))
+                    return 0;
+                if (number > INT_MAX)
+                    return yaml_event_log_set_reader_error(reader,
+                            "found a number out of range");
+                version_directive->major = (int)number;
+                if (!yaml_event_log_get_number(reader, &number))
+                    return 0;
+                if (number > INT_MAX)
+                    return yaml_event_log_set_reader_error(reader,
+                            "found a number out of range");
+                version_directive->minor = (int)number;
+            }
+            if (!yaml_event_log_get_number(reader, &count))
+                return 0;
+            if (!count)
+                return 1;
+            if (count > (size_t)(reader->end - reader->pointer)/2)
+                return yaml_event_log_set_reader_error(reader,
+                        "unexpected end of the event log");
+            event->data.document_start.tag_directives.start
+                = event->data.document_start.tag_directives.end
+                = (yaml_tag_directive_t *)yaml_malloc(
+                        count*sizeof(yaml_tag_directive_t));
+            if (!event->data.document_start.tag_directives.start) {
+                reader->error = YAML_MEMORY_ERROR;
+                return 0;
+            }
+            while (count --) {
+                yaml_tag_directive_t *tag_directive
+                    = event->data.document_start.tag_directives.end;
+                if (!yaml_event_log_get_string(reader, &tag_directive->handle))
+                    return 0;
+                if (!yaml_event_log_get_string(reader,
+                            &tag_directive->prefix)) {
+                    yaml_free(tag_directive->handle);
+                    return 0;
+                }
+                event->data.document_start.tag_directives.end ++;
+                if (!tag_directive->handle || !tag_directive->prefix)
+                    return yaml_event_log_set_reader_error(reader,
+                            "found an incomplete tag directive");
+            }
+            return 1;
+
+        case YAML_DOCUMENT_END_EVENT:
+            if (!yaml_event_log_get_number(reader, &number))
+                return 0;
+            if (number > 1)
+                return yaml_event_log_set_reader_error(reader,
+                        "found invalid event flags");
+            event->data.document_end.implicit = (number != 0);
+            return 1;
+
+        case YAML_ALIAS_EVENT:
+            if (!yaml_event_log_get_string(reader, &event->data.alias.anchor))
+                return 0;
+            if (!event->data.alias.anchor)
+                return yaml_event_log_set_reader_error(reader,
+                        "found an alias without an anchor");
+            return 1;
+
+        case YAML_SCALAR_EVENT:
+            if (!yaml_event_log_get_string(reader, &event->data.scalar.anchor)
+                    || !yaml_event_log_get_string(reader,
+                        &event->data.scalar.tag)
+                    || !yaml_event_log_get_flags(reader, &flags,
+                        EVENT_LOG_STYLE | EVENT_LOG_IMPLICIT
+                        | EVENT_LOG_QUOTED_IMPLICIT,
+                        YAML_FOLDED_SCALAR_STYLE))
+                return 0;
+            event->data.scalar.style
+                = (yaml_scalar_style_t)(flags & EVENT_LOG_STYLE);
+            event->data.scalar.plain_implicit
+                = (flags & EVENT_LOG_IMPLICIT) != 0;
+            event->data.scalar.quoted_implicit
+                = (flags & EVENT_LOG_QUOTED_IMPLICIT) != 0;
+            return yaml_event_log_get_value(reader, event);
+
+        case YAML_SEQUENCE_START_EVENT:
+            if (!yaml_event_log_get_string(reader,
+                        &event->data.sequence_start.anchor)
+                    || !yaml_event_log_get_string(reader,
+                        &event->data.sequence_start.tag)
+                    || !yaml_event_log_get_flags(reader, &flags,
+                        EVENT_LOG_STYLE | EVENT_LOG_IMPLICIT,
+                        YAML_FLOW_SEQUENCE_STYLE))
+                return 0;
+            event->data.sequence_start.style
+                = (yaml_sequence_style_t)(flags & EVENT_LOG_STYLE);
+            event->data.sequence_start.implicit
+                = (flags & EVENT_LOG_IMPLICIT) != 0;
+            return 1;
+
+        case YAML_MAPPING_START_EVENT:
+            if (!yaml_event_log_get_string(reader,
+                        &event->data.mapping_start.anchor)
+                    || !yaml_event_log_get_string(reader,
+                        &event->data.mapping_start.tag)
+                    || !yaml_event_log_get_flags(reader, &flags,
+                        EVENT_LOG_STYLE | EVENT_LOG_IMPLICIT,
+                        YAML_FLOW_MAPPING_STYLE))
+                return 0;
+            event->data.mapping_start.style
+                = (yaml_mapping_style_t)(flags & EVENT_LOG_STYLE);
+            event->data.mapping_start.implicit
+                = (flags & EVENT_LOG_IMPLICIT) != 0;
+            return 1;
+
+        case YAML_SCALAR_START_EVENT:
+            if (!yaml_event_log_get_string(reader, &event->data.scalar.anchor)
+                    || !yaml_event_log_get_string(reader,
+                        &event->data.scalar.tag)
+                    || !yaml_event_log_get_flags(reader, &flags,
+                        EVENT_LOG_STYLE | EVENT_LOG_IMPLICIT
+                        | EVENT_LOG_QUOTED_IMPLICIT,
+                        YAML_FOLDED_SCALAR_STYLE))
+                return 0;
+            event->data.scalar.style
+                = (yaml_scalar_style_t)(flags & EVENT_LOG_STYLE);
+            event->data.scalar.plain_implicit
+                = (flags & EVENT_LOG_IMPLICIT) != 0;
+            event->data.scalar.quoted_implicit
+                = (flags & EVENT_LOG_QUOTED_IMPLICIT) != 0;
+            return 1;
+
+        case YAML_SCALAR_CHUNK_EVENT:
+            return yaml_event_log_get_value(reader, event);
+
+        case YAML_SEQUENCE_END_EVENT:
+        case YAML_MAPPING_END_EVENT:
+        case YAML_SCALAR_END_EVENT:
+            return 1;
+
+        default:
+            event->type = YAML_NO_EVENT;
+            reader->pointer --;
+            return yaml_event_log_set_reader_error(reader,
+                    "found an unknown event type");
+    }
+}
+
+/*
+ * Replay the next recorded event.
+ */
+
+YAML_DECLARE(int)
+yaml_event_log_read(yaml_event_log_reader_t *reader, yaml_event_t *event)
+{
+    assert(reader);     /* Non-NULL reader object is expected. */
+    assert(event);      /* Non-NULL event object is expected. */
+
+    memset(event, 0, sizeof(yaml_event_t));
+
+    if (reader->error || reader->stream_end_produced)
+        return !reader->error;
+
+    if (reader->pointer == reader->end)
+        return yaml_event_log_set_reader_error(reader,
+                "unexpected end of the event log");
+
+    if (!yaml_event_log_get_event(reader, event)) {
+        yaml_event_delete(event);
+        return 0;
+    }
+
+    return 1;
+}
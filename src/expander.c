@@ -0,0 +1,621 @@
+
+#include "yaml_private.h"
+
+/*
+ * Alias expansion for the event parser.
+ *
+ * The events of every anchored node are recorded in an arena while the node
+ * is being parsed.  An alias met inside an anchored node is recorded as a
+ * reference to the anchored node it names, so the arena never grows beyond
+ * the size of the input.  When an alias is met, the recorded range of its
+ * node is replayed and the references are followed on a stack of ranges.
+ *
+ * A record starts with the event type.  Scalars are followed by a flags
+ * octet, the tag, and the value; collection starts by a flags octet and the
+ * tag; aliases by the number of the anchored node.  Strings are stored as
+ * their length plus one, or zero for a missing tag, followed by the octets.
+ * Lengths and numbers are stored in 7-bit groups, the lowest group first.
+ */
+
+#define EXPANSION_IMPLICIT          0x08
+#define EXPANSION_QUOTED_IMPLICIT   0x10
+#define EXPANSION_STYLE             0x07
+
+/*
+ * Error handling.
+ */
+
+static int
+yaml_parser_set_expansion_error(yaml_parser_t *parser,
+        const char *problem, yaml_mark_t problem_mark);
+
+/*
+ * Recording.
+ */
+
+static int
+yaml_parser_init_expansion(yaml_parser_t *parser);
+
+static int
+yaml_parser_write_octets(yaml_parser_t *parser,
+        const yaml_char_t *octets, size_t length);
+
+static int
+yaml_parser_write_number(yaml_parser_t *parser, size_t number);
+
+static int
+yaml_parser_write_string(yaml_parser_t *parser,
+        const yaml_char_t *string, size_t length);
+
+static int
+yaml_parser_record_event(yaml_parser_t *parser, yaml_event_t *event);
+
+static int
+yaml_parser_add_anchor(yaml_parser_t *parser, yaml_char_t *anchor,
+        size_t start, size_t end);
+
+static int
+yaml_parser_expand_alias(yaml_parser_t *parser, yaml_event_t *event);
+
+/*
+ * Replaying.
+ */
+
+static size_t
+yaml_parser_read_number(yaml_char_t **pointer);
+
+static int
+yaml_parser_read_string(yaml_parser_t *parser, yaml_char_t **pointer,
+        yaml_char_t **string, size_t *length);
+
+/*
+ * Set an expansion error.
+ */
+
+static int
+yaml_parser_set_expansion_error(yaml_parser_t *parser,
+        const char *problem, yaml_mark_t problem_mark)
+{
+    parser->error = YAML_COMPOSER_ERROR;
+    parser->context = "while expanding an alias";
+    parser->context_mark = parser->expansion_start_mark;
+    parser->problem = problem;
+    parser->problem_mark = problem_mark;
+
+    return 0;
+}
+
+/*
+ * Allocate the arena and the stacks on the first use.
+ */
+
+static int
+yaml_parser_init_expansion(yaml_parser_t *parser)
+{
+    if (!STRING_INIT(parser, parser->expansion_arena, INITIAL_STRING_SIZE))
+        goto error;
+    if (!STACK_INIT(parser, parser->expansion_anchors,
+                yaml_expansion_anchor_t*))
+        goto error;
+    if (!STACK_INIT(parser, parser->expansion_open, int*))
+        goto error;
+    if (!STACK_INIT(parser, parser->expansion_frames,
+                yaml_expansion_frame_t*))
+        goto error;
+
+    return 1;
+
+error:
+
+    STRING_DEL(parser, parser->expansion_arena);
+    STACK_DEL(parser, parser->expansion_anchors);
+    STACK_DEL(parser, parser->expansion_open);
+    STACK_DEL(parser, parser->expansion_frames);
+
+    return 0;
+}
+
+/*
+ * Append octets to the arena.
+ */
+
+static int
+yaml_parser_write_octets(yaml_parser_t *parser,
+        const yaml_char_t *octets, size_t length)
+{
+    while ((size_t)(parser->expansion_arena.end
+                - parser->expansion_arena.pointer) < length) {
+        if (!yaml_string_extend(&parser->expansion_arena.start,
+                    &parser->expansion_arena.pointer,
+                    &parser->expansion_arena.end)) {
+            parser->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+    }
+
+    if (length) {
+        memcpy(parser->expansion_arena.pointer, octets, length);
+        parser->expansion_arena.pointer += length;
+    }
+
+    return 1;
+}
+
+/*
+ * Append a number to the arena.
+ */
+
+static int
+yaml_parser_write_number(yaml_parser_t *parser, size_t number)
+{
+    yaml_char_t octets[(sizeof(size_t)*8+6)/7];
+    size_t length = 0;
+
+    do {
+        octets[length] = number & 0x7F;
+        number >>= 7;
+        if (number) octets[length] |= 0x80;
+        length ++;
+    } while (number);
+
+    return yaml_parser_write_octets(parser, octets, length);
+}
+
+/*
+ * Append a string or a missing tag to the arena.
+ */
+
+static int
+yaml_parser_write_string(yaml_parser_t *parser,
+        const yaml_char_t *string, size_t length)
+{
+    if (!string)
+        return yaml_parser_write_number(parser, 0);
+
+    return yaml_parser_write_number(parser, length+1)
+        && yaml_parser_write_octets(parser, string, length);
+}
+
+/*
+ * Append the record of an event to the arena.
+ */
+
+static int
+yaml_parser_record_event(yaml_parser_t *parser, yaml_event_t *event)
+{
+    yaml_char_t type = (yaml_char_t)event->type;
+    yaml_char_t flags;
+
+    if (!yaml_parser_write_octets(parser, &type, 1))
+        return 0;
+
+    switch (event->type)
+    {
+        case YAML_SCALAR_EVENT:
+        case YAML_SCALAR_START_EVENT:
+            flags = (yaml_char_t)event->data.scalar.style
+                | (event->data.scalar.plain_implicit ? EXPANSION_IMPLICIT : 0)
+                | (event->data.scalar.quoted_implicit
+                        ? EXPANSION_QUOTED_IMPLICIT : 0);
+            if (!yaml_parser_write_octets(parser, &flags, 1)
+                    || !yaml_parser_write_string(parser, event->data.scalar.tag,
+                        event->data.scalar.tag
+                        ? strlen((char *)event->data.scalar.tag) : 0))
+                return 0;
+            if (event->type == YAML_SCALAR_START_EVENT)
+                return 1;
+            return yaml_parser_write_string(parser, event->data.scalar.value,
+                    event->data.scalar.length);
+
+        case YAML_SCALAR_CHUNK_EVENT:
+            return yaml_parser_write_string(parser, event->data.scalar.value,
+                    event->data.scalar.length);
+
+        case YAML_SEQUENCE_START_EVENT:
+            flags = (yaml_char_t)event->data.sequence_start.style
+                | (event->data.sequence_start.implicit ? EXPANSION_IMPLICIT : 0);
+            return yaml_parser_write_octets(parser, &flags, 1)
+                && yaml_parser_write_string(parser,
+                        event->data.sequence_start.tag,
+                        event->data.sequence_start.tag
+                        ? strlen((char *)event->data.sequence_start.tag) : 0);
+
+        case YAML_MAPPING_START_EVENT:
+            flags = (yaml_char_t)event->data.mapping_start.style
+                | (event->data.mapping_start.implicit ? EXPANSION_IMPLICIT : 0);
+            return yaml_parser_write_octets(parser, &flags, 1)
+                && yaml_parser_write_string(parser,
+                        event->data.mapping_start.tag,
+                        event->data.mapping_start.tag
+                        ? strlen((char *)event->data.mapping_start.tag) : 0);
+
+        default:
+            return 1;
+    }
+}
+
+/*
+ * Add an anchored node.
+ */
+
+static int
+yaml_parser_add_anchor(yaml_parser_t *parser, yaml_char_t *anchor,
+        size_t start, size_t end)
+{
+    yaml_expansion_anchor_t data;
+
+    data.anchor = yaml_strdup(anchor);
+    data.start = start;
+    data.end = end;
+    data.level = parser->expansion_level;
+
+    if (!data.anchor) {
+        parser->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+
+    if (!PUSH(parser, parser->expansion_anchors, data)) {
+        yaml_free(data.anchor);
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Record the event of an anchored node or start expanding an alias.
+ */
+
+YAML_DECLARE(int)
+yaml_parser_expand_event(yaml_parser_t *parser, yaml_event_t *event)
+{
+    yaml_char_t *anchor = NULL;
+    size_t start;
+    int recording;
+
+    if (!parser->expansion_anchors.start
+            && !yaml_parser_init_expansion(parser))
+        goto error;
+
+    start = parser->expansion_arena.pointer - parser->expansion_arena.start;
+    recording = !STACK_EMPTY(parser, parser->expansion_open);
+
+    switch (event->type)
+    {
+        case YAML_DOCUMENT_END_EVENT:
+            yaml_parser_reset_expansion(parser);
+            return 1;
+
+        case YAML_ALIAS_EVENT:
+            return yaml_parser_expand_alias(parser, event);
+
+        case YAML_SCALAR_EVENT:
+            anchor = event->data.scalar.anchor;
+            if (!anchor && !recording)
+                return 1;
+            if (!yaml_parser_record_event(parser, event))
+                goto error;
+            if (anchor && !yaml_parser_add_anchor(parser, anchor, start,
+                        parser->expansion_arena.pointer
+                        - parser->expansion_arena.start))
+                goto error;
+            return 1;
+
+        case YAML_SCALAR_CHUNK_EVENT:
+            if (recording && !yaml_parser_record_event(parser, event))
+                goto error;
+            return 1;
+
+        case YAML_SCALAR_START_EVENT:
+        case YAML_SEQUENCE_START_EVENT:
+        case YAML_MAPPING_START_EVENT:
+            anchor = (event->type == YAML_SCALAR_START_EVENT)
+                ? event->data.scalar.anchor
+                : (event->type == YAML_SEQUENCE_START_EVENT)
+                ? event->data.sequence_start.anchor
+                : event->data.mapping_start.anchor;
+            if (anchor || recording) {
+                if (!yaml_parser_record_event(parser, event))
+                    goto error;
+            }
+            if (anchor) {
+                if (!yaml_parser_add_anchor(parser, anchor, start, 0))
+                    goto error;
+                if (!PUSH(parser, parser->expansion_open,
+                            (int)(parser->expansion_anchors.top
+                                - parser->expansion_anchors.start - 1)))
+                    goto error;
+            }
+            parser->expansion_level ++;
+            return 1;
+
+        case YAML_SCALAR_END_EVENT:
+        case YAML_SEQUENCE_END_EVENT:
+        case YAML_MAPPING_END_EVENT:
+            parser->expansion_level --;
+            if (!recording)
+                return 1;
+            if (!yaml_parser_record_event(parser, event))
+                goto error;
+            while (!STACK_EMPTY(parser, parser->expansion_open)
+                    && parser->expansion_anchors.start[
+                        parser->expansion_open.top[-1]].level
+                        == parser->expansion_level) {
+                parser->expansion_anchors.start[
+                    POP(parser, parser->expansion_open)].end
+                    = parser->expansion_arena.pointer
+                    - parser->expansion_arena.start;
+            }
+            return 1;
+
+        default:
+            return 1;
+    }
+
+error:
+
+    yaml_event_delete(event);
+    return 0;
+}
+
+/*
+ * Replace an alias event with the first event of its node.
+ */
+
+static int
+yaml_parser_expand_alias(yaml_parser_t *parser, yaml_event_t *event)
+{
+    yaml_expansion_anchor_t *anchor;
+    yaml_expansion_frame_t frame;
+    yaml_char_t type = YAML_ALIAS_EVENT;
+
+    parser->expansion_start_mark = event->start_mark;
+    parser->expansion_end_mark = event->end_mark;
+
+    for (anchor = parser->expansion_anchors.top;
+            anchor != parser->expansion_anchors.start; anchor --) {
+        if (strcmp((char *)anchor[-1].anchor,
+                    (char *)event->data.alias.anchor) == 0)
+            break;
+    }
+
+    if (anchor == parser->expansion_anchors.start) {
+        yaml_parser_set_expansion_error(parser, "found undefined alias",
+                event->start_mark);
+        goto error;
+    }
+
+    anchor --;
+
+    if (!anchor->end) {
+        yaml_parser_set_expansion_error(parser, "found recursive alias",
+                event->start_mark);
+        goto error;
+    }
+
+    if (!STACK_EMPTY(parser, parser->expansion_open)) {
+        if (!yaml_parser_write_octets(parser, &type, 1)
+                || !yaml_parser_write_number(parser,
+                    anchor - parser->expansion_anchors.start))
+            goto error;
+    }
+
+    frame.pointer = anchor->start;
+    frame.end = anchor->end;
+    if (!PUSH(parser, parser->expansion_frames, frame))
+        goto error;
+
+    yaml_event_delete(event);
+
+    return yaml_parser_replay_event(parser, event);
+
+error:
+
+    yaml_event_delete(event);
+    return 0;
+}
+
+/*
+ * Read a number from the arena.
+ */
+
+static size_t
+yaml_parser_read_number(yaml_char_t **pointer)
+{
+    size_t number = 0;
+    int shift = 0;
+
+    do {
+        number |= (size_t)(**pointer & 0x7F) << shift;
+        shift += 7;
+    } while (*((*pointer)++) & 0x80);
+
+    return number;
+}
+
+/*
+ * Read a copy of a string or a missing tag from the arena.
+ */
+
+static int
+yaml_parser_read_string(yaml_parser_t *parser, yaml_char_t **pointer,
+        yaml_char_t **string, size_t *length)
+{
+    size_t size = yaml_parser_read_number(pointer);
+
+    *string = NULL;
+    *length = 0;
+
+    if (!size)
+        return 1;
+
+    *length = size-1;
+    *string = YAML_MALLOC(size);
+    if (!*string) {
+        parser->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+
+    memcpy(*string, *pointer, *length);
+    (*string)[*length] = '\0';
+    *pointer += *length;
+
+    return 1;
+}
+
+/*
+ * Produce the next replayed event.
+ */
+
+YAML_DECLARE(int)
+yaml_parser_replay_event(yaml_parser_t *parser, yaml_event_t *event)
+{
+    yaml_mark_t start_mark = parser->expansion_start_mark;
+    yaml_mark_t end_mark = parser->expansion_end_mark;
+    yaml_char_t *pointer;
+    yaml_char_t *tag = NULL;
+    yaml_char_t *value = NULL;
+    size_t tag_length = 0;
+    size_t length = 0;
+    yaml_event_type_t type;
+    int flags = 0;
+
+    memset(event, 0, sizeof(yaml_event_t));
+
+    while (1)
+    {
+        yaml_expansion_frame_t *frame = parser->expansion_frames.top - 1;
+
+        pointer = parser->expansion_arena.start + frame->pointer;
+        type = (yaml_event_type_t)*(pointer++);
+
+        if (type == YAML_ALIAS_EVENT) {
+            yaml_expansion_anchor_t *anchor = parser->expansion_anchors.start
+                + yaml_parser_read_number(&pointer);
+            yaml_expansion_frame_t next;
+
+            frame->pointer = pointer - parser->expansion_arena.start;
+            if (frame->pointer == frame->end) {
+                (void)POP(parser, parser->expansion_frames);
+            }
+
+            next.pointer = anchor->start;
+            next.end = anchor->end;
+            if (!PUSH(parser, parser->expansion_frames, next))
+                return 0;
+            continue;
+        }
+
+        if (type == YAML_SCALAR_EVENT || type == YAML_SCALAR_START_EVENT
+                || type == YAML_SEQUENCE_START_EVENT
+                || type == YAML_MAPPING_START_EVENT) {
+            flags = *(pointer++);
+            if (!yaml_parser_read_string(parser, &pointer, &tag, &tag_length))
+                goto error;
+        }
+
+        if (type == YAML_SCALAR_EVENT || type == YAML_SCALAR_CHUNK_EVENT) {
+            if (!yaml_parser_read_string(parser, &pointer, &value, &length))
+                goto error;
+        }
+
+        frame->pointer = pointer - parser->expansion_arena.start;
+        if (frame->pointer == frame->end) {
+            (void)POP(parser, parser->expansion_frames);
+        }
+
+        break;
+    }
+
+    /* Check the expansion limits. */
+
+    parser->expansion_events ++;
+    parser->expansion_bytes += tag_length + length;
+
+    if ((parser->expansion_max_events
+                && parser->expansion_events > parser->expansion_max_events)
+            || (parser->expansion_max_bytes
+                && parser->expansion_bytes > parser->expansion_max_bytes)) {
+        yaml_parser_set_expansion_error(parser,
+                "exceeded the alias expansion limit", start_mark);
+        goto error;
+    }
+
+    switch (type)
+    {
+        case YAML_SCALAR_EVENT:
+            SCALAR_EVENT_INIT(*event, NULL, tag, value, length,
+                    (flags & EXPANSION_IMPLICIT) != 0,
+                    (flags & EXPANSION_QUOTED_IMPLICIT) != 0,
+                    (yaml_scalar_style_t)(flags & EXPANSION_STYLE),
+                    start_mark, end_mark);
+            break;
+
+        case YAML_SCALAR_START_EVENT:
+            SCALAR_START_EVENT_INIT(*event, NULL, tag,
+                    (flags & EXPANSION_IMPLICIT) != 0,
+                    (flags & EXPANSION_QUOTED_IMPLICIT) != 0,
+                    (yaml_scalar_style_t)(flags & EXPANSION_STYLE),
+                    start_mark, end_mark);
+            break;
+
+        case YAML_SCALAR_CHUNK_EVENT:
+            SCALAR_CHUNK_EVENT_INIT(*event, value, length,
+                    start_mark, end_mark);
+            break;
+
+        case YAML_SCALAR_END_EVENT:
+            SCALAR_END_EVENT_INIT(*event, start_mark, end_mark);
+            break;
+
+        case YAML_SEQUENCE_START_EVENT:
+            SEQUENCE_START_EVENT_INIT(*event, NULL, tag,
+                    (flags & EXPANSION_IMPLICIT) != 0,
+                    (yaml_sequence_style_t)(flags & EXPANSION_STYLE),
+                    start_mark, end_mark);
+            break;
+
+        case YAML_MAPPING_START_EVENT:
+            MAPPING_START_EVENT_INIT(*event, NULL, tag,
+                    (flags & EXPANSION_IMPLICIT) != 0,
+                    (yaml_mapping_style_t)(flags & EXPANSION_STYLE),
+                    start_mark, end_mark);
+            break;
+
+        case YAML_SEQUENCE_END_EVENT:
+            SEQUENCE_END_EVENT_INIT(*event, start_mark, end_mark);
+            break;
+
+        default:
+            MAPPING_END_EVENT_INIT(*event, start_mark, end_mark);
+            break;
+    }
+
+    return 1;
+
+error:
+
+    yaml_free(tag);
+    yaml_free(value);
+    parser->expansion_frames.top = parser->expansion_frames.start;
+    return 0;
+}
+
+/*
+ * Forget the anchored nodes of the current document.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_reset_expansion(yaml_parser_t *parser)
+{
+    while (!STACK_EMPTY(parser, parser->expansion_anchors)) {
+        yaml_free(POP(parser, parser->expansion_anchors).anchor);
+    }
+
+    parser->expansion_arena.pointer = parser->expansion_arena.start;
+    parser->expansion_open.top = parser->expansion_open.start;
+    parser->expansion_frames.top = parser->expansion_frames.start;
+    parser->expansion_level = 0;
+    parser->expansion_events = 0;
+    parser->expansion_bytes = 0;
+}
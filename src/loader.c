@@ -8,6 +8,10 @@
 YAML_DECLARE(int)
 yaml_parser_load(yaml_parser_t *parser, yaml_document_t *document);
 
+YAML_DECLARE(int)
+yaml_parser_reload(yaml_parser_t *parser, yaml_document_t *document,
+        const unsigned char *input, size_t size, const yaml_edit_t *edit);
+
 /*
  * Error handling.
  */
@@ -37,6 +41,22 @@ yaml_parser_register_anchor(yaml_parser_t *parser,
 static void
 yaml_parser_delete_aliases(yaml_parser_t *parser);
 
+/*
+ * Deduplication table.
+ */
+struct dedup_entry {
+    size_t hash;
+    const yaml_char_t *string;
+    size_t length;
+    int index;
+};
+
+struct dedup_table {
+    struct dedup_entry *entries;
+    size_t capacity;
+    size_t count;
+};
+
 /*
  * Document loading context.
  */
@@ -44,8 +64,49 @@ struct loader_ctx {
     int *start;
     int *end;
     int *top;
+    struct dedup_table strings;
+    struct dedup_table nodes;
+    yaml_mark_t end_mark;
 };
 
+/*
+ * Deduplication functions.
+ */
+
+static int
+yaml_parser_dedup_extend(yaml_parser_t *parser, struct dedup_table *table);
+
+static int
+yaml_parser_intern(yaml_parser_t *parser, struct loader_ctx *ctx,
+        yaml_char_t **string, size_t length);
+
+static int
+yaml_parser_dedup_node(yaml_parser_t *parser, struct loader_ctx *ctx,
+        int *index);
+
+static void
+yaml_parser_replace_node(yaml_parser_t *parser, struct loader_ctx *ctx,
+        int index, int shared);
+
+static void
+yaml_parser_delete_dedup(struct loader_ctx *ctx);
+
+/*
+ * Merge key functions.
+ */
+
+static int
+yaml_parser_check_merge(yaml_parser_t *parser, struct loader_ctx *ctx,
+        int index, yaml_node_pair_t *pair, size_t *count);
+
+static int
+yaml_parser_merge_key(yaml_document_t *document, struct dedup_table *table,
+        int key);
+
+static int
+yaml_parser_load_merges(yaml_parser_t *parser, struct loader_ctx *ctx,
+        int index);
+
 /*
  * Composer functions.
  */
@@ -63,6 +124,15 @@ static int
 yaml_parser_load_scalar(yaml_parser_t *parser, yaml_event_t *event,
         struct loader_ctx *ctx);
 
+static int
+yaml_parser_load_scalar_chunks(yaml_parser_t *parser, yaml_event_t *event,
+        struct loader_ctx *ctx);
+
+static int
+yaml_parser_resolve_scalar(yaml_parser_t *parser, yaml_event_t *event,
+        yaml_char_t **tag, yaml_scalar_type_t *type,
+        yaml_resolved_value_t *resolved);
+
 static int
 yaml_parser_load_sequence(yaml_parser_t *parser, yaml_event_t *event,
         struct loader_ctx *ctx);
@@ -79,6 +149,30 @@ static int
 yaml_parser_load_mapping_end(yaml_parser_t *parser, yaml_event_t *event,
         struct loader_ctx *ctx);
 
+/*
+ * Incremental reloading.
+ */
+
+static void
+yaml_parser_reload_free_node(yaml_node_t *node);
+
+static int
+yaml_parser_reload_check_range(yaml_document_t *document,
+        int first, int last, int low, int high);
+
+static int
+yaml_parser_reload_offset(const unsigned char *input, size_t size,
+        size_t offset, size_t *pointer, size_t *count);
+
+static void
+yaml_parser_reload_shift_mark(yaml_mark_t *mark,
+        yaml_mark_t old_start, yaml_mark_t new_start,
+        yaml_mark_t old_end, yaml_mark_t new_end);
+
+static int
+yaml_parser_reload_pairs(yaml_parser_t *parser, yaml_document_t *document,
+        const unsigned char *input, size_t size, const yaml_edit_t *edit);
+
 /*
  * Load the next document of the stream.
  */
@@ -184,11 +278,13 @@ yaml_parser_delete_aliases(yaml_parser_t *parser)
 static int
 yaml_parser_load_document(yaml_parser_t *parser, yaml_event_t *event)
 {
-    struct loader_ctx ctx = { NULL, NULL, NULL };
+    struct loader_ctx ctx;
 
     assert(event->type == YAML_DOCUMENT_START_EVENT);
                         /* DOCUMENT-START is expected. */
 
+    memset(&ctx, 0, sizeof(ctx));
+
     parser->document->version_directive
         = event->data.document_start.version_directive;
     parser->document->tag_directives.start
@@ -201,9 +297,11 @@ yaml_parser_load_document(yaml_parser_t *parser, yaml_event_t *event)
 
     if (!STACK_INIT(parser, ctx, int*)) return 0;
     if (!yaml_parser_load_nodes(parser, &ctx)) {
+        yaml_parser_delete_dedup(&ctx);
         STACK_DEL(parser, ctx);
         return 0;
     }
+    yaml_parser_delete_dedup(&ctx);
     STACK_DEL(parser, ctx);
 
     return 1;
@@ -228,6 +326,10 @@ yaml_parser_load_nodes(yaml_parser_t *parser, struct loader_ctx *ctx)
             case YAML_SCALAR_EVENT:
                 if (!yaml_parser_load_scalar(parser, &event, ctx)) return 0;
                 break;
+            case YAML_SCALAR_START_EVENT:
+                if (!yaml_parser_load_scalar_chunks(parser, &event, ctx))
+                    return 0;
+                break;
             case YAML_SEQUENCE_START_EVENT:
                 if (!yaml_parser_load_sequence(parser, &event, ctx)) return 0;
                 break;
@@ -291,6 +393,314 @@ yaml_parser_register_anchor(yaml_parser_t *parser,
     return 1;
 }
 
+/*
+ * Hash a block of bytes (FNV-1a).
+ */
+
+static size_t
+yaml_parser_dedup_hash(size_t hash, const void *data, size_t length)
+{
+    const unsigned char *pointer = (const unsigned char *)data;
+
+    while (length --) {
+        hash ^= *(pointer++);
+        hash *= (size_t)0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+#define DEDUP_HASH_SEED     ((size_t)0xCBF29CE484222325ULL)
+
+/*
+ * Double the capacity of a deduplication table.
+ */
+
+static int
+yaml_parser_dedup_extend(yaml_parser_t *parser, struct dedup_table *table)
+{
+    size_t capacity = table->capacity ? table->capacity*2 : 64;
+    struct dedup_entry *entries;
+    size_t k;
+
+    entries = (struct dedup_entry *)yaml_malloc(capacity*sizeof(*entries));
+    if (!entries) {
+        parser->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+    memset(entries, 0, capacity*sizeof(*entries));
+
+    for (k = 0; k < table->capacity; k ++) {
+        struct dedup_entry *entry = table->entries + k;
+        size_t slot;
+        if (!entry->string && !entry->index)
+            continue;
+        slot = entry->hash & (capacity-1);
+        while (entries[slot].string || entries[slot].index)
+            slot = (slot+1) & (capacity-1);
+        entries[slot] = *entry;
+    }
+
+    yaml_free(table->entries);
+    table->entries = entries;
+    table->capacity = capacity;
+
+    return 1;
+}
+
+/*
+ * Replace a string with its copy from the document string pool.
+ *
+ * If an equal string is already in the pool, the given string is freed.
+ * Otherwise the string is moved to the pool.
+ */
+
+static int
+yaml_parser_intern(yaml_parser_t *parser, struct loader_ctx *ctx,
+        yaml_char_t **string, size_t length)
+{
+    struct dedup_table *table = &ctx->strings;
+    size_t hash = yaml_parser_dedup_hash(DEDUP_HASH_SEED, *string, length);
+    size_t slot;
+
+    if (table->count*2 >= table->capacity) {
+        if (!yaml_parser_dedup_extend(parser, table))
+            return 0;
+    }
+
+    slot = hash & (table->capacity-1);
+
+    while (table->entries[slot].string)
+    {
+        struct dedup_entry *entry = table->entries + slot;
+        if (entry->hash == hash && entry->length == length
+                && memcmp(entry->string, *string, length) == 0) {
+            yaml_free(*string);
+            *string = (yaml_char_t *)entry->string;
+            return 1;
+        }
+        slot = (slot+1) & (table->capacity-1);
+    }
+
+    if (!parser->document->strings.start) {
+        if (!STACK_INIT(parser, parser->document->strings, yaml_char_t**))
+            return 0;
+    }
+    if (!PUSH(parser, parser->document->strings, *string))
+        return 0;
+
+    table->entries[slot].hash = hash;
+    table->entries[slot].string = *string;
+    table->entries[slot].length = length;
+    table->count ++;
+
+    return 1;
+}
+
+/*
+ * Hash a node.  The strings of the node are interned and its items are
+ * already deduplicated, so they are hashed by identity.
+ */
+
+static size_t
+yaml_parser_dedup_node_hash(yaml_node_t *node)
+{
+    size_t hash = DEDUP_HASH_SEED;
+
+    hash = yaml_parser_dedup_hash(hash, &node->type, sizeof(node->type));
+    hash = yaml_parser_dedup_hash(hash, &node->tag, sizeof(node->tag));
+
+    switch (node->type)
+    {
+        case YAML_SCALAR_NODE:
+            hash = yaml_parser_dedup_hash(hash, &node->data.scalar.style,
+                    sizeof(node->data.scalar.style));
+            hash = yaml_parser_dedup_hash(hash, &node->data.scalar.value,
+                    sizeof(node->data.scalar.value));
+            break;
+
+        case YAML_SEQUENCE_NODE:
+            hash = yaml_parser_dedup_hash(hash, &node->data.sequence.style,
+                    sizeof(node->data.sequence.style));
+            hash = yaml_parser_dedup_hash(hash, node->data.sequence.items.start,
+                    (char *)node->data.sequence.items.top
+                    - (char *)node->data.sequence.items.start);
+            break;
+
+        case YAML_MAPPING_NODE:
+            hash = yaml_parser_dedup_hash(hash, &node->data.mapping.style,
+                    sizeof(node->data.mapping.style));
+            hash = yaml_parser_dedup_hash(hash, node->data.mapping.pairs.start,
+                    (char *)node->data.mapping.pairs.top
+                    - (char *)node->data.mapping.pairs.start);
+            break;
+
+        default:
+            assert(0);      /* Could not happen. */
+    }
+
+    return hash;
+}
+
+/*
+ * Check if two nodes with interned strings and deduplicated items are equal.
+ */
+
+static int
+yaml_parser_dedup_node_equal(yaml_node_t *a, yaml_node_t *b)
+{
+    if (a->type != b->type || a->tag != b->tag)
+        return 0;
+
+    switch (a->type)
+    {
+        case YAML_SCALAR_NODE:
+            return (a->data.scalar.style == b->data.scalar.style
+                    && a->resolved.type == b->resolved.type
+                    && (a->flags & YAML_NODE_RESOLVED_TAG)
+                    == (b->flags & YAML_NODE_RESOLVED_TAG)
+                    && a->data.scalar.value == b->data.scalar.value);
+
+        case YAML_SEQUENCE_NODE:
+            return (a->data.sequence.style == b->data.sequence.style
+                    && a->data.sequence.items.top - a->data.sequence.items.start
+                    == b->data.sequence.items.top - b->data.sequence.items.start
+                    && memcmp(a->data.sequence.items.start,
+                        b->data.sequence.items.start,
+                        (char *)a->data.sequence.items.top
+                        - (char *)a->data.sequence.items.start) == 0);
+
+        case YAML_MAPPING_NODE:
+            return (a->data.mapping.style == b->data.mapping.style
+                    && a->data.mapping.pairs.top - a->data.mapping.pairs.start
+                    == b->data.mapping.pairs.top - b->data.mapping.pairs.start
+                    && memcmp(a->data.mapping.pairs.start,
+                        b->data.mapping.pairs.start,
+                        (char *)a->data.mapping.pairs.top
+                        - (char *)a->data.mapping.pairs.start) == 0);
+
+        default:
+            return 0;
+    }
+}
+
+/*
+ * Look up a node equal to the given node.
+ *
+ * If such a node exists, the given node is removed and `*index` is set to the
+ * id of the existing node.  Otherwise the given node is added to the table.
+ */
+
+static int
+yaml_parser_dedup_node(yaml_parser_t *parser, struct loader_ctx *ctx,
+        int *index)
+{
+    struct dedup_table *table = &ctx->nodes;
+    yaml_document_t *document = parser->document;
+    yaml_node_t *node = document->nodes.start + *index - 1;
+    size_t hash = yaml_parser_dedup_node_hash(node);
+    size_t slot;
+
+    if (table->count*2 >= table->capacity) {
+        if (!yaml_parser_dedup_extend(parser, table))
+            return 0;
+    }
+
+    slot = hash & (table->capacity-1);
+
+    while (table->entries[slot].index)
+    {
+        struct dedup_entry *entry = table->entries + slot;
+        if (entry->hash == hash && yaml_parser_dedup_node_equal(node,
+                    document->nodes.start + entry->index - 1)) {
+            /*
+             * A mapping with materialized merge keys has the pairs of the
+             * merged mappings, which follow it in the document, so it
+             * cannot be removed.  It is left without references, unless it
+             * is the root, which keeps its own node.
+             */
+            if (node != document->nodes.top - 1) {
+                if (!STACK_EMPTY(parser, *ctx)) {
+                    *index = entry->index;
+                }
+                return 1;
+            }
+            /*
+             * Otherwise, an equal node has the same items, so the items of
+             * the node are not new and the node is the last one in the
+             * document.
+             */
+            if (node->type == YAML_SEQUENCE_NODE) {
+                STACK_DEL(parser, node->data.sequence.items);
+            }
+            if (node->type == YAML_MAPPING_NODE) {
+                STACK_DEL(parser, node->data.mapping.pairs);
+            }
+            document->nodes.top --;
+            *index = entry->index;
+            return 1;
+        }
+        slot = (slot+1) & (table->capacity-1);
+    }
+
+    table->entries[slot].hash = hash;
+    table->entries[slot].index = *index;
+    table->count ++;
+
+    return 1;
+}
+
+/*
+ * Replace the references to a removed collection with the shared one.
+ */
+
+static void
+yaml_parser_replace_node(yaml_parser_t *parser, struct loader_ctx *ctx,
+        int index, int shared)
+{
+    yaml_alias_data_t *alias_data;
+
+    for (alias_data = parser->aliases.start;
+            alias_data != parser->aliases.top; alias_data ++) {
+        if (alias_data->index == index)
+            alias_data->index = shared;
+    }
+
+    if (!STACK_EMPTY(parser, *ctx)) {
+        yaml_node_t *parent =
+            parser->document->nodes.start + *((*ctx).top - 1) - 1;
+
+        if (parent->type == YAML_SEQUENCE_NODE) {
+            yaml_node_item_t *item = parent->data.sequence.items.top - 1;
+            assert(*item == index);
+            *item = shared;
+        }
+        else {
+            yaml_node_pair_t *pair = parent->data.mapping.pairs.top - 1;
+            if (pair->value == index) {
+                pair->value = shared;
+            }
+            else {
+                assert(pair->key == index);
+                pair->key = shared;
+            }
+        }
+    }
+}
+
+/*
+ * Delete the deduplication tables.
+ */
+
+static void
+yaml_parser_delete_dedup(struct loader_ctx *ctx)
+{
+    yaml_free(ctx->strings.entries);
+    yaml_free(ctx->nodes.entries);
+    memset(&ctx->strings, 0, sizeof(ctx->strings));
+    memset(&ctx->nodes, 0, sizeof(ctx->nodes));
+}
+
 /*
  * Compose node into its parent in the stree.
  */
@@ -354,6 +764,8 @@ yaml_parser_load_alias(yaml_parser_t *parser, yaml_event_t *event,
     yaml_char_t *anchor = event->data.alias.anchor;
     yaml_alias_data_t *alias_data;
 
+    ctx->end_mark = event->end_mark;
+
     for (alias_data = parser->aliases.start;
             alias_data != parser->aliases.top; alias_data ++) {
         if (strcmp((char *)alias_data->anchor, (char *)anchor) == 0) {
@@ -367,6 +779,67 @@ yaml_parser_load_alias(yaml_parser_t *parser, yaml_event_t *event,
             event->start_mark);
 }
 
+/*
+ * Resolve the type of a scalar using the core schema.
+ */
+
+static int
+yaml_parser_resolve_scalar(yaml_parser_t *parser, yaml_event_t *event,
+        yaml_char_t **tag, yaml_scalar_type_t *type,
+        yaml_resolved_value_t *resolved)
+{
+    int implicit = 0;
+
+    *type = YAML_UNRESOLVED_SCALAR_TYPE;
+
+    if (!*tag) {
+        implicit = 1;
+        if (event->data.scalar.style != YAML_PLAIN_SCALAR_STYLE)
+            *type = YAML_STR_SCALAR_TYPE;
+    }
+    else if (strcmp((char *)*tag, "!") == 0) {
+        implicit = 1;
+        *type = YAML_STR_SCALAR_TYPE;
+    }
+    else if (strcmp((char *)*tag, YAML_STR_TAG) == 0) {
+        *type = YAML_STR_SCALAR_TYPE;
+    }
+    else if (strcmp((char *)*tag, YAML_NULL_TAG) == 0) {
+        *type = YAML_NULL_SCALAR_TYPE;
+    }
+    else if (strcmp((char *)*tag, YAML_BOOL_TAG) == 0) {
+        *type = YAML_BOOL_SCALAR_TYPE;
+    }
+    else if (strcmp((char *)*tag, YAML_INT_TAG) == 0) {
+        *type = YAML_INT_SCALAR_TYPE;
+    }
+    else if (strcmp((char *)*tag, YAML_FLOAT_TAG) == 0) {
+        *type = YAML_FLOAT_SCALAR_TYPE;
+    }
+    else {
+        return 1;
+    }
+
+    if (!yaml_resolve_scalar(event->data.scalar.value,
+                event->data.scalar.length, type, resolved)) {
+        parser->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+
+    if (implicit) {
+        yaml_char_t *resolved_tag =
+            yaml_strdup((yaml_char_t *)yaml_resolved_tag(*type));
+        if (!resolved_tag) {
+            parser->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+        yaml_free(*tag);
+        *tag = resolved_tag;
+    }
+
+    return 1;
+}
+
 /*
  * Compose a scalar node.
  */
@@ -378,32 +851,134 @@ yaml_parser_load_scalar(yaml_parser_t *parser, yaml_event_t *event,
     yaml_node_t node;
     int index;
     yaml_char_t *tag = event->data.scalar.tag;
+    yaml_char_t *value = event->data.scalar.value;
+    size_t length = event->data.scalar.length;
+    yaml_scalar_type_t type = YAML_UNRESOLVED_SCALAR_TYPE;
+    yaml_resolved_value_t resolved;
+    int flags = 0;
+
+    ctx->end_mark = event->end_mark;
 
     if (!STACK_LIMIT(parser, parser->document->nodes, INT_MAX-1)) goto error;
 
+    if (parser->resolve_scalars) {
+        if (!tag && event->data.scalar.style == YAML_PLAIN_SCALAR_STYLE) {
+            flags |= YAML_NODE_RESOLVED_TAG;
+        }
+        if (!yaml_parser_resolve_scalar(parser, event, &tag, &type, &resolved))
+            goto error;
+    }
+    else if (tag ? (strcmp((char *)tag, "!") == 0
+                || strcmp((char *)tag, YAML_STR_TAG) == 0)
+            : event->data.scalar.style != YAML_PLAIN_SCALAR_STYLE) {
+        /* Keep the node accessors from resolving a string by its value. */
+        type = YAML_STR_SCALAR_TYPE;
+    }
+
+    /* Decode a binary scalar in place before its value may be shared. */
+
+    if (parser->decode_binary && tag
+            && strcmp((char *)tag, YAML_BINARY_TAG) == 0) {
+        if (!yaml_resolve_binary(value, length, &length)) {
+            yaml_parser_set_composer_error(parser,
+                    "found invalid base64 data in a binary scalar",
+                    event->start_mark);
+            goto error;
+        }
+        type = YAML_BINARY_SCALAR_TYPE;
+    }
+
     if (!tag || strcmp((char *)tag, "!") == 0) {
         yaml_free(tag);
         tag = yaml_strdup((yaml_char_t *)YAML_DEFAULT_SCALAR_TAG);
         if (!tag) goto error;
     }
 
-    SCALAR_NODE_INIT(node, tag, event->data.scalar.value,
-            event->data.scalar.length, event->data.scalar.style,
+    if (parser->dedup != YAML_DEDUP_NONE) {
+        if (!yaml_parser_intern(parser, ctx, &tag, strlen((char *)tag)))
+            goto error;
+        flags |= YAML_NODE_SHARED_TAG;
+        if (!yaml_parser_intern(parser, ctx, &value, length))
+            goto error;
+        flags |= YAML_NODE_SHARED_VALUE;
+    }
+
+    SCALAR_NODE_INIT(node, tag, value, length, event->data.scalar.style,
             event->start_mark, event->end_mark);
+    node.flags = flags;
+
+    if (type != YAML_UNRESOLVED_SCALAR_TYPE) {
+        node.resolved.type = type;
+        node.resolved.value = resolved;
+    }
 
     if (!PUSH(parser, parser->document->nodes, node)) goto error;
 
     index = parser->document->nodes.top - parser->document->nodes.start;
 
+    if (parser->dedup == YAML_DEDUP_NODES) {
+        if (!yaml_parser_dedup_node(parser, ctx, &index)) {
+            yaml_free(event->data.scalar.anchor);
+            return 0;
+        }
+    }
+
     if (!yaml_parser_register_anchor(parser, index,
                 event->data.scalar.anchor)) return 0;
 
     return yaml_parser_load_node_add(parser, ctx, index);
 
 error:
-    yaml_free(tag);
+    if (!(flags & YAML_NODE_SHARED_TAG)) yaml_free(tag);
+    if (!(flags & YAML_NODE_SHARED_VALUE)) yaml_free(value);
     yaml_free(event->data.scalar.anchor);
-    yaml_free(event->data.scalar.value);
+    return 0;
+}
+
+/*
+ * Join the chunks of a scalar and compose a scalar node.
+ */
+
+static int
+yaml_parser_load_scalar_chunks(yaml_parser_t *parser, yaml_event_t *event,
+        struct loader_ctx *ctx)
+{
+    yaml_event_t chunk;
+    yaml_string_t string = NULL_STRING;
+    yaml_char_t *pointer;
+    yaml_char_t *end;
+
+    if (!STRING_INIT(parser, string, INITIAL_STRING_SIZE)) goto error;
+
+    while (1)
+    {
+        if (!yaml_parser_parse(parser, &chunk)) goto error;
+        if (chunk.type == YAML_SCALAR_END_EVENT) break;
+        assert(chunk.type == YAML_SCALAR_CHUNK_EVENT);
+                        /* SCALAR-CHUNK is expected. */
+
+        pointer = chunk.data.scalar.value;
+        end = pointer + chunk.data.scalar.length;
+        if (!yaml_string_join(&string.start, &string.pointer, &string.end,
+                    &pointer, &end, &end)) {
+            parser->error = YAML_MEMORY_ERROR;
+            yaml_event_delete(&chunk);
+            goto error;
+        }
+        yaml_event_delete(&chunk);
+    }
+
+    event->type = YAML_SCALAR_EVENT;
+    event->data.scalar.value = string.start;
+    event->data.scalar.length = string.pointer - string.start;
+    event->end_mark = chunk.end_mark;
+
+    return yaml_parser_load_scalar(parser, event, ctx);
+
+error:
+    STRING_DEL(parser, string);
+    yaml_free(event->data.scalar.anchor);
+    yaml_free(event->data.scalar.tag);
     return 0;
 }
 
@@ -423,6 +998,7 @@ yaml_parser_load_sequence(yaml_parser_t *parser, yaml_event_t *event,
     } items = { NULL, NULL, NULL };
     int index;
     yaml_char_t *tag = event->data.sequence_start.tag;
+    int flags = 0;
 
     if (!STACK_LIMIT(parser, parser->document->nodes, INT_MAX-1)) goto error;
 
@@ -432,11 +1008,18 @@ yaml_parser_load_sequence(yaml_parser_t *parser, yaml_event_t *event,
         if (!tag) goto error;
     }
 
+    if (parser->dedup != YAML_DEDUP_NONE) {
+        if (!yaml_parser_intern(parser, ctx, &tag, strlen((char *)tag)))
+            goto error;
+        flags |= YAML_NODE_SHARED_TAG;
+    }
+
     if (!STACK_INIT(parser, items, yaml_node_item_t*)) goto error;
 
     SEQUENCE_NODE_INIT(node, tag, items.start, items.end,
             event->data.sequence_start.style,
             event->start_mark, event->end_mark);
+    node.flags = flags;
 
     if (!PUSH(parser, parser->document->nodes, node)) goto error;
 
@@ -453,7 +1036,8 @@ yaml_parser_load_sequence(yaml_parser_t *parser, yaml_event_t *event,
     return 1;
 
 error:
-    yaml_free(tag);
+    STACK_DEL(parser, items);
+    if (!(flags & YAML_NODE_SHARED_TAG)) yaml_free(tag);
     yaml_free(event->data.sequence_start.anchor);
     return 0;
 }
@@ -462,16 +1046,35 @@ static int
 yaml_parser_load_sequence_end(yaml_parser_t *parser, yaml_event_t *event,
         struct loader_ctx *ctx)
 {
+    yaml_node_t *node;
     int index;
 
     assert(((*ctx).top - (*ctx).start) > 0);
 
     index = *((*ctx).top - 1);
-    assert(parser->document->nodes.start[index-1].type == YAML_SEQUENCE_NODE);
-    parser->document->nodes.start[index-1].end_mark = event->end_mark;
+    node = parser->document->nodes.start + index - 1;
+    assert(node->type == YAML_SEQUENCE_NODE);
+
+    /* A block collection ends where its last entry does. */
+
+    if (parser->source_spans && node->data.sequence.style == YAML_BLOCK_SEQUENCE_STYLE) {
+        node->end_mark = ctx->end_mark;
+    }
+    else {
+        node->end_mark = event->end_mark;
+        ctx->end_mark = event->end_mark;
+    }
 
     (void)POP(parser, *ctx);
 
+    if (parser->dedup == YAML_DEDUP_NODES) {
+        int shared = index;
+        if (!yaml_parser_dedup_node(parser, ctx, &shared)) return 0;
+        if (shared != index) {
+            yaml_parser_replace_node(parser, ctx, index, shared);
+        }
+    }
+
     return 1;
 }
 
@@ -491,6 +1094,7 @@ yaml_parser_load_mapping(yaml_parser_t *parser, yaml_event_t *event,
     } pairs = { NULL, NULL, NULL };
     int index;
     yaml_char_t *tag = event->data.mapping_start.tag;
+    int flags = 0;
 
     if (!STACK_LIMIT(parser, parser->document->nodes, INT_MAX-1)) goto error;
 
@@ -500,11 +1104,18 @@ yaml_parser_load_mapping(yaml_parser_t *parser, yaml_event_t *event,
         if (!tag) goto error;
     }
 
+    if (parser->dedup != YAML_DEDUP_NONE) {
+        if (!yaml_parser_intern(parser, ctx, &tag, strlen((char *)tag)))
+            goto error;
+        flags |= YAML_NODE_SHARED_TAG;
+    }
+
     if (!STACK_INIT(parser, pairs, yaml_node_pair_t*)) goto error;
 
     MAPPING_NODE_INIT(node, tag, pairs.start, pairs.end,
             event->data.mapping_start.style,
             event->start_mark, event->end_mark);
+    node.flags = flags;
 
     if (!PUSH(parser, parser->document->nodes, node)) goto error;
 
@@ -521,7 +1132,8 @@ yaml_parser_load_mapping(yaml_parser_t *parser, yaml_event_t *event,
     return 1;
 
 error:
-    yaml_free(tag);
+    STACK_DEL(parser, pairs);
+    if (!(flags & YAML_NODE_SHARED_TAG)) yaml_free(tag);
     yaml_free(event->data.mapping_start.anchor);
     return 0;
 }
@@ -530,15 +1142,721 @@ static int
 yaml_parser_load_mapping_end(yaml_parser_t *parser, yaml_event_t *event,
         struct loader_ctx *ctx)
 {
+    yaml_node_t *node;
     int index;
 
     assert(((*ctx).top - (*ctx).start) > 0);
 
     index = *((*ctx).top - 1);
-    assert(parser->document->nodes.start[index-1].type == YAML_MAPPING_NODE);
-    parser->document->nodes.start[index-1].end_mark = event->end_mark;
+    node = parser->document->nodes.start + index - 1;
+    assert(node->type == YAML_MAPPING_NODE);
+
+    /* A block collection ends where its last entry does. */
+
+    if (parser->source_spans && node->data.mapping.style == YAML_BLOCK_MAPPING_STYLE) {
+        node->end_mark = ctx->end_mark;
+    }
+    else {
+        node->end_mark = event->end_mark;
+        ctx->end_mark = event->end_mark;
+    }
 
     (void)POP(parser, *ctx);
 
+    if (parser->merge != YAML_MERGE_NONE) {
+        if (!yaml_parser_load_merges(parser, ctx, index)) return 0;
+    }
+
+    if (parser->dedup == YAML_DEDUP_NODES) {
+        int shared = index;
+        if (!yaml_parser_dedup_node(parser, ctx, &shared)) return 0;
+        if (shared != index) {
+            yaml_parser_replace_node(parser, ctx, index, shared);
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * Check the value of a merge key and add the number of the merged pairs to
+ * `*count`.
+ */
+
+static int
+yaml_parser_check_merge(yaml_parser_t *parser, struct loader_ctx *ctx,
+        int index, yaml_node_pair_t *pair, size_t *count)
+{
+    yaml_document_t *document = parser->document;
+    yaml_node_t *value = document->nodes.start + pair->value - 1;
+    yaml_node_item_t *item;
+    yaml_node_item_t *items = &pair->value;
+    yaml_node_item_t *items_end = &pair->value + 1;
+
+    if (value->type == YAML_SEQUENCE_NODE) {
+        items = value->data.sequence.items.start;
+        items_end = value->data.sequence.items.top;
+    }
+
+    for (item = items; item < items_end; item ++)
+    {
+        yaml_node_t *source = document->nodes.start + *item - 1;
+        int *open;
+
+        if (source->type != YAML_MAPPING_NODE) {
+            return yaml_parser_set_composer_error_context(parser,
+                    "while merging a mapping",
+                    document->nodes.start[index-1].start_mark,
+                    "expected a mapping or a sequence of mappings",
+                    source->start_mark);
+        }
+
+        for (open = ctx->start; open != ctx->top; open ++) {
+            if (*open == *item) break;
+        }
+
+        if (*item == index || open != ctx->top) {
+            return yaml_parser_set_composer_error_context(parser,
+                    "while merging a mapping",
+                    document->nodes.start[index-1].start_mark,
+                    "found a merge of an enclosing mapping",
+                    value->start_mark);
+        }
+
+        *count += source->data.mapping.pairs.top
+            - source->data.mapping.pairs.start;
+    }
+
+    return 1;
+}
+
+/*
+ * Hash a key of a merged mapping.  Scalar keys are hashed by tag and value,
+ * other keys by identity.
+ */
+
+static size_t
+yaml_parser_merge_key_hash(yaml_node_t *node, int key)
+{
+    size_t hash = DEDUP_HASH_SEED;
+
+    if (node->type != YAML_SCALAR_NODE)
+        return yaml_parser_dedup_hash(hash, &key, sizeof(key));
+
+    hash = yaml_parser_dedup_hash(hash, node->tag, strlen((char *)node->tag));
+    return yaml_parser_dedup_hash(hash, node->data.scalar.value,
+            node->data.scalar.length);
+}
+
+/*
+ * Add the key of a pair to the table.  Return 0 if an equal key is already
+ * there.
+ */
+
+static int
+yaml_parser_merge_key(yaml_document_t *document, struct dedup_table *table,
+        int key)
+{
+    yaml_node_t *node = document->nodes.start + key - 1;
+    size_t hash = yaml_parser_merge_key_hash(node, key);
+    size_t slot = hash & (table->capacity-1);
+
+    while (table->entries[slot].index)
+    {
+        struct dedup_entry *entry = table->entries + slot;
+        yaml_node_t *other = document->nodes.start + entry->index - 1;
+
+        if (entry->hash == hash && (entry->index == key
+                    || (node->type == YAML_SCALAR_NODE
+                        && other->type == YAML_SCALAR_NODE
+                        && node->data.scalar.length
+                            == other->data.scalar.length
+                        && memcmp(node->data.scalar.value,
+                            other->data.scalar.value,
+                            node->data.scalar.length) == 0
+                        && strcmp((char *)node->tag,
+                            (char *)other->tag) == 0)))
+            return 0;
+
+        slot = (slot+1) & (table->capacity-1);
+    }
+
+    table->entries[slot].hash = hash;
+    table->entries[slot].index = key;
+    table->count ++;
+
+    return 1;
+}
+
+/*
+ * Apply the merge keys of a complete mapping.
+ */
+
+static int
+yaml_parser_load_merges(yaml_parser_t *parser, struct loader_ctx *ctx,
+        int index)
+{
+    yaml_document_t *document = parser->document;
+    yaml_node_t *node = document->nodes.start + index - 1;
+    yaml_node_pair_t *pair;
+    yaml_node_pair_t *pairs;
+    struct dedup_table table = { NULL, 0, 0 };
+    size_t count = 0;
+    size_t length = 0;
+    int merges = 0;
+
+    for (pair = node->data.mapping.pairs.start;
+            pair < node->data.mapping.pairs.top; pair ++) {
+        if (!yaml_document_is_merge_key(document->nodes.start + pair->key - 1)) {
+            count ++;
+            continue;
+        }
+        if (!yaml_parser_check_merge(parser, ctx, index, pair, &count))
+            return 0;
+        merges ++;
+    }
+
+    if (!merges || parser->merge != YAML_MERGE_MATERIALIZE)
+        return 1;
+
+    if (count >= INT_MAX) {
+        parser->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+
+    table.capacity = 16;
+    while (table.capacity < count*2) {
+        table.capacity *= 2;
+    }
+
+    pairs = (yaml_node_pair_t *)yaml_malloc((count ? count : 1)*sizeof(*pairs));
+    table.entries = (struct dedup_entry *)yaml_malloc(
+            table.capacity*sizeof(*table.entries));
+    if (!pairs || !table.entries) {
+        yaml_free(pairs);
+        yaml_free(table.entries);
+        parser->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+    memset(table.entries, 0, table.capacity*sizeof(*table.entries));
+
+    /* The explicit pairs are kept as they are, even with duplicate keys. */
+
+    for (pair = node->data.mapping.pairs.start;
+            pair < node->data.mapping.pairs.top; pair ++) {
+        if (!yaml_document_is_merge_key(document->nodes.start + pair->key - 1)) {
+            yaml_parser_merge_key(document, &table, pair->key);
+            pairs[length++] = *pair;
+        }
+    }
+
+    for (pair = node->data.mapping.pairs.start;
+            pair < node->data.mapping.pairs.top; pair ++) {
+        yaml_node_t *value = document->nodes.start + pair->value - 1;
+        yaml_node_item_t *item;
+        yaml_node_item_t *items = &pair->value;
+        yaml_node_item_t *items_end = &pair->value + 1;
+
+        if (!yaml_document_is_merge_key(document->nodes.start + pair->key - 1))
+            continue;
+
+        if (value->type == YAML_SEQUENCE_NODE) {
+            items = value->data.sequence.items.start;
+            items_end = value->data.sequence.items.top;
+        }
+
+        for (item = items; item < items_end; item ++) {
+            yaml_node_t *source = document->nodes.start + *item - 1;
+            yaml_node_pair_t *merged;
+            for (merged = source->data.mapping.pairs.start;
+                    merged < source->data.mapping.pairs.top; merged ++) {
+                if (yaml_parser_merge_key(document, &table, merged->key)) {
+                    pairs[length++] = *merged;
+                }
+            }
+        }
+    }
+
+    yaml_free(table.entries);
+    yaml_free(node->data.mapping.pairs.start);
+    node->data.mapping.pairs.start = pairs;
+    node->data.mapping.pairs.top = pairs + length;
+    node->data.mapping.pairs.end = pairs + (count ? count : 1);
+
+    return 1;
+}
+
+/*
+ * Incremental reloading.
+ *
+ * When the root of a document is a block mapping with its keys in the first
+ * column, every top-level pair occupies a run of whole lines that can be
+ * parsed on its own.  An edit confined to such runs is handled by loading
+ * the affected lines as a separate document and splicing its pairs into the
+ * root.  Whenever the edit may affect anything beyond these lines, the whole
+ * input is loaded again.
+ */
+
+/*
+ * Free the content of a node.
+ */
+
+static void
+yaml_parser_reload_free_node(yaml_node_t *node)
+{
+    if (!(node->flags & YAML_NODE_SHARED_TAG)) {
+        yaml_free(node->tag);
+    }
+
+    switch (node->type) {
+        case YAML_SCALAR_NODE:
+            if (!(node->flags & YAML_NODE_SHARED_VALUE)) {
+                yaml_free(node->data.scalar.value);
+            }
+            break;
+        case YAML_SEQUENCE_NODE:
+            yaml_free(node->data.sequence.items.start);
+            break;
+        case YAML_MAPPING_NODE:
+            yaml_free(node->data.mapping.pairs.start);
+            break;
+        default:
+            assert(0);      /* Should not happen. */
+    }
+}
+
+/*
+ * Check that the nodes in the range [low, high) are referenced only by the
+ * given root pairs and by each other.
+ */
+
+static int
+yaml_parser_reload_check_range(yaml_document_t *document,
+        int first, int last, int low, int high)
+{
+    yaml_node_t *node;
+    yaml_node_item_t *item;
+    yaml_node_pair_t *pair;
+    int index, inside;
+
+#define IN_RANGE(id)    ((id) >= low && (id) < high)
+
+    for (node = document->nodes.start; node < document->nodes.top; node ++)
+    {
+        index = node - document->nodes.start + 1;
+        inside = IN_RANGE(index);
+
+        if (node->type == YAML_SEQUENCE_NODE) {
+            for (item = node->data.sequence.items.start;
+                    item < node->data.sequence.items.top; item ++) {
+                if (IN_RANGE(*item) != inside)
+                    return 0;
+            }
+        }
+
+        if (node->type == YAML_MAPPING_NODE) {
+            for (pair = node->data.mapping.pairs.start;
+                    pair < node->data.mapping.pairs.top; pair ++) {
+                if (index == 1) {
+                    inside = (pair - node->data.mapping.pairs.start >= first
+                            && pair - node->data.mapping.pairs.start <= last);
+                }
+                if (IN_RANGE(pair->key) != inside
+                        || IN_RANGE(pair->value) != inside)
+                    return 0;
+            }
+        }
+    }
+
+#undef IN_RANGE
+
+    return 1;
+}
+
+/*
+ * Convert a character offset into a byte offset of a UTF-8 buffer.
+ */
+
+static int
+yaml_parser_reload_offset(const unsigned char *input, size_t size,
+        size_t offset, size_t *pointer, size_t *count)
+{
+    while (*count < offset) {
+        if (*pointer >= size)
+            return 0;
+        (*pointer) ++;
+        while (*pointer < size && (input[*pointer] & 0xC0) == 0x80) {
+            (*pointer) ++;
+        }
+        (*count) ++;
+    }
+
+    return 1;
+}
+
+/*
+ * Move a mark that points to the first reloaded token or follows the reloaded
+ * lines.
+ */
+
+static void
+yaml_parser_reload_shift_mark(yaml_mark_t *mark,
+        yaml_mark_t old_start, yaml_mark_t new_start,
+        yaml_mark_t old_end, yaml_mark_t new_end)
+{
+    if (mark->index == old_start.index) {
+        *mark = new_start;
+        return;
+    }
+
+    if (mark->index < old_end.index)
+        return;
+
+    if (mark->line == old_end.line) {
+        mark->column = mark->column - old_end.column + new_end.column;
+    }
+    mark->line = mark->line - old_end.line + new_end.line;
+    mark->index = mark->index - old_end.index + new_end.index;
+}
+
+/*
+ * Reload the top-level pairs affected by an edit.  Return 0 if the edit
+ * cannot be handled this way.
+ */
+
+static int
+yaml_parser_reload_pairs(yaml_parser_t *parser, yaml_document_t *document,
+        const unsigned char *input, size_t size, const yaml_edit_t *edit)
+{
+    struct {
+        yaml_error_type_t error;
+    } context;
+    yaml_parser_t region_parser;
+    yaml_document_t region;
+    yaml_document_t rest;
+    yaml_node_t *root;
+    yaml_node_t *region_root;
+    yaml_node_t *node;
+    yaml_node_t *nodes;
+    yaml_node_item_t *item;
+    yaml_node_pair_t *pairs;
+    yaml_node_pair_t *pair;
+    yaml_mark_t start_mark, end_mark, new_start_mark, new_end_mark;
+    size_t start = 0, end = 0, chars = 0;
+    size_t capacity;
+    int count, first, last, low, high;
+    int node_count, old_count, new_count, pair_count, new_pair_count;
+    int shift, k;
+
+#define REMAP(id)   ((id) >= high ? (id) + shift : (id))
+
+    root = yaml_document_get_root_node(document);
+    if (!root || root->type != YAML_MAPPING_NODE
+            || root->data.mapping.style != YAML_BLOCK_MAPPING_STYLE)
+        return 0;
+
+    pairs = root->data.mapping.pairs.start;
+    count = root->data.mapping.pairs.top - pairs;
+    if (!count || edit->start > edit->end)
+        return 0;
+
+    /*
+     * Find the pairs covering the edit.  Text inserted before a key may end
+     * the value of the previous pair.
+     */
+
+    first = -1;
+    for (k = 0; k < count; k ++) {
+        node = document->nodes.start + pairs[k].key - 1;
+        if (node->start_mark.column != 0 || (k > 0 && node->start_mark.index
+                    <= document->nodes.start[pairs[k-1].key-1].start_mark.index))
+            return 0;
+        if (node->start_mark.index < edit->start
+                || (k == 0 && node->start_mark.index == edit->start)) {
+            first = k;
+        }
+    }
+    if (first < 0)
+        return 0;
+
+    for (last = first; last+1 < count; last ++) {
+        if (document->nodes.start[pairs[last+1].key-1].start_mark.index
+                >= edit->end)
+            break;
+    }
+
+    /*
+     * The lines of the last pairs run to the end of the input, so that the
+     * end marks of the root and of the document are found by loading them.
+     */
+
+    start_mark = document->nodes.start[pairs[first].key-1].start_mark;
+    end_mark = (last+1 < count) ?
+        document->nodes.start[pairs[last+1].key-1].start_mark
+        : document->end_mark;
+    if (last+1 < count && edit->end > end_mark.index)
+        return 0;
+
+    low = pairs[first].key;
+    high = (last+1 < count) ? pairs[last+1].key
+        : (int)(document->nodes.top - document->nodes.start) + 1;
+    if (low <= 1 || low >= high
+            || !yaml_parser_reload_check_range(document,
+                first, last, low, high))
+        return 0;
+
+    /* Locate the affected lines in the new input. */
+
+    if (size >= 3 && input[0] == 0xEF && input[1] == 0xBB && input[2] == 0xBF)
+        return 0;
+
+    if (!yaml_parser_reload_offset(input, size,
+                start_mark.index, &start, &chars))
+        return 0;
+    end = start;
+    if (last+1 == count) {
+        end = size;
+    }
+    else {
+        if (!yaml_parser_reload_offset(input, size,
+                    end_mark.index + edit->start + edit->length - edit->end,
+                    &end, &chars))
+            return 0;
+
+        /* The lines that follow must still start where they used to. */
+
+        if (input[end-1] != '\n' && input[end-1] != '\r')
+            return 0;
+    }
+
+    /* Anchors defined here could be referred to by the following lines. */
+
+    if (memchr(input+start, '&', end-start))
+        return 0;
+
+    /* Load the lines as a separate document. */
+
+    if (!yaml_parser_initialize(&region_parser))
+        return 0;
+    region_parser.resolve_scalars = parser->resolve_scalars;
+    region_parser.decode_binary = parser->decode_binary;
+    region_parser.dedup = parser->dedup;
+    region_parser.merge = parser->merge;
+    region_parser.source_spans = parser->source_spans;
+    yaml_parser_set_input_string(&region_parser, input+start, end-start);
+
+    if (!yaml_parser_load(&region_parser, &region)) {
+        yaml_parser_delete(&region_parser);
+        return 0;
+    }
+    if (!yaml_parser_load(&region_parser, &rest)) {
+        yaml_document_delete(&region);
+        yaml_parser_delete(&region_parser);
+        return 0;
+    }
+    new_end_mark = region_parser.mark;
+    yaml_parser_delete(&region_parser);
+
+    region_root = yaml_document_get_root_node(&region);
+    if (yaml_document_get_root_node(&rest) || !region_root
+            || region_root->type != YAML_MAPPING_NODE
+            || region_root->data.mapping.style != YAML_BLOCK_MAPPING_STYLE
+            || region_root->start_mark.column != 0
+            || !region.start_implicit || !region.end_implicit
+            || region.version_directive
+            || region.tag_directives.start != region.tag_directives.end)
+        goto error;
+    yaml_document_delete(&rest);
+
+    for (pair = region_root->data.mapping.pairs.start;
+            pair < region_root->data.mapping.pairs.top; pair ++) {
+        if (region.nodes.start[pair->key-1].start_mark.column != 0
+                || pair->key == 1 || pair->value == 1)
+            goto error;
+    }
+
+    if (last+1 == count) {
+        new_end_mark = region.end_mark;
+    }
+
+    new_start_mark = region_root->start_mark;
+    new_start_mark.index += start_mark.index;
+    new_start_mark.line += start_mark.line;
+    new_end_mark.index += start_mark.index;
+    new_end_mark.line += start_mark.line;
+
+    /* Reserve the space for the new nodes and pairs. */
+
+    node_count = document->nodes.top - document->nodes.start;
+    old_count = high - low;
+    new_count = (region.nodes.top - region.nodes.start) - 1;
+    shift = new_count - old_count;
+
+    capacity = document->nodes.end - document->nodes.start;
+    if ((size_t)(node_count + shift) > capacity) {
+        nodes = yaml_realloc(document->nodes.start,
+                (node_count + shift)*sizeof(yaml_node_t));
+        if (!nodes)
+            goto error;
+        document->nodes.start = nodes;
+        document->nodes.top = nodes + node_count;
+        document->nodes.end = nodes + node_count + shift;
+        root = document->nodes.start;
+    }
+
+    pair_count = region_root->data.mapping.pairs.top
+        - region_root->data.mapping.pairs.start;
+    new_pair_count = count - (last - first + 1) + pair_count;
+    capacity = root->data.mapping.pairs.end - root->data.mapping.pairs.start;
+    if ((size_t)new_pair_count > capacity) {
+        pairs = yaml_realloc(root->data.mapping.pairs.start,
+                new_pair_count*sizeof(yaml_node_pair_t));
+        if (!pairs)
+            goto error;
+        root->data.mapping.pairs.start = pairs;
+        root->data.mapping.pairs.top = pairs + count;
+        root->data.mapping.pairs.end = pairs + new_pair_count;
+    }
+
+    /* The document could have been loaded without a string pool. */
+
+    if (!STACK_EMPTY(&context, region.strings) && !document->strings.start) {
+        if (!STACK_INIT(&context, document->strings, yaml_char_t**))
+            goto error;
+    }
+
+    while (!STACK_EMPTY(&context, region.strings)) {
+        if (!PUSH(&context, document->strings, *(region.strings.top-1)))
+            goto error;
+        region.strings.top --;
+    }
+
+    /* Replace the nodes. */
+
+    yaml_document_clear_modified(document);
+
+    for (node = document->nodes.start + low - 1;
+            node < document->nodes.start + high - 1; node ++) {
+        yaml_parser_reload_free_node(node);
+    }
+
+    memmove(document->nodes.start + low - 1 + new_count,
+            document->nodes.start + high - 1,
+            (node_count - high + 1)*sizeof(yaml_node_t));
+    memcpy(document->nodes.start + low - 1, region.nodes.start + 1,
+            new_count*sizeof(yaml_node_t));
+    document->nodes.top += shift;
+
+    for (node = document->nodes.start;
+            node < document->nodes.top; node ++)
+    {
+        int inserted = (node >= document->nodes.start + low - 1
+                && node < document->nodes.start + low - 1 + new_count);
+
+        if (inserted) {
+            node->start_mark.index += start_mark.index;
+            node->start_mark.line += start_mark.line;
+            node->end_mark.index += start_mark.index;
+            node->end_mark.line += start_mark.line;
+        }
+        else {
+            yaml_parser_reload_shift_mark(&node->start_mark,
+                    start_mark, new_start_mark, end_mark, new_end_mark);
+            yaml_parser_reload_shift_mark(&node->end_mark,
+                    start_mark, new_start_mark, end_mark, new_end_mark);
+        }
+
+        if (node->type == YAML_SEQUENCE_NODE) {
+            for (item = node->data.sequence.items.start;
+                    item < node->data.sequence.items.top; item ++) {
+                *item = inserted ? *item + low - 2 : REMAP(*item);
+            }
+        }
+
+        if (node->type == YAML_MAPPING_NODE && node != document->nodes.start) {
+            for (pair = node->data.mapping.pairs.start;
+                    pair < node->data.mapping.pairs.top; pair ++) {
+                pair->key = inserted ? pair->key + low - 2 : REMAP(pair->key);
+                pair->value = inserted ? pair->value + low - 2
+                    : REMAP(pair->value);
+            }
+        }
+    }
+
+    /* Replace the pairs of the root. */
+
+    pairs = root->data.mapping.pairs.start;
+    memmove(pairs + first + pair_count, pairs + last + 1,
+            (count - last - 1)*sizeof(yaml_node_pair_t));
+    for (k = 0; k < pair_count; k ++) {
+        pairs[first+k].key =
+            region_root->data.mapping.pairs.start[k].key + low - 2;
+        pairs[first+k].value =
+            region_root->data.mapping.pairs.start[k].value + low - 2;
+    }
+    for (k = first + pair_count; k < new_pair_count; k ++) {
+        pairs[k].key = REMAP(pairs[k].key);
+        pairs[k].value = REMAP(pairs[k].value);
+    }
+    root->data.mapping.pairs.top = pairs + new_pair_count;
+
+    if (last+1 == count) {
+        root->end_mark = region_root->end_mark;
+        root->end_mark.index += start_mark.index;
+        root->end_mark.line += start_mark.line;
+    }
+
+    yaml_parser_reload_shift_mark(&document->start_mark,
+            start_mark, new_start_mark, end_mark, new_end_mark);
+    yaml_parser_reload_shift_mark(&document->end_mark,
+            start_mark, new_start_mark, end_mark, new_end_mark);
+    yaml_document_drop_hashes(document);
+
+    /* Only the root of the loaded lines is left to be freed. */
+
+    region.nodes.top = region.nodes.start + 1;
+    yaml_document_delete(&region);
+
+#undef REMAP
+
     return 1;
-}
\ No newline at end of file
+
+error:
+    yaml_document_delete(&region);
+    yaml_document_delete(&rest);
+
+    return 0;
+}
+
+/*
+ * Reload a document after its input has been edited.
+ */
+
+YAML_DECLARE(int)
+yaml_parser_reload(yaml_parser_t *parser, yaml_document_t *document,
+        const unsigned char *input, size_t size, const yaml_edit_t *edit)
+{
+    yaml_document_t reloaded;
+
+    assert(parser);     /* Non-NULL parser object is expected. */
+    assert(document);   /* Non-NULL document object is expected. */
+    assert(input);      /* Non-NULL input string is expected. */
+    assert(edit);       /* Non-NULL edit object is expected. */
+    assert(!parser->read_handler);  /* You can set the source only once. */
+
+    /* Materialized merges do not keep the pairs in the input order. */
+
+    if (parser->merge != YAML_MERGE_MATERIALIZE
+            && yaml_parser_reload_pairs(parser, document, input, size, edit))
+        return 1;
+
+    yaml_parser_set_input_string(parser, input, size);
+
+    if (!yaml_parser_load(parser, &reloaded))
+        return 0;
+
+    yaml_document_delete(document);
+    *document = reloaded;
+
+    return 1;
+}
@@ -150,6 +150,9 @@ static int
 yaml_parser_parse_flow_mapping_value(yaml_parser_t *parser,
         yaml_event_t *event, int empty);
 
+static int
+yaml_parser_parse_scalar_chunk(yaml_parser_t *parser, yaml_event_t *event);
+
 /*
  * Utility functions.
  */
@@ -168,6 +171,22 @@ static int
 yaml_parser_append_tag_directive(yaml_parser_t *parser,
         yaml_tag_directive_t value, int allow_duplicates, yaml_mark_t mark);
 
+/*
+ * Error recovery.
+ */
+
+static int
+yaml_parser_recover_event(yaml_parser_t *parser, yaml_event_t *event);
+
+static int
+yaml_parser_recover(yaml_parser_t *parser);
+
+static int
+yaml_parser_close_nodes(yaml_parser_t *parser, yaml_event_t *event);
+
+static int
+yaml_parser_track_event(yaml_parser_t *parser, yaml_event_t *event);
+
 YAML_DECLARE(void)
 yaml_set_max_nest_level(int max)
 {
@@ -195,9 +214,28 @@ yaml_parser_parse(yaml_parser_t *parser, yaml_event_t *event)
         return 1;
     }
 
+    /* Replay the events of an expanded alias. */
+
+    if (!STACK_EMPTY(parser, parser->expansion_frames)) {
+        return yaml_parser_replay_event(parser, event);
+    }
+
     /* Generate the next event. */
 
-    return yaml_parser_state_machine(parser, event);
+    if (parser->recover_errors) {
+        if (!yaml_parser_recover_event(parser, event))
+            return 0;
+    }
+    else if (!yaml_parser_state_machine(parser, event))
+        return 0;
+
+    /* Record the anchored nodes and expand the aliases. */
+
+    if (parser->expand_aliases) {
+        return yaml_parser_expand_event(parser, event);
+    }
+
+    return 1;
 }
 
 /*
@@ -316,6 +354,9 @@ yaml_parser_state_machine(yaml_parser_t *parser, yaml_event_t *event)
         case YAML_PARSE_FLOW_MAPPING_EMPTY_VALUE_STATE:
             return yaml_parser_parse_flow_mapping_value(parser, event, 1);
 
+        case YAML_PARSE_SCALAR_CHUNK_STATE:
+            return yaml_parser_parse_scalar_chunk(parser, event);
+
         default:
             assert(1);      /* Invalid state. */
     }
@@ -657,7 +698,8 @@ yaml_parser_parse_node(yaml_parser_t *parser, yaml_event_t *event,
             return 1;
         }
         else {
-            if (token->type == YAML_SCALAR_TOKEN) {
+            if (token->type == YAML_SCALAR_TOKEN
+                    || token->type == YAML_SCALAR_CHUNK_TOKEN) {
                 int plain_implicit = 0;
                 int quoted_implicit = 0;
                 end_mark = token->end_mark;
@@ -668,6 +710,14 @@ yaml_parser_parse_node(yaml_parser_t *parser, yaml_event_t *event,
                 else if (!tag) {
                     quoted_implicit = 1;
                 }
+                if (token->type == YAML_SCALAR_CHUNK_TOKEN) {
+                    parser->state = YAML_PARSE_SCALAR_CHUNK_STATE;
+                    SCALAR_START_EVENT_INIT(*event, anchor, tag,
+                            plain_implicit, quoted_implicit,
+                            token->data.scalar.style,
+                            start_mark, token->start_mark);
+                    return 1;
+                }
                 parser->state = POP(parser, parser->states);
                 SCALAR_EVENT_INIT(*event, anchor, tag,
                         token->data.scalar.value, token->data.scalar.length,
@@ -1239,6 +1289,43 @@ yaml_parser_parse_flow_mapping_value(yaml_parser_t *parser,
     return yaml_parser_process_empty_scalar(parser, event, token->start_mark);
 }
 
+/*
+ * Parse the chunks of a scalar:
+ * scalar   ::= SCALAR-CHUNK+ SCALAR
+ *              ************* ******
+ *
+ * The last SCALAR token holds the rest of the value.
+ */
+
+static int
+yaml_parser_parse_scalar_chunk(yaml_parser_t *parser, yaml_event_t *event)
+{
+    yaml_token_t *token;
+
+    token = PEEK_TOKEN(parser);
+    if (!token) return 0;
+
+    if (token->data.scalar.length) {
+        SCALAR_CHUNK_EVENT_INIT(*event, token->data.scalar.value,
+                token->data.scalar.length, token->start_mark, token->end_mark);
+        if (token->type == YAML_SCALAR_CHUNK_TOKEN) {
+            SKIP_TOKEN(parser);
+        }
+        else {
+            /* The value is given away, and SCALAR-END follows. */
+            token->data.scalar.value = NULL;
+            token->data.scalar.length = 0;
+        }
+        return 1;
+    }
+
+    parser->state = POP(parser, parser->states);
+    SCALAR_END_EVENT_INIT(*event, token->end_mark, token->end_mark);
+    yaml_free(token->data.scalar.value);
+    SKIP_TOKEN(parser);
+    return 1;
+}
+
 /*
  * Generate an empty scalar event.
  */
@@ -1414,3 +1501,300 @@ error:
     return 0;
 }
 
+/*
+ * Generate the next event, recovering from the syntax errors.
+ */
+
+static int
+yaml_parser_recover_event(yaml_parser_t *parser, yaml_event_t *event)
+{
+    while (1)
+    {
+        /* Complete the nodes cut off by the last error. */
+
+        if (parser->recovery_closing) {
+            if (!yaml_parser_close_nodes(parser, event))
+                return 0;
+            if (event->type != YAML_NO_EVENT)
+                break;
+        }
+
+        if (yaml_parser_state_machine(parser, event))
+            break;
+
+        if (!yaml_parser_recover(parser))
+            return 0;
+    }
+
+    return yaml_parser_track_event(parser, event);
+}
+
+/*
+ * Record the error and skip the input to the next line that belongs to an
+ * open block collection, or to the next document.
+ */
+
+static int
+yaml_parser_recover(yaml_parser_t *parser)
+{
+    yaml_parser_error_t error;
+    yaml_recovery_node_t *node;
+    ptrdiff_t column = -1;
+    size_t index = parser->mark.index;
+    int stuck, boundary, entry;
+
+    /* Only the syntax errors are recovered. */
+
+    if ((parser->error != YAML_SCANNER_ERROR
+                && parser->error != YAML_PARSER_ERROR)
+            || parser->state == YAML_PARSE_STREAM_START_STATE)
+        return 0;
+
+    /*
+     * If the input has not advanced since the last error, the line where the
+     * parser resumed is skipped as well.
+     */
+
+    stuck = (!STACK_EMPTY(parser, parser->errors)
+            && index == parser->recovery_mark.index);
+
+    if (!parser->errors.start
+            && !STACK_INIT(parser, parser->errors, yaml_parser_error_t*))
+        return 0;
+
+    error.type = parser->error;
+    error.problem = parser->problem;
+    error.problem_mark = parser->problem_mark;
+    error.context = parser->context;
+    error.context_mark = parser->context_mark;
+
+    if (!PUSH(parser, parser->errors, error))
+        return 0;
+
+    parser->error = YAML_NO_ERROR;
+    parser->problem = NULL;
+    parser->context = NULL;
+
+    /* Find the indentation of the innermost block collection. */
+
+    for (node = parser->recovery_nodes.top;
+            node != parser->recovery_nodes.start; node --) {
+        if (!node[-1].flow) {
+            column = node[-1].column;
+            break;
+        }
+    }
+
+    if (!yaml_parser_resync(parser, column, stuck, &boundary, &entry))
+        return 0;
+
+    /* Give up at the end of the stream. */
+
+    if (stuck && parser->mark.index == index) {
+        parser->error = error.type;
+        parser->problem = error.problem;
+        parser->context = error.context;
+        (void)POP(parser, parser->errors);
+        return 0;
+    }
+
+    parser->recovery_mark = parser->mark;
+
+    /*
+     * Keep the block collections that the line belongs to, and restore their
+     * indentation levels.  A sequence at the column of the line is kept only
+     * if the line starts with an entry.
+     */
+
+    parser->recovery_keep = 0;
+    parser->indents.top = parser->indents.start;
+    parser->indent = -1;
+
+    if (!boundary)
+    {
+        for (node = parser->recovery_nodes.start;
+                node != parser->recovery_nodes.top; node ++)
+        {
+            if (node->flow || (size_t)node->column > parser->mark.column
+                    || (node->type == YAML_SEQUENCE_START_EVENT
+                        && (size_t)node->column == parser->mark.column
+                        && !entry))
+                break;
+
+            if (!node->indentless) {
+                if (!PUSH(parser, parser->indents, parser->indent))
+                    return 0;
+                parser->indent = node->column;
+            }
+
+            parser->recovery_keep ++;
+        }
+    }
+
+    parser->recovery_closing = 1;
+
+    return 1;
+}
+
+/*
+ * Produce the events that complete the nodes cut off by an error.  When they
+ * are done, leave the event empty and continue with the innermost kept
+ * collection.
+ */
+
+static int
+yaml_parser_close_nodes(yaml_parser_t *parser, yaml_event_t *event)
+{
+    yaml_recovery_node_t *node = parser->recovery_nodes.top - 1;
+    size_t count = parser->recovery_nodes.top - parser->recovery_nodes.start;
+    yaml_mark_t mark = parser->recovery_mark;
+
+    if (count)
+    {
+        /* Give a pending key an empty value. */
+
+        if (node->type == YAML_MAPPING_START_EVENT && node->children % 2)
+            return yaml_parser_process_empty_scalar(parser, event, mark);
+
+        /* End the nodes above the kept ones. */
+
+        if (count > parser->recovery_keep) {
+            if (node->type == YAML_SEQUENCE_START_EVENT) {
+                SEQUENCE_END_EVENT_INIT(*event, mark, mark);
+            }
+            else if (node->type == YAML_MAPPING_START_EVENT) {
+                MAPPING_END_EVENT_INIT(*event, mark, mark);
+            }
+            else {
+                SCALAR_END_EVENT_INIT(*event, mark, mark);
+            }
+            return 1;
+        }
+
+        /* Expect the next entry of the innermost kept collection. */
+
+        parser->states.top = parser->states.start + node->states;
+        parser->marks.top = parser->marks.start + node->marks;
+
+        if (node->indentless) {
+            parser->state = YAML_PARSE_INDENTLESS_SEQUENCE_ENTRY_STATE;
+        }
+        else {
+            if (!PUSH(parser, parser->marks, node->mark))
+                return 0;
+            parser->state = (node->type == YAML_SEQUENCE_START_EVENT)
+                ? YAML_PARSE_BLOCK_SEQUENCE_ENTRY_STATE
+                : YAML_PARSE_BLOCK_MAPPING_KEY_STATE;
+        }
+    }
+
+    else if (parser->recovery_states)
+    {
+        /* Give the document an empty root node and expect its end. */
+
+        if (!parser->recovery_root)
+            return yaml_parser_process_empty_scalar(parser, event, mark);
+
+        parser->states.top = parser->states.start
+            + parser->recovery_states - 1;
+        parser->state = YAML_PARSE_DOCUMENT_END_STATE;
+    }
+
+    else
+    {
+        /* Forget the directives and expect the next document. */
+
+        while (!STACK_EMPTY(parser, parser->tag_directives)) {
+            yaml_tag_directive_t tag_directive = POP(parser, parser->tag_directives);
+            yaml_free(tag_directive.handle);
+            yaml_free(tag_directive.prefix);
+        }
+
+        parser->states.top = parser->states.start;
+        parser->state = YAML_PARSE_DOCUMENT_START_STATE;
+    }
+
+    parser->recovery_closing = 0;
+
+    return 1;
+}
+
+/*
+ * Follow the open nodes of the current document.
+ */
+
+static int
+yaml_parser_track_event(yaml_parser_t *parser, yaml_event_t *event)
+{
+    yaml_recovery_node_t node;
+
+    if (!parser->recovery_nodes.start
+            && !STACK_INIT(parser, parser->recovery_nodes,
+                yaml_recovery_node_t*))
+        goto error;
+
+    switch (event->type)
+    {
+        case YAML_DOCUMENT_START_EVENT:
+            parser->recovery_states = parser->states.top - parser->states.start;
+            parser->recovery_root = 0;
+            return 1;
+
+        case YAML_DOCUMENT_END_EVENT:
+            parser->recovery_states = 0;
+            return 1;
+
+        case YAML_SEQUENCE_START_EVENT:
+        case YAML_MAPPING_START_EVENT:
+        case YAML_SCALAR_START_EVENT:
+            memset(&node, 0, sizeof(node));
+            node.type = event->type;
+            node.flow = (event->type == YAML_SCALAR_START_EVENT
+                    || (event->type == YAML_SEQUENCE_START_EVENT
+                        && event->data.sequence_start.style
+                            == YAML_FLOW_SEQUENCE_STYLE)
+                    || (event->type == YAML_MAPPING_START_EVENT
+                        && event->data.mapping_start.style
+                            == YAML_FLOW_MAPPING_STYLE));
+            node.indentless = (parser->state
+                    == YAML_PARSE_INDENTLESS_SEQUENCE_ENTRY_STATE);
+            node.column = (node.indentless
+                    && !STACK_EMPTY(parser, parser->recovery_nodes))
+                ? parser->recovery_nodes.top[-1].column
+                : (int)event->end_mark.column;
+            node.mark = event->end_mark;
+            node.states = parser->states.top - parser->states.start;
+            node.marks = parser->marks.top - parser->marks.start;
+            if (!PUSH(parser, parser->recovery_nodes, node))
+                goto error;
+            return 1;
+
+        case YAML_SEQUENCE_END_EVENT:
+        case YAML_MAPPING_END_EVENT:
+        case YAML_SCALAR_END_EVENT:
+            (void)POP(parser, parser->recovery_nodes);
+            break;
+
+        case YAML_SCALAR_EVENT:
+        case YAML_ALIAS_EVENT:
+            break;
+
+        default:
+            return 1;
+    }
+
+    /* Count the completed node. */
+
+    if (!STACK_EMPTY(parser, parser->recovery_nodes)) {
+        parser->recovery_nodes.top[-1].children ++;
+    }
+    else {
+        parser->recovery_root = 1;
+    }
+
+    return 1;
+
+error:
+    yaml_event_delete(event);
+    return 0;
+}
@@ -199,6 +199,27 @@ yaml_parser_update_buffer(yaml_parser_t *parser, size_t length)
             size_t k;
             size_t raw_unread = parser->raw_buffer.last - parser->raw_buffer.pointer;
 
+            /* Copy a run of printable ASCII characters of UTF-8 input as is. */
+
+            if (parser->encoding == YAML_UTF8_ENCODING) {
+                const unsigned char *run = parser->raw_buffer.pointer;
+
+                while (run != parser->raw_buffer.last
+                        && ((*run >= 0x20 && *run <= 0x7E)
+                            || *run == '\n' || *run == '\r' || *run == '\t'))
+                    run ++;
+
+                if (run != parser->raw_buffer.pointer) {
+                    size_t size = run - parser->raw_buffer.pointer;
+                    memcpy(parser->buffer.last, parser->raw_buffer.pointer, size);
+                    parser->buffer.last += size;
+                    parser->raw_buffer.pointer += size;
+                    parser->offset += size;
+                    parser->unread += size;
+                    continue;
+                }
+            }
+
             /* Decode the next character. */
 
             switch (parser->encoding)
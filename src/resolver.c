@@ -0,0 +1,1138 @@
+
+#include "yaml_private.h"
+
+#include <math.h>
+
+/*
+ * Resolve scalars according to the YAML 1.2 core schema:
+ *
+ *      null    ~ | null | Null | NULL | <empty>
+ *      bool    true | True | TRUE | false | False | FALSE
+ *      int     [-+]?[0-9]+ | 0o[0-7]+ | 0x[0-9a-fA-F]+
+ *      float   [-+]?(\.[0-9]+|[0-9]+(\.[0-9]*)?)([eE][-+]?[0-9]+)?
+ *            | [-+]?\.(inf|Inf|INF) | \.nan | \.NaN | \.NAN
+ *
+ * Anything else is a string.
+ */
+
+/*
+ * Character classes.
+ */
+
+#define CLASS_DEC   0x01
+#define CLASS_HEX   0x02
+#define CLASS_OCT   0x04
+#define CLASS_NUM   0x08
+#define CLASS_WORD  0x10
+
+static const unsigned char yaml_resolve_classes[256] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x08, 0x08, 0x00,
+    0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0B, 0x0B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x02, 0x02, 0x02, 0x02, 0x02, 0x12, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x02, 0x02, 0x02, 0x02, 0x02, 0x12, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+#define IS_CLASS(pointer,class)                                                 \
+    (yaml_resolve_classes[*(pointer)] & (class))
+
+/*
+ * The values of base64 digits.  Spaces and line breaks are marked with
+ * BASE64_SPACE, the padding character with BASE64_PAD, and anything else
+ * with BASE64_INVALID.  A digit has none of the bits of BASE64_SPECIAL.
+ */
+
+#define BASE64_SPACE    0x40
+#define BASE64_PAD      0x41
+#define BASE64_INVALID  0x80
+#define BASE64_SPECIAL  0xC0
+
+static const unsigned char yaml_base64_values[256] = {
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x40, 0x40, 0x80, 0x80, 0x40, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x40, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x3E, 0x80, 0x80, 0x80, 0x3F,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x80, 0x80, 0x80, 0x41, 0x80, 0x80,
+    0x80, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+};
+
+/*
+ * Exactly representable powers of ten.
+ */
+
+static const double yaml_resolve_powers[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/*
+ * The largest integer such that every smaller integer is exactly
+ * representable as a double.
+ */
+
+#define MAX_EXACT_MANTISSA  ((uint64_t)1 << 53)
+
+/*
+ * The number of decimal digits that always fit in a 64-bit integer.
+ */
+
+#define MAX_MANTISSA_DIGITS 19
+
+/*
+ * A decimal number 0.d1d2...dn * 10^point for the exact conversion.  Only the
+ * leading digits are kept and `truncated` tells if any of the dropped ones is
+ * not zero.  A halfway point between two doubles never has more digits.
+ */
+
+#define MAX_DECIMAL_DIGITS  800
+
+typedef struct {
+    unsigned char digits[MAX_DECIMAL_DIGITS];
+    int count;
+    int point;
+    int truncated;
+} yaml_decimal_t;
+
+/*
+ * The largest binary shift of a decimal that cannot overflow 64 bits.
+ */
+
+#define MAX_DECIMAL_SHIFT   60
+
+/*
+ * Private functions.
+ */
+
+static int
+yaml_resolve_match(const yaml_char_t *value, size_t length, const char *word);
+
+static yaml_scalar_type_t
+yaml_resolve_word(const yaml_char_t *value, size_t length,
+        yaml_resolved_value_t *resolved);
+
+static yaml_scalar_type_t
+yaml_resolve_radix(const yaml_char_t *pointer, const yaml_char_t *end,
+        int shift, int class, yaml_resolved_value_t *resolved);
+
+static void
+yaml_decimal_append(yaml_decimal_t *decimal, int digit);
+
+static void
+yaml_decimal_trim(yaml_decimal_t *decimal);
+
+static void
+yaml_decimal_shift_right(yaml_decimal_t *decimal, int shift);
+
+static void
+yaml_decimal_shift_left(yaml_decimal_t *decimal, int shift);
+
+static void
+yaml_decimal_shift(yaml_decimal_t *decimal, int shift);
+
+static uint64_t
+yaml_decimal_round(yaml_decimal_t *decimal);
+
+static double
+yaml_decimal_to_real(yaml_decimal_t *decimal);
+
+static double
+yaml_resolve_decimal(const yaml_char_t *value, size_t length);
+
+static int
+yaml_resolve_number(const yaml_char_t *value, size_t length,
+        yaml_scalar_type_t *type, yaml_resolved_value_t *resolved);
+
+/*
+ * Check if the value is one of the spellings of a word: "word", "Word", or
+ * "WORD".
+ */
+
+static int
+yaml_resolve_match(const yaml_char_t *value, size_t length, const char *word)
+{
+    size_t k;
+    int upper;
+
+    if (strlen(word) != length)
+        return 0;
+
+    if (value[0] != word[0] && value[0] != word[0] - 'a' + 'A')
+        return 0;
+
+    upper = (length > 1 && value[1] >= 'A' && value[1] <= 'Z'
+            && value[0] != word[0]);
+
+    for (k = 1; k < length; k ++) {
+        if (value[k] != (upper ? word[k] - 'a' + 'A' : word[k]))
+            return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Resolve the null and boolean words.
+ */
+
+static yaml_scalar_type_t
+yaml_resolve_word(const yaml_char_t *value, size_t length,
+        yaml_resolved_value_t *resolved)
+{
+    switch (value[0])
+    {
+        case '~':
+            if (length == 1)
+                return YAML_NULL_SCALAR_TYPE;
+            break;
+
+        case 'n': case 'N':
+            if (yaml_resolve_match(value, length, "null"))
+                return YAML_NULL_SCALAR_TYPE;
+            break;
+
+        case 't': case 'T':
+            if (yaml_resolve_match(value, length, "true")) {
+                resolved->boolean = 1;
+                return YAML_BOOL_SCALAR_TYPE;
+            }
+            break;
+
+        case 'f': case 'F':
+            if (yaml_resolve_match(value, length, "false")) {
+                resolved->boolean = 0;
+                return YAML_BOOL_SCALAR_TYPE;
+            }
+            break;
+    }
+
+    return YAML_STR_SCALAR_TYPE;
+}
+
+/*
+ * Resolve an octal or a hexadecimal integer.  Integers that do not fit into
+ * 64 bits are resolved as floats.
+ */
+
+static yaml_scalar_type_t
+yaml_resolve_radix(const yaml_char_t *pointer, const yaml_char_t *end,
+        int shift, int class, yaml_resolved_value_t *resolved)
+{
+    uint64_t integer = 0;
+    double real = 0.0;
+    int overflow = 0;
+
+    if (pointer == end)
+        return YAML_STR_SCALAR_TYPE;
+
+    while (pointer != end)
+    {
+        int digit;
+
+        if (!IS_CLASS(pointer, class))
+            return YAML_STR_SCALAR_TYPE;
+
+        digit = (*pointer <= '9') ? *pointer - '0' :
+            (*pointer & 0x0F) + 9;
+
+        if (integer >> (63 - shift))
+            overflow = 1;
+
+        integer = (integer << shift) | digit;
+        real = real * (1 << shift) + digit;
+        pointer ++;
+    }
+
+    if (overflow) {
+        resolved->real = real;
+        return YAML_FLOAT_SCALAR_TYPE;
+    }
+
+    resolved->integer = (int64_t)integer;
+    return YAML_INT_SCALAR_TYPE;
+}
+
+/*
+ * Append a digit to a decimal.  Leading zeros only move the decimal point.
+ */
+
+static void
+yaml_decimal_append(yaml_decimal_t *decimal, int digit)
+{
+    if (!decimal->count && !digit) {
+        decimal->point --;
+        return;
+    }
+
+    if (decimal->count < MAX_DECIMAL_DIGITS) {
+        decimal->digits[decimal->count++] = (unsigned char)digit;
+    }
+    else if (digit) {
+        decimal->truncated = 1;
+    }
+}
+
+/*
+ * Drop the trailing zeros of a decimal.
+ */
+
+static void
+yaml_decimal_trim(yaml_decimal_t *decimal)
+{
+    while (decimal->count && !decimal->digits[decimal->count-1])
+        decimal->count --;
+
+    if (!decimal->count)
+        decimal->point = 0;
+}
+
+/*
+ * Divide a decimal by 2^shift.
+ */
+
+static void
+yaml_decimal_shift_right(yaml_decimal_t *decimal, int shift)
+{
+    uint64_t mask = ((uint64_t)1 << shift) - 1;
+    uint64_t number = 0;
+    int read = 0, write = 0;
+
+    /* Take enough leading digits to produce the first digit. */
+
+    for (; !(number >> shift); read ++)
+    {
+        if (read >= decimal->count) {
+            if (!number) {
+                decimal->count = 0;
+                return;
+            }
+            while (!(number >> shift)) {
+                number *= 10;
+                read ++;
+            }
+            break;
+        }
+        number = number * 10 + decimal->digits[read];
+    }
+
+    decimal->point -= read - 1;
+
+    for (; read < decimal->count; read ++) {
+        decimal->digits[write++] = (unsigned char)(number >> shift);
+        number = (number & mask) * 10 + decimal->digits[read];
+    }
+
+    while (number) {
+        if (write < MAX_DECIMAL_DIGITS) {
+            decimal->digits[write++] = (unsigned char)(number >> shift);
+        }
+        else if (number >> shift) {
+            decimal->truncated = 1;
+        }
+        number = (number & mask) * 10;
+    }
+
+    decimal->count = write;
+    yaml_decimal_trim(decimal);
+}
+
+/*
+ * Multiply a decimal by 2^shift.
+ */
+
+static void
+yaml_decimal_shift_left(yaml_decimal_t *decimal, int shift)
+{
+    unsigned char buffer[MAX_DECIMAL_DIGITS + 20];
+    uint64_t number = 0;
+    int write = sizeof(buffer);
+    int read, count;
+
+    for (read = decimal->count - 1; read >= 0; read --) {
+        number += (uint64_t)decimal->digits[read] << shift;
+        buffer[--write] = (unsigned char)(number % 10);
+        number /= 10;
+    }
+
+    while (number) {
+        buffer[--write] = (unsigned char)(number % 10);
+        number /= 10;
+    }
+
+    count = sizeof(buffer) - write;
+    decimal->point += count - decimal->count;
+
+    if (count > MAX_DECIMAL_DIGITS) {
+        for (read = write + MAX_DECIMAL_DIGITS; read < (int)sizeof(buffer);
+                read ++) {
+            if (buffer[read])
+                decimal->truncated = 1;
+        }
+        count = MAX_DECIMAL_DIGITS;
+    }
+
+    memcpy(decimal->digits, buffer + write, count);
+    decimal->count = count;
+    yaml_decimal_trim(decimal);
+}
+
+/*
+ * Multiply a decimal by 2^shift, or divide it if the shift is negative.
+ */
+
+static void
+yaml_decimal_shift(yaml_decimal_t *decimal, int shift)
+{
+    if (!decimal->count)
+        return;
+
+    for (; shift > MAX_DECIMAL_SHIFT; shift -= MAX_DECIMAL_SHIFT)
+        yaml_decimal_shift_left(decimal, MAX_DECIMAL_SHIFT);
+    for (; shift < -MAX_DECIMAL_SHIFT; shift += MAX_DECIMAL_SHIFT)
+        yaml_decimal_shift_right(decimal, MAX_DECIMAL_SHIFT);
+
+    if (shift > 0) {
+        yaml_decimal_shift_left(decimal, shift);
+    }
+    else if (shift < 0) {
+        yaml_decimal_shift_right(decimal, -shift);
+    }
+}
+
+/*
+ * Round a decimal to an integer, with the ties to even.
+ */
+
+static uint64_t
+yaml_decimal_round(yaml_decimal_t *decimal)
+{
+    uint64_t number = 0;
+    int point = decimal->point;
+    int k;
+
+    for (k = 0; k < point; k ++)
+        number = number * 10 + (k < decimal->count ? decimal->digits[k] : 0);
+
+    if (point >= 0 && point < decimal->count) {
+        if (decimal->digits[point] == 5 && point+1 == decimal->count
+                && !decimal->truncated) {
+            number += (point > 0 && decimal->digits[point-1] % 2);
+        }
+        else {
+            number += (decimal->digits[point] >= 5);
+        }
+    }
+
+    return number;
+}
+
+/*
+ * Convert a decimal to the nearest double.
+ *
+ * The decimal is scaled by powers of two until it is in [1/2, 1) and its
+ * leading 53 bits are then rounded.  Each shift is exact up to the digits
+ * kept, so the result is correctly rounded regardless of the locale or the C
+ * library.  The decimal is modified.
+ */
+
+static double
+yaml_decimal_to_real(yaml_decimal_t *decimal)
+{
+    /* The shifts that reduce the point by at least 1 for each point. */
+
+    static const int shifts[] = { 1, 3, 6, 9, 13, 16, 19, 23, 26 };
+    union { double real; uint64_t bits; } result;
+    uint64_t mantissa;
+    int exponent = 0;
+    int shift;
+
+    if (!decimal->count || decimal->point < -330)
+        return 0.0;
+
+    if (decimal->point > 310)
+        return HUGE_VAL;
+
+    while (decimal->point > 0) {
+        shift = (decimal->point < 9) ? shifts[decimal->point] : 27;
+        yaml_decimal_shift(decimal, -shift);
+        exponent += shift;
+    }
+
+    while (decimal->point < 0
+            || (decimal->point == 0 && decimal->digits[0] < 5)) {
+        shift = (-decimal->point < 9) ? shifts[-decimal->point] : 27;
+        yaml_decimal_shift(decimal, shift);
+        exponent -= shift;
+    }
+
+    /* The decimal is in [1/2, 1), and a normal double is in [1, 2). */
+
+    exponent --;
+
+    if (exponent < -1022) {
+        yaml_decimal_shift(decimal, exponent + 1022);
+        exponent = -1022;
+    }
+
+    if (exponent > 1023)
+        return HUGE_VAL;
+
+    yaml_decimal_shift(decimal, 53);
+    mantissa = yaml_decimal_round(decimal);
+
+    /* Rounding up could carry into the next power of two. */
+
+    if (mantissa == (uint64_t)2 << 52) {
+        mantissa >>= 1;
+        if (++ exponent > 1023)
+            return HUGE_VAL;
+    }
+
+    /* Subnormal values have no hidden bit. */
+
+    if (!(mantissa & ((uint64_t)1 << 52)))
+        exponent = -1023;
+
+    result.bits = (mantissa & (((uint64_t)1 << 52) - 1))
+        | ((uint64_t)(exponent + 1023) << 52);
+
+    return result.real;
+}
+
+/*
+ * Convert the absolute value of a number exactly.  The value is expected to
+ * be a valid core schema float or integer.
+ */
+
+static double
+yaml_resolve_decimal(const yaml_char_t *value, size_t length)
+{
+    yaml_decimal_t decimal;
+    const yaml_char_t *pointer = value;
+    const yaml_char_t *end = value + length;
+
+    decimal.count = 0;
+    decimal.point = 0;
+    decimal.truncated = 0;
+
+    if (*pointer == '+' || *pointer == '-')
+        pointer ++;
+
+    for (; pointer != end && IS_CLASS(pointer, CLASS_DEC); pointer ++) {
+        decimal.point ++;
+        yaml_decimal_append(&decimal, *pointer - '0');
+    }
+
+    if (pointer != end && *pointer == '.') {
+        for (pointer ++; pointer != end && IS_CLASS(pointer, CLASS_DEC);
+                pointer ++) {
+            yaml_decimal_append(&decimal, *pointer - '0');
+        }
+    }
+
+    if (pointer != end && (*pointer == 'e' || *pointer == 'E'))
+    {
+        int negative = 0;
+        int exponent = 0;
+
+        pointer ++;
+        if (*pointer == '+' || *pointer == '-') {
+            negative = (*pointer == '-');
+            pointer ++;
+        }
+
+        for (; pointer != end; pointer ++) {
+            if (exponent < 100000)
+                exponent = exponent * 10 + (*pointer - '0');
+        }
+
+        decimal.point += negative ? -exponent : exponent;
+    }
+
+    yaml_decimal_trim(&decimal);
+
+    return yaml_decimal_to_real(&decimal);
+}
+
+/*
+ * Convert the decimal digits of an integer multiplied by 10^exponent exactly.
+ */
+
+YAML_DECLARE(double)
+yaml_resolve_digits(const yaml_char_t *digits, size_t count, int exponent)
+{
+    yaml_decimal_t decimal;
+    size_t k;
+
+    decimal.count = 0;
+    decimal.point = (int)count + exponent;
+    decimal.truncated = 0;
+
+    for (k = 0; k < count; k ++)
+        yaml_decimal_append(&decimal, digits[k] - '0');
+
+    yaml_decimal_trim(&decimal);
+
+    return yaml_decimal_to_real(&decimal);
+}
+
+/*
+ * Resolve a number.
+ *
+ * The decimal digits are accumulated in a single pass.  If the mantissa and
+ * the power of ten are both exactly representable, the result of a single
+ * floating point operation is correctly rounded (Clinger's fast path).  The
+ * rare remaining cases are converted exactly with yaml_resolve_decimal().
+ */
+
+static int
+yaml_resolve_number(const yaml_char_t *value, size_t length,
+        yaml_scalar_type_t *type, yaml_resolved_value_t *resolved)
+{
+    const yaml_char_t *pointer = value;
+    const yaml_char_t *end = value + length;
+    int negative = 0;
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int truncated = 0;
+    int integer_digits = 0;
+    int fraction_digits = 0;
+    long exponent = 0;
+    int is_float = 0;
+    double real;
+
+    *type = YAML_STR_SCALAR_TYPE;
+
+    if (*pointer == '+' || *pointer == '-') {
+        negative = (*pointer == '-');
+        pointer ++;
+    }
+
+    if (pointer == end)
+        return 1;
+
+    /* Check for octal and hexadecimal integers. */
+
+    if (pointer == value && length > 2 && pointer[0] == '0') {
+        if (pointer[1] == 'o') {
+            *type = yaml_resolve_radix(pointer+2, end, 3, CLASS_OCT, resolved);
+            return 1;
+        }
+        if (pointer[1] == 'x') {
+            *type = yaml_resolve_radix(pointer+2, end, 4, CLASS_HEX, resolved);
+            return 1;
+        }
+    }
+
+    /* Check for infinity and not-a-number. */
+
+    if (*pointer == '.' && end - pointer == 4 && !IS_CLASS(pointer+1, CLASS_DEC))
+    {
+        if (yaml_resolve_match(pointer+1, 3, "inf")) {
+            resolved->real = negative ? -HUGE_VAL : HUGE_VAL;
+            *type = YAML_FLOAT_SCALAR_TYPE;
+        }
+        else if (pointer == value && (memcmp(pointer, ".nan", 4) == 0
+                    || memcmp(pointer, ".NaN", 4) == 0
+                    || memcmp(pointer, ".NAN", 4) == 0)) {
+            resolved->real = NAN;
+            *type = YAML_FLOAT_SCALAR_TYPE;
+        }
+        return 1;
+    }
+
+    /* Scan the integer part. */
+
+    while (pointer != end && IS_CLASS(pointer, CLASS_DEC))
+    {
+        if (digits < MAX_MANTISSA_DIGITS) {
+            mantissa = mantissa * 10 + (*pointer - '0');
+            if (mantissa) digits ++;
+        }
+        else {
+            exponent ++;
+            truncated = 1;
+        }
+        integer_digits ++;
+        pointer ++;
+    }
+
+    /* Scan the fractional part. */
+
+    if (pointer != end && *pointer == '.')
+    {
+        is_float = 1;
+        pointer ++;
+
+        while (pointer != end && IS_CLASS(pointer, CLASS_DEC))
+        {
+            if (digits < MAX_MANTISSA_DIGITS) {
+                mantissa = mantissa * 10 + (*pointer - '0');
+                if (mantissa) digits ++;
+                exponent --;
+            }
+            else {
+                truncated = 1;
+            }
+            fraction_digits ++;
+            pointer ++;
+        }
+    }
+
+    if (!integer_digits && !fraction_digits)
+        return 1;
+
+    /* Scan the exponent. */
+
+    if (pointer != end && (*pointer == 'e' || *pointer == 'E'))
+    {
+        int exponent_negative = 0;
+        long value_exponent = 0;
+
+        is_float = 1;
+        pointer ++;
+
+        if (pointer != end && (*pointer == '+' || *pointer == '-')) {
+            exponent_negative = (*pointer == '-');
+            pointer ++;
+        }
+
+        if (pointer == end)
+            return 1;
+
+        while (pointer != end && IS_CLASS(pointer, CLASS_DEC)) {
+            if (value_exponent < 100000)
+                value_exponent = value_exponent * 10 + (*pointer - '0');
+            pointer ++;
+        }
+
+        exponent += exponent_negative ? -value_exponent : value_exponent;
+    }
+
+    if (pointer != end)
+        return 1;
+
+    /* Produce an integer if it fits. */
+
+    if (!is_float && !truncated)
+    {
+        if (negative && mantissa <= (uint64_t)INT64_MAX + 1) {
+            resolved->integer = (int64_t)(0 - mantissa);
+            *type = YAML_INT_SCALAR_TYPE;
+            return 1;
+        }
+        if (!negative && mantissa <= (uint64_t)INT64_MAX) {
+            resolved->integer = (int64_t)mantissa;
+            *type = YAML_INT_SCALAR_TYPE;
+            return 1;
+        }
+    }
+
+    /* Produce a float. */
+
+    if (mantissa == 0) {
+        real = 0.0;
+    }
+    else if (!truncated && mantissa <= MAX_EXACT_MANTISSA
+            && exponent >= -22 && exponent <= 22 + 15)
+    {
+        if (exponent < 0) {
+            real = (double)mantissa / yaml_resolve_powers[-exponent];
+        }
+        else {
+            while (exponent > 22 && mantissa <= MAX_EXACT_MANTISSA) {
+                mantissa *= 10;
+                exponent --;
+            }
+            if (mantissa > MAX_EXACT_MANTISSA) {
+                real = yaml_resolve_decimal(value, length);
+            }
+            else {
+                real = (double)mantissa * yaml_resolve_powers[exponent];
+            }
+        }
+    }
+    else {
+        real = yaml_resolve_decimal(value, length);
+    }
+
+    resolved->real = negative ? -real : real;
+    *type = YAML_FLOAT_SCALAR_TYPE;
+
+    return 1;
+}
+
+/*
+ * Resolve a scalar.
+ *
+ * If `*type` is YAML_UNRESOLVED_SCALAR_TYPE, the scalar is resolved to any of
+ * the core schema types.  Otherwise, the scalar is only checked against the
+ * given type and `*type` is set to YAML_UNRESOLVED_SCALAR_TYPE if the scalar
+ * does not match.
+ */
+
+YAML_DECLARE(int)
+yaml_resolve_scalar(const yaml_char_t *value, size_t length,
+        yaml_scalar_type_t *type, yaml_resolved_value_t *resolved)
+{
+    yaml_scalar_type_t expected = *type;
+    yaml_scalar_type_t result = YAML_STR_SCALAR_TYPE;
+
+    assert(value || !length);   /* Non-NULL value is expected. */
+
+    if (expected == YAML_STR_SCALAR_TYPE) {
+        *type = YAML_STR_SCALAR_TYPE;
+        return 1;
+    }
+
+    if (!length) {
+        result = YAML_NULL_SCALAR_TYPE;
+    }
+    else if (IS_CLASS(value, CLASS_WORD)) {
+        result = yaml_resolve_word(value, length, resolved);
+    }
+    else if (IS_CLASS(value, CLASS_NUM)) {
+        if (!yaml_resolve_number(value, length, &result, resolved))
+            return 0;
+    }
+
+    if (expected == YAML_FLOAT_SCALAR_TYPE && result == YAML_INT_SCALAR_TYPE) {
+        resolved->real = (double)resolved->integer;
+        result = YAML_FLOAT_SCALAR_TYPE;
+    }
+
+    if (expected != YAML_UNRESOLVED_SCALAR_TYPE && expected != result) {
+        result = YAML_UNRESOLVED_SCALAR_TYPE;
+    }
+
+    *type = result;
+
+    return 1;
+}
+
+/*
+ * Decode the base64 text of a binary scalar in place.
+ *
+ * Spaces and line breaks are skipped and the final padding may be omitted.
+ * Eight digits are decoded at once while the text has no breaks, so that the
+ * lines of a block scalar are decoded with a single check per six octets.
+ */
+
+YAML_DECLARE(int)
+yaml_resolve_binary(yaml_char_t *value, size_t length, size_t *decoded)
+{
+    const yaml_char_t *pointer = value;
+    const yaml_char_t *end = value + length;
+    yaml_char_t *output = value;
+    uint32_t quantum = 0;
+    int digits = 0;
+    int padding = 0;
+
+    assert(value);      /* Non-NULL value is expected. */
+
+    while (pointer != end)
+    {
+        unsigned int digit;
+
+        if (!digits && end - pointer >= 8)
+        {
+            unsigned int a = yaml_base64_values[pointer[0]];
+            unsigned int b = yaml_base64_values[pointer[1]];
+            unsigned int c = yaml_base64_values[pointer[2]];
+            unsigned int d = yaml_base64_values[pointer[3]];
+            unsigned int e = yaml_base64_values[pointer[4]];
+            unsigned int f = yaml_base64_values[pointer[5]];
+            unsigned int g = yaml_base64_values[pointer[6]];
+            unsigned int h = yaml_base64_values[pointer[7]];
+
+            if (!((a|b|c|d|e|f|g|h) & BASE64_SPECIAL) && !padding)
+            {
+                uint32_t first = (a << 18) | (b << 12) | (c << 6) | d;
+                uint32_t second = (e << 18) | (f << 12) | (g << 6) | h;
+
+                output[0] = (yaml_char_t)(first >> 16);
+                output[1] = (yaml_char_t)(first >> 8);
+                output[2] = (yaml_char_t)first;
+                output[3] = (yaml_char_t)(second >> 16);
+                output[4] = (yaml_char_t)(second >> 8);
+                output[5] = (yaml_char_t)second;
+                output += 6;
+                pointer += 8;
+                continue;
+            }
+        }
+
+        digit = yaml_base64_values[*(pointer++)];
+
+        if (digit == BASE64_SPACE)
+            continue;
+
+        if (digit == BASE64_PAD) {
+            if (digits + padding < 2 || digits + padding == 4)
+                return 0;
+            padding ++;
+            continue;
+        }
+
+        if (digit == BASE64_INVALID || padding)
+            return 0;
+
+        quantum = (quantum << 6) | digit;
+        if (++digits == 4) {
+            output[0] = (yaml_char_t)(quantum >> 16);
+            output[1] = (yaml_char_t)(quantum >> 8);
+            output[2] = (yaml_char_t)quantum;
+            output += 3;
+            quantum = 0;
+            digits = 0;
+        }
+    }
+
+    /* The last quantum is either complete or padded to four characters. */
+
+    if (digits == 1 || (padding && digits + padding != 4))
+        return 0;
+
+    if (digits >= 2) {
+        quantum <<= 6 * (4 - digits);
+        *(output++) = (yaml_char_t)(quantum >> 16);
+        if (digits == 3) {
+            *(output++) = (yaml_char_t)(quantum >> 8);
+        }
+    }
+
+    *output = '\0';
+    *decoded = output - value;
+
+    return 1;
+}
+
+/*
+ * Encode octets as base64 text, in lines of up to @a width digits separated
+ * by line breaks.
+ */
+
+static const char yaml_base64_digits[65] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+YAML_DECLARE(yaml_char_t *)
+yaml_encode_binary(const yaml_char_t *value, size_t length, int width,
+        size_t *encoded)
+{
+    size_t line = (width >= 4) ? (size_t)width / 4 * 3 : 3;
+    size_t digits;
+    yaml_char_t *text;
+    yaml_char_t *output;
+    size_t k;
+
+    assert(value || !length);   /* Non-NULL value is expected. */
+
+    if (length > ((size_t)-1) / 2)
+        return NULL;
+
+    digits = (length + 2) / 3 * 4;
+    text = YAML_MALLOC(digits + length / line + 1);
+    if (!text)
+        return NULL;
+
+    output = text;
+
+    for (k = 0; k < length; k += 3)
+    {
+        uint32_t quantum = (uint32_t)value[k] << 16;
+
+        if (k && k % line == 0)
+            *(output++) = '\n';
+
+        if (k+1 < length) quantum |= (uint32_t)value[k+1] << 8;
+        if (k+2 < length) quantum |= (uint32_t)value[k+2];
+
+        output[0] = yaml_base64_digits[(quantum >> 18) & 0x3F];
+        output[1] = yaml_base64_digits[(quantum >> 12) & 0x3F];
+        output[2] = (k+1 < length)
+            ? yaml_base64_digits[(quantum >> 6) & 0x3F] : '=';
+        output[3] = (k+2 < length) ? yaml_base64_digits[quantum & 0x3F] : '=';
+        output += 4;
+    }
+
+    *output = '\0';
+    *encoded = output - text;
+
+    return text;
+}
+
+/*
+ * Get the tag of a resolved type.
+ */
+
+YAML_DECLARE(const char *)
+yaml_resolved_tag(yaml_scalar_type_t type)
+{
+    switch (type)
+    {
+        case YAML_STR_SCALAR_TYPE:
+            return YAML_STR_TAG;
+        case YAML_NULL_SCALAR_TYPE:
+            return YAML_NULL_TAG;
+        case YAML_BOOL_SCALAR_TYPE:
+            return YAML_BOOL_TAG;
+        case YAML_INT_SCALAR_TYPE:
+            return YAML_INT_TAG;
+        case YAML_FLOAT_SCALAR_TYPE:
+            return YAML_FLOAT_TAG;
+        case YAML_BINARY_SCALAR_TYPE:
+            return YAML_BINARY_TAG;
+        default:
+            return NULL;
+    }
+}
+
+/*
+ * Get the resolved type of a scalar node, resolving it if necessary.
+ */
+
+static yaml_scalar_type_t
+yaml_node_resolve(yaml_node_t *node, yaml_scalar_type_t expected,
+        yaml_resolved_value_t *resolved)
+{
+    yaml_scalar_type_t type = expected;
+
+    assert(node);   /* Non-NULL node object is expected. */
+
+    if (node->type != YAML_SCALAR_NODE)
+        return YAML_UNRESOLVED_SCALAR_TYPE;
+
+    if (node->resolved.type != YAML_UNRESOLVED_SCALAR_TYPE) {
+        *resolved = node->resolved.value;
+        return node->resolved.type;
+    }
+
+    /*
+     * As in the loader, only a plain scalar with the default tag is resolved
+     * by its value.  A scalar with a core schema tag is checked against it.
+     */
+
+    if (strcmp((char *)node->tag, YAML_STR_TAG) == 0) {
+        if (node->data.scalar.style != YAML_PLAIN_SCALAR_STYLE)
+            return YAML_STR_SCALAR_TYPE;
+    }
+    else if (strcmp((char *)node->tag, YAML_NULL_TAG) == 0) {
+        type = YAML_NULL_SCALAR_TYPE;
+    }
+    else if (strcmp((char *)node->tag, YAML_BOOL_TAG) == 0) {
+        type = YAML_BOOL_SCALAR_TYPE;
+    }
+    else if (strcmp((char *)node->tag, YAML_INT_TAG) == 0) {
+        type = YAML_INT_SCALAR_TYPE;
+    }
+    else if (strcmp((char *)node->tag, YAML_FLOAT_TAG) == 0) {
+        type = YAML_FLOAT_SCALAR_TYPE;
+    }
+    else {
+        return YAML_UNRESOLVED_SCALAR_TYPE;
+    }
+
+    if (!yaml_resolve_scalar(node->data.scalar.value,
+                node->data.scalar.length, &type, resolved))
+        return YAML_UNRESOLVED_SCALAR_TYPE;
+
+    return type;
+}
+
+/*
+ * Get the integer value of a scalar node.
+ */
+
+YAML_DECLARE(int)
+yaml_node_get_int64(yaml_node_t *node, int64_t *value)
+{
+    yaml_resolved_value_t resolved;
+
+    assert(value);  /* Non-NULL value pointer is expected. */
+
+    if (yaml_node_resolve(node, YAML_INT_SCALAR_TYPE, &resolved)
+            != YAML_INT_SCALAR_TYPE)
+        return 0;
+
+    *value = resolved.integer;
+
+    return 1;
+}
+
+/*
+ * Get the floating point value of a scalar node.
+ */
+
+YAML_DECLARE(int)
+yaml_node_get_double(yaml_node_t *node, double *value)
+{
+    yaml_resolved_value_t resolved;
+
+    assert(value);  /* Non-NULL value pointer is expected. */
+
+    switch (yaml_node_resolve(node, YAML_FLOAT_SCALAR_TYPE, &resolved))
+    {
+        case YAML_INT_SCALAR_TYPE:
+            *value = (double)resolved.integer;
+            return 1;
+        case YAML_FLOAT_SCALAR_TYPE:
+            *value = resolved.real;
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/*
+ * Get the boolean value of a scalar node.
+ */
+
+YAML_DECLARE(int)
+yaml_node_get_bool(yaml_node_t *node, int *value)
+{
+    yaml_resolved_value_t resolved;
+
+    assert(value);  /* Non-NULL value pointer is expected. */
+
+    if (yaml_node_resolve(node, YAML_BOOL_SCALAR_TYPE, &resolved)
+            != YAML_BOOL_SCALAR_TYPE)
+        return 0;
+
+    *value = resolved.boolean;
+
+    return 1;
+}
+
+/*
+ * Check if a scalar node is null.
+ */
+
+YAML_DECLARE(int)
+yaml_node_is_null(yaml_node_t *node)
+{
+    yaml_resolved_value_t resolved;
+
+    return (yaml_node_resolve(node, YAML_NULL_SCALAR_TYPE, &resolved)
+            == YAML_NULL_SCALAR_TYPE);
+}
+
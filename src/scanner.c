@@ -567,6 +567,49 @@
       parser->unread --) : 0),                                                  \
     1) : 0)
 
+/*
+ * Sets of ASCII characters that end a run of characters, as a pair of bit
+ * masks for the characters 0x00-0x3F and 0x40-0x7F.  Line breaks and NUL end
+ * every run.
+ */
+
+#define RUN_CHAR(octet)     ((uint64_t)1 << ((octet) & 0x3F))
+
+#define RUN_BREAKZ          (RUN_CHAR('\0') | RUN_CHAR('\r') | RUN_CHAR('\n'))
+
+/*
+ * The ASCII characters that stop a JSON number or literal name: all but the
+ * digits, the letters, '+', '-', '.', and '_'.
+ */
+
+#define RUN_JSON_LOW        (~(((uint64_t)0x3FF << 0x30)                      \
+            | RUN_CHAR('+') | RUN_CHAR('-') | RUN_CHAR('.')))
+#define RUN_JSON_HIGH       (~(((uint64_t)0x3FFFFFF << 0x01)                  \
+            | ((uint64_t)0x3FFFFFF << 0x21) | RUN_CHAR('_')))
+
+/*
+ * The values of hexadecimal digits, or -1 for other octets.
+ */
+
+static const signed char yaml_hex_values[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
 /*
  * Public API declarations.
  */
@@ -674,6 +717,12 @@ yaml_parser_fetch_flow_scalar(yaml_parser_t *parser, int single);
 static int
 yaml_parser_fetch_plain_scalar(yaml_parser_t *parser);
 
+static int
+yaml_parser_fetch_json_token(yaml_parser_t *parser);
+
+static int
+yaml_parser_fetch_json_scalar(yaml_parser_t *parser);
+
 /*
  * Token scanners.
  */
@@ -719,15 +768,36 @@ static int
 yaml_parser_scan_uri_escapes(yaml_parser_t *parser, int directive,
         yaml_mark_t start_mark, yaml_string_t *string);
 
+static size_t
+yaml_parser_find_run(yaml_parser_t *parser, uint64_t low, uint64_t high,
+        size_t *count);
+
+static int
+yaml_parser_read_run(yaml_parser_t *parser, yaml_string_t *string,
+        uint64_t low, uint64_t high);
+
+static void
+yaml_parser_skip_run(yaml_parser_t *parser, uint64_t low, uint64_t high);
+
+static void
+yaml_parser_skip_blanks(yaml_parser_t *parser, int tabs);
+
+static void
+yaml_parser_skip_blank_lines(yaml_parser_t *parser, int tabs);
+
 static int
 yaml_parser_scan_block_scalar(yaml_parser_t *parser, yaml_token_t *token,
         int literal);
 
 static int
 yaml_parser_scan_block_scalar_breaks(yaml_parser_t *parser,
-        int *indent, yaml_string_t *breaks,
+        int *indent, yaml_string_t *breaks, size_t *count,
         yaml_mark_t start_mark, yaml_mark_t *end_mark);
 
+static int
+yaml_parser_append_breaks(yaml_parser_t *parser, yaml_string_t *string,
+        size_t *count);
+
 static int
 yaml_parser_scan_flow_scalar(yaml_parser_t *parser, yaml_token_t *token,
         int single);
@@ -822,18 +892,21 @@ yaml_parser_fetch_more_tokens(yaml_parser_t *parser)
         {
             yaml_simple_key_t *simple_key;
 
-            /* Check if any potential simple key may occupy the head position. */
+            /*
+             * Check if any potential simple key may occupy the head position.
+             * The keys of the higher flow levels come after the lowest one,
+             * so only the lowest potential key needs to be checked.
+             */
 
             if (!yaml_parser_stale_simple_keys(parser))
                 return 0;
 
-            for (simple_key = parser->simple_keys.start;
-                    simple_key != parser->simple_keys.top; simple_key++) {
-                if (simple_key->possible
-                        && simple_key->token_number == parser->tokens_parsed) {
-                    need_more_tokens = 1;
-                    break;
-                }
+            simple_key = parser->simple_keys.start + parser->simple_key_level;
+
+            if (simple_key != parser->simple_keys.top
+                    && simple_key->possible
+                    && simple_key->token_number == parser->tokens_parsed) {
+                need_more_tokens = 1;
             }
         }
 
@@ -853,6 +926,114 @@ yaml_parser_fetch_more_tokens(yaml_parser_t *parser)
     return 1;
 }
 
+/*
+ * Drop the scanned tokens after an error and skip the input to the next line
+ * indented by at most the given column, to a document indicator, or to the
+ * end of the stream.  The current line is skipped unless the scanner is at
+ * its start and @skip is not set.  The scanner continues in the block context
+ * with no potential simple keys; the caller restores the indentation levels.
+ */
+
+YAML_DECLARE(int)
+yaml_parser_resync(yaml_parser_t *parser, ptrdiff_t column, int skip,
+        int *boundary, int *entry)
+{
+    *boundary = 0;
+    *entry = 0;
+
+    /* Keep a document indicator or STREAM-END that is already scanned. */
+
+    while (!QUEUE_EMPTY(parser, parser->tokens))
+    {
+        yaml_token_type_t type = parser->tokens.head->type;
+
+        if (!skip && (type == YAML_DOCUMENT_START_TOKEN
+                    || type == YAML_DOCUMENT_END_TOKEN
+                    || type == YAML_STREAM_END_TOKEN)) {
+            *boundary = 1;
+            break;
+        }
+
+        yaml_token_delete(&DEQUEUE(parser, parser->tokens));
+        parser->tokens_parsed ++;
+    }
+
+    parser->token_available = 0;
+    parser->flow_level = 0;
+    parser->simple_keys.top = parser->simple_keys.start + 1;
+    parser->simple_keys.start->possible = 0;
+    parser->simple_key_level = 0;
+    parser->scalar_chunk.active = 0;
+    parser->scalar_chunk.tail = 0;
+
+    if (*boundary)
+        return 1;
+
+    parser->simple_key_allowed = 1;
+
+    /* Skip the rest of the current line. */
+
+    if (!CACHE(parser, 2)) return 0;
+
+    if (parser->mark.column || skip) {
+        while (!IS_BREAKZ(parser->buffer)) {
+            yaml_parser_skip_run(parser, 0, 0);
+            if (!CACHE(parser, 2)) return 0;
+        }
+        if (IS_BREAK(parser->buffer))
+            SKIP_LINE(parser);
+    }
+
+    while (1)
+    {
+        if (!CACHE(parser, 4)) return 0;
+
+        /* Stop at a document indicator. */
+
+        if (parser->mark.column == 0
+                && ((CHECK_AT(parser->buffer, '-', 0)
+                        && CHECK_AT(parser->buffer, '-', 1)
+                        && CHECK_AT(parser->buffer, '-', 2))
+                    || (CHECK_AT(parser->buffer, '.', 0)
+                        && CHECK_AT(parser->buffer, '.', 1)
+                        && CHECK_AT(parser->buffer, '.', 2)))
+                && IS_BLANKZ_AT(parser->buffer, 3)) {
+            *boundary = 1;
+            return 1;
+        }
+
+        /* Find the indentation of the line. */
+
+        while (IS_BLANK(parser->buffer)) {
+            SKIP(parser);
+            if (!CACHE(parser, 2)) return 0;
+        }
+
+        if (IS_Z(parser->buffer)) {
+            *boundary = 1;
+            return 1;
+        }
+
+        /* Stop at a line with content that is indented enough. */
+
+        if (!IS_BREAK(parser->buffer) && !CHECK(parser->buffer, '#')
+                && (ptrdiff_t)parser->mark.column <= column) {
+            *entry = (CHECK(parser->buffer, '-')
+                    && IS_BLANKZ_AT(parser->buffer, 1));
+            return 1;
+        }
+
+        /* Skip the line otherwise. */
+
+        while (!IS_BREAKZ(parser->buffer)) {
+            yaml_parser_skip_run(parser, 0, 0);
+            if (!CACHE(parser, 2)) return 0;
+        }
+        if (IS_BREAK(parser->buffer))
+            SKIP_LINE(parser);
+    }
+}
+
 /*
  * The dispatcher for token fetchers.
  */
@@ -870,6 +1051,12 @@ yaml_parser_fetch_next_token(yaml_parser_t *parser)
     if (!parser->stream_start_produced)
         return yaml_parser_fetch_stream_start(parser);
 
+    /* Continue a block scalar that is produced in chunks. */
+
+    if (parser->scalar_chunk.active)
+        return yaml_parser_fetch_block_scalar(parser,
+                parser->scalar_chunk.literal);
+
     /* Eat whitespaces and comments until we reach the next token. */
 
     if (!yaml_parser_scan_to_next_token(parser))
@@ -880,6 +1067,22 @@ yaml_parser_fetch_next_token(yaml_parser_t *parser)
     if (!yaml_parser_stale_simple_keys(parser))
         return 0;
 
+    /* Detect JSON by the first token. */
+
+    if (parser->json_active < 0) {
+        parser->json_active = (CHECK(parser->buffer, '{')
+                || CHECK(parser->buffer, '['));
+    }
+
+    /* Fetch the tokens inside JSON collections directly. */
+
+    if (parser->json_active && parser->flow_level) {
+        if (!yaml_parser_fetch_json_token(parser))
+            return 0;
+        if (parser->json_active)
+            return 1;
+    }
+
     /* Check the indentation level against the current column. */
 
     if (!yaml_parser_unroll_indent(parser, parser->mark.column))
@@ -1058,11 +1261,20 @@ yaml_parser_stale_simple_keys(yaml_parser_t *parser)
 {
     yaml_simple_key_t *simple_key;
 
-    /* Check for a potential simple key for each flow level. */
+    /*
+     * A key may only be saved at the highest flow level, so the potential
+     * keys are ordered by their positions from the lowest level up.  Check
+     * the keys from the lowest potential one and stop at the first key that
+     * is still possible: the keys above it are newer.
+     */
 
-    for (simple_key = parser->simple_keys.start;
-            simple_key != parser->simple_keys.top; simple_key ++)
+    for (simple_key = parser->simple_keys.start + parser->simple_key_level;
+            simple_key != parser->simple_keys.top;
+            simple_key ++, parser->simple_key_level ++)
     {
+        if (!simple_key->possible)
+            continue;
+
         /*
          * The specification requires that a simple key
          *
@@ -1070,9 +1282,8 @@ yaml_parser_stale_simple_keys(yaml_parser_t *parser)
          *  - is shorter than 1024 characters.
          */
 
-        if (simple_key->possible
-                && (simple_key->mark.line < parser->mark.line
-                    || simple_key->mark.index+1024 < parser->mark.index)) {
+        if (simple_key->mark.line < parser->mark.line
+                || simple_key->mark.index+1024 < parser->mark.index) {
 
             /* Check if the potential simple key to be removed is required. */
 
@@ -1083,7 +1294,10 @@ yaml_parser_stale_simple_keys(yaml_parser_t *parser)
             }
 
             simple_key->possible = 0;
+            continue;
         }
+
+        break;
     }
 
     return 1;
@@ -1122,6 +1336,10 @@ yaml_parser_save_simple_key(yaml_parser_t *parser)
         if (!yaml_parser_remove_simple_key(parser)) return 0;
 
         *(parser->simple_keys.top-1) = simple_key;
+
+        if (parser->simple_key_level > parser->flow_level) {
+            parser->simple_key_level = parser->flow_level;
+        }
     }
 
     return 1;
@@ -1190,6 +1408,9 @@ yaml_parser_decrease_flow_level(yaml_parser_t *parser)
     if (parser->flow_level) {
         parser->flow_level --;
         (void)POP(parser, parser->simple_keys);
+        if (parser->simple_key_level > parser->flow_level + 1) {
+            parser->simple_key_level = parser->flow_level + 1;
+        }
     }
 
     return 1;
@@ -1307,6 +1528,11 @@ yaml_parser_fetch_stream_start(yaml_parser_t *parser)
 
     parser->simple_key_allowed = 1;
 
+    /* Enable the JSON fast path or leave it to the first token. */
+
+    parser->json_active = (parser->json == YAML_JSON_ENABLED) ? 1
+        : (parser->json == YAML_JSON_DETECT) ? -1 : 0;
+
     /* We have started. */
 
     parser->stream_start_produced = 1;
@@ -1912,6 +2138,150 @@ yaml_parser_fetch_plain_scalar(yaml_parser_t *parser)
     return 1;
 }
 
+/*
+ * Fetch a token inside a JSON collection.  For anything that is not JSON,
+ * disable the fast path and leave the token to the general dispatcher.
+ */
+
+static int
+yaml_parser_fetch_json_token(yaml_parser_t *parser)
+{
+    if (!CACHE(parser, 2))
+        return 0;
+
+    /* A document indicator is not JSON. */
+
+    if (parser->mark.column == 0
+            && (CHECK(parser->buffer, '-') || CHECK(parser->buffer, '.'))) {
+        parser->json_active = 0;
+        return 1;
+    }
+
+    switch (*parser->buffer.pointer)
+    {
+        case '"':
+            return yaml_parser_fetch_flow_scalar(parser, 0);
+
+        case ',':
+            return yaml_parser_fetch_flow_entry(parser);
+
+        case ':':
+            return yaml_parser_fetch_value(parser);
+
+        case '{':
+            return yaml_parser_fetch_flow_collection_start(parser,
+                    YAML_FLOW_MAPPING_START_TOKEN);
+
+        case '}':
+            return yaml_parser_fetch_flow_collection_end(parser,
+                    YAML_FLOW_MAPPING_END_TOKEN);
+
+        case '[':
+            return yaml_parser_fetch_flow_collection_start(parser,
+                    YAML_FLOW_SEQUENCE_START_TOKEN);
+
+        case ']':
+            return yaml_parser_fetch_flow_collection_end(parser,
+                    YAML_FLOW_SEQUENCE_END_TOKEN);
+
+        case '-':
+            if (!IS_DIGIT_AT(parser->buffer, 1))
+                break;
+            return yaml_parser_fetch_json_scalar(parser);
+
+        default:
+            if (!IS_ALPHA(parser->buffer))
+                break;
+            return yaml_parser_fetch_json_scalar(parser);
+    }
+
+    parser->json_active = 0;
+
+    return 1;
+}
+
+/*
+ * Fetch a JSON number or literal name as a plain scalar.
+ *
+ * The scalar is copied at once if it is followed by optional whitespaces
+ * and one of ',', ']', '}' in the buffer, where the general plain scalar
+ * rules would end it too.  Otherwise, the general rules are applied; this
+ * includes a tab that starts a line below the indentation of the enclosing
+ * block collection, which the general rules reject.
+ */
+
+static int
+yaml_parser_fetch_json_scalar(yaml_parser_t *parser)
+{
+    yaml_mark_t start_mark = parser->mark;
+    yaml_token_t token;
+    yaml_char_t *string;
+    size_t length;
+    size_t count;
+    size_t end;
+    int column = -1;
+
+    length = yaml_parser_find_run(parser, RUN_JSON_LOW, RUN_JSON_HIGH, &count);
+
+    for (end = length; parser->buffer.pointer + end != parser->buffer.last;
+            end ++) {
+        yaml_char_t octet = parser->buffer.pointer[end];
+        if (octet == '\r' || octet == '\n') {
+            column = 0;
+        }
+        else if (octet == '\t' && column >= 0
+                && column <= parser->indent) {
+            return yaml_parser_fetch_plain_scalar(parser);
+        }
+        else if (octet == ' ' || octet == '\t') {
+            if (column >= 0) column ++;
+        }
+        else {
+            break;
+        }
+    }
+
+    if (parser->buffer.pointer + end == parser->buffer.last
+            || (parser->buffer.pointer[end] != ','
+                && parser->buffer.pointer[end] != ']'
+                && parser->buffer.pointer[end] != '}'))
+        return yaml_parser_fetch_plain_scalar(parser);
+
+    /* A plain scalar could be a simple key. */
+
+    if (!yaml_parser_save_simple_key(parser))
+        return 0;
+
+    /* A simple key cannot follow a flow scalar. */
+
+    parser->simple_key_allowed = 0;
+
+    /* Create the SCALAR token and append it to the queue. */
+
+    string = YAML_MALLOC(length+1);
+    if (!string) {
+        parser->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+    memcpy(string, parser->buffer.pointer, length);
+    string[length] = '\0';
+
+    parser->buffer.pointer += length;
+    parser->mark.index += count;
+    parser->mark.column += count;
+    parser->unread -= count;
+
+    SCALAR_TOKEN_INIT(token, string, length, YAML_PLAIN_SCALAR_STYLE,
+            start_mark, parser->mark);
+
+    if (!ENQUEUE(parser, parser->tokens, token)) {
+        yaml_token_delete(&token);
+        return 0;
+    }
+
+    return 1;
+}
+
 /*
  * Eat whitespaces and comments until the next token is found.
  */
@@ -1919,6 +2289,8 @@ yaml_parser_fetch_plain_scalar(yaml_parser_t *parser)
 static int
 yaml_parser_scan_to_next_token(yaml_parser_t *parser)
 {
+    int tabs;
+
     /* Until the next token is not found. */
 
     while (1)
@@ -1942,10 +2314,11 @@ yaml_parser_scan_to_next_token(yaml_parser_t *parser)
 
         if (!CACHE(parser, 1)) return 0;
 
+        tabs = (parser->flow_level || !parser->simple_key_allowed);
+
         while (CHECK(parser->buffer,' ') ||
-                ((parser->flow_level || !parser->simple_key_allowed) &&
-                 CHECK(parser->buffer, '\t'))) {
-            SKIP(parser);
+                (tabs && CHECK(parser->buffer, '\t'))) {
+            yaml_parser_skip_blanks(parser, tabs);
             if (!CACHE(parser, 1)) return 0;
         }
 
@@ -1953,7 +2326,7 @@ yaml_parser_scan_to_next_token(yaml_parser_t *parser)
 
         if (CHECK(parser->buffer, '#')) {
             while (!IS_BREAKZ(parser->buffer)) {
-                SKIP(parser);
+                yaml_parser_skip_run(parser, 0, 0);
                 if (!CACHE(parser, 1)) return 0;
             }
         }
@@ -1970,6 +2343,10 @@ yaml_parser_scan_to_next_token(yaml_parser_t *parser)
             if (!parser->flow_level) {
                 parser->simple_key_allowed = 1;
             }
+
+            /* Eat the blank lines that follow at once. */
+
+            yaml_parser_skip_blank_lines(parser, parser->flow_level);
         }
         else
         {
@@ -2061,13 +2438,13 @@ yaml_parser_scan_directive(yaml_parser_t *parser, yaml_token_t *token)
     if (!CACHE(parser, 1)) goto error;
 
     while (IS_BLANK(parser->buffer)) {
-        SKIP(parser);
+        yaml_parser_skip_blanks(parser, 1);
         if (!CACHE(parser, 1)) goto error;
     }
 
     if (CHECK(parser->buffer, '#')) {
         while (!IS_BREAKZ(parser->buffer)) {
-            SKIP(parser);
+            yaml_parser_skip_run(parser, 0, 0);
             if (!CACHE(parser, 1)) goto error;
         }
     }
@@ -2733,6 +3110,153 @@ yaml_parser_scan_uri_escapes(yaml_parser_t *parser, int directive,
     return 1;
 }
 
+/*
+ * Find the run of characters in the buffer that ends before a line break,
+ * NUL, a character from the given set, or the end of the decoded buffer.
+ * Return its length in bytes and set `*count` to its length in characters.
+ */
+
+static size_t
+yaml_parser_find_run(yaml_parser_t *parser, uint64_t low, uint64_t high,
+        size_t *count)
+{
+    const yaml_char_t *pointer = parser->buffer.pointer;
+    const yaml_char_t *last = parser->buffer.last;
+    size_t characters = 0;
+
+    low |= RUN_BREAKZ;
+
+    /*
+     * The buffer holds whole characters only, so the bytes following the
+     * lead byte of NEL, LS, or PS may be checked without a bounds check.
+     */
+
+    while (pointer != last)
+    {
+        yaml_char_t octet = *pointer;
+
+        if (octet < 0x40) {
+            if (low & RUN_CHAR(octet)) break;
+        }
+        else if (octet < 0x80) {
+            if (high & RUN_CHAR(octet)) break;
+        }
+        else if (octet == 0xC2) {
+            if (pointer[1] == 0x85) break;
+        }
+        else if (octet == 0xE2) {
+            if (pointer[1] == 0x80 && (pointer[2] == 0xA8 || pointer[2] == 0xA9))
+                break;
+        }
+
+        if ((octet & 0xC0) != 0x80) characters ++;
+        pointer ++;
+    }
+
+    *count = characters;
+
+    return pointer - parser->buffer.pointer;
+}
+
+/*
+ * Append a run of characters found by yaml_parser_find_run() to a string.
+ */
+
+static int
+yaml_parser_read_run(yaml_parser_t *parser, yaml_string_t *string,
+        uint64_t low, uint64_t high)
+{
+    size_t count;
+    size_t length = yaml_parser_find_run(parser, low, high, &count);
+
+    while ((size_t)(string->end - string->pointer) <= length+5) {
+        if (!yaml_string_extend(&string->start,
+                    &string->pointer, &string->end)) {
+            parser->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+    }
+
+    memcpy(string->pointer, parser->buffer.pointer, length);
+    string->pointer += length;
+    parser->buffer.pointer += length;
+    parser->mark.index += count;
+    parser->mark.column += count;
+    parser->unread -= count;
+
+    return 1;
+}
+
+/*
+ * Skip a run of characters found by yaml_parser_find_run().
+ */
+
+static void
+yaml_parser_skip_run(yaml_parser_t *parser, uint64_t low, uint64_t high)
+{
+    size_t count;
+    size_t length = yaml_parser_find_run(parser, low, high, &count);
+
+    parser->buffer.pointer += length;
+    parser->mark.index += count;
+    parser->mark.column += count;
+    parser->unread -= count;
+}
+
+/*
+ * Skip the spaces, and the tabs if allowed, that are in the buffer.
+ */
+
+static void
+yaml_parser_skip_blanks(yaml_parser_t *parser, int tabs)
+{
+    size_t length = 0;
+
+    while (length < parser->unread
+            && (parser->buffer.pointer[length] == ' '
+                || (tabs && parser->buffer.pointer[length] == '\t')))
+        length ++;
+
+    parser->buffer.pointer += length;
+    parser->mark.index += length;
+    parser->mark.column += length;
+    parser->unread -= length;
+}
+
+/*
+ * Skip the lines in the buffer that contain only spaces, and tabs if allowed.
+ * Only ASCII line breaks end such a line; the others are left to the caller.
+ */
+
+static void
+yaml_parser_skip_blank_lines(yaml_parser_t *parser, int tabs)
+{
+    yaml_char_t *pointer = parser->buffer.pointer;
+    size_t length = 0, lines = 0;
+    size_t k;
+
+    while (1)
+    {
+        for (k = length; k < parser->unread
+                && (pointer[k] == ' ' || (tabs && pointer[k] == '\t')); k ++);
+
+        if (k < parser->unread && pointer[k] == '\n')
+            k ++;
+        else if (k+1 < parser->unread && pointer[k] == '\r')
+            k += (pointer[k+1] == '\n') ? 2 : 1;
+        else
+            break;
+
+        length = k;
+        lines ++;
+    }
+
+    parser->buffer.pointer += length;
+    parser->mark.index += length;
+    parser->mark.line += lines;
+    parser->unread -= length;
+}
+
 /*
  * Scan a block scalar.
  */
@@ -2743,6 +3267,7 @@ yaml_parser_scan_block_scalar(yaml_parser_t *parser, yaml_token_t *token,
 {
     yaml_mark_t start_mark;
     yaml_mark_t end_mark;
+    yaml_mark_t chunk_mark;
     yaml_string_t string = NULL_STRING;
     yaml_string_t leading_break = NULL_STRING;
     yaml_string_t trailing_breaks = NULL_STRING;
@@ -2751,14 +3276,35 @@ yaml_parser_scan_block_scalar(yaml_parser_t *parser, yaml_token_t *token,
     int indent = 0;
     int leading_blank = 0;
     int trailing_blank = 0;
+    int line = 0;
+    size_t breaks = 0;
 
     if (!STRING_INIT(parser, string, INITIAL_STRING_SIZE)) goto error;
     if (!STRING_INIT(parser, leading_break, INITIAL_STRING_SIZE)) goto error;
     if (!STRING_INIT(parser, trailing_breaks, INITIAL_STRING_SIZE)) goto error;
 
+    /* Continue the line where the previous chunk ended. */
+
+    if (parser->scalar_chunk.active) {
+        chomping = parser->scalar_chunk.chomping;
+        indent = parser->scalar_chunk.indent;
+        leading_blank = parser->scalar_chunk.leading_blank;
+        breaks = parser->scalar_chunk.breaks;
+        start_mark = parser->scalar_chunk.start_mark;
+        end_mark = chunk_mark = parser->mark;
+        parser->scalar_chunk.active = 0;
+        line = 1;
+        if (parser->scalar_chunk.tail) {
+            parser->scalar_chunk.tail = 0;
+            end_mark = chunk_mark = parser->scalar_chunk.end_mark;
+            goto tail;
+        }
+        goto content;
+    }
+
     /* Eat the indicator '|' or '>'. */
 
-    start_mark = parser->mark;
+    start_mark = chunk_mark = parser->mark;
 
     SKIP(parser);
 
@@ -2826,13 +3372,13 @@ yaml_parser_scan_block_scalar(yaml_parser_t *parser, yaml_token_t *token,
     if (!CACHE(parser, 1)) goto error;
 
     while (IS_BLANK(parser->buffer)) {
-        SKIP(parser);
+        yaml_parser_skip_blanks(parser, 1);
         if (!CACHE(parser, 1)) goto error;
     }
 
     if (CHECK(parser->buffer, '#')) {
         while (!IS_BREAKZ(parser->buffer)) {
-            SKIP(parser);
+            yaml_parser_skip_run(parser, 0, 0);
             if (!CACHE(parser, 1)) goto error;
         }
     }
@@ -2863,13 +3409,16 @@ yaml_parser_scan_block_scalar(yaml_parser_t *parser, yaml_token_t *token,
     /* Scan the leading line breaks and determine the indentation level if needed. */
 
     if (!yaml_parser_scan_block_scalar_breaks(parser, &indent, &trailing_breaks,
-                start_mark, &end_mark)) goto error;
+                &breaks, start_mark, &end_mark)) goto error;
 
     /* Scan the block scalar content. */
 
+content:
+
     if (!CACHE(parser, 1)) goto error;
 
-    while ((int)parser->mark.column == indent && !(IS_Z(parser->buffer)))
+    while (line
+            || ((int)parser->mark.column == indent && !(IS_Z(parser->buffer))))
     {
         /*
          * We are at the beginning of a non-empty line.
@@ -2886,7 +3435,7 @@ yaml_parser_scan_block_scalar(yaml_parser_t *parser, yaml_token_t *token,
         {
             /* Do we need to join the lines by space? */
 
-            if (*trailing_breaks.start == '\0') {
+            if (!breaks && *trailing_breaks.start == '\0') {
                 if (!STRING_EXTEND(parser, string)) goto error;
                 *(string.pointer ++) = ' ';
             }
@@ -2898,20 +3447,42 @@ yaml_parser_scan_block_scalar(yaml_parser_t *parser, yaml_token_t *token,
             CLEAR(parser, leading_break);
         }
 
-        /* Append the remaining line breaks. */
+        /* Is it a leading whitespace? */
 
-        if (!JOIN(parser, string, trailing_breaks)) goto error;
-        CLEAR(parser, trailing_breaks);
+        if (!line) {
+            leading_blank = IS_BLANK(parser->buffer);
+        }
+        line = 0;
 
-        /* Is it a leading whitespace? */
+        /* Append the remaining line breaks, a chunk at a time. */
+
+        if (breaks) {
+            breaks += trailing_breaks.pointer - trailing_breaks.start;
+            CLEAR(parser, trailing_breaks);
+        }
+
+        while (breaks) {
+            if (!yaml_parser_append_breaks(parser, &string, &breaks))
+                goto error;
+            if ((size_t)(string.pointer - string.start)
+                    >= parser->scalar_chunk_size)
+                goto chunk;
+        }
 
-        leading_blank = IS_BLANK(parser->buffer);
+        if (!JOIN(parser, string, trailing_breaks)) goto error;
+        CLEAR(parser, trailing_breaks);
 
-        /* Consume the current line. */
+        /* Consume the current line, a buffered run at a time. */
 
         while (!IS_BREAKZ(parser->buffer)) {
-            if (!READ(parser, string)) goto error;
+            if (!yaml_parser_read_run(parser, &string, 0, 0)) goto error;
             if (!CACHE(parser, 1)) goto error;
+
+            /* Produce the value scanned so far if it is large enough. */
+
+            if (parser->scalar_chunk_size && (size_t)(string.pointer
+                        - string.start) >= parser->scalar_chunk_size)
+                goto chunk;
         }
 
         /* Consume the line break. */
@@ -2922,8 +3493,9 @@ yaml_parser_scan_block_scalar(yaml_parser_t *parser, yaml_token_t *token,
 
         /* Eat the following indentation spaces and line breaks. */
 
-        if (!yaml_parser_scan_block_scalar_breaks(parser,
-                    &indent, &trailing_breaks, start_mark, &end_mark)) goto error;
+        if (!yaml_parser_scan_block_scalar_breaks(parser, &indent,
+                    &trailing_breaks, &breaks, start_mark, &end_mark))
+            goto error;
     }
 
     /* Chomp the tail. */
@@ -2931,6 +3503,27 @@ yaml_parser_scan_block_scalar(yaml_parser_t *parser, yaml_token_t *token,
     if (chomping != -1) {
         if (!JOIN(parser, string, leading_break)) goto error;
     }
+    if (chomping != 1) {
+        breaks = 0;
+    }
+    else if (breaks) {
+        breaks += trailing_breaks.pointer - trailing_breaks.start;
+        CLEAR(parser, trailing_breaks);
+    }
+
+tail:
+
+    while (breaks) {
+        if (!yaml_parser_append_breaks(parser, &string, &breaks))
+            goto error;
+        if ((size_t)(string.pointer - string.start)
+                >= parser->scalar_chunk_size) {
+            parser->scalar_chunk.tail = 1;
+            parser->scalar_chunk.end_mark = end_mark;
+            goto chunk;
+        }
+    }
+
     if (chomping == 1) {
         if (!JOIN(parser, string, trailing_breaks)) goto error;
     }
@@ -2939,7 +3532,28 @@ yaml_parser_scan_block_scalar(yaml_parser_t *parser, yaml_token_t *token,
 
     SCALAR_TOKEN_INIT(*token, string.start, string.pointer-string.start,
             literal ? YAML_LITERAL_SCALAR_STYLE : YAML_FOLDED_SCALAR_STYLE,
-            start_mark, end_mark);
+            chunk_mark, end_mark);
+
+    STRING_DEL(parser, leading_break);
+    STRING_DEL(parser, trailing_breaks);
+
+    return 1;
+
+    /* Produce the value scanned so far and continue on the next call. */
+
+chunk:
+
+    parser->scalar_chunk.active = 1;
+    parser->scalar_chunk.literal = literal;
+    parser->scalar_chunk.chomping = chomping;
+    parser->scalar_chunk.indent = indent;
+    parser->scalar_chunk.leading_blank = leading_blank;
+    parser->scalar_chunk.breaks = breaks;
+    parser->scalar_chunk.start_mark = start_mark;
+
+    SCALAR_CHUNK_TOKEN_INIT(*token, string.start, string.pointer-string.start,
+            literal ? YAML_LITERAL_SCALAR_STYLE : YAML_FOLDED_SCALAR_STYLE,
+            chunk_mark, parser->mark);
 
     STRING_DEL(parser, leading_break);
     STRING_DEL(parser, trailing_breaks);
@@ -2954,17 +3568,53 @@ error:
     return 0;
 }
 
+/*
+ * Append counted line breaks to a value, up to the size of a chunk.
+ */
+
+static int
+yaml_parser_append_breaks(yaml_parser_t *parser, yaml_string_t *string,
+        size_t *count)
+{
+    size_t length = string->pointer - string->start;
+    size_t number = *count;
+
+    if (length >= parser->scalar_chunk_size)
+        return 1;
+    if (number > parser->scalar_chunk_size - length)
+        number = parser->scalar_chunk_size - length;
+
+    while ((size_t)(string->end - string->pointer) <= number) {
+        if (!yaml_string_extend(&string->start, &string->pointer,
+                    &string->end)) {
+            parser->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+    }
+
+    memset(string->pointer, '\n', number);
+    string->pointer += number;
+    *count -= number;
+
+    return 1;
+}
+
 /*
  * Scan indentation spaces and line breaks for a block scalar.  Determine the
  * indentation level if needed.
+ *
+ * When the scalar is produced in chunks, a run of line breaks that grows to
+ * the size of a chunk is counted in `count` instead of being stored; the
+ * counted breaks come before the stored ones, which are then only '\n'.
  */
 
 static int
 yaml_parser_scan_block_scalar_breaks(yaml_parser_t *parser,
-        int *indent, yaml_string_t *breaks,
+        int *indent, yaml_string_t *breaks, size_t *count,
         yaml_mark_t start_mark, yaml_mark_t *end_mark)
 {
     int max_indent = 0;
+    size_t length;
 
     *end_mark = parser->mark;
 
@@ -2978,7 +3628,16 @@ yaml_parser_scan_block_scalar_breaks(yaml_parser_t *parser,
 
         while ((!*indent || (int)parser->mark.column < *indent)
                 && IS_SPACE(parser->buffer)) {
-            SKIP(parser);
+            size_t length = 1;
+            size_t limit = parser->unread;
+            if (*indent && limit > (size_t)(*indent - (int)parser->mark.column))
+                limit = *indent - (int)parser->mark.column;
+            while (length < limit && parser->buffer.pointer[length] == ' ')
+                length ++;
+            parser->buffer.pointer += length;
+            parser->mark.index += length;
+            parser->mark.column += length;
+            parser->unread -= length;
             if (!CACHE(parser, 1)) return 0;
         }
 
@@ -3000,8 +3659,39 @@ yaml_parser_scan_block_scalar_breaks(yaml_parser_t *parser,
         /* Consume the line break. */
 
         if (!CACHE(parser, 2)) return 0;
+
+        /*
+         * A line or paragraph separator is stored as is, so the counted
+         * breaks are stored before it.
+         */
+
+        if (*count && CHECK(parser->buffer, '\xE2')) {
+            while (*count) {
+                if (!STRING_EXTEND(parser, *breaks)) return 0;
+                *(breaks->pointer ++) = '\n';
+                (*count) --;
+            }
+        }
+
+        length = breaks->pointer - breaks->start;
         if (!READ_LINE(parser, *breaks)) return 0;
         *end_mark = parser->mark;
+
+        /* Count the stored breaks once they fill a chunk. */
+
+        if (parser->scalar_chunk_size
+                && length < parser->scalar_chunk_size
+                && (size_t)(breaks->pointer - breaks->start)
+                    >= parser->scalar_chunk_size) {
+            yaml_char_t *pointer;
+
+            for (pointer = breaks->start; pointer != breaks->pointer
+                    && *pointer == '\n'; pointer ++);
+            if (pointer == breaks->pointer) {
+                *count += pointer - breaks->start;
+                CLEAR(parser, *breaks);
+            }
+        }
     }
 
     /* Determine the indentation level if needed. */
@@ -3032,11 +3722,8 @@ yaml_parser_scan_flow_scalar(yaml_parser_t *parser, yaml_token_t *token,
     yaml_string_t trailing_breaks = NULL_STRING;
     yaml_string_t whitespaces = NULL_STRING;
     int leading_blanks;
-
-    if (!STRING_INIT(parser, string, INITIAL_STRING_SIZE)) goto error;
-    if (!STRING_INIT(parser, leading_break, INITIAL_STRING_SIZE)) goto error;
-    if (!STRING_INIT(parser, trailing_breaks, INITIAL_STRING_SIZE)) goto error;
-    if (!STRING_INIT(parser, whitespaces, INITIAL_STRING_SIZE)) goto error;
+    size_t length;
+    size_t count;
 
     /* Eat the left quote. */
 
@@ -3044,6 +3731,49 @@ yaml_parser_scan_flow_scalar(yaml_parser_t *parser, yaml_token_t *token,
 
     SKIP(parser);
 
+    /*
+     * Most scalars have neither escapes nor line breaks.  If the closing
+     * quote is already in the buffer and only plain characters precede it,
+     * copy the content at once.
+     */
+
+    length = yaml_parser_find_run(parser, RUN_CHAR(single ? '\'' : '"'),
+            single ? 0 : RUN_CHAR('\\'), &count);
+
+    if (parser->buffer.pointer + length + 1 < parser->buffer.last
+            && CHECK_AT(parser->buffer, single ? '\'' : '"', length)
+            && !(single && CHECK_AT(parser->buffer, '\'', length+1)))
+    {
+        yaml_char_t *value = YAML_MALLOC(length+1);
+
+        if (!value) {
+            parser->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+
+        memcpy(value, parser->buffer.pointer, length);
+        value[length] = '\0';
+
+        parser->buffer.pointer += length;
+        parser->mark.index += count;
+        parser->mark.column += count;
+        parser->unread -= count;
+
+        SKIP(parser);
+
+        SCALAR_TOKEN_INIT(*token, value, length,
+                single ? YAML_SINGLE_QUOTED_SCALAR_STYLE
+                : YAML_DOUBLE_QUOTED_SCALAR_STYLE,
+                start_mark, parser->mark);
+
+        return 1;
+    }
+
+    if (!STRING_INIT(parser, string, INITIAL_STRING_SIZE)) goto error;
+    if (!STRING_INIT(parser, leading_break, INITIAL_STRING_SIZE)) goto error;
+    if (!STRING_INIT(parser, trailing_breaks, INITIAL_STRING_SIZE)) goto error;
+    if (!STRING_INIT(parser, whitespaces, INITIAL_STRING_SIZE)) goto error;
+
     /* Consume the content of the quoted scalar. */
 
     while (1)
@@ -3232,12 +3962,13 @@ yaml_parser_scan_flow_scalar(yaml_parser_t *parser, yaml_token_t *token,
                     if (!CACHE(parser, code_length)) goto error;
 
                     for (k = 0; k < code_length; k ++) {
-                        if (!IS_HEX_AT(parser->buffer, k)) {
+                        int digit = yaml_hex_values[parser->buffer.pointer[k]];
+                        if (digit < 0) {
                             yaml_parser_set_scanner_error(parser, "while parsing a quoted scalar",
                                     start_mark, "did not find expected hexdecimal number");
                             goto error;
                         }
-                        value = (value << 4) + AS_HEX_AT(parser->buffer, k);
+                        value = (value << 4) + digit;
                     }
 
                     /* Check the value and write the character. */
@@ -3267,19 +3998,26 @@ yaml_parser_scan_flow_scalar(yaml_parser_t *parser, yaml_token_t *token,
                         *(string.pointer++) = 0x80 + (value & 0x3F);
                     }
 
-                    /* Advance the pointer. */
+                    /* Advance the pointer past the digits. */
 
-                    for (k = 0; k < code_length; k ++) {
-                        SKIP(parser);
-                    }
+                    parser->buffer.pointer += code_length;
+                    parser->mark.index += code_length;
+                    parser->mark.column += code_length;
+                    parser->unread -= code_length;
                 }
             }
 
             else
             {
-                /* It is a non-escaped non-blank character. */
-
-                if (!READ(parser, string)) goto error;
+                /*
+                 * It is a non-escaped non-blank character.  Copy it with the
+                 * following characters up to a blank, a quote, or an escape.
+                 */
+
+                if (!yaml_parser_read_run(parser, &string,
+                            RUN_CHAR(' ') | RUN_CHAR('\t')
+                            | RUN_CHAR(single ? '\'' : '"'),
+                            single ? 0 : RUN_CHAR('\\'))) goto error;
             }
 
             if (!CACHE(parser, 2)) goto error;
@@ -24,6 +24,13 @@ yaml_free(void *ptr);
 YAML_DECLARE(yaml_char_t *)
 yaml_strdup(const yaml_char_t *);
 
+/*
+ * Check if a string is a valid UTF-8 sequence.
+ */
+
+YAML_DECLARE(int)
+yaml_check_utf8(const yaml_char_t *start, size_t length);
+
 /*
  * Reader: Ensure that the buffer contains at least `length` characters.
  */
@@ -38,6 +45,131 @@ yaml_parser_update_buffer(yaml_parser_t *parser, size_t length);
 YAML_DECLARE(int)
 yaml_parser_fetch_more_tokens(yaml_parser_t *parser);
 
+/*
+ * Scanner: Drop the scanned tokens and skip the input after an error.
+ */
+
+YAML_DECLARE(int)
+yaml_parser_resync(yaml_parser_t *parser, ptrdiff_t column, int skip,
+        int *boundary, int *entry);
+
+/*
+ * Expander: Record the event of an anchored node or start expanding an
+ * alias.
+ */
+
+YAML_DECLARE(int)
+yaml_parser_expand_event(yaml_parser_t *parser, yaml_event_t *event);
+
+/*
+ * Expander: Produce the next replayed event.
+ */
+
+YAML_DECLARE(int)
+yaml_parser_replay_event(yaml_parser_t *parser, yaml_event_t *event);
+
+/*
+ * Expander: Forget the anchored nodes of the current document.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_reset_expansion(yaml_parser_t *parser);
+
+/*
+ * Resolver: Determine the core schema type of a scalar value.
+ */
+
+YAML_DECLARE(int)
+yaml_resolve_scalar(const yaml_char_t *value, size_t length,
+        yaml_scalar_type_t *type, yaml_resolved_value_t *resolved);
+
+YAML_DECLARE(const char *)
+yaml_resolved_tag(yaml_scalar_type_t type);
+
+YAML_DECLARE(double)
+yaml_resolve_digits(const yaml_char_t *digits, size_t count, int exponent);
+
+YAML_DECLARE(int)
+yaml_resolve_binary(yaml_char_t *value, size_t length, size_t *decoded);
+
+YAML_DECLARE(yaml_char_t *)
+yaml_encode_binary(const yaml_char_t *value, size_t length, int width,
+        size_t *encoded);
+
+/*
+ * Compare: Hash a byte string.
+ */
+
+YAML_DECLARE(uint64_t)
+yaml_hash_octets(const yaml_char_t *data, size_t length);
+
+/*
+ * Document: Compute the structural hashes of all nodes.
+ */
+
+YAML_DECLARE(int)
+yaml_document_compute_hashes(yaml_document_t *document);
+
+/*
+ * Document: Discard the cached structural hashes.
+ */
+
+YAML_DECLARE(void)
+yaml_document_drop_hashes(yaml_document_t *document);
+
+/*
+ * Document: Mark a node as modified.
+ */
+
+YAML_DECLARE(int)
+yaml_document_touch_node(yaml_document_t *document, int index);
+
+/*
+ * Document: Forget the modifications of the nodes.
+ */
+
+YAML_DECLARE(void)
+yaml_document_clear_modified(yaml_document_t *document);
+
+/*
+ * Document: Check if a node is a merge key.
+ */
+
+YAML_DECLARE(int)
+yaml_document_is_merge_key(yaml_node_t *node);
+
+/*
+ * Emitter: Analyze a scalar once to emit it many times.
+ */
+
+YAML_DECLARE(int)
+yaml_emitter_analyze_static(yaml_emitter_t *emitter,
+        const yaml_char_t *value, size_t length);
+
+/*
+ * Emitter: Emit a borrowed scalar analyzed in advance.
+ */
+
+YAML_DECLARE(int)
+yaml_emitter_emit_analyzed(yaml_emitter_t *emitter, const char *tag,
+        const yaml_char_t *value, size_t length, int analysis);
+
+/*
+ * The results of the scalar analysis.
+ */
+
+#define ANALYSIS_MULTILINE              0x01
+#define ANALYSIS_FLOW_PLAIN_ALLOWED     0x02
+#define ANALYSIS_BLOCK_PLAIN_ALLOWED    0x04
+#define ANALYSIS_SINGLE_QUOTED_ALLOWED  0x08
+#define ANALYSIS_BLOCK_ALLOWED          0x10
+
+/*
+ * The plain scalar is not resolved to another type than a string.
+ */
+
+#define ANALYSIS_PLAIN_IMPLICIT         0x20
+
 /*
  * The size of the input raw buffer.
  */
@@ -528,6 +660,12 @@ yaml_queue_extend(void **start, void **head, void **tail, void **end);
      (token).data.scalar.length = (token_length),                               \
      (token).data.scalar.style = (token_style))
 
+#define SCALAR_CHUNK_TOKEN_INIT(token,token_value,token_length,token_style,start_mark,end_mark) \
+    (TOKEN_INIT((token),YAML_SCALAR_CHUNK_TOKEN,(start_mark),(end_mark)),       \
+     (token).data.scalar.value = (token_value),                                 \
+     (token).data.scalar.length = (token_length),                               \
+     (token).data.scalar.style = (token_style))
+
 #define VERSION_DIRECTIVE_TOKEN_INIT(token,token_major,token_minor,start_mark,end_mark)     \
     (TOKEN_INIT((token),YAML_VERSION_DIRECTIVE_TOKEN,(start_mark),(end_mark)),  \
      (token).data.version_directive.major = (token_major),                      \
@@ -582,6 +720,23 @@ yaml_queue_extend(void **start, void **head, void **tail, void **end);
      (event).data.scalar.quoted_implicit = (event_quoted_implicit),             \
      (event).data.scalar.style = (event_style))
 
+#define SCALAR_START_EVENT_INIT(event,event_anchor,event_tag,                   \
+        event_plain_implicit,event_quoted_implicit,event_style,start_mark,end_mark) \
+    (EVENT_INIT((event),YAML_SCALAR_START_EVENT,(start_mark),(end_mark)),       \
+     (event).data.scalar.anchor = (event_anchor),                               \
+     (event).data.scalar.tag = (event_tag),                                     \
+     (event).data.scalar.plain_implicit = (event_plain_implicit),               \
+     (event).data.scalar.quoted_implicit = (event_quoted_implicit),             \
+     (event).data.scalar.style = (event_style))
+
+#define SCALAR_CHUNK_EVENT_INIT(event,event_value,event_length,start_mark,end_mark) \
+    (EVENT_INIT((event),YAML_SCALAR_CHUNK_EVENT,(start_mark),(end_mark)),       \
+     (event).data.scalar.value = (event_value),                                 \
+     (event).data.scalar.length = (event_length))
+
+#define SCALAR_END_EVENT_INIT(event,start_mark,end_mark)                        \
+    (EVENT_INIT((event),YAML_SCALAR_END_EVENT,(start_mark),(end_mark)))
+
 #define SEQUENCE_START_EVENT_INIT(event,event_anchor,event_tag,                 \
         event_implicit,event_style,start_mark,end_mark)                         \
     (EVENT_INIT((event),YAML_SEQUENCE_START_EVENT,(start_mark),(end_mark)),     \
@@ -0,0 +1,374 @@
+#include <yaml.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+/*
+ * The approximate size of a generated input.
+ */
+
+#define INPUT_SIZE  (8*1024*1024)
+
+typedef struct {
+    unsigned char *start;
+    size_t size;
+    size_t capacity;
+} buffer_t;
+
+void append(buffer_t *buffer, const char *string)
+{
+    size_t length = strlen(string);
+
+    while (buffer->size + length > buffer->capacity) {
+        buffer->capacity = buffer->capacity ? buffer->capacity*2 : 4096;
+        buffer->start = realloc(buffer->start, buffer->capacity);
+        assert(buffer->start);
+    }
+
+    memcpy(buffer->start + buffer->size, string, length);
+    buffer->size += length;
+}
+
+/*
+ * A list of services bound to structures.
+ */
+
+typedef struct {
+    char *name;
+    char *image;
+    int replicas;
+    double weight;
+    int enabled;
+    int *ports;
+    size_t port_count;
+} service_t;
+
+typedef struct {
+    service_t *services;
+    size_t service_count;
+} services_t;
+
+yaml_field_t service_fields[] = {
+    {"name", YAML_FIELD_STRING, offsetof(service_t, name),
+        YAML_FIELD_STRING, 0, NULL, YAML_FIELD_REQUIRED, NULL},
+    {"image", YAML_FIELD_STRING, offsetof(service_t, image),
+        YAML_FIELD_STRING, 0, NULL, 0, NULL},
+    {"replicas", YAML_FIELD_INT, offsetof(service_t, replicas),
+        YAML_FIELD_STRING, 0, NULL, 0, "1"},
+    {"weight", YAML_FIELD_DOUBLE, offsetof(service_t, weight),
+        YAML_FIELD_STRING, 0, NULL, 0, NULL},
+    {"enabled", YAML_FIELD_BOOL, offsetof(service_t, enabled),
+        YAML_FIELD_STRING, 0, NULL, 0, "true"},
+    {"ports", YAML_FIELD_ARRAY, offsetof(service_t, ports),
+        YAML_FIELD_INT, offsetof(service_t, port_count), NULL, 0, NULL},
+    {NULL, YAML_FIELD_STRING, 0, YAML_FIELD_STRING, 0, NULL, 0, NULL}
+};
+
+yaml_schema_t service_schema = { sizeof(service_t), service_fields };
+
+yaml_field_t services_fields[] = {
+    {"services", YAML_FIELD_ARRAY, offsetof(services_t, services),
+        YAML_FIELD_STRUCT, offsetof(services_t, service_count),
+        &service_schema, 0, NULL},
+    {NULL, YAML_FIELD_STRING, 0, YAML_FIELD_STRING, 0, NULL, 0, NULL}
+};
+
+yaml_schema_t services_schema = { sizeof(services_t), services_fields };
+
+/*
+ * Write the output of an emitter nowhere.
+ */
+
+int write_nothing(void *data, unsigned char *buffer, size_t size)
+{
+    (void)data;
+    (void)buffer;
+    (void)size;
+
+    return 1;
+}
+
+/*
+ * Print the time spent on a stage of a benchmark.
+ */
+
+void report(const char *name, buffer_t *buffer, clock_t start)
+{
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("%-24s %8.2f MB %8.3f s %8.1f MB/s\n", name,
+            buffer->size / 1048576.0, seconds,
+            seconds > 0 ? buffer->size / 1048576.0 / seconds : 0.0);
+}
+
+/*
+ * Load and dump a list of services as a document, then decode and encode it
+ * as structures.
+ */
+
+void benchmark_binding(void)
+{
+    buffer_t buffer = { NULL, 0, 0 };
+    yaml_parser_t parser;
+    yaml_emitter_t emitter;
+    yaml_document_t document;
+    yaml_binding_t binding;
+    services_t services;
+    clock_t start;
+
+    append(&buffer, "services:\n");
+    while (buffer.size < INPUT_SIZE) {
+        append(&buffer, "- name: frontend\n  image: registry.example.com/web\n"
+                "  replicas: 3\n  weight: 0.25\n  enabled: true\n"
+                "  ports: [80, 443, 8080]\n");
+    }
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_input_string(&parser, buffer.start, buffer.size);
+    start = clock();
+    assert(yaml_parser_load(&parser, &document));
+    report("load document", &buffer, start);
+    yaml_parser_delete(&parser);
+
+    assert(yaml_emitter_initialize(&emitter));
+    yaml_emitter_set_output(&emitter, write_nothing, NULL);
+    start = clock();
+    assert(yaml_emitter_dump(&emitter, &document));
+    assert(yaml_emitter_close(&emitter));
+    report("dump document", &buffer, start);
+    yaml_emitter_delete(&emitter);
+
+    assert(yaml_binding_initialize(&binding, &services_schema));
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_input_string(&parser, buffer.start, buffer.size);
+    start = clock();
+    assert(yaml_binding_decode(&binding, &parser, &services));
+    report("decode structures", &buffer, start);
+    yaml_parser_delete(&parser);
+
+    assert(services.service_count > 0
+            && services.services[0].port_count == 3);
+
+    assert(yaml_emitter_initialize(&emitter));
+    yaml_emitter_set_output(&emitter, write_nothing, NULL);
+    start = clock();
+    assert(yaml_binding_encode(&binding, &emitter, &services));
+    assert(yaml_emitter_close(&emitter));
+    report("encode structures", &buffer, start);
+    yaml_emitter_delete(&emitter);
+
+    yaml_binding_free(&binding, &services);
+    yaml_binding_delete(&binding);
+
+    free(buffer.start);
+}
+
+/*
+ * Load a commented configuration, change one value, and write it back,
+ * either dumping the whole document or copying the unchanged text.
+ */
+
+void benchmark_edit(void)
+{
+    buffer_t buffer = { NULL, 0, 0 };
+    yaml_parser_t parser;
+    yaml_emitter_t emitter;
+    yaml_document_t document, copy;
+    yaml_node_t *root;
+    clock_t start;
+
+    append(&buffer, "# Services\nservices:\n");
+    while (buffer.size < INPUT_SIZE) {
+        append(&buffer, "  # The web frontend.\n"
+                "  - name: frontend   # public\n"
+                "    image: registry.example.com/web\n"
+                "    ports: [80, 443]\n");
+    }
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_input_string(&parser, buffer.start, buffer.size);
+    yaml_parser_set_source_spans(&parser, 1);
+    assert(yaml_parser_load(&parser, &document));
+    yaml_parser_delete(&parser);
+
+    root = yaml_document_get_root_node(&document);
+    assert(yaml_document_set_scalar(&document,
+                root->data.mapping.pairs.start[0].key,
+                (yaml_char_t *)"deployments", -1));
+
+    assert(yaml_document_copy(&copy, &document));
+    assert(yaml_emitter_initialize(&emitter));
+    yaml_emitter_set_output(&emitter, write_nothing, NULL);
+    start = clock();
+    assert(yaml_emitter_dump(&emitter, &copy));
+    assert(yaml_emitter_close(&emitter));
+    report("dump edited document", &buffer, start);
+    yaml_emitter_delete(&emitter);
+
+    assert(yaml_emitter_initialize(&emitter));
+    yaml_emitter_set_output(&emitter, write_nothing, NULL);
+    start = clock();
+    assert(yaml_emitter_dump_edited(&emitter, &document,
+                buffer.start, buffer.size));
+    report("copy edited document", &buffer, start);
+    yaml_emitter_delete(&emitter);
+
+    yaml_document_delete(&document);
+
+    free(buffer.start);
+}
+
+/*
+ * Binary scalars loaded as base64 text and as decoded octets, and dumped
+ * back.  The difference between each pair of runs is the cost of the base64
+ * codec, which should stay small next to scanning and emitting the text.
+ */
+
+void benchmark_binary(void)
+{
+    const char *names[] = { "binary as text", "binary decoded" };
+    buffer_t buffer = { NULL, 0, 0 };
+    yaml_parser_t parser;
+    yaml_emitter_t emitter;
+    yaml_document_t document;
+    clock_t start;
+    int decode;
+    int lines;
+
+    while (buffer.size < INPUT_SIZE) {
+        append(&buffer, "- !!binary |\n");
+        for (lines = 0; lines < 100; lines ++) {
+            append(&buffer, "  MIIDdzCCAl+gAwIBAgIEAgAAuTANBgkqhkiG9w0BAQUFADBaMQswCQYDVQQG"
+                    "EwJJRTESMBAG\n");
+        }
+    }
+
+    for (decode = 0; decode < 2; decode ++) {
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_input_string(&parser, buffer.start, buffer.size);
+        yaml_parser_set_decode_binary(&parser, decode);
+        start = clock();
+        assert(yaml_parser_load(&parser, &document));
+        report(names[decode], &buffer, start);
+        yaml_parser_delete(&parser);
+
+        assert(yaml_emitter_initialize(&emitter));
+        yaml_emitter_set_output(&emitter, write_nothing, NULL);
+        start = clock();
+        assert(yaml_emitter_dump(&emitter, &document));
+        assert(yaml_emitter_close(&emitter));
+        report(decode ? "dump binary decoded" : "dump binary as text",
+                &buffer, start);
+        yaml_emitter_delete(&emitter);
+    }
+
+    free(buffer.start);
+}
+
+/*
+ * A shared file loaded repeatedly, parsed every time and through a document
+ * cache.
+ */
+
+void benchmark_cache(void)
+{
+    const char *path = "run-benchmark-cache.yaml";
+    buffer_t buffer = { NULL, 0, 0 };
+    buffer_t total;
+    yaml_document_cache_t cache;
+    yaml_parser_t parser;
+    yaml_document_t document;
+    const yaml_document_t *cached;
+    clock_t start;
+    FILE *file;
+    int k;
+
+    while (buffer.size < INPUT_SIZE/8) {
+        append(&buffer, "- {name: frontend, image: registry.example.com/web, "
+                "ports: [80, 443], enabled: true}\n");
+    }
+    file = fopen(path, "wb");
+    assert(file);
+    assert(fwrite(buffer.start, 1, buffer.size, file) == buffer.size);
+    assert(fclose(file) == 0);
+
+    total = buffer;
+    total.size *= 16;
+
+    start = clock();
+    for (k = 0; k < 16; k ++) {
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_input_string(&parser, buffer.start, buffer.size);
+        assert(yaml_parser_load(&parser, &document));
+        yaml_document_delete(&document);
+        yaml_parser_delete(&parser);
+    }
+    report("load uncached", &total, start);
+
+    assert(yaml_document_cache_initialize(&cache, INPUT_SIZE*8, 0));
+    start = clock();
+    for (k = 0; k < 16; k ++) {
+        assert(yaml_parser_initialize(&parser));
+        assert(yaml_document_cache_load(&cache, &parser, path, &cached));
+        yaml_document_cache_release(&cache, cached);
+        yaml_parser_delete(&parser);
+    }
+    report("load cached", &total, start);
+    yaml_document_cache_delete(&cache);
+
+    remove(path);
+    free(buffer.start);
+}
+
+typedef struct {
+    const char *name;
+    void (*run)(void);
+} benchmark_t;
+
+benchmark_t benchmarks[] = {
+    { "binding", benchmark_binding },
+    { "edit", benchmark_edit },
+    { "binary", benchmark_binary },
+    { "cache", benchmark_cache },
+    { NULL, NULL }
+};
+
+int
+main(int argc, char *argv[])
+{
+    int number;
+    int k;
+
+    if (argc < 2) {
+        for (k = 0; benchmarks[k].name; k ++) {
+            benchmarks[k].run();
+        }
+        return 0;
+    }
+
+    for (number = 1; number < argc; number ++) {
+        for (k = 0; benchmarks[k].name; k ++) {
+            if (strcmp(argv[number], benchmarks[k].name) == 0)
+                break;
+        }
+        if (!benchmarks[k].name) {
+            printf("Usage: %s [benchmark ...]\nBenchmarks:", argv[0]);
+            for (k = 0; benchmarks[k].name; k ++) {
+                printf(" %s", benchmarks[k].name);
+            }
+            printf("\n");
+            return 1;
+        }
+        benchmarks[k].run();
+    }
+
+    return 0;
+}
@@ -0,0 +1,248 @@
+#include <yaml.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+/*
+ * The approximate size of a generated input.
+ */
+
+#define INPUT_SIZE  (8*1024*1024)
+
+typedef struct {
+    unsigned char *start;
+    size_t size;
+    size_t capacity;
+} buffer_t;
+
+void append(buffer_t *buffer, const char *string)
+{
+    size_t length = strlen(string);
+
+    while (buffer->size + length > buffer->capacity) {
+        buffer->capacity = buffer->capacity ? buffer->capacity*2 : 4096;
+        buffer->start = realloc(buffer->start, buffer->capacity);
+        assert(buffer->start);
+    }
+
+    memcpy(buffer->start + buffer->size, string, length);
+    buffer->size += length;
+}
+
+/*
+ * Append the output of an event log writer to a buffer.
+ */
+
+int write_log(void *data, unsigned char *octets, size_t size)
+{
+    buffer_t *buffer = (buffer_t *)data;
+
+    while (buffer->size + size > buffer->capacity) {
+        buffer->capacity = buffer->capacity ? buffer->capacity*2 : 4096;
+        buffer->start = realloc(buffer->start, buffer->capacity);
+        assert(buffer->start);
+    }
+
+    memcpy(buffer->start + buffer->size, octets, size);
+    buffer->size += size;
+
+    return 1;
+}
+
+/*
+ * Parse a configuration-like input while recording an event log, then
+ * replay the log.
+ */
+
+void benchmark_event_log(void)
+{
+    buffer_t buffer = { NULL, 0, 0 };
+    buffer_t log = { NULL, 0, 0 };
+    yaml_parser_t parser;
+    yaml_event_log_writer_t writer;
+    yaml_event_log_reader_t reader;
+    yaml_event_t event;
+    clock_t start;
+    double seconds;
+    long count = 0;
+    int done = 0;
+
+    while (buffer.size < INPUT_SIZE) {
+        append(&buffer, "- name: service\n  image: \"registry.example.com/app:1.2\"\n"
+                "  ports: [80, 443]\n  env: {MODE: production, DEBUG: false}\n");
+    }
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_input_string(&parser, buffer.start, buffer.size);
+    assert(yaml_event_log_writer_initialize(&writer, 0));
+    yaml_event_log_writer_set_output(&writer, write_log, &log);
+
+    start = clock();
+
+    while (!done) {
+        assert(yaml_parser_parse(&parser, &event));
+        done = (event.type == YAML_STREAM_END_EVENT);
+        assert(yaml_event_log_write(&writer, &event));
+        yaml_event_delete(&event);
+        count ++;
+    }
+
+    seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    yaml_event_log_writer_delete(&writer);
+    yaml_parser_delete(&parser);
+
+    printf("%-24s %8.2f MB %10ld events %8.3f s %8.1f MB/s\n", "parse and record",
+            buffer.size / 1048576.0, count, seconds,
+            seconds > 0 ? buffer.size / 1048576.0 / seconds : 0.0);
+
+    assert(yaml_event_log_reader_initialize(&reader, log.start, log.size));
+
+    start = clock();
+
+    for (count = 0; ; count ++) {
+        assert(yaml_event_log_read(&reader, &event));
+        if (event.type == YAML_NO_EVENT) break;
+        yaml_event_delete(&event);
+    }
+
+    seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    yaml_event_log_reader_delete(&reader);
+
+    printf("%-24s %8.2f MB %10ld events %8.3f s %8.1f MB/s\n", "replay",
+            log.size / 1048576.0, count, seconds,
+            seconds > 0 ? buffer.size / 1048576.0 / seconds : 0.0);
+
+    free(buffer.start);
+    free(log.start);
+}
+
+/*
+ * Write the output of an emitter nowhere.
+ */
+
+int write_nothing(void *data, unsigned char *buffer, size_t size)
+{
+    (void)data;
+    (void)buffer;
+    (void)size;
+
+    return 1;
+}
+
+/*
+ * Print the time spent on a stage of a benchmark.
+ */
+
+void report(const char *name, buffer_t *buffer, clock_t start)
+{
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("%-24s %8.2f MB %8.3f s %8.1f MB/s\n", name,
+            buffer->size / 1048576.0, seconds,
+            seconds > 0 ? buffer->size / 1048576.0 / seconds : 0.0);
+}
+
+/*
+ * Parse a configuration-like input and emit every event, either passing it
+ * over to the emitter or lending it.
+ */
+
+void benchmark_passthrough(void)
+{
+    const char *names[] = { "emit events", "emit borrowed events" };
+    buffer_t buffer = { NULL, 0, 0 };
+    int mode;
+
+    while (buffer.size < INPUT_SIZE) {
+        append(&buffer, "- name: service\n  image: 'registry.example.com/app:1.2'\n"
+                "  command: \"run --port 8080\"\n  ports: [80, 443]\n"
+                "  env: {MODE: production, DEBUG: false}\n");
+    }
+
+    for (mode = 0; mode < 2; mode ++) {
+        yaml_parser_t parser;
+        yaml_emitter_t emitter;
+        yaml_event_t event;
+        clock_t start;
+        int done = 0;
+
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_input_string(&parser, buffer.start, buffer.size);
+        assert(yaml_emitter_initialize(&emitter));
+        yaml_emitter_set_output(&emitter, write_nothing, NULL);
+
+        start = clock();
+
+        while (!done) {
+            assert(yaml_parser_parse(&parser, &event));
+            done = (event.type == YAML_STREAM_END_EVENT);
+            if (mode) {
+                assert(yaml_emitter_emit_borrowed(&emitter, &event, 1));
+                yaml_event_delete(&event);
+            }
+            else {
+                assert(yaml_emitter_emit(&emitter, &event));
+            }
+        }
+
+        report(names[mode], &buffer, start);
+
+        yaml_emitter_delete(&emitter);
+        yaml_parser_delete(&parser);
+    }
+
+    free(buffer.start);
+}
+
+typedef struct {
+    const char *name;
+    void (*run)(void);
+} benchmark_t;
+
+benchmark_t benchmarks[] = {
+    { "eventlog", benchmark_event_log },
+    { "passthrough", benchmark_passthrough },
+    { NULL, NULL }
+};
+
+int
+main(int argc, char *argv[])
+{
+    int number;
+    int k;
+
+    if (argc < 2) {
+        for (k = 0; benchmarks[k].name; k ++) {
+            benchmarks[k].run();
+        }
+        return 0;
+    }
+
+    for (number = 1; number < argc; number ++) {
+        for (k = 0; benchmarks[k].name; k ++) {
+            if (strcmp(argv[number], benchmarks[k].name) == 0)
+                break;
+        }
+        if (!benchmarks[k].name) {
+            printf("Usage: %s [benchmark ...]\nBenchmarks:", argv[0]);
+            for (k = 0; benchmarks[k].name; k ++) {
+                printf(" %s", benchmarks[k].name);
+            }
+            printf("\n");
+            return 1;
+        }
+        benchmarks[k].run();
+    }
+
+    return 0;
+}
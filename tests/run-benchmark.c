@@ -0,0 +1,407 @@
+#include <yaml.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+/*
+ * The approximate size of a generated input.
+ */
+
+#define INPUT_SIZE  (8*1024*1024)
+
+typedef struct {
+    unsigned char *start;
+    size_t size;
+    size_t capacity;
+} buffer_t;
+
+void append(buffer_t *buffer, const char *string)
+{
+    size_t length = strlen(string);
+
+    while (buffer->size + length > buffer->capacity) {
+        buffer->capacity = buffer->capacity ? buffer->capacity*2 : 4096;
+        buffer->start = realloc(buffer->start, buffer->capacity);
+        assert(buffer->start);
+    }
+
+    memcpy(buffer->start + buffer->size, string, length);
+    buffer->size += length;
+}
+
+/*
+ * Scan the input and report the number of tokens and the time spent.
+ */
+
+void scan(const char *name, buffer_t *buffer)
+{
+    yaml_parser_t parser;
+    yaml_token_t token;
+    clock_t start;
+    double seconds;
+    long count = 0;
+    int done = 0;
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_input_string(&parser, buffer->start, buffer->size);
+
+    start = clock();
+
+    while (!done) {
+        assert(yaml_parser_scan(&parser, &token));
+        done = (token.type == YAML_STREAM_END_TOKEN);
+        yaml_token_delete(&token);
+        count ++;
+    }
+
+    seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    yaml_parser_delete(&parser);
+
+    printf("%-24s %8.2f MB %10ld tokens %8.3f s %8.1f MB/s\n", name,
+            buffer->size / 1048576.0, count, seconds,
+            seconds > 0 ? buffer->size / 1048576.0 / seconds : 0.0);
+}
+
+/*
+ * Nested flow collections on a single line, as in minified JSON.
+ */
+
+void benchmark_depth(void)
+{
+    int depths[] = { 1, 16, 64, 256, 1024, 4096, 0 };
+    int k;
+
+    for (k = 0; depths[k]; k ++) {
+        buffer_t buffer = { NULL, 0, 0 };
+        char name[64];
+        int level;
+
+        append(&buffer, "[");
+        while (buffer.size < INPUT_SIZE) {
+            for (level = 0; level < depths[k]; level ++) {
+                append(&buffer, "{\"key\": [1, \"two\", ");
+            }
+            append(&buffer, "3");
+            for (level = 0; level < depths[k]; level ++) {
+                append(&buffer, "]}");
+            }
+            append(&buffer, ", ");
+        }
+        append(&buffer, "0]\n");
+
+        sprintf(name, "depth %d", depths[k]);
+        scan(name, &buffer);
+
+        free(buffer.start);
+    }
+}
+
+/*
+ * Large literal and folded block scalars, as in embedded certificates and
+ * scripts.
+ */
+
+void benchmark_block(void)
+{
+    const char *styles[] = { "|", ">", "|-", NULL };
+    const char *line = "MIIDdzCCAl+gAwIBAgIEAgAAuTANBgkqhkiG9w0BAQUFADBaMQswCQYDVQQGEwJJ"
+        "RTESMBA\n";
+    int k;
+
+    for (k = 0; styles[k]; k ++) {
+        buffer_t buffer = { NULL, 0, 0 };
+        char name[64];
+        int lines;
+
+        while (buffer.size < INPUT_SIZE) {
+            append(&buffer, "certificate: ");
+            append(&buffer, styles[k]);
+            append(&buffer, "\n");
+            for (lines = 0; lines < 1000; lines ++) {
+                append(&buffer, "    ");
+                append(&buffer, line);
+                if (lines % 100 == 99) {
+                    append(&buffer, "\n      indented\n");
+                }
+            }
+        }
+
+        sprintf(name, "block %s", styles[k]);
+        scan(name, &buffer);
+
+        free(buffer.start);
+    }
+}
+
+/*
+ * Double- and single-quoted scalars, as in YAML converted from JSON.
+ */
+
+void benchmark_quoted(void)
+{
+    const char *records[] = {
+        "- {\"id\": \"7f3c9a2e-58d1-4c0b-9e4f-2a6d8b1c0e53\", "
+            "\"name\": \"Quoted scalar with several words in it\", "
+            "\"path\": \"C:\\\\Program Files\\\\Example\\\\bin\", "
+            "\"note\": \"caf\\u00e9 \\x41\\t\\U0001F600\"}\n",
+        "- {'id': '7f3c9a2e-58d1-4c0b-9e4f-2a6d8b1c0e53', "
+            "'name': 'Quoted scalar with several words in it', "
+            "'path': 'it''s a quote'}\n",
+        NULL
+    };
+    const char *names[] = { "quoted double", "quoted single" };
+    int k;
+
+    for (k = 0; records[k]; k ++) {
+        buffer_t buffer = { NULL, 0, 0 };
+
+        while (buffer.size < INPUT_SIZE) {
+            append(&buffer, records[k]);
+        }
+
+        scan(names[k], &buffer);
+
+        free(buffer.start);
+    }
+}
+
+/*
+ * Heavily commented input with blank lines, as in annotated configuration
+ * files.
+ */
+
+void benchmark_comments(void)
+{
+    buffer_t buffer = { NULL, 0, 0 };
+    int lines;
+
+    while (buffer.size < INPUT_SIZE) {
+        append(&buffer, "# Licensed under the Apache License, Version 2.0 "
+                "(the \"License\");\n");
+        for (lines = 0; lines < 20; lines ++) {
+            append(&buffer, "#   you may not use this file except in compliance "
+                    "with the License.\n");
+        }
+        append(&buffer, "\n\n        \n");
+        append(&buffer, "key: value    # a trailing comment on the same line\n");
+        append(&buffer, "list:\n");
+        append(&buffer, "    # an indented comment before the items\n");
+        append(&buffer, "    - item          # another trailing comment\n");
+        append(&buffer, "\n");
+    }
+
+    scan("comments", &buffer);
+
+    free(buffer.start);
+}
+
+/*
+ * Pretty-printed JSON records, scanned with and without the JSON fast path.
+ */
+
+void benchmark_json(void)
+{
+    buffer_t buffer = { NULL, 0, 0 };
+    yaml_json_mode_t modes[] = { YAML_JSON_DISABLED, YAML_JSON_ENABLED };
+    const char *names[] = { "json general", "json fast" };
+    int k;
+
+    append(&buffer, "[\n");
+    while (buffer.size < INPUT_SIZE) {
+        append(&buffer, "  {\n    \"id\": 1024,\n    \"name\": \"record\",\n"
+                "    \"score\": -12.5e3,\n    \"active\": true,\n"
+                "    \"parent\": null,\n    \"tags\": [\"a\", \"b\", \"c\"]\n  },\n");
+    }
+    append(&buffer, "  {}\n]\n");
+
+    for (k = 0; k < 2; k ++) {
+        yaml_parser_t parser;
+        yaml_token_t token;
+        clock_t start;
+        double seconds;
+        long count = 0;
+        int done = 0;
+
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_json(&parser, modes[k]);
+        yaml_parser_set_input_string(&parser, buffer.start, buffer.size);
+
+        start = clock();
+
+        while (!done) {
+            assert(yaml_parser_scan(&parser, &token));
+            done = (token.type == YAML_STREAM_END_TOKEN);
+            yaml_token_delete(&token);
+            count ++;
+        }
+
+        seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        yaml_parser_delete(&parser);
+
+        printf("%-24s %8.2f MB %10ld tokens %8.3f s %8.1f MB/s\n", names[k],
+                buffer.size / 1048576.0, count, seconds,
+                seconds > 0 ? buffer.size / 1048576.0 / seconds : 0.0);
+    }
+
+    free(buffer.start);
+}
+
+/*
+ * Print the time spent on a stage of a benchmark.
+ */
+
+void report(const char *name, buffer_t *buffer, clock_t start)
+{
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("%-24s %8.2f MB %8.3f s %8.1f MB/s\n", name,
+            buffer->size / 1048576.0, seconds,
+            seconds > 0 ? buffer->size / 1048576.0 / seconds : 0.0);
+}
+
+/*
+ * A single literal scalar spanning the whole input, parsed whole and in
+ * chunks.
+ */
+
+void benchmark_chunks(void)
+{
+    const char *names[] = { "scalar whole", "scalar chunks" };
+    buffer_t buffer = { NULL, 0, 0 };
+    yaml_parser_t parser;
+    yaml_event_t event;
+    clock_t start;
+    int mode;
+
+    append(&buffer, "payload: |\n");
+    while (buffer.size < INPUT_SIZE) {
+        append(&buffer, "  MIIDdzCCAl+gAwIBAgIEAgAAuTANBgkqhkiG9w0BAQUFADBaMQswCQYDVQQG"
+                "EwJJRTESMBA\n");
+    }
+
+    for (mode = 0; mode < 2; mode ++) {
+        int done = 0;
+
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_input_string(&parser, buffer.start, buffer.size);
+        if (mode) {
+            yaml_parser_set_scalar_chunk_size(&parser, 64*1024);
+        }
+        start = clock();
+        while (!done) {
+            assert(yaml_parser_parse(&parser, &event));
+            done = (event.type == YAML_STREAM_END_EVENT);
+            yaml_event_delete(&event);
+        }
+        report(names[mode], &buffer, start);
+        yaml_parser_delete(&parser);
+    }
+
+    free(buffer.start);
+}
+
+/*
+ * Block mappings parsed without and with the error recovery, and with an
+ * error in every tenth entry.
+ */
+
+void benchmark_recovery(void)
+{
+    const char *names[] = { "parse strict", "parse recovering",
+        "parse with errors" };
+    buffer_t buffers[2] = { { NULL, 0, 0 }, { NULL, 0, 0 } };
+    yaml_parser_t parser;
+    yaml_event_t event;
+    clock_t start;
+    int mode;
+    int k;
+
+    for (k = 0; buffers[0].size < INPUT_SIZE; k ++) {
+        const char *entry = "- name: frontend\n  image: registry.example.com/web\n"
+            "  ports:\n    - 80\n    - 443\n";
+        append(&buffers[0], entry);
+        append(&buffers[1], (k % 10) ? entry : "- name: frontend: web\n"
+                "  image: registry.example.com/web\n  ports:\n    - 80\n"
+                "    - 443\n");
+    }
+
+    for (mode = 0; mode < 3; mode ++) {
+        buffer_t *buffer = &buffers[mode / 2];
+        int done = 0;
+
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_input_string(&parser, buffer->start, buffer->size);
+        yaml_parser_set_recover_errors(&parser, mode > 0);
+        start = clock();
+        while (!done) {
+            assert(yaml_parser_parse(&parser, &event));
+            done = (event.type == YAML_STREAM_END_EVENT);
+            yaml_event_delete(&event);
+        }
+        report(names[mode], buffer, start);
+        assert((size_t)(parser.errors.top - parser.errors.start)
+                == (mode == 2 ? (size_t)(k + 9) / 10 : 0));
+        yaml_parser_delete(&parser);
+    }
+
+    free(buffers[0].start);
+    free(buffers[1].start);
+}
+
+typedef struct {
+    const char *name;
+    void (*run)(void);
+} benchmark_t;
+
+benchmark_t benchmarks[] = {
+    { "depth", benchmark_depth },
+    { "block", benchmark_block },
+    { "quoted", benchmark_quoted },
+    { "comments", benchmark_comments },
+    { "json", benchmark_json },
+    { "chunks", benchmark_chunks },
+    { "recovery", benchmark_recovery },
+    { NULL, NULL }
+};
+
+int
+main(int argc, char *argv[])
+{
+    int number;
+    int k;
+
+    if (argc < 2) {
+        for (k = 0; benchmarks[k].name; k ++) {
+            benchmarks[k].run();
+        }
+        return 0;
+    }
+
+    for (number = 1; number < argc; number ++) {
+        for (k = 0; benchmarks[k].name; k ++) {
+            if (strcmp(argv[number], benchmarks[k].name) == 0)
+                break;
+        }
+        if (!benchmarks[k].name) {
+            printf("Usage: %s [benchmark ...]\nBenchmarks:", argv[0]);
+            for (k = 0; benchmarks[k].name; k ++) {
+                printf(" %s", benchmarks[k].name);
+            }
+            printf("\n");
+            return 1;
+        }
+        benchmarks[k].run();
+    }
+
+    return 0;
+}
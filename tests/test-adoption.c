@@ -0,0 +1,51 @@
+#include "test-helpers.h"
+
+int check_adoption(void)
+{
+    yaml_document_t document, expected;
+    yaml_char_t *value;
+    int mapping, sequence, key, item;
+    int failed = 0;
+
+    printf("checking adoption...\n");
+
+    assert(yaml_document_initialize(&document, NULL, NULL, NULL, 1, 1));
+    assert(yaml_document_reserve_nodes(&document, 4));
+    mapping = yaml_document_adopt_mapping(&document, NULL,
+            YAML_ANY_MAPPING_STYLE, 0);
+    assert(mapping && yaml_document_reserve_pairs(&document, mapping, 1));
+    key = yaml_document_adopt_scalar(&document, (yaml_char_t *)"!k",
+            (yaml_char_t *)"key", -1, YAML_ANY_SCALAR_STYLE,
+            YAML_ADOPT_BORROWED);
+    sequence = yaml_document_adopt_sequence(&document, NULL,
+            YAML_ANY_SEQUENCE_STYLE, 0);
+    assert(key && sequence && yaml_document_reserve_items(&document,
+                sequence, 2));
+    assert(yaml_document_append_mapping_pair(&document, mapping,
+                key, sequence));
+    value = malloc(6);
+    memcpy(value, "value", 6);
+    item = yaml_document_adopt_scalar(&document, NULL, value, 5,
+            YAML_ANY_SCALAR_STYLE, YAML_ADOPT_TRUSTED);
+    assert(item && yaml_document_append_sequence_item(&document,
+                sequence, item));
+    failed |= yaml_document_adopt_scalar(&document, NULL,
+            (yaml_char_t *)"\xff", 1, YAML_ANY_SCALAR_STYLE,
+            YAML_ADOPT_BORROWED);
+
+    load("!k key: [value]", &expected);
+    failed |= !yaml_document_equal(&document, &expected);
+
+    yaml_document_delete(&expected);
+    yaml_document_delete(&document);
+
+    printf("checking adoption: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_adoption();
+}
@@ -0,0 +1,108 @@
+#include <yaml.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+int load_binary(const char *input, yaml_document_t *document)
+{
+    yaml_parser_t parser;
+    int result;
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_input_string(&parser,
+            (const unsigned char *)input, strlen(input));
+    yaml_parser_set_decode_binary(&parser, 1);
+    result = yaml_parser_load(&parser, document);
+    assert(result || parser.error == YAML_COMPOSER_ERROR);
+    yaml_parser_delete(&parser);
+
+    return result;
+}
+
+int check_binary(void)
+{
+    const char *valid[] = {
+        "!!binary AAEC/w==", "!!binary |\n  AAE\n  C/w\n",
+        "!!binary AAEC/w", "[!!binary \"AA EC /w ==\"]", NULL
+    };
+    const char *invalid[] = {
+        "!!binary AAEC/w=", "!!binary AAEC/", "!!binary AA=C", "!!binary A*==",
+        NULL
+    };
+    yaml_document_t document, loaded;
+    yaml_emitter_t emitter;
+    yaml_node_t *node;
+    yaml_char_t octets[256];
+    unsigned char output[1024];
+    size_t size;
+    size_t k, width;
+    int failed = 0;
+
+    printf("checking binary scalars...\n");
+
+    for (k = 0; valid[k]; k ++) {
+        assert(load_binary(valid[k], &document));
+        node = yaml_document_get_node(&document, k < 3 ? 1 : 2);
+        if (node->resolved.type != YAML_BINARY_SCALAR_TYPE
+                || node->data.scalar.length != 4
+                || memcmp(node->data.scalar.value, "\x00\x01\x02\xFF", 4)) {
+            printf("\t%s: unexpected octets\n", valid[k]);
+            failed = 1;
+        }
+        yaml_document_delete(&document);
+    }
+
+    for (k = 0; invalid[k]; k ++) {
+        if (load_binary(invalid[k], &document)) {
+            printf("\t%s: expected an error\n", invalid[k]);
+            yaml_document_delete(&document);
+            failed = 1;
+        }
+    }
+
+    /* The dumper wraps the base64 text at the preferred width. */
+
+    for (k = 0; k < sizeof(octets); k ++) {
+        octets[k] = (yaml_char_t)k;
+    }
+    assert(load_binary("a: !!binary ''\nb: [!!binary '']\n", &document));
+    assert(yaml_document_set_scalar(&document, 3, octets, sizeof(octets)));
+    assert(yaml_document_set_scalar(&document, 6, octets, 5));
+    assert(yaml_document_copy(&loaded, &document));
+
+    assert(yaml_emitter_initialize(&emitter));
+    yaml_emitter_set_width(&emitter, 40);
+    yaml_emitter_set_output_string(&emitter, output, sizeof(output), &size);
+    assert(yaml_emitter_open(&emitter));
+    assert(yaml_emitter_dump(&emitter, &loaded));
+    assert(yaml_emitter_close(&emitter));
+    yaml_emitter_delete(&emitter);
+
+    for (k = 0, width = 0; k < size; k ++) {
+        width = (output[k] == '\n' || (output[k] == ' ' && !width))
+            ? 0 : width + 1;
+        failed |= (width > 40);
+    }
+    output[size] = '\0';
+    failed |= !strstr((char *)output, "[!!binary \"AAECAwQ=\"]");
+
+    assert(load_binary((char *)output, &loaded));
+    failed |= !yaml_document_equal(&document, &loaded);
+    yaml_document_delete(&loaded);
+    yaml_document_delete(&document);
+
+    printf("checking binary scalars: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_binary();
+}
@@ -0,0 +1,216 @@
+#include <yaml.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+typedef struct {
+    char *host;
+    int port;
+} endpoint_t;
+
+typedef struct {
+    int cpu;
+    double memory;
+} limits_t;
+
+typedef struct {
+    char *name;
+    int64_t size;
+    double ratio;
+    int enabled;
+    endpoint_t primary;
+    limits_t limits;
+    endpoint_t *replicas;
+    size_t replica_count;
+    char **tags;
+    size_t tag_count;
+} service_t;
+
+yaml_field_t endpoint_fields[] = {
+    {"host", YAML_FIELD_STRING, offsetof(endpoint_t, host),
+        YAML_FIELD_STRING, 0, NULL, YAML_FIELD_REQUIRED, NULL},
+    {"port", YAML_FIELD_INT, offsetof(endpoint_t, port),
+        YAML_FIELD_STRING, 0, NULL, 0, "80"},
+    {NULL, YAML_FIELD_STRING, 0, YAML_FIELD_STRING, 0, NULL, 0, NULL}
+};
+
+yaml_schema_t endpoint_schema = { sizeof(endpoint_t), endpoint_fields };
+
+yaml_field_t limits_fields[] = {
+    {"cpu", YAML_FIELD_INT, offsetof(limits_t, cpu),
+        YAML_FIELD_STRING, 0, NULL, 0, "1"},
+    {"memory", YAML_FIELD_DOUBLE, offsetof(limits_t, memory),
+        YAML_FIELD_STRING, 0, NULL, 0, "0.25"},
+    {NULL, YAML_FIELD_STRING, 0, YAML_FIELD_STRING, 0, NULL, 0, NULL}
+};
+
+yaml_schema_t limits_schema = { sizeof(limits_t), limits_fields };
+
+yaml_field_t service_fields[] = {
+    {"name", YAML_FIELD_STRING, offsetof(service_t, name),
+        YAML_FIELD_STRING, 0, NULL, YAML_FIELD_REQUIRED, NULL},
+    {"size", YAML_FIELD_INT64, offsetof(service_t, size),
+        YAML_FIELD_STRING, 0, NULL, 0, NULL},
+    {"ratio", YAML_FIELD_DOUBLE, offsetof(service_t, ratio),
+        YAML_FIELD_STRING, 0, NULL, 0, "0.5"},
+    {"enabled", YAML_FIELD_BOOL, offsetof(service_t, enabled),
+        YAML_FIELD_STRING, 0, NULL, 0, "true"},
+    {"primary", YAML_FIELD_STRUCT, offsetof(service_t, primary),
+        YAML_FIELD_STRING, 0, &endpoint_schema, 0, NULL},
+    {"limits", YAML_FIELD_STRUCT, offsetof(service_t, limits),
+        YAML_FIELD_STRING, 0, &limits_schema, 0, NULL},
+    {"replicas", YAML_FIELD_ARRAY, offsetof(service_t, replicas),
+        YAML_FIELD_STRUCT, offsetof(service_t, replica_count),
+        &endpoint_schema, 0, NULL},
+    {"tags", YAML_FIELD_ARRAY, offsetof(service_t, tags),
+        YAML_FIELD_STRING, offsetof(service_t, tag_count), NULL, 0, NULL},
+    {NULL, YAML_FIELD_STRING, 0, YAML_FIELD_STRING, 0, NULL, 0, NULL}
+};
+
+yaml_schema_t service_schema = { sizeof(service_t), service_fields };
+
+const char *invalid_services[] = {
+    "size: 1\n",
+    "name: a\nsize: x\n",
+    "name: a\nenabled: 1\n",
+    "name: a\nprimary: {port: 1}\n",
+    "name: a\n",
+    "name: a\nprimary: ~\n",
+    "name: a\nprimary: [a]\n",
+    "name: a\nreplicas: [{host: b, port: 99999999999}]\n",
+    "name: a\nname: b\n",
+    "name: a\nprimary: {host: b}\nsize: '42'\n",
+    "name: a\nprimary: {host: b}\nenabled: \"true\"\n",
+    "name: a\nprimary: {host: b}\nratio: !!str 1.5\n",
+    "name: a\nprimary: {host: b, port: !!str 80}\n",
+    "name: &n a\nprimary: {host: *n}\n",
+    "[a]",
+    "~",
+    "---\n",
+    "name",
+    NULL
+};
+
+int decode_service(yaml_binding_t *binding, const char *input,
+        int expand, service_t *service)
+{
+    yaml_parser_t parser;
+    int result;
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_expand_aliases(&parser, expand, 0, 0);
+    yaml_parser_set_input_string(&parser,
+            (const unsigned char *)input, strlen(input));
+    result = yaml_binding_decode(binding, &parser, service);
+    yaml_parser_delete(&parser);
+
+    return result;
+}
+
+int check_binding(void)
+{
+    const char *input = "name: web\nsize: 0x10\nextra: {a: [b, {c: d}]}\n"
+        "primary: {host: &h example.com}\n"
+        "replicas:\n- {host: a, port: 8080}\n- host: *h\n"
+        "tags: [x, 'y', null]\n";
+    const char *stream = "--- {name: a, primary: {host: h}}\n"
+        "--- {name: b, ratio: 2, primary: {host: h}}\n";
+    yaml_binding_t binding;
+    yaml_parser_t parser;
+    yaml_emitter_t emitter;
+    service_t service;
+    unsigned char output[1024];
+    size_t output_size;
+    int failed = 0;
+    int k;
+
+    printf("checking struct binding...\n");
+
+    assert(yaml_binding_initialize(&binding, &service_schema));
+
+    failed |= !decode_service(&binding, input, 1, &service);
+    failed |= (strcmp(service.name, "web") != 0 || service.size != 16
+            || service.ratio != 0.5 || service.enabled != 1
+            || strcmp(service.primary.host, "example.com") != 0
+            || service.primary.port != 80 || service.replica_count != 2
+            || strcmp(service.replicas[0].host, "a") != 0
+            || service.replicas[0].port != 8080
+            || strcmp(service.replicas[1].host, "example.com") != 0
+            || service.tag_count != 3 || strcmp(service.tags[1], "y") != 0
+            || service.tags[2] != NULL || service.limits.cpu != 1
+            || service.limits.memory != 0.25);
+    yaml_binding_free(&binding, &service);
+    failed |= (service.name != NULL || service.replicas != NULL);
+
+    /* Explicit core tags are converted whatever the style. */
+
+    failed |= !decode_service(&binding, "name: !!str 1\nsize: !!int '42'\n"
+            "primary: {host: a}\nlimits: {cpu: 2}\n", 0, &service);
+    failed |= (strcmp(service.name, "1") != 0 || service.size != 42
+            || service.limits.cpu != 2 || service.limits.memory != 0.25);
+    yaml_binding_free(&binding, &service);
+
+    for (k = 0; invalid_services[k]; k ++) {
+        if (decode_service(&binding, invalid_services[k], 0, &service)
+                || service.name || service.replicas || service.tags) {
+            printf("\t%s: expected an error\n", invalid_services[k]);
+            failed = 1;
+        }
+    }
+
+    /* Every document is decoded in turn. */
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_input_string(&parser,
+            (const unsigned char *)stream, strlen(stream));
+    failed |= !yaml_binding_decode(&binding, &parser, &service);
+    failed |= (strcmp(service.name, "a") != 0);
+    yaml_binding_free(&binding, &service);
+    failed |= !yaml_binding_decode(&binding, &parser, &service);
+    failed |= (strcmp(service.name, "b") != 0 || service.ratio != 2.0);
+    yaml_binding_free(&binding, &service);
+    failed |= !yaml_binding_decode(&binding, &parser, &service);
+    failed |= (service.name || !parser.stream_end_produced);
+    yaml_parser_delete(&parser);
+
+    /* An encoded structure is decoded back. */
+
+    failed |= !decode_service(&binding, input, 1, &service);
+    free(service.name);
+    service.name = (char *)malloc(5);
+    memcpy(service.name, "true", 5);
+    service.tags[0][0] = '\0';
+    assert(yaml_emitter_initialize(&emitter));
+    yaml_emitter_set_output_string(&emitter, output, sizeof(output)-1,
+            &output_size);
+    failed |= !yaml_binding_encode(&binding, &emitter, &service);
+    failed |= !yaml_emitter_close(&emitter);
+    yaml_emitter_delete(&emitter);
+    yaml_binding_free(&binding, &service);
+
+    output[output_size] = '\0';
+    failed |= !decode_service(&binding, (char *)output, 0, &service);
+    failed |= (strcmp(service.name, "true") != 0 || service.size != 16
+            || service.primary.port != 80 || service.replica_count != 2
+            || service.replicas[1].port != 80 || service.tag_count != 3
+            || strcmp(service.tags[0], "") != 0 || service.tags[2] != NULL);
+    yaml_binding_free(&binding, &service);
+
+    yaml_binding_delete(&binding);
+
+    printf("checking struct binding: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_binding();
+}
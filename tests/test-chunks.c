@@ -0,0 +1,178 @@
+#include "test-helpers.h"
+
+int check_scalar_chunks(void)
+{
+    const char *inputs[] = {
+        "a: |\n  The quick brown fox jumps over the lazy dog.\n"
+        "  Pack my box with five dozen liquor jugs.\n\n  caf\xC3\xA9\nb: x\n",
+        "- >-\n  folded text that is long enough\n  to be split"
+        " into chunks\n\n   more indented\n  tail\n- |+\n  keep\n\n",
+        "--- |\n  short\n",
+        NULL
+    };
+    yaml_parser_t parser;
+    yaml_emitter_t emitter;
+    yaml_event_t event;
+    yaml_document_t document, chunked;
+    unsigned char value[1024], output[2048];
+    size_t length, size;
+    int failed = 0;
+    int k;
+
+    printf("checking scalar chunks...\n");
+
+    for (k = 0; inputs[k]; k ++) {
+        int done = 0;
+        int chunks = 0;
+
+        load(inputs[k], &document);
+
+        /* The chunks are emitted as a double-quoted scalar. */
+
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_input_string(&parser,
+                (const unsigned char *)inputs[k], strlen(inputs[k]));
+        yaml_parser_set_scalar_chunk_size(&parser, 16);
+        assert(yaml_emitter_initialize(&emitter));
+        yaml_emitter_set_output_string(&emitter, output, sizeof(output),
+                &size);
+        length = 0;
+        while (!done) {
+            assert(yaml_parser_parse(&parser, &event));
+            done = (event.type == YAML_STREAM_END_EVENT);
+            if (event.type == YAML_SCALAR_CHUNK_EVENT) {
+                assert(length + event.data.scalar.length <= sizeof(value));
+                memcpy(value + length, event.data.scalar.value,
+                        event.data.scalar.length);
+                length += event.data.scalar.length;
+                chunks ++;
+            }
+            assert(yaml_emitter_emit(&emitter, &event));
+        }
+        yaml_emitter_delete(&emitter);
+        yaml_parser_delete(&parser);
+
+        if (k < 2 && chunks < 2) {
+            printf("\t%s: expected several chunks\n", inputs[k]);
+            failed = 1;
+        }
+
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_input_string(&parser, output, size);
+        assert(yaml_parser_load(&parser, &chunked));
+        yaml_parser_delete(&parser);
+        failed |= !yaml_document_equal(&document, &chunked);
+        yaml_document_delete(&chunked);
+
+        /* The loader joins the chunks. */
+
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_input_string(&parser,
+                (const unsigned char *)inputs[k], strlen(inputs[k]));
+        yaml_parser_set_scalar_chunk_size(&parser, 16);
+        assert(yaml_parser_load(&parser, &chunked));
+        yaml_parser_delete(&parser);
+        failed |= !yaml_document_equal(&document, &chunked);
+        yaml_document_delete(&chunked);
+
+        yaml_document_delete(&document);
+    }
+
+    printf("checking scalar chunks: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+/*
+ * Long runs of empty lines are produced in chunks as well.
+ */
+
+int check_empty_lines(void)
+{
+    struct {
+        const char *template;
+        int bounded;
+    } templates[] = {
+        {"a: |\n  first\n%s  last\nb: x\n", 1},
+        {"a: >\n  first\n%s  last\n", 1},
+        {"a: |\n%s  last\n", 1},
+        {"a: |+\n  first\n%s", 1},
+        {"a: |\n  first\n%s", 1},
+        {"a: |-\n  first\n%s", 1},
+        {"a: >+\n%s", 1},
+        {"a: |\n  first\n%s\xE2\x80\xA8%s  last\n", 0},
+        {NULL, 0}
+    };
+    yaml_parser_t parser;
+    yaml_event_t event;
+    yaml_document_t document, chunked;
+    char *lines, *input;
+    size_t count = 2000;
+    int failed = 0;
+    int k;
+
+    printf("checking empty lines in scalar chunks...\n");
+
+    lines = (char *)malloc(count+1);
+    input = (char *)malloc(2*count+64);
+    assert(lines && input);
+    memset(lines, '\n', count);
+    lines[count] = '\0';
+
+    for (k = 0; templates[k].template; k ++) {
+        size_t longest = 0;
+        int done = 0;
+
+        sprintf(input, templates[k].template, lines, lines);
+        load(input, &document);
+
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_input_string(&parser,
+                (const unsigned char *)input, strlen(input));
+        yaml_parser_set_scalar_chunk_size(&parser, 64);
+        while (!done) {
+            assert(yaml_parser_parse(&parser, &event));
+            done = (event.type == YAML_STREAM_END_EVENT);
+            if ((event.type == YAML_SCALAR_CHUNK_EVENT
+                        || event.type == YAML_SCALAR_EVENT)
+                    && event.data.scalar.length > longest)
+                longest = event.data.scalar.length;
+            yaml_event_delete(&event);
+        }
+        yaml_parser_delete(&parser);
+
+        if (templates[k].bounded && longest > 64) {
+            printf("\t%s: found a chunk of %d octets\n",
+                    templates[k].template, (int)longest);
+            failed = 1;
+        }
+
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_input_string(&parser,
+                (const unsigned char *)input, strlen(input));
+        yaml_parser_set_scalar_chunk_size(&parser, 64);
+        assert(yaml_parser_load(&parser, &chunked));
+        yaml_parser_delete(&parser);
+        if (!yaml_document_equal(&document, &chunked)) {
+            printf("\t%s: the chunks differ from the value\n",
+                    templates[k].template);
+            failed = 1;
+        }
+        yaml_document_delete(&chunked);
+        yaml_document_delete(&document);
+    }
+
+    free(lines);
+    free(input);
+
+    printf("checking empty lines in scalar chunks: %s\n",
+            (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_scalar_chunks() + check_empty_lines();
+}
@@ -0,0 +1,159 @@
+#include "test-helpers.h"
+
+typedef struct {
+    char *a;
+    char *b;
+    int equal;
+} test_case;
+
+test_case documents[] = {
+    {"a", "'a'", 1},
+    {"a", "b", 0},
+    {"a", "!!int a", 0},
+    {"[1, 2, 3]", "- 1\n- 2\n- 3\n", 1},
+    {"[1, 2, 3]", "[1, 3, 2]", 0},
+    {"[1, 2]", "[1, 2, 3]", 0},
+    {"{a: 1, b: [x, y]}", "b: [x, y]\na: 1\n", 1},
+    {"{a: 1, b: 2}", "{a: 2, b: 1}", 0},
+    {"{a: 1, b: 2, c: 3, d: 4, e: 5, f: 6, g: 7, h: 8, i: 9, j: 10}",
+        "{j: 10, i: 9, h: 8, g: 7, f: 6, e: 5, d: 4, c: 3, b: 2, a: 1}", 1},
+    {"{a: 1, b: 2, c: 3, d: 4, e: 5, f: 6, g: 7, h: 8, i: 9, j: 10}",
+        "{j: 10, i: 9, h: 8, g: 7, f: 6, e: 5, d: 4, c: 3, b: 2, a: 0}", 0},
+    {"[&x [a], *x]", "[[a], [a]]", 1},
+    {"&x [a, *x]", "&y [a, *y]", 1},
+    {"&x [a, *x]", "&y [b, *y]", 0},
+    {"&x {k: *x}", "{k: &y {k: *y}}", 1},
+    {NULL, NULL, 0}
+};
+
+int check_documents(void)
+{
+    int failed = 0;
+    int k;
+
+    printf("checking structural equality...\n");
+
+    for (k = 0; documents[k].a; k ++) {
+        yaml_document_t a, b;
+        int hashes_equal, equal;
+
+        load(documents[k].a, &a);
+        load(documents[k].b, &b);
+
+        hashes_equal = (yaml_document_hash_node(&a, 1)
+                == yaml_document_hash_node(&b, 1));
+        equal = yaml_document_equal(&a, &b);
+
+        if (equal != documents[k].equal
+                || yaml_document_equal(&b, &a) != equal
+                || (equal && !hashes_equal)) {
+            printf("\t%s <=> %s: expected %d, got %d (hashes %s)\n",
+                    documents[k].a, documents[k].b, documents[k].equal,
+                    equal, hashes_equal ? "equal" : "different");
+            failed = 1;
+        }
+
+        yaml_document_delete(&a);
+        yaml_document_delete(&b);
+    }
+
+    printf("checking structural equality: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int check_cache(void)
+{
+    yaml_document_t document;
+    uint64_t hash;
+    int item;
+    int failed = 0;
+
+    printf("checking hash cache...\n");
+
+    load("[a, b]", &document);
+    hash = yaml_document_hash_node(&document, 1);
+    item = yaml_document_add_scalar(&document, NULL,
+            (yaml_char_t *)"c", -1, YAML_ANY_SCALAR_STYLE);
+    assert(item);
+    failed |= (yaml_document_hash_node(&document, 1) != hash);
+    assert(yaml_document_append_sequence_item(&document, 1, item));
+    failed |= (yaml_document_hash_node(&document, 1) == hash);
+    failed |= !yaml_node_equal(&document, 2, &document, 2);
+    failed |= yaml_node_equal(&document, 2, &document, 3);
+
+    yaml_document_delete(&document);
+
+    printf("checking hash cache: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+/*
+ * Build a chain of nested sequences and mappings ending with a scalar.
+ */
+
+void nest(yaml_document_t *document, int depth, const char *leaf)
+{
+    int key;
+    int node;
+    int child;
+    int k;
+
+    assert(yaml_document_initialize(document, NULL, NULL, NULL, 1, 1));
+    key = yaml_document_add_scalar(document, NULL,
+            (yaml_char_t *)"k", -1, YAML_ANY_SCALAR_STYLE);
+    child = yaml_document_add_scalar(document, NULL,
+            (yaml_char_t *)leaf, -1, YAML_ANY_SCALAR_STYLE);
+    assert(key && child);
+    for (k = 0; k < depth; k ++) {
+        if (k & 1) {
+            node = yaml_document_add_mapping(document, NULL,
+                    YAML_ANY_MAPPING_STYLE);
+            assert(node);
+            assert(yaml_document_append_mapping_pair(document,
+                        node, key, child));
+        }
+        else {
+            node = yaml_document_add_sequence(document, NULL,
+                    YAML_ANY_SEQUENCE_STYLE);
+            assert(node);
+            assert(yaml_document_append_sequence_item(document, node, child));
+        }
+        child = node;
+    }
+}
+
+int check_deep(void)
+{
+    yaml_document_t a, b, c;
+    int depth = 1000000;
+    int failed = 0;
+
+    printf("checking deep nesting...\n");
+
+    nest(&a, depth, "x");
+    nest(&b, depth, "x");
+    nest(&c, depth, "y");
+
+    failed |= (yaml_document_hash_node(&a, depth+2)
+            != yaml_document_hash_node(&b, depth+2));
+    failed |= (yaml_document_hash_node(&a, depth+2)
+            == yaml_document_hash_node(&c, depth+2));
+    failed |= !yaml_node_equal(&a, depth+2, &b, depth+2);
+    failed |= yaml_node_equal(&a, depth+2, &c, depth+2);
+
+    yaml_document_delete(&a);
+    yaml_document_delete(&b);
+    yaml_document_delete(&c);
+
+    printf("checking deep nesting: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_documents() + check_cache() + check_deep();
+}
@@ -0,0 +1,52 @@
+#include "test-helpers.h"
+
+int write_handler(void *data, unsigned char *buffer, size_t size)
+{
+    (void)data;
+    (void)buffer;
+    (void)size;
+    return 1;
+}
+
+int check_copies(void)
+{
+    yaml_document_t document, copy, subtree;
+    yaml_emitter_t emitter;
+    yaml_node_t *root;
+    int failed = 0;
+
+    printf("checking copies...\n");
+
+    load("a: &x [1, {b: c}]\nd: *x\ne: [*x, 2]\n", &document);
+
+    assert(yaml_document_copy(&copy, &document));
+    failed |= !yaml_document_equal(&copy, &document);
+    failed |= (copy.nodes.top - copy.nodes.start
+            != document.nodes.top - document.nodes.start);
+
+    assert(yaml_document_extract_subtree(&subtree, &document, 10));
+    root = yaml_document_get_root_node(&subtree);
+    failed |= !yaml_node_equal(&subtree, 1, &document, 10);
+    failed |= (subtree.nodes.top - subtree.nodes.start != 7);
+    failed |= (root->data.sequence.items.start[0] != 2);
+
+    assert(yaml_emitter_initialize(&emitter));
+    yaml_emitter_set_output(&emitter, write_handler, NULL);
+    assert(yaml_emitter_open(&emitter));
+    assert(yaml_emitter_dump(&emitter, &copy));
+    assert(yaml_emitter_close(&emitter));
+    yaml_emitter_delete(&emitter);
+
+    yaml_document_delete(&subtree);
+    yaml_document_delete(&document);
+
+    printf("checking copies: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_copies();
+}
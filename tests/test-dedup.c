@@ -0,0 +1,117 @@
+#include "test-helpers.h"
+
+typedef struct {
+    char *input;
+    int first;
+    int second;
+    int shared;
+} test_case;
+
+/*
+ * The pairs of nodes are given as the indices of the root sequence items.
+ */
+
+test_case nodes[] = {
+    {"[a, a]", 0, 1, 1},
+    {"[a, 'a']", 0, 1, 0},
+    {"[a, !t a]", 0, 1, 0},
+    {"[[a, b], [a, b]]", 0, 1, 1},
+    {"[[a, b], [b, a]]", 0, 1, 0},
+    {"[{k: [1]}, {k: [1]}, {k: [2]}]", 0, 1, 1},
+    {"[{k: [1]}, {k: [1]}, {k: [2]}]", 0, 2, 0},
+    {"[[a], [a]]", 0, 1, 1},
+    {"[&x [a], *x, [a]]", 0, 2, 1},
+    {NULL, 0, 0, 0}
+};
+
+int load_dedup(const char *input, yaml_dedup_mode_t mode,
+        yaml_document_t *document)
+{
+    yaml_parser_t parser;
+    int result;
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_dedup(&parser, mode);
+    yaml_parser_set_input_string(&parser,
+            (const unsigned char *)input, strlen(input));
+    result = yaml_parser_load(&parser, document);
+    yaml_parser_delete(&parser);
+
+    return result;
+}
+
+int check_strings(void)
+{
+    yaml_document_t document, expected;
+    yaml_node_t *a, *b, *c;
+    int failed = 0;
+
+    printf("checking string deduplication...\n");
+
+    assert(load_dedup("[!t abc, !t abc, abc]", YAML_DEDUP_STRINGS, &document));
+    load("[!t abc, !t abc, abc]", &expected);
+
+    a = yaml_document_get_node(&document, 2);
+    b = yaml_document_get_node(&document, 3);
+    c = yaml_document_get_node(&document, 4);
+    failed |= (a == b);
+    failed |= (a->data.scalar.value != b->data.scalar.value
+            || b->data.scalar.value != c->data.scalar.value);
+    failed |= (a->tag != b->tag || b->tag == c->tag);
+    failed |= !(a->flags & YAML_NODE_SHARED_VALUE)
+        || !(a->flags & YAML_NODE_SHARED_TAG);
+    failed |= !yaml_document_equal(&document, &expected);
+
+    yaml_document_delete(&expected);
+    yaml_document_delete(&document);
+
+    printf("checking string deduplication: %s\n",
+            (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int check_nodes(void)
+{
+    yaml_document_t document, expected;
+    yaml_node_t *root;
+    int failed = 0;
+    int k;
+
+    printf("checking node deduplication...\n");
+
+    for (k = 0; nodes[k].input; k ++) {
+        int first, second;
+
+        assert(load_dedup(nodes[k].input, YAML_DEDUP_NODES, &document));
+        load(nodes[k].input, &expected);
+
+        root = yaml_document_get_root_node(&document);
+        first = root->data.sequence.items.start[nodes[k].first];
+        second = root->data.sequence.items.start[nodes[k].second];
+        if ((first == second) != nodes[k].shared) {
+            printf("\t%s: items #%d and #%d are %s\n", nodes[k].input,
+                    nodes[k].first, nodes[k].second,
+                    nodes[k].shared ? "separate" : "shared");
+            failed = 1;
+        }
+        if (!yaml_document_equal(&document, &expected)) {
+            printf("\t%s: the shared document differs\n", nodes[k].input);
+            failed = 1;
+        }
+
+        yaml_document_delete(&expected);
+        yaml_document_delete(&document);
+    }
+
+    printf("checking node deduplication: %s\n",
+            (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_strings() | check_nodes();
+}
@@ -0,0 +1,147 @@
+#include "test-helpers.h"
+
+#include <time.h>
+
+void write_file(const char *path, const char *content)
+{
+    FILE *file = fopen(path, "wb");
+
+    assert(file);
+    assert(fwrite(content, 1, strlen(content), file) == strlen(content));
+    assert(fclose(file) == 0);
+}
+
+/*
+ * Wait long enough for the file system clock to advance.
+ */
+
+void wait_for_clock(void)
+{
+    clock_t start = clock();
+
+    while (clock() - start < CLOCKS_PER_SEC / 20);
+}
+
+const yaml_document_t *load_cached(yaml_document_cache_t *cache,
+        const char *path)
+{
+    yaml_parser_t parser;
+    const yaml_document_t *document = NULL;
+
+    assert(yaml_parser_initialize(&parser));
+    if (!yaml_document_cache_load(cache, &parser, path, &document)) {
+        document = NULL;
+    }
+    yaml_parser_delete(&parser);
+
+    return document;
+}
+
+int check_document_cache(void)
+{
+    const char *first = "test-cache-1.yaml";
+    const char *second = "test-cache-2.yaml";
+    yaml_document_cache_t cache;
+    const yaml_document_t *a, *b, *c;
+    yaml_document_t expected;
+    int failed = 0;
+
+    printf("checking document cache...\n");
+
+    write_file(first, "{a: [1, 2]}\n");
+    write_file(second, "[x, y]\n");
+
+    /* Repeated lookups share the document. */
+
+    assert(yaml_document_cache_initialize(&cache, 1 << 20, 0));
+    a = load_cached(&cache, first);
+    b = load_cached(&cache, first);
+    assert(a && b);
+    failed |= (a != b || cache.hits != 1 || cache.misses != 1);
+    failed |= (a->hashes.end - a->hashes.start
+            != a->nodes.top - a->nodes.start);
+    load("{a: [1, 2]}", &expected);
+    failed |= !yaml_document_equal(a, &expected);
+    yaml_document_delete(&expected);
+
+    /* A file of another size is loaded again. */
+
+    write_file(first, "{a: [1, 2, 3]}\n");
+    c = load_cached(&cache, first);
+    assert(c);
+    failed |= (c == a || cache.misses != 2);
+    load("{a: [1, 2, 3]}", &expected);
+    failed |= !yaml_document_equal(c, &expected);
+    failed |= yaml_document_equal(a, &expected);
+    yaml_document_delete(&expected);
+    yaml_document_cache_release(&cache, a);
+    yaml_document_cache_release(&cache, b);
+    yaml_document_cache_release(&cache, c);
+
+    failed |= (load_cached(&cache, "test-cache-none.yaml") != NULL);
+    yaml_document_cache_delete(&cache);
+
+    /* Only the most recent document fits in a small budget. */
+
+    assert(yaml_document_cache_initialize(&cache, 1, 0));
+    a = load_cached(&cache, first);
+    b = load_cached(&cache, second);
+    assert(a && b);
+    failed |= (cache.head != cache.tail || cache.head == NULL);
+    yaml_document_cache_release(&cache, a);
+    yaml_document_cache_release(&cache, b);
+    a = load_cached(&cache, first);
+    assert(a);
+    failed |= (cache.misses != 3);
+    yaml_document_cache_release(&cache, a);
+    yaml_document_cache_delete(&cache);
+
+    /* The content hash notices a change of the same size. */
+
+    assert(yaml_document_cache_initialize(&cache, 1 << 20,
+                YAML_CACHE_HASH_CONTENT));
+    a = load_cached(&cache, second);
+    write_file(second, "[z, y]\n");
+    b = load_cached(&cache, second);
+    write_file(second, "[z, y]\n");
+    c = load_cached(&cache, second);
+    assert(a && b && c);
+    failed |= (a == b || b != c || cache.hits != 1);
+    load("[z, y]", &expected);
+    failed |= !yaml_document_equal(b, &expected);
+    yaml_document_delete(&expected);
+    yaml_document_cache_release(&cache, a);
+    yaml_document_cache_release(&cache, b);
+    yaml_document_cache_release(&cache, c);
+    yaml_document_cache_delete(&cache);
+
+    /* A rewrite of the same size within a second is noticed as well. */
+
+    assert(yaml_document_cache_initialize(&cache, 1 << 20, 0));
+    write_file(first, "on: true\n");
+    a = load_cached(&cache, first);
+    wait_for_clock();
+    write_file(first, "on: fals\n");
+    b = load_cached(&cache, first);
+    assert(a && b);
+    failed |= (a == b || cache.hits != 0);
+    load("on: fals", &expected);
+    failed |= !yaml_document_equal(b, &expected);
+    yaml_document_delete(&expected);
+    yaml_document_cache_release(&cache, a);
+    yaml_document_cache_release(&cache, b);
+    yaml_document_cache_delete(&cache);
+
+    remove(first);
+    remove(second);
+
+    printf("checking document cache: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_document_cache();
+}
@@ -0,0 +1,197 @@
+#include "test-helpers.h"
+
+typedef struct {
+    char *input;
+    int node;
+    char *value;
+    char *output;
+} edit_case;
+
+edit_case edits[] = {
+    {"# head\na: 1   # one\nb: [x, y]\n", 0, NULL,
+        "# head\na: 1   # one\nb: [x, y]\n"},
+    {"# head\na: 1   # one\nb: [x, y]\n", 3, "two words",
+        "# head\na: two words   # one\nb: [x, y]\n"},
+    {"a: 1\nb: [x, y]\n", 7, "z, w",
+        "a: 1\nb: [x, 'z, w']\n"},
+    {"a: |\n  text\n\nb: 2\n", 3, "new\nlines",
+        "a: \"new\\nlines\"\n\nb: 2\n"},
+    {"a:\n  - &x b   # c\n  - c\nd: *x\n", 4, "e",
+        "a:\n  - &x e   # c\n  - c\nd: *x\n"},
+    {"a:\nb: 1\n", 3, "x",
+        "a: x\nb: 1\n"},
+    {"--- \n", 1, "x",
+        "--- \nx\n"},
+    {"---\n...\n", 1, "x",
+        "---\nx\n...\n"},
+    {"? a\nb: c\n", 3, "v",
+        "? a\n: v\nb: c\n"},
+    {"{a, b: c}", 3, "v",
+        "{a: v, b: c}"},
+    {NULL, 0, NULL, NULL}
+};
+
+typedef struct {
+    char *input;
+    char *value;
+    char *tag;
+} retag_case;
+
+retag_case retags[] = {
+    {"a: !!str y\n", "", YAML_STR_TAG},
+    {"a: !!str 1\n", "2", YAML_STR_TAG},
+    {"a: !!str abc\n", "5", YAML_STR_TAG},
+    {"a: !!int 1\n", "2", YAML_INT_TAG},
+    {"a: 1\n", "abc", YAML_STR_TAG},
+    {"a: abc\n", "5", YAML_INT_TAG},
+    {"a: 'abc'\n", "5", YAML_STR_TAG},
+    {NULL, NULL, NULL}
+};
+
+/*
+ * Dump an edited document into a buffer of 1024 bytes, leaving room for a
+ * terminating NUL character.
+ */
+
+int dump_edited(const char *input, yaml_document_t *document,
+        unsigned char *output, size_t *size)
+{
+    yaml_emitter_t emitter;
+    int result;
+
+    assert(yaml_emitter_initialize(&emitter));
+    yaml_emitter_set_output_string(&emitter, output, 1023, size);
+    result = yaml_emitter_dump_edited(&emitter, document,
+            (const unsigned char *)input, strlen(input));
+    yaml_emitter_delete(&emitter);
+    output[result ? *size : 0] = '\0';
+
+    return result;
+}
+
+int check_dump_edited(void)
+{
+    const char *input = "# list\nitems:\n  - a   # first\n  # gap\n  - b\n"
+        "map:\n  k: v\n";
+    const char *expected = "# list\nitems:\n  - a   # first\n  # gap\n"
+        "  - b\n  - c\nmap:\n  k: v\n  n: [1]\n";
+    yaml_parser_t parser;
+    yaml_emitter_t emitter;
+    yaml_document_t document, result;
+    unsigned char output[1024];
+    size_t size;
+    int key, value;
+    int failed = 0;
+    int k;
+
+    printf("checking edited dumps...\n");
+
+    for (k = 0; edits[k].input; k ++) {
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_input_string(&parser,
+                (const unsigned char *)edits[k].input,
+                strlen(edits[k].input));
+        yaml_parser_set_source_spans(&parser, 1);
+        assert(yaml_parser_load(&parser, &document));
+        yaml_parser_delete(&parser);
+        if (edits[k].node) {
+            assert(yaml_document_set_scalar(&document, edits[k].node,
+                        (yaml_char_t *)edits[k].value, -1));
+        }
+        assert(dump_edited(edits[k].input, &document, output, &size));
+        if (size != strlen(edits[k].output)
+                || memcmp(output, edits[k].output, size) != 0) {
+            printf("\t%s: unexpected output: %.*s\n", edits[k].input,
+                    (int)size, output);
+            failed = 1;
+        }
+        yaml_document_delete(&document);
+    }
+
+    /* Append the new entries to the block collections. */
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_input_string(&parser, (const unsigned char *)input,
+            strlen(input));
+    yaml_parser_set_source_spans(&parser, 1);
+    assert(yaml_parser_load(&parser, &document));
+    yaml_parser_delete(&parser);
+
+    value = yaml_document_add_scalar(&document, NULL,
+            (yaml_char_t *)"c", -1, YAML_ANY_SCALAR_STYLE);
+    assert(value && yaml_document_append_sequence_item(&document, 3, value));
+    key = yaml_document_add_scalar(&document, NULL,
+            (yaml_char_t *)"n", -1, YAML_ANY_SCALAR_STYLE);
+    value = yaml_document_add_sequence(&document, NULL,
+            YAML_FLOW_SEQUENCE_STYLE);
+    assert(key && value && yaml_document_append_mapping_pair(&document, 7,
+                key, value));
+    key = yaml_document_add_scalar(&document, NULL,
+            (yaml_char_t *)"1", -1, YAML_ANY_SCALAR_STYLE);
+    assert(key && yaml_document_append_sequence_item(&document, value, key));
+
+    assert(dump_edited(input, &document, output, &size));
+    if (size != strlen(expected) || memcmp(output, expected, size) != 0) {
+        printf("\tunexpected output: %.*s\n", (int)size, output);
+        failed = 1;
+    }
+
+    load((const char *)output, &result);
+    failed |= !yaml_document_equal(&document, &result);
+    yaml_document_delete(&result);
+
+    /* The dumper takes the modified document over. */
+
+    assert(yaml_emitter_initialize(&emitter));
+    yaml_emitter_set_output_string(&emitter, output, 1023, &size);
+    assert(yaml_emitter_dump(&emitter, &document));
+    failed |= (document.modified.start != NULL);
+    yaml_emitter_delete(&emitter);
+
+    printf("checking edited dumps: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int check_retags(void)
+{
+    yaml_parser_t parser;
+    yaml_document_t document;
+    int failed = 0;
+    int k;
+
+    printf("checking replaced scalar tags...\n");
+
+    /* Only a tag resolved from a plain value follows a new value. */
+
+    for (k = 0; retags[k].input; k ++) {
+        yaml_node_t *node;
+
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_input_string(&parser,
+                (const unsigned char *)retags[k].input,
+                strlen(retags[k].input));
+        yaml_parser_set_resolve_scalars(&parser, 1);
+        assert(yaml_parser_load(&parser, &document));
+        yaml_parser_delete(&parser);
+        assert(yaml_document_set_scalar(&document, 3,
+                    (yaml_char_t *)retags[k].value, -1));
+        node = yaml_document_get_node(&document, 3);
+        if (strcmp((char *)node->tag, retags[k].tag) != 0) {
+            printf("\t%s: unexpected tag %s\n", retags[k].input, node->tag);
+            failed = 1;
+        }
+        yaml_document_delete(&document);
+    }
+
+    printf("checking replaced scalar tags: %s\n",
+            (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_dump_edited() | check_retags();
+}
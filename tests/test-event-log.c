@@ -0,0 +1,149 @@
+#include <yaml.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+typedef struct {
+    unsigned char log[32];
+    size_t size;
+    int produced;
+} invalid_log;
+
+invalid_log invalid_logs[] = {
+    /* A plain scalar with invalid UTF-8. */
+    {{'Y','E','V','L',1,0, 1,0, 3,1,0, 6,0,0,0x09,2,0x80,0x80, 4,1, 2},
+        21, 2},
+    /* An anchor with invalid UTF-8. */
+    {{'Y','E','V','L',1,0, 1,0, 3,1,0, 6,6,0xC0,0x80,0,0x09,1,'a', 4,1, 2},
+        22, 2},
+    /* An unknown encoding. */
+    {{'Y','E','V','L',1,0, 1,9, 2}, 9, 0},
+    /* Unknown document flags. */
+    {{'Y','E','V','L',1,0, 1,0, 3,5,0, 4,1, 2}, 14, 1},
+    /* An unknown scalar style. */
+    {{'Y','E','V','L',1,0, 1,0, 3,1,0, 6,0,0,0x0F,1,'a', 4,1, 2}, 20, 2},
+    /* An unknown flag of a scalar. */
+    {{'Y','E','V','L',1,0, 1,0, 3,1,0, 6,0,0,0x29,1,'a', 4,1, 2}, 20, 2},
+    /* An unknown sequence style. */
+    {{'Y','E','V','L',1,0, 1,0, 3,1,0, 7,0,0,0x03, 8, 4,1, 2}, 19, 2},
+    /* The quoted implicit flag of a mapping. */
+    {{'Y','E','V','L',1,0, 1,0, 3,1,0, 9,0,0,0x11, 10, 4,1, 2}, 19, 2},
+    /* A scalar chunk with invalid UTF-8. */
+    {{'Y','E','V','L',1,0, 1,0, 3,1,0, 11,0,0,0x04, 12,1,0xFF, 13,
+        4,1, 2}, 22, 3},
+    {{0}, 0, 0}
+};
+
+int check_event_log(void)
+{
+    const char *input = "%YAML 1.1\n%TAG !e! tag:example.com,2000:\n"
+        "--- !e!root\na: &x [1, {b: 'c'}]\nd: *x\ne: |\n  text\n"
+        "f: !e!t \"\\0\"\n...\n--- [!t x, !t y, !!str z]\n";
+    yaml_parser_t parser;
+    yaml_event_log_writer_t writer;
+    yaml_event_log_reader_t reader;
+    yaml_emitter_t emitter;
+    yaml_event_t event;
+    yaml_mark_t marks[64];
+    unsigned char log[1024], parsed[1024], replayed[1024];
+    size_t log_size, parsed_size, replayed_size;
+    size_t count = 0;
+    size_t k;
+    int failed = 0;
+    int done = 0;
+
+    printf("checking event log...\n");
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_input_string(&parser,
+            (const unsigned char *)input, strlen(input));
+    assert(yaml_event_log_writer_initialize(&writer, YAML_EVENT_LOG_MARKS));
+    yaml_event_log_writer_set_output_string(&writer, log, sizeof(log),
+            &log_size);
+    assert(yaml_emitter_initialize(&emitter));
+    yaml_emitter_set_output_string(&emitter, parsed, sizeof(parsed),
+            &parsed_size);
+    while (!done) {
+        assert(yaml_parser_parse(&parser, &event));
+        done = (event.type == YAML_STREAM_END_EVENT);
+        assert(count < 64);
+        marks[count++] = event.end_mark;
+        assert(yaml_event_log_write(&writer, &event));
+        assert(yaml_emitter_emit(&emitter, &event));
+    }
+    yaml_emitter_delete(&emitter);
+    yaml_event_log_writer_delete(&writer);
+    yaml_parser_delete(&parser);
+
+    assert(yaml_event_log_reader_initialize(&reader, log, log_size));
+    assert(yaml_emitter_initialize(&emitter));
+    yaml_emitter_set_output_string(&emitter, replayed, sizeof(replayed),
+            &replayed_size);
+    for (k = 0; ; k ++) {
+        assert(yaml_event_log_read(&reader, &event));
+        if (event.type == YAML_NO_EVENT) break;
+        failed |= (k >= count || event.end_mark.index != marks[k].index
+                || event.end_mark.line != marks[k].line
+                || event.end_mark.column != marks[k].column);
+        assert(yaml_emitter_emit(&emitter, &event));
+    }
+    yaml_emitter_delete(&emitter);
+    yaml_event_log_reader_delete(&reader);
+
+    failed |= (k != count || parsed_size != replayed_size
+            || memcmp(parsed, replayed, parsed_size) != 0);
+
+    /* A log truncated anywhere, record boundaries included, is an error. */
+
+    for (k = 0; k < log_size; k ++) {
+        if (!yaml_event_log_reader_initialize(&reader, log, k)) {
+            failed |= (reader.error != YAML_READER_ERROR);
+            yaml_event_log_reader_delete(&reader);
+            continue;
+        }
+        while (yaml_event_log_read(&reader, &event)
+                && event.type != YAML_NO_EVENT) {
+            yaml_event_delete(&event);
+        }
+        failed |= (reader.error != YAML_READER_ERROR);
+        yaml_event_log_reader_delete(&reader);
+    }
+
+    failed |= yaml_event_log_reader_initialize(&reader, parsed, parsed_size);
+    yaml_event_log_reader_delete(&reader);
+
+    /* Logs with invalid UTF-8 or fields out of range are errors. */
+
+    for (k = 0; invalid_logs[k].size; k ++) {
+        int produced = 0;
+
+        assert(yaml_event_log_reader_initialize(&reader,
+                    invalid_logs[k].log, invalid_logs[k].size));
+        while (yaml_event_log_read(&reader, &event)
+                && event.type != YAML_NO_EVENT) {
+            yaml_event_delete(&event);
+            produced ++;
+        }
+        if (reader.error != YAML_READER_ERROR
+                || produced != invalid_logs[k].produced) {
+            printf("\tinvalid log %d: accepted\n", (int)k);
+            failed = 1;
+        }
+        yaml_event_log_reader_delete(&reader);
+    }
+
+    printf("checking event log: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_event_log();
+}
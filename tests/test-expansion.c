@@ -0,0 +1,86 @@
+#include "test-helpers.h"
+
+typedef struct {
+    char *a;
+    char *b;
+    int equal;
+} test_case;
+
+test_case expansions[] = {
+    {"- &a {x: [1, 2]}\n- *a\n", "- {x: [1, 2]}\n- {x: [1, 2]}\n", 1},
+    {"[&a x, &b [*a, *a], *b, &c !t y, *c]",
+        "[x, [x, x], [x, x], !t y, !t y]", 1},
+    {"{&k k: &v [a, &w {b: *k}], *v : *w}",
+        "{k: [a, {b: k}], [a, {b: k}] : {b: k}}", 1},
+    {"[*a]", NULL, 0},
+    {"&a [b, *a]", NULL, 0},
+    {NULL, NULL, 0}
+};
+
+int check_expansion(void)
+{
+    yaml_parser_t parser;
+    yaml_document_t document, expected;
+    char laughs[1024] = "";
+    int failed = 0;
+    int k;
+
+    printf("checking alias expansion...\n");
+
+    for (k = 0; expansions[k].a; k ++) {
+        int loaded;
+
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_expand_aliases(&parser, 1, 0, 0);
+        yaml_parser_set_input_string(&parser,
+                (const unsigned char *)expansions[k].a,
+                strlen(expansions[k].a));
+        loaded = yaml_parser_load(&parser, &document);
+        yaml_parser_delete(&parser);
+
+        if (loaded != expansions[k].equal) {
+            printf("\t%s: expected %s\n", expansions[k].a,
+                    expansions[k].equal ? "success" : "an error");
+            failed = 1;
+        }
+        if (!loaded)
+            continue;
+
+        load(expansions[k].b, &expected);
+        if (!yaml_document_equal(&document, &expected)
+                || document.nodes.top - document.nodes.start
+                    != expected.nodes.top - expected.nodes.start) {
+            printf("\t%s: expected %s\n", expansions[k].a, expansions[k].b);
+            failed = 1;
+        }
+        yaml_document_delete(&expected);
+        yaml_document_delete(&document);
+    }
+
+    /* A billion laughs stop at the limit. */
+
+    strcat(laughs, "- &a0 [lol, lol, lol, lol, lol, lol, lol, lol, lol]\n");
+    for (k = 1; k < 10; k ++) {
+        sprintf(laughs + strlen(laughs), "- &a%d [*a%d, *a%d, *a%d, *a%d, "
+                "*a%d, *a%d, *a%d, *a%d, *a%d]\n", k, k-1, k-1, k-1, k-1,
+                k-1, k-1, k-1, k-1, k-1);
+    }
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_expand_aliases(&parser, 1, 100000, 0);
+    yaml_parser_set_input_string(&parser,
+            (const unsigned char *)laughs, strlen(laughs));
+    failed |= yaml_parser_load(&parser, &document);
+    failed |= (parser.error != YAML_COMPOSER_ERROR);
+    yaml_parser_delete(&parser);
+
+    printf("checking alias expansion: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_expansion();
+}
@@ -0,0 +1,34 @@
+/*
+ * Helpers shared by the test programs.
+ */
+
+#ifndef TEST_HELPERS_H
+#define TEST_HELPERS_H
+
+#include <yaml.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+/*
+ * Load the first document of a string with the default parser options.
+ */
+
+static void
+load(const char *input, yaml_document_t *document)
+{
+    yaml_parser_t parser;
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_input_string(&parser,
+            (const unsigned char *)input, strlen(input));
+    assert(yaml_parser_load(&parser, document));
+    yaml_parser_delete(&parser);
+}
+
+#endif
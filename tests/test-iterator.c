@@ -0,0 +1,80 @@
+#include "test-helpers.h"
+
+int check_iterator(void)
+{
+    const char *input = "%TAG !e! tag:example.com,2000:\n"
+        "--- !e!root\na: &x [1, {b: c}]\nd: *x\ne: [*x, !!int 2, '3']\n"
+        "f: &y {g: *y}\n";
+    const char *strings = "[!!str 3, !!str abc, '5', !!str null]";
+    yaml_parser_t parser;
+    yaml_document_t document, copy;
+    yaml_document_iter_t iter;
+    yaml_emitter_t emitter;
+    yaml_event_t event;
+    unsigned char dumped[1024], iterated[1024];
+    size_t dumped_size, iterated_size;
+    int failed = 0;
+
+    printf("checking document iterator...\n");
+
+    load(input, &document);
+    assert(yaml_document_copy(&copy, &document));
+
+    assert(yaml_emitter_initialize(&emitter));
+    yaml_emitter_set_output_string(&emitter, dumped, sizeof(dumped),
+            &dumped_size);
+    assert(yaml_emitter_open(&emitter));
+    assert(yaml_emitter_dump(&emitter, &copy));
+    assert(yaml_emitter_close(&emitter));
+    yaml_emitter_delete(&emitter);
+
+    assert(yaml_emitter_initialize(&emitter));
+    yaml_emitter_set_output_string(&emitter, iterated, sizeof(iterated),
+            &iterated_size);
+    assert(yaml_emitter_open(&emitter));
+    assert(yaml_document_iter_initialize(&iter, &document));
+    while (1) {
+        assert(yaml_document_iter_next(&iter, &event));
+        if (event.type == YAML_NO_EVENT) break;
+        assert(yaml_emitter_emit_borrowed(&emitter, &event, 0));
+    }
+    yaml_document_iter_delete(&iter);
+    assert(yaml_emitter_close(&emitter));
+    yaml_emitter_delete(&emitter);
+
+    failed |= (dumped_size != iterated_size
+            || memcmp(dumped, iterated, dumped_size) != 0);
+
+    yaml_document_delete(&document);
+
+    /* A string that reads as another type is not plain implicit. */
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_resolve_scalars(&parser, 1);
+    yaml_parser_set_input_string(&parser, (const unsigned char *)strings,
+            strlen(strings));
+    assert(yaml_parser_load(&parser, &document));
+    yaml_parser_delete(&parser);
+
+    assert(yaml_document_iter_initialize(&iter, &document));
+    while (1) {
+        assert(yaml_document_iter_next(&iter, &event));
+        if (event.type == YAML_NO_EVENT) break;
+        if (event.type == YAML_SCALAR_EVENT) {
+            failed |= (event.data.scalar.plain_implicit
+                    != (strcmp((char *)event.data.scalar.value, "abc") == 0));
+        }
+    }
+    yaml_document_iter_delete(&iter);
+    yaml_document_delete(&document);
+
+    printf("checking document iterator: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_iterator();
+}
@@ -0,0 +1,126 @@
+#include <yaml.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+int check_json(void)
+{
+    const char *inputs[] = {
+        "{\"a\": [1, -2.5e3, true, null], \"b\": {\"c\": \"d\\n\"}}\n",
+        "[\n  {\"id\": 7,\n   \"tags\": [\"x\", \"y\"]},\n  {}\n]\n",
+        "{a: b c, d: [1 2], 'e': 1:2} # not JSON\n",
+        "- [1, 2]\n- {x: y}\n",
+        NULL
+    };
+    yaml_parser_t parser;
+    yaml_emitter_t emitter;
+    yaml_event_t event;
+    unsigned char output[2][1024];
+    size_t size[2], marks[2];
+    int failed = 0;
+    int k, mode;
+
+    printf("checking JSON mode...\n");
+
+    for (k = 0; inputs[k]; k ++) {
+        for (mode = 0; mode < 2; mode ++) {
+            int done = 0;
+
+            assert(yaml_parser_initialize(&parser));
+            yaml_parser_set_json(&parser,
+                    mode ? YAML_JSON_DETECT : YAML_JSON_DISABLED);
+            yaml_parser_set_input_string(&parser,
+                    (const unsigned char *)inputs[k], strlen(inputs[k]));
+            assert(yaml_emitter_initialize(&emitter));
+            yaml_emitter_set_output_string(&emitter, output[mode],
+                    sizeof(output[mode]), &size[mode]);
+            marks[mode] = 0;
+            while (!done) {
+                assert(yaml_parser_parse(&parser, &event));
+                done = (event.type == YAML_STREAM_END_EVENT);
+                marks[mode] = marks[mode]*31 + event.start_mark.index*7
+                    + event.end_mark.column;
+                assert(yaml_emitter_emit(&emitter, &event));
+            }
+            yaml_emitter_delete(&emitter);
+            yaml_parser_delete(&parser);
+        }
+        if (size[0] != size[1] || marks[0] != marks[1]
+                || memcmp(output[0], output[1], size[0]) != 0) {
+            printf("\t%s: events differ in JSON mode\n", inputs[k]);
+            failed = 1;
+        }
+    }
+
+    printf("checking JSON mode: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+/*
+ * The fast path must report the same errors as the general scanner.
+ */
+
+int check_json_errors(void)
+{
+    const char *inputs[] = {
+        "- [\ta-b \n\t ,*a\r\n,1\n]\n",
+        "- [1\n\t, 2]\n",
+        "key: {a: 1\n\t}\n",
+        "[1\n\t, 2]\n",
+        NULL
+    };
+    yaml_parser_t parser;
+    yaml_event_t event;
+    yaml_error_type_t error[2];
+    const char *problem[2];
+    size_t index[2];
+    int failed = 0;
+    int k, mode;
+
+    printf("checking JSON mode errors...\n");
+
+    for (k = 0; inputs[k]; k ++) {
+        for (mode = 0; mode < 2; mode ++) {
+            int done = 0;
+
+            assert(yaml_parser_initialize(&parser));
+            yaml_parser_set_json(&parser,
+                    mode ? YAML_JSON_ENABLED : YAML_JSON_DISABLED);
+            yaml_parser_set_input_string(&parser,
+                    (const unsigned char *)inputs[k], strlen(inputs[k]));
+            while (!done) {
+                if (!yaml_parser_parse(&parser, &event))
+                    break;
+                done = (event.type == YAML_STREAM_END_EVENT);
+                yaml_event_delete(&event);
+            }
+            error[mode] = parser.error;
+            problem[mode] = parser.problem;
+            index[mode] = parser.problem_mark.index;
+            yaml_parser_delete(&parser);
+        }
+        if (error[0] != error[1] || problem[0] != problem[1]
+                || index[0] != index[1]) {
+            printf("\t%s: errors differ in JSON mode: %s, %s\n", inputs[k],
+                    problem[0] ? problem[0] : "none",
+                    problem[1] ? problem[1] : "none");
+            failed = 1;
+        }
+    }
+
+    printf("checking JSON mode errors: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_json() + check_json_errors();
+}
@@ -0,0 +1,138 @@
+#include "test-helpers.h"
+
+typedef struct {
+    char *a;
+    char *b;
+    int equal;
+} test_case;
+
+test_case merges[] = {
+    {"- &a {x: 1, y: 2}\n- {<<: *a, y: 3}\n",
+        "- {x: 1, y: 2}\n- {x: 1, y: 3}\n", 1},
+    {"- &a {x: 1}\n- &b {x: 2, z: 3}\n- {<<: [*a, *b], w: 4}\n",
+        "- {x: 1}\n- {x: 2, z: 3}\n- {x: 1, z: 3, w: 4}\n", 1},
+    {"- &a {x: 1}\n- &b {<<: *a, y: 2}\n- {<<: *b, !!merge <<: {z: 3}}\n",
+        "- {x: 1}\n- {x: 1, y: 2}\n- {x: 1, y: 2, z: 3}\n", 1},
+    {"- &a {!!int 1: a, '1': b}\n- {<<: *a, 1: c}\n",
+        "- {!!int 1: a, '1': b}\n- {!!int 1: a, 1: c}\n", 1},
+    {"{'<<': {x: 1}}", "{'<<': {x: 1}}", 1},
+    {"{<<: [x]}", NULL, 0},
+    {"&a {b: {<<: *a}}", NULL, 0},
+    {NULL, NULL, 0}
+};
+
+test_case shared_merges[] = {
+    {"{<<: {a: 1}}", "{a: 1}", 0},
+    {"[{a: 1}, {<<: {a: 1}}]", "[{a: 1}, {a: 1}]", 1},
+    {"{<<: {}}", "{}", 0},
+    {"[&m {<<: {a: 1}}, *m, {a: 1}]", "[{a: 1}, {a: 1}, {a: 1}]", 1},
+    {NULL, NULL, 0}
+};
+
+int check_merges(void)
+{
+    yaml_parser_t parser;
+    yaml_document_t document, expected;
+    yaml_node_t *node;
+    int failed = 0;
+    int k;
+
+    printf("checking merge keys...\n");
+
+    for (k = 0; merges[k].a; k ++) {
+        int loaded;
+
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_merge(&parser, YAML_MERGE_MATERIALIZE);
+        yaml_parser_set_input_string(&parser,
+                (const unsigned char *)merges[k].a, strlen(merges[k].a));
+        loaded = yaml_parser_load(&parser, &document);
+        yaml_parser_delete(&parser);
+
+        if (loaded != merges[k].equal) {
+            printf("\t%s: expected %s\n", merges[k].a,
+                    merges[k].equal ? "success" : "an error");
+            failed = 1;
+        }
+        if (!loaded)
+            continue;
+
+        load(merges[k].b, &expected);
+        if (!yaml_document_equal(&document, &expected)) {
+            printf("\t%s: expected %s\n", merges[k].a, merges[k].b);
+            failed = 1;
+        }
+        yaml_document_delete(&expected);
+        yaml_document_delete(&document);
+    }
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_merge(&parser, YAML_MERGE_LINK);
+    yaml_parser_set_input_string(&parser, (const unsigned char *)
+            merges[2].a, strlen(merges[2].a));
+    assert(yaml_parser_load(&parser, &document));
+    yaml_parser_delete(&parser);
+
+    node = yaml_document_get_root_node(&document);
+    k = node->data.sequence.items.start[2];
+    node = yaml_document_get_node(&document,
+            yaml_document_get_mapping_value(&document, k,
+                (yaml_char_t *)"x", 1));
+    failed |= (!node || strcmp((char *)node->data.scalar.value, "1") != 0);
+    failed |= !yaml_document_get_mapping_value(&document, k,
+            (yaml_char_t *)"z", 1);
+    failed |= yaml_document_get_mapping_value(&document, k,
+            (yaml_char_t *)"w", 1);
+    yaml_document_delete(&document);
+
+    printf("checking merge keys: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int check_shared_merges(void)
+{
+    yaml_parser_t parser;
+    yaml_document_t document, expected;
+    yaml_node_t *node;
+    int failed = 0;
+    int k;
+
+    printf("checking shared merged mappings...\n");
+
+    /* Materialized mappings are shared like any other node. */
+
+    for (k = 0; shared_merges[k].a; k ++) {
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_merge(&parser, YAML_MERGE_MATERIALIZE);
+        yaml_parser_set_dedup(&parser, YAML_DEDUP_NODES);
+        yaml_parser_set_input_string(&parser, (const unsigned char *)
+                shared_merges[k].a, strlen(shared_merges[k].a));
+        assert(yaml_parser_load(&parser, &document));
+        yaml_parser_delete(&parser);
+
+        load(shared_merges[k].b, &expected);
+        node = yaml_document_get_root_node(&document);
+        if (!yaml_document_equal(&document, &expected)
+                || (shared_merges[k].equal
+                    && node->data.sequence.items.start[0]
+                    != node->data.sequence.items.start[1])) {
+            printf("\t%s: expected shared %s\n", shared_merges[k].a,
+                    shared_merges[k].b);
+            failed = 1;
+        }
+        yaml_document_delete(&expected);
+        yaml_document_delete(&document);
+    }
+
+    printf("checking shared merged mappings: %s\n",
+            (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_merges() | check_shared_merges();
+}
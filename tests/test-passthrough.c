@@ -0,0 +1,75 @@
+#include <yaml.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+int check_passthrough(void)
+{
+    const char *inputs[] = {
+        "%TAG !e! tag:example.com,2000:\n--- !e!root\n"
+        "a: &x [1, {b: 'c d', e: \"f\\tg\"}]\nh: *x\n"
+        "i: |\n  literal\n  text\nj: 'multi\n\n  line'\nk: caf\xC3\xA9\n",
+        "- plain scalar\n- 'single quoted'\n- \"double quoted\"\n"
+        "- {key: value, other: [a, b]}\n- ''\n- !!str 1\n...\n--- x\n",
+        NULL
+    };
+    yaml_parser_t parser;
+    yaml_emitter_t emitter;
+    yaml_event_t event;
+    unsigned char output[2][1024];
+    size_t size[2];
+    int failed = 0;
+    int k, mode, unicode;
+
+    printf("checking event passthrough...\n");
+
+    for (k = 0; inputs[k]; k ++) {
+        for (unicode = 0; unicode < 2; unicode ++) {
+            for (mode = 0; mode < 2; mode ++) {
+                int done = 0;
+
+                assert(yaml_parser_initialize(&parser));
+                yaml_parser_set_input_string(&parser,
+                        (const unsigned char *)inputs[k], strlen(inputs[k]));
+                assert(yaml_emitter_initialize(&emitter));
+                yaml_emitter_set_unicode(&emitter, unicode);
+                yaml_emitter_set_output_string(&emitter, output[mode],
+                        sizeof(output[mode]), &size[mode]);
+                while (!done) {
+                    assert(yaml_parser_parse(&parser, &event));
+                    done = (event.type == YAML_STREAM_END_EVENT);
+                    if (mode) {
+                        assert(yaml_emitter_emit_borrowed(&emitter, &event, 1));
+                        yaml_event_delete(&event);
+                    }
+                    else {
+                        assert(yaml_emitter_emit(&emitter, &event));
+                    }
+                }
+                yaml_emitter_delete(&emitter);
+                yaml_parser_delete(&parser);
+            }
+            if (size[0] != size[1]
+                    || memcmp(output[0], output[1], size[0]) != 0) {
+                printf("\t%s: borrowed events are emitted differently\n",
+                        inputs[k]);
+                failed = 1;
+            }
+        }
+    }
+
+    printf("checking event passthrough: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_passthrough();
+}
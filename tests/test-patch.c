@@ -0,0 +1,161 @@
+#include "test-helpers.h"
+
+typedef struct {
+    char *a;
+    char *b;
+    int equal;
+} test_case;
+
+test_case patches[] = {
+    {"{a: 1, b: 2}", "{a: 1, b: 2}", 0},
+    {"{a: 1, b: 2}", "{a: 1, b: 3, c: 4}", 2},
+    {"{a: 1, b: 2}", "{b: 2}", 1},
+    {"{a/b: {c~d: 1}}", "{a/b: {c~d: 2}}", 1},
+    {"[a, b, c, d]", "[a, c, d, e]", 2},
+    {"[a, b, c, d]", "[x, a, b, c, d]", 1},
+    {"[a, b, c]", "[a, x, c]", 1},
+    {"[a, [b, c], d]", "[a, [b, x], d, e]", 2},
+    {"[a, b]", "{a: b}", 1},
+    {"{1: a}", "{!!int 1: a}", 1},
+    {"{[k]: a}", "{[k]: b}", 1},
+    {"[&x [a], *x]", "[[b], [b]]", 1},
+    {"[&x [a], *x]", "[[b], [a]]", 1},
+    {"[&x [a], *x]", "[[a], [b]]", 1},
+    {"{a: &x {k: 1}, b: *x}", "{a: &x {j: 1}, b: *x}", 2},
+    {"[&x [1, 2], *x]", "[&x [1, 2, 3], *x]", 1},
+    {"[&x [1], {k: *x}]", "[[1, 2], {k: [1]}]", 1},
+    {"&a [*a]", "&a [*a, 1]", 1},
+    {"&a [*a, 1]", "&a [*a, 2]", 1},
+    {"a", "b", 1},
+    {"{\"a\":0,\"x\":1,\"b\":{}}", "{\"a\":0,\"x\":1,\"b\":{\"c\":0}}", 1},
+    {NULL, NULL, 0}
+};
+
+int check_patches(void)
+{
+    int failed = 0;
+    int k;
+
+    printf("checking patches...\n");
+
+    for (k = 0; patches[k].a; k ++) {
+        yaml_document_t a, b, patch;
+        yaml_node_t *root;
+        int count;
+
+        load(patches[k].a, &a);
+        load(patches[k].b, &b);
+
+        assert(yaml_document_diff(&a, &b, &patch));
+        root = yaml_document_get_root_node(&patch);
+        assert(root && root->type == YAML_SEQUENCE_NODE);
+        count = root->data.sequence.items.top - root->data.sequence.items.start;
+
+        if (count != patches[k].equal
+                || !yaml_document_apply_patch(&a, &patch)
+                || !yaml_document_equal(&a, &b)) {
+            printf("\t%s => %s: expected %d operations, got %d\n",
+                    patches[k].a, patches[k].b, patches[k].equal, count);
+            failed = 1;
+        }
+
+        yaml_document_delete(&patch);
+        yaml_document_delete(&a);
+        yaml_document_delete(&b);
+    }
+
+    printf("checking patches: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+/*
+ * A small linear congruential generator, so that the generated documents
+ * are the same on every run.
+ */
+
+int next(unsigned long *seed, int range)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return (int)((*seed >> 16) % range);
+}
+
+/*
+ * Generate a JSON document from @a seed.  Documents generated from the same
+ * seed share their structure up to the first point where the @a mutation
+ * generator, if any, decides to skip a value.
+ */
+
+void generate(char *buffer, size_t *length, int depth,
+        unsigned long *seed, unsigned long *mutation)
+{
+    static const char *keys[] = { "a", "b", "c", "x" };
+    int kind, count, offset;
+    int k;
+
+    if (mutation && next(mutation, 16) == 0)
+        next(seed, 2);
+
+    kind = depth > 0 ? next(seed, 3) : 0;
+    count = next(seed, 4);
+    offset = next(seed, 4);
+
+    if (kind == 0) {
+        *length += sprintf(buffer + *length, "%d", count % 3);
+        return;
+    }
+
+    buffer[(*length) ++] = (kind == 1 ? '[' : '{');
+    for (k = 0; k < count; k ++) {
+        if (k)
+            buffer[(*length) ++] = ',';
+        if (kind == 2)
+            *length += sprintf(buffer + *length, "\"%s\":",
+                    keys[(k+offset)%4]);
+        generate(buffer, length, depth-1, seed, mutation);
+    }
+    buffer[(*length) ++] = (kind == 1 ? ']' : '}');
+    buffer[*length] = '\0';
+}
+
+int check_round_trips(void)
+{
+    int failed = 0;
+    int k;
+
+    printf("checking patch round trips...\n");
+
+    for (k = 0; k < 2000; k ++) {
+        char input_a[4096], input_b[4096];
+        size_t length_a = 0, length_b = 0;
+        unsigned long seed_a = k, seed_b = k, mutation = ~(unsigned long)k;
+        yaml_document_t a, b, patch;
+
+        generate(input_a, &length_a, 4, &seed_a, NULL);
+        generate(input_b, &length_b, 4, &seed_b, &mutation);
+        load(input_a, &a);
+        load(input_b, &b);
+
+        assert(yaml_document_diff(&a, &b, &patch));
+        if (!yaml_document_apply_patch(&a, &patch)
+                || !yaml_document_equal(&a, &b)) {
+            printf("\t%s => %s: the patch does not reproduce the target\n",
+                    input_a, input_b);
+            failed = 1;
+        }
+
+        yaml_document_delete(&patch);
+        yaml_document_delete(&a);
+        yaml_document_delete(&b);
+    }
+
+    printf("checking patch round trips: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_patches() + check_round_trips();
+}
@@ -0,0 +1,98 @@
+#include "test-helpers.h"
+
+int check_error_recovery(void)
+{
+    const char *input =
+        "first: 1\nsecond: a: b\nthird: 3\nnested:\n  inner: @bad\n"
+        "  fine: 2\nlast: `x`\n---\n- ok\n- [unclosed\n---\nkey:\n- a\n"
+        "- b: c: d\n- e\nnext: 1\n";
+    const char *expected_documents[] = {
+        "{first: 1, second: a, third: 3, nested: {inner: '', fine: 2}, last: ''}",
+        "[ok, [unclosed]]", "{key: [a, {b: c}, e], next: 1}", NULL
+    };
+    struct {
+        yaml_error_type_t type;
+        size_t line;
+    } expected_errors[] = {
+        { YAML_SCANNER_ERROR, 1 }, { YAML_SCANNER_ERROR, 4 },
+        { YAML_SCANNER_ERROR, 6 }, { YAML_PARSER_ERROR, 10 },
+        { YAML_SCANNER_ERROR, 13 }
+    };
+    yaml_parser_t parser;
+    yaml_document_t document, expected;
+    yaml_parser_error_t *error;
+    size_t k;
+    int failed = 0;
+
+    printf("checking error recovery...\n");
+
+    /* Every error is reported, and the documents keep the rest. */
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_input_string(&parser,
+            (const unsigned char *)input, strlen(input));
+    yaml_parser_set_recover_errors(&parser, 1);
+    for (k = 0; expected_documents[k]; k ++) {
+        assert(yaml_parser_load(&parser, &document));
+        load(expected_documents[k], &expected);
+        if (!yaml_document_equal(&document, &expected)) {
+            printf("\tdocument %d: expected %s\n", (int)k,
+                    expected_documents[k]);
+            failed = 1;
+        }
+        yaml_document_delete(&expected);
+        yaml_document_delete(&document);
+    }
+    assert(yaml_parser_load(&parser, &document));
+    failed |= (yaml_document_get_root_node(&document) != NULL);
+    yaml_document_delete(&document);
+
+    failed |= (parser.errors.top - parser.errors.start != 5);
+    for (k = 0, error = parser.errors.start;
+            k < 5 && error != parser.errors.top; k ++, error ++) {
+        if (error->type != expected_errors[k].type
+                || error->problem_mark.line != expected_errors[k].line
+                || !error->problem) {
+            printf("\terror %d: unexpected %s at line %d\n", (int)k,
+                    error->problem, (int)error->problem_mark.line + 1);
+            failed = 1;
+        }
+    }
+    yaml_parser_delete(&parser);
+
+    /* Without the recovery, the first error stops the parser. */
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_input_string(&parser,
+            (const unsigned char *)input, strlen(input));
+    failed |= yaml_parser_load(&parser, &document);
+    failed |= (parser.error != YAML_SCANNER_ERROR
+            || parser.problem_mark.line != 1
+            || parser.errors.start != parser.errors.top);
+    yaml_parser_delete(&parser);
+
+    /* A valid stream is parsed as usual. */
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_input_string(&parser,
+            (const unsigned char *)expected_documents[0],
+            strlen(expected_documents[0]));
+    yaml_parser_set_recover_errors(&parser, 1);
+    assert(yaml_parser_load(&parser, &document));
+    load(expected_documents[0], &expected);
+    failed |= !yaml_document_equal(&document, &expected);
+    failed |= (parser.errors.start != parser.errors.top);
+    yaml_document_delete(&expected);
+    yaml_document_delete(&document);
+    yaml_parser_delete(&parser);
+
+    printf("checking error recovery: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_error_recovery();
+}
@@ -0,0 +1,205 @@
+#include <yaml.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+typedef struct {
+    char *input;
+    size_t start;
+    size_t end;
+    char *replacement;
+} test_case;
+
+#define BASE    "a: 1\nb:\n  - x\n  - y\n# comment\nc: {k: v}\nd: text\n"
+
+test_case edits[] = {
+    {BASE, 3, 4, "2"},
+    {BASE, 12, 13, "z"},
+    {BASE, 14, 14, "  - w\n"},
+    {BASE, 20, 20, "e: new\n"},
+    {BASE, 5, 20, ""},
+    {BASE, 37, 38, "w"},
+    {BASE, 43, 47, "more\n  text"},
+    {BASE, 0, 0, "---\n"},
+    {BASE, 3, 4, "&x 1"},
+    {BASE, 0, 1, "z"},
+    {"a: 1\nb: 2", 8, 9, "[3,\n 4]"},
+    {"a: \xc3\xa9\nb: 2\n", 9, 10, "\xc3\xa9\xc3\xa9"},
+    {"a: 1\nb: 2", 9, 9, "\n"},
+    {"a: 1\nb: 2\n\n\n", 8, 9, "3"},
+    {"a: 1\nb: |\n  x\n", 12, 13, "y"},
+    {"a: 1\nb: |\n  x\n", 14, 14, "\n\n"},
+    {"a: |+\n  x\nb: 1\n", 10, 10, "\n"},
+    {NULL, 0, 0, NULL}
+};
+
+int compare_marks(yaml_mark_t a, yaml_mark_t b)
+{
+    return (a.index == b.index && a.line == b.line && a.column == b.column);
+}
+
+int compare_documents(yaml_document_t *a, yaml_document_t *b)
+{
+    int k;
+
+    if (a->nodes.top - a->nodes.start != b->nodes.top - b->nodes.start)
+        return 0;
+
+    for (k = 0; a->nodes.start + k < a->nodes.top; k ++) {
+        yaml_node_t *x = a->nodes.start + k;
+        yaml_node_t *y = b->nodes.start + k;
+        if (x->type != y->type || strcmp((char *)x->tag, (char *)y->tag) != 0
+                || !compare_marks(x->start_mark, y->start_mark)
+                || !compare_marks(x->end_mark, y->end_mark))
+            return 0;
+        if (x->type == YAML_SCALAR_NODE
+                && strcmp((char *)x->data.scalar.value,
+                    (char *)y->data.scalar.value) != 0)
+            return 0;
+        if (x->type == YAML_SEQUENCE_NODE
+                && (x->data.sequence.items.top - x->data.sequence.items.start
+                    != y->data.sequence.items.top - y->data.sequence.items.start
+                    || memcmp(x->data.sequence.items.start,
+                        y->data.sequence.items.start,
+                        (x->data.sequence.items.top
+                         - x->data.sequence.items.start)
+                        *sizeof(yaml_node_item_t)) != 0))
+            return 0;
+        if (x->type == YAML_MAPPING_NODE
+                && (x->data.mapping.pairs.top - x->data.mapping.pairs.start
+                    != y->data.mapping.pairs.top - y->data.mapping.pairs.start
+                    || memcmp(x->data.mapping.pairs.start,
+                        y->data.mapping.pairs.start,
+                        (x->data.mapping.pairs.top
+                         - x->data.mapping.pairs.start)
+                        *sizeof(yaml_node_pair_t)) != 0))
+            return 0;
+    }
+
+    return compare_marks(a->start_mark, b->start_mark)
+        && compare_marks(a->end_mark, b->end_mark);
+}
+
+int check_edits(void)
+{
+    int failed = 0;
+    int spans;
+    int k;
+
+    printf("checking incremental reloading...\n");
+
+    /* Compare the nodes and their marks with a full load of the buffer. */
+
+    for (spans = 0; spans < 2; spans ++)
+    for (k = 0; edits[k].input; k ++) {
+        yaml_parser_t parser;
+        yaml_document_t document, expected;
+        yaml_edit_t edit;
+        char buffer[256];
+        size_t size = strlen(edits[k].input);
+        size_t length = strlen(edits[k].replacement);
+        size_t start = edits[k].start, end = edits[k].end;
+        size_t offset;
+
+        /* Convert the byte offsets of the test into character offsets. */
+
+        for (offset = 0, edit.start = 0; offset < start; offset ++)
+            edit.start += ((edits[k].input[offset] & 0xC0) != 0x80);
+        for (offset = start, edit.end = edit.start; offset < end; offset ++)
+            edit.end += ((edits[k].input[offset] & 0xC0) != 0x80);
+        for (offset = 0, edit.length = 0; offset < length; offset ++)
+            edit.length += ((edits[k].replacement[offset] & 0xC0) != 0x80);
+
+        memcpy(buffer, edits[k].input, start);
+        memcpy(buffer+start, edits[k].replacement, length);
+        memcpy(buffer+start+length, edits[k].input+end, size-end);
+        size = size - (end - start) + length;
+        buffer[size] = '\0';
+
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_source_spans(&parser, spans);
+        yaml_parser_set_input_string(&parser,
+                (unsigned char *)edits[k].input, strlen(edits[k].input));
+        assert(yaml_parser_load(&parser, &document));
+        yaml_parser_delete(&parser);
+
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_source_spans(&parser, spans);
+        yaml_parser_set_input_string(&parser, (unsigned char *)buffer, size);
+        assert(yaml_parser_load(&parser, &expected));
+        yaml_parser_delete(&parser);
+
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_source_spans(&parser, spans);
+        assert(yaml_parser_reload(&parser, &document,
+                    (unsigned char *)buffer, size, &edit));
+        yaml_parser_delete(&parser);
+
+        if (!compare_documents(&document, &expected)) {
+            printf("\tedit #%d%s: the reloaded document differs\n", k,
+                    spans ? " with source spans" : "");
+            failed = 1;
+        }
+
+        yaml_document_delete(&document);
+        yaml_document_delete(&expected);
+    }
+
+    printf("checking incremental reloading: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int check_pool(void)
+{
+    const char *input = "a: 1\nb: x\nc: 3\n";
+    const char *edited = "a: 1\nb: yy\nc: 3\n";
+    yaml_parser_t parser;
+    yaml_document_t document, expected;
+    yaml_edit_t edit = { 8, 9, 2 };
+    int failed = 0;
+
+    printf("checking reloading into a string pool...\n");
+
+    /* The document has no string pool but the loaded lines have one. */
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_input_string(&parser,
+            (unsigned char *)input, strlen(input));
+    assert(yaml_parser_load(&parser, &document));
+    yaml_parser_delete(&parser);
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_dedup(&parser, YAML_DEDUP_STRINGS);
+    yaml_parser_set_input_string(&parser,
+            (unsigned char *)edited, strlen(edited));
+    assert(yaml_parser_load(&parser, &expected));
+    yaml_parser_delete(&parser);
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_dedup(&parser, YAML_DEDUP_STRINGS);
+    assert(yaml_parser_reload(&parser, &document,
+                (unsigned char *)edited, strlen(edited), &edit));
+    yaml_parser_delete(&parser);
+
+    failed |= !compare_documents(&document, &expected);
+
+    yaml_document_delete(&document);
+    yaml_document_delete(&expected);
+
+    printf("checking reloading into a string pool: %s\n",
+            (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_edits() | check_pool();
+}
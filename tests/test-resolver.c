@@ -0,0 +1,271 @@
+#include <yaml.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+typedef struct {
+    char *value;
+    yaml_scalar_type_t type;
+    double number;
+} test_case;
+
+test_case scalars[] = {
+    {"~", YAML_NULL_SCALAR_TYPE, 0},
+    {"null", YAML_NULL_SCALAR_TYPE, 0},
+    {"NULL", YAML_NULL_SCALAR_TYPE, 0},
+    {"nULL", YAML_STR_SCALAR_TYPE, 0},
+    {"True", YAML_BOOL_SCALAR_TYPE, 1},
+    {"FALSE", YAML_BOOL_SCALAR_TYPE, 0},
+    {"yes", YAML_STR_SCALAR_TYPE, 0},
+    {"0", YAML_INT_SCALAR_TYPE, 0},
+    {"-17", YAML_INT_SCALAR_TYPE, -17},
+    {"+0042", YAML_INT_SCALAR_TYPE, 42},
+    {"0o17", YAML_INT_SCALAR_TYPE, 15},
+    {"0xFf", YAML_INT_SCALAR_TYPE, 255},
+    {"0x", YAML_STR_SCALAR_TYPE, 0},
+    {"-0x1", YAML_STR_SCALAR_TYPE, 0},
+    {"9223372036854775807", YAML_INT_SCALAR_TYPE, 9223372036854775807.0},
+    {"-9223372036854775808", YAML_INT_SCALAR_TYPE, -9223372036854775808.0},
+    {"9223372036854775808", YAML_FLOAT_SCALAR_TYPE, 9223372036854775808.0},
+    {"1.5", YAML_FLOAT_SCALAR_TYPE, 1.5},
+    {"-.5", YAML_FLOAT_SCALAR_TYPE, -0.5},
+    {"1.", YAML_FLOAT_SCALAR_TYPE, 1.0},
+    {"1e3", YAML_FLOAT_SCALAR_TYPE, 1000.0},
+    {"0.1", YAML_FLOAT_SCALAR_TYPE, 0.1},
+    {"3.14159265358979", YAML_FLOAT_SCALAR_TYPE, 3.14159265358979},
+    {"2.2250738585072014e-308", YAML_FLOAT_SCALAR_TYPE, 2.2250738585072014e-308},
+    {"1.7976931348623157e308", YAML_FLOAT_SCALAR_TYPE, 1.7976931348623157e308},
+    {"123456789012345678901234567890", YAML_FLOAT_SCALAR_TYPE, 123456789012345678901234567890.0},
+    {"12e37", YAML_FLOAT_SCALAR_TYPE, 12e37},
+    {"1e23", YAML_FLOAT_SCALAR_TYPE, 1e23},
+    {"9007199254740993.0", YAML_FLOAT_SCALAR_TYPE, 9007199254740992.0},
+    {"0.1000000000000000055511151231257827021181583404541015625", YAML_FLOAT_SCALAR_TYPE, 0.1},
+    {"4.9406564584124654e-324", YAML_FLOAT_SCALAR_TYPE, 4.9406564584124654e-324},
+    {"2.4703282292062328e-324", YAML_FLOAT_SCALAR_TYPE, 4.9406564584124654e-324},
+    {"1e-400", YAML_FLOAT_SCALAR_TYPE, 0.0},
+    {"1e400", YAML_FLOAT_SCALAR_TYPE, HUGE_VAL},
+    {".", YAML_STR_SCALAR_TYPE, 0},
+    {"1.2.3", YAML_STR_SCALAR_TYPE, 0},
+    {"1e", YAML_STR_SCALAR_TYPE, 0},
+    {"-.INF", YAML_FLOAT_SCALAR_TYPE, -HUGE_VAL},
+    {".Inf", YAML_FLOAT_SCALAR_TYPE, HUGE_VAL},
+    {"foo", YAML_STR_SCALAR_TYPE, 0},
+    {NULL, YAML_UNRESOLVED_SCALAR_TYPE, 0}
+};
+
+int check_scalars(void)
+{
+    int failed = 0;
+    int k;
+
+    printf("checking scalar resolution...\n");
+
+    for (k = 0; scalars[k].value; k ++) {
+        char buffer[64];
+        yaml_parser_t parser;
+        yaml_document_t document;
+        yaml_node_t *node;
+        int64_t integer;
+        double real;
+        int boolean;
+
+        sprintf(buffer, "[%s]", scalars[k].value);
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_resolve_scalars(&parser, 1);
+        yaml_parser_set_input_string(&parser,
+                (unsigned char *)buffer, strlen(buffer));
+        assert(yaml_parser_load(&parser, &document));
+        node = yaml_document_get_node(&document, 2);
+        assert(node && node->type == YAML_SCALAR_NODE);
+
+        if (node->resolved.type != scalars[k].type) {
+            printf("\t%s: expected type %d, got %d\n", scalars[k].value,
+                    scalars[k].type, node->resolved.type);
+            failed = 1;
+        }
+        else if (node->resolved.type == YAML_INT_SCALAR_TYPE
+                && (!yaml_node_get_int64(node, &integer)
+                    || (double)integer != scalars[k].number)) {
+            printf("\t%s: wrong integer value\n", scalars[k].value);
+            failed = 1;
+        }
+        else if (node->resolved.type == YAML_FLOAT_SCALAR_TYPE
+                && (!yaml_node_get_double(node, &real)
+                    || real != scalars[k].number)) {
+            printf("\t%s: wrong float value\n", scalars[k].value);
+            failed = 1;
+        }
+        else if (node->resolved.type == YAML_BOOL_SCALAR_TYPE
+                && (!yaml_node_get_bool(node, &boolean)
+                    || boolean != (int)scalars[k].number)) {
+            printf("\t%s: wrong boolean value\n", scalars[k].value);
+            failed = 1;
+        }
+        else if (node->resolved.type == YAML_NULL_SCALAR_TYPE
+                && !yaml_node_is_null(node)) {
+            printf("\t%s: not null\n", scalars[k].value);
+            failed = 1;
+        }
+
+        yaml_document_delete(&document);
+        yaml_parser_delete(&parser);
+    }
+
+    printf("checking scalar resolution: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int check_tags(void)
+{
+    const char *input = "- '1'\n- !!float 1\n- !!int x\n- !custom 1\n- .nan\n";
+    yaml_parser_t parser;
+    yaml_document_t document;
+    yaml_node_t *node;
+    double real;
+    int failed = 0;
+
+    printf("checking tagged scalars...\n");
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_resolve_scalars(&parser, 1);
+    yaml_parser_set_input_string(&parser,
+            (unsigned char *)input, strlen(input));
+    assert(yaml_parser_load(&parser, &document));
+
+    node = yaml_document_get_node(&document, 2);
+    failed |= (node->resolved.type != YAML_STR_SCALAR_TYPE);
+    node = yaml_document_get_node(&document, 3);
+    failed |= (node->resolved.type != YAML_FLOAT_SCALAR_TYPE
+            || strcmp((char *)node->tag, YAML_FLOAT_TAG) != 0);
+    node = yaml_document_get_node(&document, 4);
+    failed |= (node->resolved.type != YAML_UNRESOLVED_SCALAR_TYPE);
+    node = yaml_document_get_node(&document, 5);
+    failed |= (node->resolved.type != YAML_UNRESOLVED_SCALAR_TYPE);
+    node = yaml_document_get_node(&document, 6);
+    failed |= (!yaml_node_get_double(node, &real) || real == real);
+
+    yaml_document_delete(&document);
+    yaml_parser_delete(&parser);
+
+    printf("checking tagged scalars: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int check_accessors(void)
+{
+    const char *input = "- 42\n- '42'\n- !!str 42\n- ! 42\n- \"\"\n- \n"
+        "- !!int \"42\"\n- !!float 1\n- !!bool x\n- !custom 42\n- ~\n";
+    yaml_parser_t parser;
+    yaml_document_t document;
+    int64_t integer;
+    double real;
+    int boolean;
+    int resolve;
+    int failed = 0;
+
+    printf("checking node accessors...\n");
+
+    for (resolve = 0; resolve < 2; resolve ++) {
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_resolve_scalars(&parser, resolve);
+        yaml_parser_set_input_string(&parser,
+                (unsigned char *)input, strlen(input));
+        assert(yaml_parser_load(&parser, &document));
+
+        failed |= (!yaml_node_get_int64(yaml_document_get_node(&document, 2),
+                    &integer) || integer != 42);
+        failed |= yaml_node_get_int64(yaml_document_get_node(&document, 3),
+                &integer);
+        failed |= yaml_node_get_int64(yaml_document_get_node(&document, 4),
+                &integer);
+        failed |= yaml_node_get_int64(yaml_document_get_node(&document, 5),
+                &integer);
+        failed |= yaml_node_is_null(yaml_document_get_node(&document, 6));
+        failed |= !yaml_node_is_null(yaml_document_get_node(&document, 7));
+        failed |= (!yaml_node_get_int64(yaml_document_get_node(&document, 8),
+                    &integer) || integer != 42);
+        failed |= (!yaml_node_get_double(yaml_document_get_node(&document, 9),
+                    &real) || real != 1.0);
+        failed |= yaml_node_get_bool(yaml_document_get_node(&document, 10),
+                &boolean);
+        failed |= yaml_node_get_int64(yaml_document_get_node(&document, 11),
+                &integer);
+        failed |= !yaml_node_is_null(yaml_document_get_node(&document, 12));
+
+        yaml_document_delete(&document);
+        yaml_parser_delete(&parser);
+    }
+
+    printf("checking node accessors: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int check_dump(void)
+{
+    const char *input = "[!!str 3, !!str true, \"4\", !!str ~, !!str '',"
+        " abc, 5, ~]";
+    yaml_parser_t parser;
+    yaml_emitter_t emitter;
+    yaml_document_t document, result;
+    yaml_scalar_type_t types[8];
+    unsigned char output[256];
+    size_t size;
+    int failed = 0;
+    int k;
+
+    printf("checking dumped types...\n");
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_resolve_scalars(&parser, 1);
+    yaml_parser_set_input_string(&parser,
+            (unsigned char *)input, strlen(input));
+    assert(yaml_parser_load(&parser, &document));
+    yaml_parser_delete(&parser);
+
+    for (k = 0; k < 8; k ++) {
+        types[k] = yaml_document_get_node(&document, k+2)->resolved.type;
+    }
+
+    assert(yaml_emitter_initialize(&emitter));
+    yaml_emitter_set_output_string(&emitter, output, sizeof(output), &size);
+    assert(yaml_emitter_dump(&emitter, &document));
+    assert(yaml_emitter_close(&emitter));
+    yaml_emitter_delete(&emitter);
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_resolve_scalars(&parser, 1);
+    yaml_parser_set_input_string(&parser, output, size);
+    assert(yaml_parser_load(&parser, &result));
+    yaml_parser_delete(&parser);
+
+    for (k = 0; k < 8; k ++) {
+        yaml_node_t *node = yaml_document_get_node(&result, k+2);
+        if (!node || node->resolved.type != types[k]) {
+            printf("\titem %d: type %d, dumped as %.*s\n", k, types[k],
+                    (int)size, output);
+            failed = 1;
+        }
+    }
+
+    yaml_document_delete(&result);
+
+    printf("checking dumped types: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_scalars() + check_tags() + check_accessors()
+        + check_dump();
+}
@@ -0,0 +1,111 @@
+#include <yaml.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+typedef struct {
+    double value;
+    char *text;
+} test_case;
+
+test_case doubles[] = {
+    {1e23, "1.0e+23"},
+    {0.1, "0.1"},
+    {0.3, "0.3"},
+    {-0.0, "-0.0"},
+    {123456.0, "123456.0"},
+    {0.000025, "0.000025"},
+    {5e-324, "5.0e-324"},
+    {2.2250738585072014e-308, "2.2250738585072014e-308"},
+    {1.7976931348623157e308, "1.7976931348623157e+308"},
+    {9007199254740993.0, "9007199254740992.0"},
+    {0, NULL}
+};
+
+int emit_scalar(yaml_emitter_t *emitter, const char *value)
+{
+    yaml_event_t event;
+
+    assert(yaml_scalar_event_initialize(&event, NULL, NULL,
+                (yaml_char_t *)value, -1, 1, 1, YAML_ANY_SCALAR_STYLE));
+    return yaml_emitter_emit(emitter, &event);
+}
+
+int check_doubles(void)
+{
+    yaml_emitter_t emitter;
+    yaml_event_t event;
+    unsigned char output[1024];
+    char expected[1024];
+    size_t size, length;
+    int failed = 0;
+    int k;
+
+    printf("checking typed scalars...\n");
+
+    /*
+     * The first scalars of each collection are emitted while the start event
+     * waits in the queue for lookahead.
+     */
+
+    assert(yaml_emitter_initialize(&emitter));
+    yaml_emitter_set_output_string(&emitter, output, sizeof(output), &size);
+
+    assert(yaml_stream_start_event_initialize(&event, YAML_UTF8_ENCODING));
+    assert(yaml_emitter_emit(&emitter, &event));
+    assert(yaml_document_start_event_initialize(&event, NULL, NULL, NULL, 1));
+    assert(yaml_emitter_emit(&emitter, &event));
+    assert(yaml_mapping_start_event_initialize(&event, NULL, NULL, 1,
+                YAML_BLOCK_MAPPING_STYLE));
+    assert(yaml_emitter_emit(&emitter, &event));
+
+    assert(yaml_emitter_emit_int64(&emitter, INT64_MIN));
+    assert(yaml_emitter_emit_bool(&emitter, 1));
+    assert(yaml_emitter_emit_null(&emitter));
+    assert(yaml_emitter_emit_bool(&emitter, 0));
+
+    assert(emit_scalar(&emitter, "doubles"));
+    assert(yaml_sequence_start_event_initialize(&event, NULL, NULL, 1,
+                YAML_BLOCK_SEQUENCE_STYLE));
+    assert(yaml_emitter_emit(&emitter, &event));
+    for (k = 0; doubles[k].text; k ++) {
+        assert(yaml_emitter_emit_double(&emitter, doubles[k].value));
+    }
+    assert(yaml_sequence_end_event_initialize(&event));
+    assert(yaml_emitter_emit(&emitter, &event));
+
+    assert(yaml_mapping_end_event_initialize(&event));
+    assert(yaml_emitter_emit(&emitter, &event));
+    assert(yaml_document_end_event_initialize(&event, 1));
+    assert(yaml_emitter_emit(&emitter, &event));
+    assert(yaml_stream_end_event_initialize(&event));
+    assert(yaml_emitter_emit(&emitter, &event));
+    yaml_emitter_delete(&emitter);
+
+    length = sprintf(expected,
+            "-9223372036854775808: true\nnull: false\ndoubles:\n");
+    for (k = 0; doubles[k].text; k ++) {
+        length += sprintf(expected + length, "- %s\n", doubles[k].text);
+    }
+
+    if (size != length || memcmp(output, expected, length) != 0) {
+        printf("\tunexpected output:\n%.*s", (int)size, output);
+        failed = 1;
+    }
+
+    printf("checking typed scalars: %s\n", (failed ? "FAILED" : "PASSED"));
+
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_doubles();
+}